@@ -37,6 +37,7 @@
 #include <rte_kvargs.h>
 #include <rte_ring.h>
 #include <rte_errno.h>
+#include <rte_service_component.h>
 
 #include "sw_evdev.h"
 #include "iq_ring.h"
@@ -629,6 +630,7 @@ sw_start(struct rte_eventdev *dev)
 
 	rte_smp_wmb();
 	sw->started = 1;
+	rte_service_component_runstate_set(sw->service_id, 1);
 
 	return 0;
 }
@@ -637,6 +639,7 @@ static void
 sw_stop(struct rte_eventdev *dev)
 {
 	struct sw_evdev *sw = sw_pmd_priv(dev);
+	rte_service_component_runstate_set(sw->service_id, 0);
 	sw_xstats_uninit(sw);
 	sw->started = 0;
 	rte_smp_wmb();
@@ -695,6 +698,14 @@ set_credit_quanta(const char *key __rte_unused, const char *value, void *opaque)
 	return 0;
 }
 
+static int32_t
+sw_sched_service_func(void *args)
+{
+	struct rte_eventdev *dev = args;
+	sw_event_schedule(dev);
+	return 0;
+}
+
 static int
 sw_probe(struct rte_vdev_device *vdev)
 {
@@ -806,12 +817,29 @@ sw_probe(struct rte_vdev_device *vdev)
 	sw->credit_update_quanta = credit_quanta;
 	sw->sched_quanta = sched_quanta;
 
+	/* let the application run the scheduler on a service lcore */
+	struct rte_service_spec service;
+	memset(&service, 0, sizeof(service));
+	snprintf(service.name, sizeof(service.name), "%s_sched", name);
+	service.socket_id = socket_id;
+	service.callback = sw_sched_service_func;
+	service.callback_userdata = (void *)dev;
+
+	int32_t ret = rte_service_component_register(&service,
+			&sw->service_id);
+	if (ret) {
+		SW_LOG_ERR("service register() failed");
+		rte_event_pmd_vdev_uninit(name);
+		return -ENOEXEC;
+	}
+
 	return 0;
 }
 
 static int
 sw_remove(struct rte_vdev_device *vdev)
 {
+	struct rte_eventdev *dev;
 	const char *name;
 
 	name = rte_vdev_device_name(vdev);
@@ -820,6 +848,11 @@ sw_remove(struct rte_vdev_device *vdev)
 
 	SW_LOG_INFO("Closing eventdev sw device %s\n", name);
 
+	dev = rte_event_pmd_get_named_dev(name);
+	if (dev != NULL && rte_eal_process_type() == RTE_PROC_PRIMARY)
+		rte_service_component_unregister(
+				sw_pmd_priv(dev)->service_id);
+
 	return rte_event_pmd_vdev_uninit(name);
 }
 
@@ -269,6 +269,9 @@ struct sw_evdev {
 	uint8_t started;
 	uint32_t credit_update_quanta;
 
+	/* the scheduler service, see rte_service_component.h */
+	uint32_t service_id;
+
 	/* store num stats and offset of the stats for each port */
 	uint16_t xstats_count_per_port[SW_PORTS_MAX];
 	uint16_t xstats_offset_for_port[SW_PORTS_MAX];
@@ -32,6 +32,7 @@
 
 #include <rte_ring.h>
 #include <rte_hash_crc.h>
+#include <rte_trace.h>
 #include "sw_evdev.h"
 #include "iq_ring.h"
 #include "event_ring.h"
@@ -538,6 +539,9 @@ sw_schedule_pull_port_dir(struct sw_evdev *sw, uint32_t port_id)
 	return pkts_iter;
 }
 
+/* device, packets pulled from the ports, packets scheduled to the CQs */
+RTE_TRACE_POINT_DEFINE(eventdev_sw_schedule);
+
 void
 sw_event_schedule(struct rte_eventdev *dev)
 {
@@ -598,4 +602,6 @@ sw_event_schedule(struct rte_eventdev *dev)
 	sw->sched_no_iq_enqueues += (in_pkts_total == 0);
 	sw->sched_no_cq_enqueues += (out_pkts_total == 0);
 
+	RTE_TRACE(eventdev_sw_schedule, dev->data->dev_id, in_pkts_total,
+			out_pkts_total);
 }
@@ -145,3 +145,228 @@ static struct rte_mempool_ops ops_stack = {
 };
 
 MEMPOOL_REGISTER_OPS(ops_stack);
+
+#if defined(RTE_ARCH_X86_64) || \
+	(defined(RTE_ARCH_ARM64) && defined(RTE_FORCE_INTRINSICS))
+
+/*
+ * Lock-free stack
+ *
+ * The objects are kept in a linked list of elements, and the unused
+ * elements in a second list. Both list heads are updated with a 128-bit
+ * compare and set of the top pointer together with a modification
+ * counter, which protects against the ABA problem. The elements are
+ * allocated with the pool and never released while it exists, so a
+ * thread can safely walk a list that is concurrently modified: the
+ * compare and set then fails and the operation is retried.
+ */
+
+struct lf_stack_elem {
+	void *data;                 /**< Object pointer. */
+	struct lf_stack_elem *next; /**< Next element in the list. */
+};
+
+struct lf_stack_head {
+	RTE_STD_C11
+	union {
+		rte_int128_t raw;
+		struct {
+			struct lf_stack_elem *top; /**< Top of the list. */
+			uint64_t cnt;              /**< Modification counter. */
+		};
+	};
+};
+
+struct lf_stack_list {
+	/** List head, only modified with rte_atomic128_cmpset(). */
+	volatile struct lf_stack_head head;
+	/** Number of elements in the list that are not reserved. */
+	rte_atomic64_t len;
+};
+
+struct rte_mempool_lf_stack {
+	struct lf_stack_list used __rte_cache_aligned; /**< Objects. */
+	struct lf_stack_list free __rte_cache_aligned; /**< Free elements. */
+	struct lf_stack_elem elems[] __rte_cache_aligned;
+};
+
+static inline void
+lf_stack_head_read(const struct lf_stack_list *list, struct lf_stack_head *h)
+{
+	/* Not atomic: an inconsistent value only makes the following
+	 * compare and set fail. */
+	h->cnt = list->head.cnt;
+	rte_smp_rmb();
+	h->top = list->head.top;
+}
+
+/* Reserve n elements of a list, so that a following pop cannot fail */
+static inline int
+lf_stack_list_reserve(struct lf_stack_list *list, unsigned int n)
+{
+	uint64_t len;
+
+	do {
+		len = rte_atomic64_read(&list->len);
+		if (unlikely(len < n))
+			return -ENOENT;
+	} while (unlikely(rte_atomic64_cmpset((volatile uint64_t *)
+			&list->len.cnt, len, len - n) == 0));
+
+	return 0;
+}
+
+/* Push a chain of n elements, from first to last, on top of a list */
+static inline void
+lf_stack_list_push(struct lf_stack_list *list, struct lf_stack_elem *first,
+		struct lf_stack_elem *last, unsigned int n)
+{
+	struct lf_stack_head old_head, new_head;
+
+	lf_stack_head_read(list, &old_head);
+	do {
+		last->next = old_head.top;
+		new_head.top = first;
+		new_head.cnt = old_head.cnt + 1;
+	} while (unlikely(rte_atomic128_cmpset(&list->head.raw,
+			&old_head.raw, &new_head.raw) == 0));
+
+	rte_atomic64_add(&list->len, n);
+}
+
+/*
+ * Pop a chain of n previously reserved elements from the top of a list.
+ * If obj_table is not NULL, it is filled with the objects of the popped
+ * elements, top first. Returns the first element and sets *last.
+ */
+static inline struct lf_stack_elem *
+lf_stack_list_pop(struct lf_stack_list *list, unsigned int n,
+		void **obj_table, struct lf_stack_elem **last)
+{
+	struct lf_stack_head old_head, new_head;
+	struct lf_stack_elem *tmp, *prev;
+	unsigned int i;
+
+	lf_stack_head_read(list, &old_head);
+	for (;;) {
+		prev = NULL;
+		tmp = old_head.top;
+		for (i = 0; i < n && tmp != NULL; i++) {
+			if (obj_table != NULL)
+				obj_table[i] = tmp->data;
+			prev = tmp;
+			tmp = tmp->next;
+		}
+
+		/* the list changed while walking it, start over */
+		if (unlikely(i != n)) {
+			rte_pause();
+			lf_stack_head_read(list, &old_head);
+			continue;
+		}
+
+		new_head.top = tmp;
+		new_head.cnt = old_head.cnt + 1;
+		if (likely(rte_atomic128_cmpset(&list->head.raw,
+				&old_head.raw, &new_head.raw) != 0))
+			break;
+	}
+
+	*last = prev;
+	return old_head.top;
+}
+
+static int
+lf_stack_alloc(struct rte_mempool *mp)
+{
+	struct rte_mempool_lf_stack *s;
+	unsigned n = mp->size;
+	unsigned i;
+	int size = sizeof(*s) + n * sizeof(struct lf_stack_elem);
+
+	/* Allocate our local memory structure */
+	s = rte_zmalloc_socket("mempool-lf-stack",
+			size,
+			RTE_CACHE_LINE_SIZE,
+			mp->socket_id);
+	if (s == NULL) {
+		RTE_LOG(ERR, MEMPOOL, "Cannot allocate lock-free stack!\n");
+		return -ENOMEM;
+	}
+
+	/* all elements start in the free list, the used list is empty */
+	for (i = 0; i + 1 < n; i++)
+		s->elems[i].next = &s->elems[i + 1];
+	s->free.head.top = n > 0 ? &s->elems[0] : NULL;
+	rte_atomic64_set(&s->free.len, n);
+
+	mp->pool_data = s;
+
+	return 0;
+}
+
+static int
+lf_stack_enqueue(struct rte_mempool *mp, void * const *obj_table,
+		unsigned n)
+{
+	struct rte_mempool_lf_stack *s = mp->pool_data;
+	struct lf_stack_elem *first, *last, *tmp;
+	unsigned i;
+
+	if (unlikely(n == 0))
+		return 0;
+
+	/* Is there sufficient space in the stack ? */
+	if (lf_stack_list_reserve(&s->free, n) < 0)
+		return -ENOBUFS;
+
+	first = lf_stack_list_pop(&s->free, n, NULL, &last);
+
+	/* Last object of the table ends on top, like the "stack" handler */
+	for (i = n, tmp = first; i > 0; i--, tmp = tmp->next)
+		tmp->data = obj_table[i - 1];
+
+	lf_stack_list_push(&s->used, first, last, n);
+	return 0;
+}
+
+static int
+lf_stack_dequeue(struct rte_mempool *mp, void **obj_table,
+		unsigned n)
+{
+	struct rte_mempool_lf_stack *s = mp->pool_data;
+	struct lf_stack_elem *first, *last;
+
+	if (unlikely(n == 0))
+		return 0;
+
+	if (lf_stack_list_reserve(&s->used, n) < 0)
+		return -ENOENT;
+
+	first = lf_stack_list_pop(&s->used, n, obj_table, &last);
+
+	/* Give the elements back to the free list */
+	lf_stack_list_push(&s->free, first, last, n);
+	return 0;
+}
+
+static unsigned
+lf_stack_get_count(const struct rte_mempool *mp)
+{
+	struct rte_mempool_lf_stack *s = mp->pool_data;
+
+	return rte_atomic64_read(&s->used.len);
+}
+
+static struct rte_mempool_ops ops_lf_stack = {
+	.name = "lf_stack",
+	.alloc = lf_stack_alloc,
+	.free = stack_free,
+	.enqueue = lf_stack_enqueue,
+	.dequeue = lf_stack_dequeue,
+	.get_count = lf_stack_get_count
+};
+
+MEMPOOL_REGISTER_OPS(ops_lf_stack);
+
+#endif /* RTE_ARCH_X86_64 || (RTE_ARCH_ARM64 && RTE_FORCE_INTRINSICS) */
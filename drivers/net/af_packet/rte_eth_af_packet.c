@@ -42,6 +42,7 @@
 #include <rte_malloc.h>
 #include <rte_kvargs.h>
 #include <rte_vdev.h>
+#include <rte_interrupts.h>
 
 #include <linux/if_ether.h>
 #include <linux/if_packet.h>
@@ -107,6 +108,8 @@ struct pmd_internals {
 
 	struct pkt_rx_queue rx_queue[RTE_PMD_AF_PACKET_MAX_RINGS];
 	struct pkt_tx_queue tx_queue[RTE_PMD_AF_PACKET_MAX_RINGS];
+
+	struct rte_intr_handle intr_handle; /* Rx queue interrupt handle */
 };
 
 static const char *valid_arguments[] = {
@@ -262,9 +265,60 @@ eth_af_packet_tx(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 	return i;
 }
 
+/*
+ * Use the packet socket of each Rx queue as its interrupt event fd. The
+ * kernel wakes up the socket whenever it hands a frame over to the Rx ring,
+ * which is exactly the edge the EAL waits for.
+ */
+static int
+eth_rx_intr_vec_install(struct rte_eth_dev *dev)
+{
+	struct pmd_internals *internals = dev->data->dev_private;
+	struct rte_intr_handle *intr_handle = &internals->intr_handle;
+	uint16_t nb_rxq = dev->data->nb_rx_queues;
+	unsigned int i;
+
+	intr_handle->intr_vec = malloc(nb_rxq * sizeof(int));
+	if (intr_handle->intr_vec == NULL) {
+		RTE_LOG(ERR, PMD, "%s: cannot allocate Rx interrupt vector\n",
+			dev->data->name);
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < nb_rxq; i++) {
+		intr_handle->intr_vec[i] = RTE_INTR_VEC_RXTX_OFFSET + i;
+		intr_handle->efds[i] = internals->rx_queue[i].sockfd;
+	}
+	intr_handle->nb_efd = nb_rxq;
+	intr_handle->max_intr = nb_rxq + 1;
+
+	return 0;
+}
+
+static void
+eth_rx_intr_vec_uninstall(struct rte_eth_dev *dev)
+{
+	struct pmd_internals *internals = dev->data->dev_private;
+	struct rte_intr_handle *intr_handle = &internals->intr_handle;
+
+	rte_intr_free_epoll_fd(intr_handle);
+	free(intr_handle->intr_vec);
+	intr_handle->intr_vec = NULL;
+	intr_handle->nb_efd = 0;
+	intr_handle->max_intr = 0;
+}
+
 static int
 eth_dev_start(struct rte_eth_dev *dev)
 {
+	int ret;
+
+	if (dev->data->dev_conf.intr_conf.rxq) {
+		ret = eth_rx_intr_vec_install(dev);
+		if (ret < 0)
+			return ret;
+	}
+
 	dev->data->dev_link.link_status = ETH_LINK_UP;
 	return 0;
 }
@@ -279,6 +333,8 @@ eth_dev_stop(struct rte_eth_dev *dev)
 	int sockfd;
 	struct pmd_internals *internals = dev->data->dev_private;
 
+	eth_rx_intr_vec_uninstall(dev);
+
 	for (i = 0; i < internals->nb_queues; i++) {
 		sockfd = internals->rx_queue[i].sockfd;
 		if (sockfd != -1)
@@ -387,6 +443,24 @@ eth_link_update(struct rte_eth_dev *dev __rte_unused,
 	return 0;
 }
 
+/*
+ * The packet socket signals every received frame on its own, so there is
+ * nothing to arm or mask when the application toggles the Rx interrupt.
+ */
+static int
+eth_rx_queue_intr_enable(struct rte_eth_dev *dev __rte_unused,
+			 uint16_t queue_id __rte_unused)
+{
+	return 0;
+}
+
+static int
+eth_rx_queue_intr_disable(struct rte_eth_dev *dev __rte_unused,
+			  uint16_t queue_id __rte_unused)
+{
+	return 0;
+}
+
 static int
 eth_rx_queue_setup(struct rte_eth_dev *dev,
                    uint16_t rx_queue_id,
@@ -512,6 +586,8 @@ static const struct eth_dev_ops ops = {
 	.tx_queue_setup = eth_tx_queue_setup,
 	.rx_queue_release = eth_queue_release,
 	.tx_queue_release = eth_queue_release,
+	.rx_queue_intr_enable = eth_rx_queue_intr_enable,
+	.rx_queue_intr_disable = eth_rx_queue_intr_disable,
 	.link_update = eth_link_update,
 	.stats_get = eth_stats_get,
 	.stats_reset = eth_stats_reset,
@@ -791,9 +867,13 @@ rte_pmd_init_internals(struct rte_vdev_device *dev,
 	data->dev_link = pmd_link;
 	data->mac_addrs = &(*internals)->eth_addr;
 
+	(*internals)->intr_handle.type = RTE_INTR_HANDLE_VDEV;
+	(*internals)->intr_handle.fd = -1;
+
 	(*eth_dev)->data = data;
 	(*eth_dev)->dev_ops = &ops;
 	(*eth_dev)->data->dev_flags = RTE_ETH_DEV_DETACHABLE;
+	(*eth_dev)->intr_handle = &(*internals)->intr_handle;
 
 	return 0;
 
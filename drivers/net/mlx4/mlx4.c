@@ -1150,7 +1150,8 @@ mlx4_mp2mr(struct ibv_pd *pd, struct rte_mempool *mp)
 
 /**
  * Get Memory Pool (MP) from mbuf. If mbuf is indirect, the pool from which
- * the cloned mbuf is allocated is returned instead.
+ * the cloned mbuf is allocated is returned instead. The data of a mbuf
+ * with an external buffer is in no pool, see txq_mb2mr().
  *
  * @param buf
  *   Pointer to mbuf.
@@ -1223,6 +1224,40 @@ txq_mp2mr(struct txq *txq, struct rte_mempool *mp)
 	return txq->mp2mr[i].lkey;
 }
 
+/**
+ * Get Memory Region (MR) lkey of the data of a mbuf. The external buffer
+ * of a mbuf is not in its pool: it is looked up in the MRs registered for
+ * the pools of the TX queue, which cover their whole memory segments.
+ *
+ * @param txq
+ *   Pointer to TX queue structure.
+ * @param buf
+ *   Pointer to mbuf.
+ *
+ * @return
+ *   mr->lkey on success, (uint32_t)-1 on failure.
+ */
+static uint32_t
+txq_mb2mr(struct txq *txq, struct rte_mbuf *buf)
+{
+	uintptr_t addr;
+	unsigned int i;
+
+	if (likely(!RTE_MBUF_HAS_EXTBUF(buf)))
+		return txq_mp2mr(txq, txq_mb2mp(buf));
+	addr = rte_pktmbuf_mtod(buf, uintptr_t);
+	for (i = 0; (i != elemof(txq->mp2mr)); ++i) {
+		struct ibv_mr *mr = txq->mp2mr[i].mr;
+
+		if (txq->mp2mr[i].mp == NULL)
+			break;
+		if (addr >= (uintptr_t)mr->addr &&
+		    addr + DATA_LEN(buf) <= (uintptr_t)mr->addr + mr->length)
+			return txq->mp2mr[i].lkey;
+	}
+	return (uint32_t)-1;
+}
+
 struct txq_mp2mr_mbuf_check_data {
 	int ret;
 };
@@ -1359,7 +1394,7 @@ tx_burst_sg(struct txq *txq, unsigned int segs, struct txq_elt *elt,
 		uint32_t lkey;
 
 		/* Retrieve Memory Region key for this memory pool. */
-		lkey = txq_mp2mr(txq, txq_mb2mp(buf));
+		lkey = txq_mb2mr(txq, buf);
 		if (unlikely(lkey == (uint32_t)-1)) {
 			/* MR does not exist. */
 			DEBUG("%p: unable to get MP <-> MR association",
@@ -1520,7 +1555,7 @@ mlx4_tx_burst(void *dpdk_txq, struct rte_mbuf **pkts, uint16_t pkts_n)
 			addr = rte_pktmbuf_mtod(buf, uintptr_t);
 			length = DATA_LEN(buf);
 			/* Retrieve Memory Region key for this memory pool. */
-			lkey = txq_mp2mr(txq, txq_mb2mp(buf));
+			lkey = txq_mb2mr(txq, buf);
 			if (unlikely(lkey == (uint32_t)-1)) {
 				/* MR does not exist. */
 				DEBUG("%p: unable to get MP <-> MR"
@@ -81,6 +81,10 @@ static inline uint32_t
 txq_mp2mr(struct txq *txq, struct rte_mempool *mp)
 	__attribute__((always_inline));
 
+static inline uint32_t
+txq_mb2mr(struct txq *txq, struct rte_mbuf *buf)
+	__attribute__((always_inline));
+
 static inline void
 mlx5_tx_dbrec(struct txq *txq, volatile struct mlx5_wqe *wqe)
 	__attribute__((always_inline));
@@ -326,7 +330,8 @@ txq_complete(struct txq *txq)
 
 /**
  * Get Memory Pool (MP) from mbuf. If mbuf is indirect, the pool from which
- * the cloned mbuf is allocated is returned instead.
+ * the cloned mbuf is allocated is returned instead. The data of a mbuf
+ * with an external buffer is in no pool, see txq_mb2mr().
  *
  * @param buf
  *   Pointer to mbuf.
@@ -379,6 +384,40 @@ txq_mp2mr(struct txq *txq, struct rte_mempool *mp)
 	return lkey;
 }
 
+/**
+ * Get Memory Region (MR) lkey of the data of a mbuf. The external buffer
+ * of a mbuf is not in its pool: it is looked up in the MRs registered for
+ * the pools of the TX queue, which cover their whole memory segments.
+ *
+ * @param txq
+ *   Pointer to TX queue structure.
+ * @param buf
+ *   Pointer to mbuf.
+ *
+ * @return
+ *   mr->lkey on success, (uint32_t)-1 on failure.
+ */
+static inline uint32_t
+txq_mb2mr(struct txq *txq, struct rte_mbuf *buf)
+{
+	uintptr_t addr;
+	unsigned int i;
+
+	if (likely(!RTE_MBUF_HAS_EXTBUF(buf)))
+		return txq_mp2mr(txq, txq_mb2mp(buf));
+	addr = rte_pktmbuf_mtod(buf, uintptr_t);
+	for (i = 0; (i != RTE_DIM(txq->mp2mr)); ++i) {
+		struct ibv_mr *mr = txq->mp2mr[i].mr;
+
+		if (txq->mp2mr[i].mp == NULL)
+			break;
+		if (addr >= (uintptr_t)mr->addr &&
+		    addr + DATA_LEN(buf) <= (uintptr_t)mr->addr + mr->length)
+			return txq->mp2mr[i].lkey;
+	}
+	return (uint32_t)-1;
+}
+
 /**
  * Ring TX queue doorbell.
  *
@@ -762,7 +801,7 @@ mlx5_tx_burst(void *dpdk_txq, struct rte_mbuf **pkts, uint16_t pkts_n)
 			naddr = htonll(addr);
 			*dseg = (rte_v128u32_t){
 				htonl(length),
-				txq_mp2mr(txq, txq_mb2mp(buf)),
+				txq_mb2mr(txq, buf),
 				naddr,
 				naddr >> 32,
 			};
@@ -801,7 +840,7 @@ mlx5_tx_burst(void *dpdk_txq, struct rte_mbuf **pkts, uint16_t pkts_n)
 		naddr = htonll(rte_pktmbuf_mtod(buf, uintptr_t));
 		*dseg = (rte_v128u32_t){
 			htonl(length),
-			txq_mp2mr(txq, txq_mb2mp(buf)),
+			txq_mb2mr(txq, buf),
 			naddr,
 			naddr >> 32,
 		};
@@ -1047,7 +1086,7 @@ mlx5_tx_burst_mpw(void *dpdk_txq, struct rte_mbuf **pkts, uint16_t pkts_n)
 			addr = rte_pktmbuf_mtod(buf, uintptr_t);
 			*dseg = (struct mlx5_wqe_data_seg){
 				.byte_count = htonl(DATA_LEN(buf)),
-				.lkey = txq_mp2mr(txq, txq_mb2mp(buf)),
+				.lkey = txq_mb2mr(txq, buf),
 				.addr = htonll(addr),
 			};
 			elts_head = elts_head_next;
@@ -1299,7 +1338,7 @@ mlx5_tx_burst_mpw_inline(void *dpdk_txq, struct rte_mbuf **pkts,
 				addr = rte_pktmbuf_mtod(buf, uintptr_t);
 				*dseg = (struct mlx5_wqe_data_seg){
 					.byte_count = htonl(DATA_LEN(buf)),
-					.lkey = txq_mp2mr(txq, txq_mb2mp(buf)),
+					.lkey = txq_mb2mr(txq, buf),
 					.addr = htonll(addr),
 				};
 				elts_head = elts_head_next;
@@ -1613,7 +1652,7 @@ mlx5_tx_burst_empw(void *dpdk_txq, struct rte_mbuf **pkts, uint16_t pkts_n)
 				addr = rte_pktmbuf_mtod(buf, uintptr_t);
 				*dseg = (struct mlx5_wqe_data_seg){
 					.byte_count = htonl(DATA_LEN(buf)),
-					.lkey = txq_mp2mr(txq, txq_mb2mp(buf)),
+					.lkey = txq_mb2mr(txq, buf),
 					.addr = htonll(addr),
 				};
 				elts_head = elts_head_next;
@@ -1699,7 +1738,7 @@ mlx5_tx_burst_empw(void *dpdk_txq, struct rte_mbuf **pkts, uint16_t pkts_n)
 			naddr = htonll(addr);
 			*dseg = (rte_v128u32_t) {
 				htonl(length),
-				txq_mp2mr(txq, txq_mb2mp(buf)),
+				txq_mb2mr(txq, buf),
 				naddr,
 				naddr >> 32,
 			};
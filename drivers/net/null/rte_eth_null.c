@@ -60,6 +60,7 @@ struct null_queue {
 
 	struct rte_mempool *mb_pool;
 	struct rte_mbuf *dummy_packet;
+	int fast_free; /**< TX mbufs are simple and from a single pool. */
 
 	rte_atomic64_t rx_pkts;
 	rte_atomic64_t tx_pkts;
@@ -152,18 +153,21 @@ eth_null_copy_rx(void *q, struct rte_mbuf **bufs, uint16_t nb_bufs)
 static uint16_t
 eth_null_tx(void *q, struct rte_mbuf **bufs, uint16_t nb_bufs)
 {
-	int i;
 	struct null_queue *h = q;
 
 	if ((q == NULL) || (bufs == NULL))
 		return 0;
 
-	for (i = 0; i < nb_bufs; i++)
-		rte_pktmbuf_free(bufs[i]);
+	if (h->fast_free) {
+		if (nb_bufs != 0)
+			rte_mbuf_raw_free_bulk(bufs[0]->pool, bufs, nb_bufs);
+	} else {
+		rte_pktmbuf_free_bulk(bufs, nb_bufs);
+	}
 
-	rte_atomic64_add(&(h->tx_pkts), i);
+	rte_atomic64_add(&(h->tx_pkts), nb_bufs);
 
-	return i;
+	return nb_bufs;
 }
 
 static uint16_t
@@ -177,11 +181,10 @@ eth_null_copy_tx(void *q, struct rte_mbuf **bufs, uint16_t nb_bufs)
 		return 0;
 
 	packet_size = h->internals->packet_size;
-	for (i = 0; i < nb_bufs; i++) {
+	for (i = 0; i < nb_bufs; i++)
 		rte_memcpy(h->dummy_packet, rte_pktmbuf_mtod(bufs[i], void *),
 					packet_size);
-		rte_pktmbuf_free(bufs[i]);
-	}
+	rte_pktmbuf_free_bulk(bufs, nb_bufs);
 
 	rte_atomic64_add(&(h->tx_pkts), i);
 
@@ -252,8 +255,10 @@ static int
 eth_tx_queue_setup(struct rte_eth_dev *dev, uint16_t tx_queue_id,
 		uint16_t nb_tx_desc __rte_unused,
 		unsigned int socket_id __rte_unused,
-		const struct rte_eth_txconf *tx_conf __rte_unused)
+		const struct rte_eth_txconf *tx_conf)
 {
+	const uint32_t fast_free_flags = ETH_TXQ_FLAGS_NOREFCOUNT |
+		ETH_TXQ_FLAGS_NOMULTMEMP | ETH_TXQ_FLAGS_NOMULTSEGS;
 	struct rte_mbuf *dummy_packet;
 	struct pmd_internals *internals;
 	unsigned packet_size;
@@ -277,6 +282,8 @@ eth_tx_queue_setup(struct rte_eth_dev *dev, uint16_t tx_queue_id,
 
 	internals->tx_null_queues[tx_queue_id].internals = internals;
 	internals->tx_null_queues[tx_queue_id].dummy_packet = dummy_packet;
+	internals->tx_null_queues[tx_queue_id].fast_free = tx_conf != NULL &&
+		(tx_conf->txq_flags & fast_free_flags) == fast_free_flags;
 
 	return 0;
 }
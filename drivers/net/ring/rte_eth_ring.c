@@ -31,6 +31,13 @@
  *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/queue.h>
+#ifdef RTE_EXEC_ENV_LINUXAPP
+#include <sys/eventfd.h>
+#endif
+
 #include "rte_eth_ring.h"
 #include <rte_mbuf.h>
 #include <rte_ethdev.h>
@@ -41,6 +48,8 @@
 #include <rte_vdev.h>
 #include <rte_kvargs.h>
 #include <rte_errno.h>
+#include <rte_interrupts.h>
+#include <rte_spinlock.h>
 
 #define ETH_RING_NUMA_NODE_ACTION_ARG	"nodeaction"
 #define ETH_RING_ACTION_CREATE		"CREATE"
@@ -56,8 +65,27 @@ enum dev_action {
 	DEV_ATTACH
 };
 
+/*
+ * Rx interrupt state of a ring. A ring is usually the Tx queue of one port
+ * and the Rx queue of another one, so the state is looked up by ring and
+ * shared by all the queues of this process using it.
+ */
+struct ring_intr {
+	TAILQ_ENTRY(ring_intr) next;
+	const struct rte_ring *rng;
+	unsigned int refcnt;
+	int efd;                /**< eventfd of the consumer, -1 if none */
+	rte_atomic32_t armed;   /**< set while the consumer waits on efd */
+};
+
+TAILQ_HEAD(ring_intr_list, ring_intr);
+static struct ring_intr_list ring_intr_list =
+	TAILQ_HEAD_INITIALIZER(ring_intr_list);
+static rte_spinlock_t ring_intr_lock = RTE_SPINLOCK_INITIALIZER;
+
 struct ring_queue {
 	struct rte_ring *rng;
+	struct ring_intr *intr;
 	rte_atomic64_t rx_pkts;
 	rte_atomic64_t tx_pkts;
 	rte_atomic64_t err_pkts;
@@ -72,6 +100,8 @@ struct pmd_internals {
 
 	struct ether_addr address;
 	enum dev_action action;
+
+	struct rte_intr_handle intr_handle; /**< Rx queue interrupt handle */
 };
 
 
@@ -82,6 +112,69 @@ static struct rte_eth_link pmd_link = {
 		.link_autoneg = ETH_LINK_SPEED_AUTONEG
 };
 
+static struct ring_intr *
+ring_intr_get(const struct rte_ring *rng)
+{
+	struct ring_intr *intr;
+
+	rte_spinlock_lock(&ring_intr_lock);
+	TAILQ_FOREACH(intr, &ring_intr_list, next) {
+		if (intr->rng == rng)
+			break;
+	}
+	if (intr == NULL) {
+		intr = calloc(1, sizeof(*intr));
+		if (intr == NULL)
+			goto out;
+		intr->rng = rng;
+		intr->efd = -1;
+		TAILQ_INSERT_TAIL(&ring_intr_list, intr, next);
+	}
+	intr->refcnt++;
+out:
+	rte_spinlock_unlock(&ring_intr_lock);
+	return intr;
+}
+
+static void
+ring_intr_put(struct ring_intr *intr)
+{
+	if (intr == NULL)
+		return;
+
+	rte_spinlock_lock(&ring_intr_lock);
+	if (--intr->refcnt == 0) {
+		TAILQ_REMOVE(&ring_intr_list, intr, next);
+		if (intr->efd >= 0)
+			close(intr->efd);
+		free(intr);
+	}
+	rte_spinlock_unlock(&ring_intr_lock);
+}
+
+/*
+ * Wake up the consumer of the ring if it is waiting for packets. Only the
+ * first caller after the consumer armed the interrupt signals the eventfd.
+ */
+static void
+ring_intr_notify(struct ring_intr *intr)
+{
+#ifdef RTE_EXEC_ENV_LINUXAPP
+	/*
+	 * Order the ring update before reading the armed flag: the consumer
+	 * publishes the flag before checking the ring, reading it any earlier
+	 * could miss a wake-up. The atomic operation is only done when armed.
+	 */
+	rte_smp_mb();
+	if (rte_atomic32_read(&intr->armed) != 0 &&
+			rte_atomic32_cmpset((volatile uint32_t *)
+				&intr->armed.cnt, 1, 0))
+		eventfd_write(intr->efd, 1);
+#else
+	RTE_SET_USED(intr);
+#endif
+}
+
 static uint16_t
 eth_ring_rx(void *q, struct rte_mbuf **bufs, uint16_t nb_bufs)
 {
@@ -110,15 +203,130 @@ eth_ring_tx(void *q, struct rte_mbuf **bufs, uint16_t nb_bufs)
 		rte_atomic64_add(&(r->tx_pkts), nb_tx);
 		rte_atomic64_add(&(r->err_pkts), nb_bufs - nb_tx);
 	}
+	if (unlikely(r->intr != NULL && r->intr->efd >= 0) && nb_tx > 0)
+		ring_intr_notify(r->intr);
 	return nb_tx;
 }
 
 static int
 eth_dev_configure(struct rte_eth_dev *dev __rte_unused) { return 0; }
 
+#ifdef RTE_EXEC_ENV_LINUXAPP
+/*
+ * Give each Rx ring an eventfd, signalled by the Tx burst of whichever
+ * port of this process enqueues into it. Producers living in another
+ * process cannot wake up the consumer.
+ */
+static int
+eth_rx_intr_vec_install(struct rte_eth_dev *dev)
+{
+	struct pmd_internals *internals = dev->data->dev_private;
+	struct rte_intr_handle *intr_handle = &internals->intr_handle;
+	uint16_t nb_rxq = dev->data->nb_rx_queues;
+	struct ring_intr *intr;
+	unsigned int i;
+
+	if (nb_rxq > RTE_MAX_RXTX_INTR_VEC_ID) {
+		RTE_LOG(ERR, PMD, "%s: too many Rx queues for interrupts\n",
+			dev->data->name);
+		return -ENOTSUP;
+	}
+
+	intr_handle->intr_vec = malloc(nb_rxq * sizeof(int));
+	if (intr_handle->intr_vec == NULL)
+		return -ENOMEM;
+
+	for (i = 0; i < nb_rxq; i++) {
+		intr = internals->rx_ring_queues[i].intr;
+		if (intr == NULL) {
+			free(intr_handle->intr_vec);
+			intr_handle->intr_vec = NULL;
+			return -ENOMEM;
+		}
+		rte_spinlock_lock(&ring_intr_lock);
+		if (intr->efd < 0)
+			intr->efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		rte_spinlock_unlock(&ring_intr_lock);
+		if (intr->efd < 0) {
+			RTE_LOG(ERR, PMD, "%s: cannot create eventfd: %s\n",
+				dev->data->name, strerror(errno));
+			free(intr_handle->intr_vec);
+			intr_handle->intr_vec = NULL;
+			return -errno;
+		}
+		intr_handle->intr_vec[i] = RTE_INTR_VEC_RXTX_OFFSET + i;
+		intr_handle->efds[i] = intr->efd;
+	}
+	intr_handle->nb_efd = nb_rxq;
+	intr_handle->max_intr = nb_rxq + 1;
+
+	return 0;
+}
+
+static void
+eth_rx_intr_vec_uninstall(struct rte_eth_dev *dev)
+{
+	struct pmd_internals *internals = dev->data->dev_private;
+	struct rte_intr_handle *intr_handle = &internals->intr_handle;
+
+	rte_intr_free_epoll_fd(intr_handle);
+	free(intr_handle->intr_vec);
+	intr_handle->intr_vec = NULL;
+	intr_handle->nb_efd = 0;
+	intr_handle->max_intr = 0;
+}
+
+static int
+eth_rx_queue_intr_enable(struct rte_eth_dev *dev, uint16_t queue_id)
+{
+	struct ring_queue *r = dev->data->rx_queues[queue_id];
+	struct ring_intr *intr = r->intr;
+
+	if (intr == NULL || intr->efd < 0)
+		return -EINVAL;
+
+	rte_atomic32_set(&intr->armed, 1);
+	/*
+	 * A producer which enqueued before seeing the flag did not signal,
+	 * so look at the ring once more after publishing it.
+	 */
+	rte_smp_mb();
+	if (!rte_ring_empty(r->rng))
+		ring_intr_notify(intr);
+
+	return 0;
+}
+
+static int
+eth_rx_queue_intr_disable(struct rte_eth_dev *dev, uint16_t queue_id)
+{
+	struct ring_queue *r = dev->data->rx_queues[queue_id];
+	struct ring_intr *intr = r->intr;
+	eventfd_t val;
+
+	if (intr == NULL || intr->efd < 0)
+		return -EINVAL;
+
+	rte_atomic32_clear(&intr->armed);
+	/* drain the pending wake-ups, the eventfd is non-blocking */
+	eventfd_read(intr->efd, &val);
+
+	return 0;
+}
+#endif /* RTE_EXEC_ENV_LINUXAPP */
+
 static int
 eth_dev_start(struct rte_eth_dev *dev)
 {
+#ifdef RTE_EXEC_ENV_LINUXAPP
+	int ret;
+
+	if (dev->data->dev_conf.intr_conf.rxq) {
+		ret = eth_rx_intr_vec_install(dev);
+		if (ret < 0)
+			return ret;
+	}
+#endif
 	dev->data->dev_link.link_status = ETH_LINK_UP;
 	return 0;
 }
@@ -126,6 +334,9 @@ eth_dev_start(struct rte_eth_dev *dev)
 static void
 eth_dev_stop(struct rte_eth_dev *dev)
 {
+#ifdef RTE_EXEC_ENV_LINUXAPP
+	eth_rx_intr_vec_uninstall(dev);
+#endif
 	dev->data->dev_link.link_status = ETH_LINK_DOWN;
 }
 
@@ -250,6 +461,10 @@ static const struct eth_dev_ops ops = {
 	.tx_queue_setup = eth_tx_queue_setup,
 	.rx_queue_release = eth_queue_release,
 	.tx_queue_release = eth_queue_release,
+#ifdef RTE_EXEC_ENV_LINUXAPP
+	.rx_queue_intr_enable = eth_rx_queue_intr_enable,
+	.rx_queue_intr_disable = eth_rx_queue_intr_disable,
+#endif
 	.link_update = eth_link_update,
 	.stats_get = eth_stats_get,
 	.stats_reset = eth_stats_reset,
@@ -323,10 +538,12 @@ do_eth_dev_ring_create(const char *name,
 	internals->max_tx_queues = nb_tx_queues;
 	for (i = 0; i < nb_rx_queues; i++) {
 		internals->rx_ring_queues[i].rng = rx_queues[i];
+		internals->rx_ring_queues[i].intr = ring_intr_get(rx_queues[i]);
 		data->rx_queues[i] = &internals->rx_ring_queues[i];
 	}
 	for (i = 0; i < nb_tx_queues; i++) {
 		internals->tx_ring_queues[i].rng = tx_queues[i];
+		internals->tx_ring_queues[i].intr = ring_intr_get(tx_queues[i]);
 		data->tx_queues[i] = &internals->tx_ring_queues[i];
 	}
 
@@ -338,6 +555,12 @@ do_eth_dev_ring_create(const char *name,
 	data->dev_link = pmd_link;
 	data->mac_addrs = &internals->address;
 
+#ifdef RTE_EXEC_ENV_LINUXAPP
+	internals->intr_handle.type = RTE_INTR_HANDLE_VDEV;
+	internals->intr_handle.fd = -1;
+	eth_dev->intr_handle = &internals->intr_handle;
+#endif
+
 	eth_dev->data = data;
 	eth_dev->dev_ops = &ops;
 	data->dev_flags = RTE_ETH_DEV_DETACHABLE;
@@ -602,6 +825,11 @@ rte_pmd_ring_remove(struct rte_vdev_device *dev)
 	eth_dev_stop(eth_dev);
 
 	internals = eth_dev->data->dev_private;
+	for (i = 0; i < internals->max_rx_queues; i++)
+		ring_intr_put(internals->rx_ring_queues[i].intr);
+	for (i = 0; i < internals->max_tx_queues; i++)
+		ring_intr_put(internals->tx_ring_queues[i].intr);
+
 	if (internals->action == DEV_CREATE) {
 		/*
 		 * it is only necessary to delete the rings in rx_queues because
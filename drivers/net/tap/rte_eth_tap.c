@@ -115,6 +115,7 @@ tap_ioctl(struct pmd_internals *pmd, unsigned long request,
 	  struct ifreq *ifr, int set, enum ioctl_mode mode);
 
 static int tap_intr_handle_set(struct rte_eth_dev *dev, int set);
+static int tap_rx_intr_vec_set(struct rte_eth_dev *dev, int set);
 
 /* Tun/Tap allocation routine
  *
@@ -519,6 +520,9 @@ tap_dev_start(struct rte_eth_dev *dev)
 	int err;
 
 	err = tap_intr_handle_set(dev, 1);
+	if (err)
+		return err;
+	err = tap_rx_intr_vec_set(dev, 1);
 	if (err)
 		return err;
 	return tap_link_set_up(dev);
@@ -529,6 +533,7 @@ tap_dev_start(struct rte_eth_dev *dev)
 static void
 tap_dev_stop(struct rte_eth_dev *dev)
 {
+	tap_rx_intr_vec_set(dev, 0);
 	tap_intr_handle_set(dev, 0);
 	tap_link_set_down(dev);
 }
@@ -1039,6 +1044,79 @@ tap_intr_handle_set(struct rte_eth_dev *dev, int set)
 					    tap_dev_intr_handler, dev);
 }
 
+static void
+tap_rx_intr_vec_uninstall(struct rte_eth_dev *dev)
+{
+	struct pmd_internals *pmd = dev->data->dev_private;
+	struct rte_intr_handle *intr_handle = &pmd->rx_intr_handle;
+
+	rte_intr_free_epoll_fd(intr_handle);
+	free(intr_handle->intr_vec);
+	intr_handle->intr_vec = NULL;
+	intr_handle->nb_efd = 0;
+	intr_handle->max_intr = 0;
+}
+
+/*
+ * The fd of each queue becomes readable as soon as the kernel queues a
+ * packet on it, so it is used as is as the Rx interrupt event fd.
+ */
+static int
+tap_rx_intr_vec_install(struct rte_eth_dev *dev)
+{
+	struct pmd_internals *pmd = dev->data->dev_private;
+	struct rte_intr_handle *intr_handle = &pmd->rx_intr_handle;
+	uint16_t nb_rxq = dev->data->nb_rx_queues;
+	unsigned int i;
+
+	intr_handle->intr_vec = malloc(nb_rxq * sizeof(int));
+	if (intr_handle->intr_vec == NULL) {
+		RTE_LOG(ERR, PMD, "%s: cannot allocate Rx interrupt vector\n",
+			pmd->name);
+		return -ENOMEM;
+	}
+	for (i = 0; i < nb_rxq; i++) {
+		if (pmd->rxq[i].fd == -1) {
+			RTE_LOG(ERR, PMD, "%s: Rx queue %u is not set up\n",
+				pmd->name, i);
+			tap_rx_intr_vec_uninstall(dev);
+			return -EINVAL;
+		}
+		intr_handle->intr_vec[i] = RTE_INTR_VEC_RXTX_OFFSET + i;
+		intr_handle->efds[i] = pmd->rxq[i].fd;
+	}
+	intr_handle->nb_efd = nb_rxq;
+	intr_handle->max_intr = nb_rxq + 1;
+	return 0;
+}
+
+static int
+tap_rx_intr_vec_set(struct rte_eth_dev *dev, int set)
+{
+	tap_rx_intr_vec_uninstall(dev);
+	if (set && dev->data->dev_conf.intr_conf.rxq)
+		return tap_rx_intr_vec_install(dev);
+	return 0;
+}
+
+/*
+ * The queue fd signals every packet on its own, there is nothing to arm or
+ * mask when the application toggles the Rx interrupt.
+ */
+static int
+tap_rx_queue_intr_enable(struct rte_eth_dev *dev __rte_unused,
+			 uint16_t queue_id __rte_unused)
+{
+	return 0;
+}
+
+static int
+tap_rx_queue_intr_disable(struct rte_eth_dev *dev __rte_unused,
+			  uint16_t queue_id __rte_unused)
+{
+	return 0;
+}
+
 static const uint32_t*
 tap_dev_supported_ptypes_get(struct rte_eth_dev *dev __rte_unused)
 {
@@ -1097,6 +1175,8 @@ static const struct eth_dev_ops ops = {
 	.tx_queue_setup         = tap_tx_queue_setup,
 	.rx_queue_release       = tap_rx_queue_release,
 	.tx_queue_release       = tap_tx_queue_release,
+	.rx_queue_intr_enable   = tap_rx_queue_intr_enable,
+	.rx_queue_intr_disable  = tap_rx_queue_intr_disable,
 	.flow_ctrl_get          = tap_flow_ctrl_get,
 	.flow_ctrl_set          = tap_flow_ctrl_set,
 	.link_update            = tap_link_update,
@@ -1188,6 +1268,9 @@ eth_dev_tap_create(struct rte_vdev_device *vdev, char *tap_name,
 
 	pmd->intr_handle.type = RTE_INTR_HANDLE_EXT;
 	pmd->intr_handle.fd = -1;
+	pmd->rx_intr_handle.type = RTE_INTR_HANDLE_VDEV;
+	pmd->rx_intr_handle.fd = -1;
+	dev->intr_handle = &pmd->rx_intr_handle;
 
 	/* Presetup the fds to -1 as being not valid */
 	for (i = 0; i < RTE_PMD_TAP_MAX_QUEUES; i++) {
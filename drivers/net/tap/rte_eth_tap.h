@@ -95,6 +95,7 @@ struct pmd_internals {
 	struct rx_queue rxq[RTE_PMD_TAP_MAX_QUEUES]; /* List of RX queues */
 	struct tx_queue txq[RTE_PMD_TAP_MAX_QUEUES]; /* List of TX queues */
 	struct rte_intr_handle intr_handle;          /* LSC interrupt handle. */
+	struct rte_intr_handle rx_intr_handle;       /* Rx queue intr handle. */
 };
 
 #endif /* _RTE_ETH_TAP_H_ */
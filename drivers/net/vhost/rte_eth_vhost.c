@@ -33,6 +33,9 @@
 #include <unistd.h>
 #include <pthread.h>
 #include <stdbool.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 
 #include <rte_mbuf.h>
 #include <rte_ethdev.h>
@@ -43,6 +46,7 @@
 #include <rte_kvargs.h>
 #include <rte_vhost.h>
 #include <rte_spinlock.h>
+#include <rte_interrupts.h>
 
 #include "rte_eth_vhost.h"
 
@@ -116,6 +120,9 @@ struct pmd_internal {
 	char *iface_name;
 	uint16_t max_queues;
 	rte_atomic32_t started;
+	struct rte_intr_handle intr_handle; /* Rx queue interrupt handle */
+	/* Rx queue event fds while no guest is attached */
+	int detached_efds[RTE_MAX_RXTX_INTR_VEC_ID];
 };
 
 struct internal_list {
@@ -489,6 +496,167 @@ eth_dev_configure(struct rte_eth_dev *dev __rte_unused)
 	return 0;
 }
 
+static void
+eth_vhost_uninstall_intr(struct rte_eth_dev *dev)
+{
+	struct pmd_internal *internal = dev->data->dev_private;
+	struct rte_intr_handle *intr_handle = &internal->intr_handle;
+	unsigned int i;
+
+	rte_intr_free_epoll_fd(intr_handle);
+	for (i = 0; i < intr_handle->nb_efd; i++) {
+		close(internal->detached_efds[i]);
+		internal->detached_efds[i] = -1;
+	}
+	free(intr_handle->intr_vec);
+	intr_handle->intr_vec = NULL;
+	intr_handle->nb_efd = 0;
+	intr_handle->max_intr = 0;
+}
+
+/*
+ * Once notifications are enabled on a vring, the guest kicks the host
+ * through its kickfd, so the kickfd of the guest Tx vring backing each Rx
+ * queue is used as the queue interrupt event fd. The vrings only exist while
+ * a guest is attached, so the vector is installed from the port start to
+ * its stop with an eventfd per queue standing for the kickfd meanwhile.
+ */
+static int
+eth_vhost_install_intr(struct rte_eth_dev *dev)
+{
+	struct pmd_internal *internal = dev->data->dev_private;
+	struct rte_intr_handle *intr_handle = &internal->intr_handle;
+	uint16_t nb_rxq = dev->data->nb_rx_queues;
+	unsigned int i;
+	int ret;
+
+	eth_vhost_uninstall_intr(dev);
+
+	if (nb_rxq > RTE_MAX_RXTX_INTR_VEC_ID) {
+		RTE_LOG(ERR, PMD, "Too many Rx queues for interrupts: %u\n",
+			nb_rxq);
+		return -ENOTSUP;
+	}
+
+	intr_handle->intr_vec = malloc(nb_rxq * sizeof(int));
+	if (intr_handle->intr_vec == NULL) {
+		RTE_LOG(ERR, PMD, "Failed to allocate Rx interrupt vector\n");
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < nb_rxq; i++) {
+		internal->detached_efds[i] = eventfd(0,
+				EFD_NONBLOCK | EFD_CLOEXEC);
+		if (internal->detached_efds[i] < 0) {
+			ret = -errno;
+			RTE_LOG(ERR, PMD, "Failed to create eventfd for rxq "
+				"%u\n", i);
+			intr_handle->nb_efd = i;
+			eth_vhost_uninstall_intr(dev);
+			return ret;
+		}
+		intr_handle->intr_vec[i] = RTE_INTR_VEC_RXTX_OFFSET + i;
+		intr_handle->efds[i] = internal->detached_efds[i];
+	}
+	intr_handle->nb_efd = nb_rxq;
+	intr_handle->max_intr = nb_rxq + 1;
+
+	return 0;
+}
+
+/*
+ * Switch the event fd of each Rx queue to the kickfd of the attached guest,
+ * or back to the eventfd of the queue on detach. An event fd added to an
+ * epoll set by the application is replaced in the same set, and signalled
+ * so that an lcore sleeping on it checks the queue again.
+ */
+static void
+eth_vhost_update_intr(struct rte_eth_dev *dev)
+{
+	struct pmd_internal *internal = dev->data->dev_private;
+	struct rte_intr_handle *intr_handle = &internal->intr_handle;
+	struct rte_epoll_event *rev;
+	struct rte_epoll_data epdata;
+	struct rte_vhost_vring vring;
+	struct vhost_queue *vq;
+	unsigned int i;
+	int fd, epfd;
+
+	for (i = 0; i < intr_handle->nb_efd; i++) {
+		fd = internal->detached_efds[i];
+		vq = dev->data->rx_queues[i];
+		if (vq != NULL && vq->vid >= 0) {
+			if (rte_vhost_get_vhost_vring(vq->vid,
+					vq->virtqueue_id, &vring) == 0 &&
+			    vring.kickfd >= 0)
+				fd = vring.kickfd;
+			else
+				RTE_LOG(INFO, PMD, "No kickfd for rxq %u, "
+					"interrupt unavailable\n", i);
+		}
+		if (fd == intr_handle->efds[i])
+			continue;
+
+		rev = &intr_handle->elist[i];
+		if (rev->status == RTE_EPOLL_INVALID) {
+			intr_handle->efds[i] = fd;
+			continue;
+		}
+		epfd = rev->epfd;
+		epdata = rev->epdata;
+		rte_epoll_ctl(epfd, EPOLL_CTL_DEL, intr_handle->efds[i], rev);
+		intr_handle->efds[i] = fd;
+		rev->epdata = epdata;
+		if (rte_epoll_ctl(epfd, EPOLL_CTL_ADD, fd, rev) < 0) {
+			RTE_LOG(ERR, PMD, "Failed to update interrupt of "
+				"rxq %u\n", i);
+			continue;
+		}
+		eventfd_write(fd, 1);
+	}
+}
+
+static int
+eth_rxq_intr_enable(struct rte_eth_dev *dev, uint16_t qid)
+{
+	struct pmd_internal *internal = dev->data->dev_private;
+	struct rte_intr_handle *intr_handle = &internal->intr_handle;
+	struct vhost_queue *vq = dev->data->rx_queues[qid];
+
+	if (vq == NULL || vq->vid < 0 || qid >= intr_handle->nb_efd)
+		return -EINVAL;
+
+	if (rte_vhost_enable_guest_notification(vq->vid, vq->virtqueue_id,
+						1) < 0)
+		return -EINVAL;
+
+	/*
+	 * The guest does not kick for the buffers it made available before
+	 * it saw notifications enabled, so check the vring once more.
+	 */
+	rte_smp_mb();
+	if (rte_vhost_avail_entries(vq->vid, vq->virtqueue_id) > 0 &&
+	    intr_handle->efds[qid] >= 0)
+		eventfd_write(intr_handle->efds[qid], 1);
+
+	return 0;
+}
+
+static int
+eth_rxq_intr_disable(struct rte_eth_dev *dev, uint16_t qid)
+{
+	struct vhost_queue *vq = dev->data->rx_queues[qid];
+
+	if (vq == NULL || vq->vid < 0)
+		return -EINVAL;
+
+	if (rte_vhost_enable_guest_notification(vq->vid, vq->virtqueue_id,
+						0) < 0)
+		return -EINVAL;
+
+	return 0;
+}
+
 static inline struct internal_list *
 find_internal_resource(char *ifname)
 {
@@ -605,6 +773,8 @@ new_device(int vid)
 	rte_atomic32_set(&internal->dev_attached, 1);
 	update_queuing_status(eth_dev);
 
+	eth_vhost_update_intr(eth_dev);
+
 	RTE_LOG(INFO, PMD, "New connection established\n");
 
 	_rte_eth_dev_callback_process(eth_dev, RTE_ETH_EVENT_INTR_LSC, NULL);
@@ -650,6 +820,8 @@ destroy_device(int vid)
 		vq->vid = -1;
 	}
 
+	eth_vhost_update_intr(eth_dev);
+
 	state = vring_states[eth_dev->data->port_id];
 	rte_spinlock_lock(&state->lock);
 	for (i = 0; i <= state->max_vring; i++) {
@@ -771,6 +943,14 @@ static int
 eth_dev_start(struct rte_eth_dev *dev)
 {
 	struct pmd_internal *internal = dev->data->dev_private;
+	int ret;
+
+	if (dev->data->dev_conf.intr_conf.rxq) {
+		ret = eth_vhost_install_intr(dev);
+		if (ret < 0)
+			return ret;
+		eth_vhost_update_intr(dev);
+	}
 
 	rte_atomic32_set(&internal->started, 1);
 	update_queuing_status(dev);
@@ -785,6 +965,8 @@ eth_dev_stop(struct rte_eth_dev *dev)
 
 	rte_atomic32_set(&internal->started, 0);
 	update_queuing_status(dev);
+
+	eth_vhost_uninstall_intr(dev);
 }
 
 static void
@@ -984,6 +1166,8 @@ static const struct eth_dev_ops ops = {
 	.rx_queue_release = eth_queue_release,
 	.tx_queue_release = eth_queue_release,
 	.tx_done_cleanup = eth_tx_done_cleanup,
+	.rx_queue_intr_enable = eth_rxq_intr_enable,
+	.rx_queue_intr_disable = eth_rxq_intr_disable,
 	.link_update = eth_link_update,
 	.stats_get = eth_stats_get,
 	.stats_reset = eth_stats_reset,
@@ -1071,7 +1255,11 @@ eth_dev_vhost_create(struct rte_vdev_device *dev, char *iface_name,
 	data->dev_flags =
 		RTE_ETH_DEV_DETACHABLE | RTE_ETH_DEV_INTR_LSC;
 
+	internal->intr_handle.type = RTE_INTR_HANDLE_VDEV;
+	internal->intr_handle.fd = -1;
+
 	eth_dev->dev_ops = &ops;
+	eth_dev->intr_handle = &internal->intr_handle;
 
 	/* finally assign rx and tx ops */
 	eth_dev->rx_pkt_burst = eth_vhost_rx;
@@ -266,8 +266,10 @@ virtio_user_fill_intr_handle(struct virtio_user_dev *dev)
 		memset(eth_dev->intr_handle, 0, sizeof(*eth_dev->intr_handle));
 	}
 
+	/* callfds are indexed by vring, the Rx vring of pair i is 2 * i */
 	for (i = 0; i < dev->max_queue_pairs; ++i)
-		eth_dev->intr_handle->efds[i] = dev->callfds[i];
+		eth_dev->intr_handle->efds[i] =
+			dev->callfds[2 * i + VTNET_SQ_RQ_QUEUE_IDX];
 	eth_dev->intr_handle->nb_efd = dev->max_queue_pairs;
 	eth_dev->intr_handle->max_intr = dev->max_queue_pairs + 1;
 	eth_dev->intr_handle->type = RTE_INTR_HANDLE_VDEV;
@@ -1655,6 +1655,7 @@ main(int argc, char **argv)
 	uint32_t dev_rxq_num, dev_txq_num;
 	uint8_t portid, nb_rx_queue, queue, socketid;
 	uint16_t org_rxq_intr = port_conf.intr_conf.rxq;
+	uint16_t org_lsc_intr = port_conf.intr_conf.lsc;
 
 	/* catch SIGINT and restore cpufreq governor to ondemand */
 	signal(SIGINT, signal_exit_now);
@@ -1718,10 +1719,15 @@ main(int argc, char **argv)
 		/* If number of Rx queue is 0, no need to enable Rx interrupt */
 		if (nb_rx_queue == 0)
 			port_conf.intr_conf.rxq = 0;
+		/* Virtual devices may not report link status changes */
+		if (!(rte_eth_devices[portid].data->dev_flags &
+				RTE_ETH_DEV_INTR_LSC))
+			port_conf.intr_conf.lsc = 0;
 		ret = rte_eth_dev_configure(portid, nb_rx_queue,
 					(uint16_t)n_tx_queue, &port_conf);
 		/* Revert to original value */
 		port_conf.intr_conf.rxq = org_rxq_intr;
+		port_conf.intr_conf.lsc = org_lsc_intr;
 		if (ret < 0)
 			rte_exit(EXIT_FAILURE, "Cannot configure device: "
 					"err=%d, port=%d\n", ret, portid);
@@ -416,9 +416,13 @@ rx_thread(struct rte_ring *ring_out)
 				}
 				app_stats.rx.rx_pkts += nb_rx_pkts;
 
-				/* mark sequence number */
-				for (i = 0; i < nb_rx_pkts; )
-					pkts[i++]->seqn = seqn++;
+				/* mark sequence number, if the reorder
+				 * buffer registered the mbuf field */
+				if (!disable_reorder) {
+					for (i = 0; i < nb_rx_pkts; )
+						*rte_reorder_seqn(pkts[i++]) =
+							seqn++;
+				}
 
 				/* enqueue to rx_to_workers ring */
 				ret = rte_ring_enqueue_burst(ring_out,
@@ -72,6 +72,8 @@
 #include <rte_common.h>
 #include <rte_version.h>
 #include <rte_atomic.h>
+#include <rte_service_component.h>
+#include <rte_trace.h>
 #include <malloc_heap.h>
 
 #include "eal_private.h"
@@ -567,6 +569,14 @@ rte_eal_init(int argc, char **argv)
 
 	rte_config_init();
 
+	if (rte_mp_channel_init() < 0) {
+		rte_eal_init_alert("Cannot init multi-process channel\n");
+		if (rte_eal_process_type() == RTE_PROC_PRIMARY) {
+			rte_errno = EFAULT;
+			return -1;
+		}
+	}
+
 	if (rte_eal_memory_init() < 0) {
 		rte_eal_init_alert("Cannot init memory\n");
 		rte_errno = ENOMEM;
@@ -621,7 +631,11 @@ rte_eal_init(int argc, char **argv)
 		return -1;
 	}
 
-	RTE_LCORE_FOREACH_SLAVE(i) {
+	for (i = 0; i < RTE_MAX_LCORE; i++) {
+		/* service lcores need a thread too */
+		if (i == (int)rte_config.master_lcore ||
+				rte_config.lcore_role[i] == ROLE_OFF)
+			continue;
 
 		/*
 		 * create communication pipes between master thread
@@ -653,6 +667,27 @@ rte_eal_init(int argc, char **argv)
 	rte_eal_mp_remote_launch(sync_func, NULL, SKIP_MASTER);
 	rte_eal_mp_wait_lcore();
 
+	/* initialize services so that vdevs can register theirs when probed */
+	ret = rte_service_init();
+	if (ret) {
+		rte_eal_init_alert("rte_service_init() failed\n");
+		rte_errno = -ret;
+		return -1;
+	}
+
+	if (internal_config.log_deferred && rte_log_deferred_enable() < 0) {
+		rte_eal_init_alert("Cannot enable deferred logging\n");
+		rte_errno = ENOMEM;
+		return -1;
+	}
+
+	if (internal_config.trace_regex != NULL &&
+			rte_trace_regexp(internal_config.trace_regex, 1) < 0) {
+		rte_eal_init_alert("Cannot enable tracepoints\n");
+		rte_errno = EINVAL;
+		return -1;
+	}
+
 	/* Probe all the buses and devices/drivers on them */
 	if (rte_bus_probe()) {
 		rte_eal_init_alert("Cannot probe devices\n");
@@ -660,6 +695,13 @@ rte_eal_init(int argc, char **argv)
 		return -1;
 	}
 
+	/* run the services on the service lcores given with -s or -S */
+	ret = rte_service_start_with_defaults();
+	if (ret < 0 && ret != -ENOTSUP) {
+		rte_errno = -ret;
+		return -1;
+	}
+
 	rte_eal_mcfg_complete();
 
 	return fctret;
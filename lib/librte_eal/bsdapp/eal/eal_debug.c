@@ -81,6 +81,7 @@ void __rte_panic(const char *funcname, const char *format, ...)
 {
 	va_list ap;
 
+	rte_log_deferred_flush();
 	rte_log(RTE_LOG_CRIT, RTE_LOGTYPE_EAL, "PANIC in %s():\n", funcname);
 	va_start(ap, format);
 	rte_vlog(RTE_LOG_CRIT, RTE_LOGTYPE_EAL, format, ap);
@@ -99,6 +100,8 @@ rte_exit(int exit_code, const char *format, ...)
 {
 	va_list ap;
 
+	rte_log_deferred_flush();
+
 	if (exit_code != 0)
 		RTE_LOG(CRIT, EAL, "Error - exiting with code: %d\n"
 				"  Cause: ", exit_code);
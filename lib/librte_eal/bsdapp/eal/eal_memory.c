@@ -192,3 +192,21 @@ rte_eal_hugepage_attach(void)
 		close(fd_hugepage);
 	return -1;
 }
+
+/* contigmem buffers are all mapped at init, there is no memory hotplug */
+int
+eal_memseg_hotplug_add(int socket_id __rte_unused, size_t len __rte_unused)
+{
+	return -1;
+}
+
+int
+eal_memseg_hotplug_remove(struct rte_memseg *ms __rte_unused)
+{
+	return -1;
+}
+
+void
+eal_memseg_hotplug_sync(void)
+{
+}
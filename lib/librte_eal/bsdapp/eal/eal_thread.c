@@ -133,7 +133,11 @@ eal_thread_loop(__attribute__((unused)) void *arg)
 	thread_id = pthread_self();
 
 	/* retrieve our lcore_id from the configuration structure */
-	RTE_LCORE_FOREACH_SLAVE(lcore_id) {
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		/* service lcores are not enabled but have a thread too */
+		if (rte_eal_get_configuration()->lcore_role[lcore_id] ==
+				ROLE_OFF)
+			continue;
 		if (thread_id == lcore_config[lcore_id].thread_id)
 			break;
 	}
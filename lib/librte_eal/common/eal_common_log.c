@@ -33,6 +33,8 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <stddef.h>
+#include <inttypes.h>
 #include <stdarg.h>
 #include <stdlib.h>
 #include <string.h>
@@ -42,6 +44,11 @@
 #include <rte_eal.h>
 #include <rte_log.h>
 #include <rte_per_lcore.h>
+#include <rte_lcore.h>
+#include <rte_cycles.h>
+#include <rte_spinlock.h>
+#include <rte_malloc.h>
+#include <rte_service_component.h>
 
 #include "eal_private.h"
 
@@ -72,6 +79,95 @@ struct rte_log_dynamic_type {
  /* per core log */
 static RTE_DEFINE_PER_LCORE(struct log_cur_msg, log_cur_msg);
 
+#define LOG_DEFERRED_RING_MASK (RTE_LOG_DEFERRED_RING_SIZE - 1)
+#define LOG_DEFERRED_MAX_ARGS 12
+/* format and string arguments, a record fills 6 cache lines */
+#define LOG_DEFERRED_TEXT_SIZE 248
+#define LOG_DEFERRED_LINE_MAX 1024
+/* messages formatted by the caller and waiting for a flush */
+#define LOG_DEFERRED_LINES 64
+#define LOG_DEFERRED_LINES_MASK (LOG_DEFERRED_LINES - 1)
+/* longest conversion specification handled in deferred mode */
+#define LOG_SPEC_MAX 24
+
+/* types of the arguments of a deferred message */
+enum log_arg_type {
+	LOG_ARG_INT,
+	LOG_ARG_LONG,
+	LOG_ARG_LLONG,
+	LOG_ARG_INTMAX,
+	LOG_ARG_SIZE,
+	LOG_ARG_PTRDIFF,
+	LOG_ARG_DOUBLE,
+	LOG_ARG_LDOUBLE,
+	LOG_ARG_PTR,
+	LOG_ARG_STR,
+};
+
+/*
+ * A message logged in deferred mode. The format and the strings are copied
+ * in text, the other arguments are stored in binary.
+ */
+struct log_record {
+	uint64_t tsc;
+	uint32_t loglevel;
+	uint32_t logtype;
+	uint8_t nb_args;
+	uint8_t arg_types[LOG_DEFERRED_MAX_ARGS];
+	union {
+		int64_t i;
+		double d;
+		const void *p;
+		uint32_t str_off; /**< offset of a string in text */
+	} args[LOG_DEFERRED_MAX_ARGS];
+	char text[LOG_DEFERRED_TEXT_SIZE]; /**< format, then the strings */
+} __rte_cache_aligned;
+
+/* single producer, single consumer ring of the messages of an lcore */
+struct log_ring {
+	volatile uint32_t head; /**< written by the lcore */
+	uint64_t dropped;       /**< messages dropped as the ring was full */
+	volatile uint32_t tail __rte_cache_aligned; /**< written on flush */
+	struct log_record records[RTE_LOG_DEFERRED_RING_SIZE];
+};
+
+/* a message which cannot be stored in a record, formatted by the caller */
+struct log_line {
+	uint64_t tsc;
+	uint32_t loglevel;
+	uint32_t logtype;
+	char text[LOG_DEFERRED_LINE_MAX];
+};
+
+/* multi producer ring of the formatted messages */
+struct log_line_ring {
+	rte_spinlock_t lock;    /**< serializes the producers */
+	volatile uint32_t head;
+	volatile uint32_t tail __rte_cache_aligned; /**< written on flush */
+	struct log_line lines[LOG_DEFERRED_LINES];
+};
+
+static struct {
+	volatile int enabled;
+	int atexit_registered;
+	int service_registered;
+	uint32_t service_id;
+	rte_spinlock_t lock; /**< serializes the flushes */
+	struct log_ring *rings[RTE_MAX_LCORE];
+	struct log_line_ring *lines;
+} log_deferred = {
+	.lock = RTE_SPINLOCK_INITIALIZER,
+};
+
+/* a conversion specification of a printf format */
+struct log_spec {
+	const char *end;      /**< after the conversion character */
+	uint8_t star_width;   /**< width given as an int argument */
+	uint8_t star_prec;    /**< precision given as an int argument */
+	int precision;        /**< precision, -1 if none or given with '*' */
+	enum log_arg_type type;
+};
+
 /* default logs */
 
 /* Change the stream that will be used by logging system */
@@ -338,16 +434,22 @@ rte_log_dump(FILE *f)
 			i, rte_logs.dynamic_types[i].name,
 			loglevel_to_string(rte_logs.dynamic_types[i].loglevel));
 	}
+
+	if (log_deferred.enabled) {
+		uint64_t dropped = 0;
+
+		for (i = 0; i < RTE_MAX_LCORE; i++)
+			if (log_deferred.rings[i] != NULL)
+				dropped += log_deferred.rings[i]->dropped;
+		fprintf(f, "deferred logging enabled, %"PRIu64
+			" messages dropped\n", dropped);
+	}
 }
 
-/*
- * Generates a log message The message will be sent in the stream
- * defined by the previous call to rte_openlog_stream().
- */
-int
-rte_vlog(uint32_t level, uint32_t logtype, const char *format, va_list ap)
+/* stream defined by rte_openlog_stream(), or the default one */
+static FILE *
+log_stream_get(void)
 {
-	int ret;
 	FILE *f = rte_logs.file;
 	if (f == NULL) {
 		f = default_log_stream;
@@ -362,6 +464,559 @@ rte_vlog(uint32_t level, uint32_t logtype, const char *format, va_list ap)
 			f = stderr;
 		}
 	}
+	return f;
+}
+
+/*
+ * Parse the conversion specification starting with the '%' at p.
+ * Returns -1 for specifications not handled in deferred mode: positional
+ * arguments, wide characters and %n.
+ */
+static int
+log_parse_spec(const char *p, struct log_spec *spec)
+{
+	const char *start = p;
+	char length = 0;
+
+	spec->star_width = 0;
+	spec->star_prec = 0;
+	spec->precision = -1;
+
+	/* flags */
+	for (p++; *p == '-' || *p == '+' || *p == ' ' || *p == '#' ||
+			*p == '0' || *p == '\''; p++)
+		;
+	/* width */
+	if (*p == '*') {
+		spec->star_width = 1;
+		p++;
+	} else {
+		while (*p >= '0' && *p <= '9')
+			p++;
+	}
+	if (*p == '$')
+		return -1;
+	/* precision */
+	if (*p == '.') {
+		p++;
+		if (*p == '*') {
+			spec->star_prec = 1;
+			p++;
+		} else {
+			spec->precision = 0;
+			while (*p >= '0' && *p <= '9')
+				spec->precision = spec->precision * 10 +
+					*p++ - '0';
+		}
+	}
+	/* length modifier, 'H' for hh and 'q' for ll */
+	switch (*p) {
+	case 'h':
+		length = 'h';
+		if (*++p == 'h') {
+			length = 'H';
+			p++;
+		}
+		break;
+	case 'l':
+		length = 'l';
+		if (*++p == 'l') {
+			length = 'q';
+			p++;
+		}
+		break;
+	case 'q': case 'L': case 'j': case 'z': case 't':
+		length = *p++;
+		break;
+	}
+	/* conversion */
+	switch (*p) {
+	case 'd': case 'i': case 'o': case 'u': case 'x': case 'X': case 'c':
+		if (*p == 'c' && length != 0)
+			return -1;
+		switch (length) {
+		case 'l': spec->type = LOG_ARG_LONG; break;
+		case 'q': spec->type = LOG_ARG_LLONG; break;
+		case 'j': spec->type = LOG_ARG_INTMAX; break;
+		case 'z': spec->type = LOG_ARG_SIZE; break;
+		case 't': spec->type = LOG_ARG_PTRDIFF; break;
+		case 'L': return -1;
+		default: spec->type = LOG_ARG_INT; break;
+		}
+		break;
+	case 'e': case 'E': case 'f': case 'F':
+	case 'g': case 'G': case 'a': case 'A':
+		if (length == 'L')
+			spec->type = LOG_ARG_LDOUBLE;
+		else if (length == 0 || length == 'l')
+			spec->type = LOG_ARG_DOUBLE;
+		else
+			return -1;
+		break;
+	case 's':
+		if (length != 0)
+			return -1;
+		spec->type = LOG_ARG_STR;
+		break;
+	case 'p':
+		if (length != 0)
+			return -1;
+		spec->type = LOG_ARG_PTR;
+		break;
+	default:
+		return -1;
+	}
+
+	spec->end = p + 1;
+	if (spec->end - start > LOG_SPEC_MAX)
+		return -1;
+	return 0;
+}
+
+/*
+ * Store the format and the arguments of a message in a record, returns -1
+ * if the message cannot be deferred or does not fit.
+ */
+static int
+log_record_fill(struct log_record *rec, const char *format, va_list ap)
+{
+	struct log_spec spec;
+	const char *p = format;
+	unsigned int n = 0;
+	size_t str_off;
+
+	/* the format may be built at runtime, it is copied */
+	str_off = strnlen(format, LOG_DEFERRED_TEXT_SIZE) + 1;
+	if (str_off > LOG_DEFERRED_TEXT_SIZE)
+		return -1;
+	memcpy(rec->text, format, str_off);
+
+	while ((p = strchr(p, '%')) != NULL) {
+		if (p[1] == '%') {
+			p += 2;
+			continue;
+		}
+		if (log_parse_spec(p, &spec) < 0)
+			return -1;
+		p = spec.end;
+
+		if (n + spec.star_width + spec.star_prec >=
+				LOG_DEFERRED_MAX_ARGS)
+			return -1;
+		if (spec.star_width) {
+			rec->arg_types[n] = LOG_ARG_INT;
+			rec->args[n++].i = va_arg(ap, int);
+		}
+		if (spec.star_prec) {
+			rec->arg_types[n] = LOG_ARG_INT;
+			spec.precision = va_arg(ap, int);
+			rec->args[n++].i = spec.precision;
+		}
+
+		rec->arg_types[n] = spec.type;
+		switch (spec.type) {
+		case LOG_ARG_INT:
+			rec->args[n].i = va_arg(ap, int);
+			break;
+		case LOG_ARG_LONG:
+			rec->args[n].i = va_arg(ap, long);
+			break;
+		case LOG_ARG_LLONG:
+			rec->args[n].i = va_arg(ap, long long);
+			break;
+		case LOG_ARG_INTMAX:
+			rec->args[n].i = va_arg(ap, intmax_t);
+			break;
+		case LOG_ARG_SIZE:
+			rec->args[n].i = va_arg(ap, size_t);
+			break;
+		case LOG_ARG_PTRDIFF:
+			rec->args[n].i = va_arg(ap, ptrdiff_t);
+			break;
+		case LOG_ARG_DOUBLE:
+			rec->args[n].d = va_arg(ap, double);
+			break;
+		case LOG_ARG_LDOUBLE:
+			rec->args[n].d = va_arg(ap, long double);
+			break;
+		case LOG_ARG_PTR:
+			rec->args[n].p = va_arg(ap, void *);
+			break;
+		case LOG_ARG_STR: {
+			/* copy the string, a longer one is written at once */
+			const char *str = va_arg(ap, const char *);
+			size_t max = LOG_DEFERRED_TEXT_SIZE - str_off;
+			size_t len;
+
+			if (str == NULL)
+				str = "(null)";
+			len = strnlen(str, max);
+			if (spec.precision >= 0 && (size_t)spec.precision < len)
+				len = spec.precision;
+			else if (len == max)
+				return -1;
+			memcpy(&rec->text[str_off], str, len);
+			rec->text[str_off + len] = '\0';
+			rec->args[n].str_off = str_off;
+			str_off += len + 1;
+			break;
+		}
+		}
+		n++;
+	}
+
+	rec->nb_args = n;
+	return 0;
+}
+
+/* snprintf() of one argument, with a format built at runtime */
+static int
+log_snprintf(char *buf, size_t size, const char *format, ...)
+{
+	va_list ap;
+	int ret;
+
+	va_start(ap, format);
+	ret = vsnprintf(buf, size, format, ap);
+	va_end(ap);
+	return ret;
+}
+
+/* format a record in buf, returns the length of the message */
+static size_t
+log_record_format(const struct log_record *rec, char *buf, size_t size)
+{
+	const char *p = rec->text;
+	struct log_spec spec;
+	unsigned int n = 0;
+	size_t off = 0;
+	size_t len;
+	int ret;
+
+	while (*p != '\0' && off < size - 1) {
+		char sub[LOG_SPEC_MAX + 32];
+		const char *pct = strchr(p, '%');
+		const char *q;
+
+		if (pct == NULL)
+			pct = p + strlen(p);
+
+		/* literal text up to the next conversion */
+		len = RTE_MIN((size_t)(pct - p), size - 1 - off);
+		memcpy(buf + off, p, len);
+		off += len;
+		if (*pct == '\0')
+			break;
+		if (pct[1] == '%') {
+			buf[off++] = '%';
+			p = pct + 2;
+			continue;
+		}
+
+		/* already checked when the record was filled */
+		log_parse_spec(pct, &spec);
+		p = spec.end;
+
+		/* copy the specification, with the '*' replaced by values */
+		len = 0;
+		for (q = pct; q < spec.end; q++) {
+			if (*q == '*')
+				len += snprintf(sub + len, sizeof(sub) - len,
+					"%d", (int)rec->args[n++].i);
+			else if (*q != 'L')
+				sub[len++] = *q;
+		}
+		sub[len] = '\0';
+
+		switch (rec->arg_types[n]) {
+		case LOG_ARG_INT:
+			ret = log_snprintf(buf + off, size - off, sub,
+				(int)rec->args[n].i);
+			break;
+		case LOG_ARG_LONG:
+			ret = log_snprintf(buf + off, size - off, sub,
+				(long)rec->args[n].i);
+			break;
+		case LOG_ARG_LLONG:
+			ret = log_snprintf(buf + off, size - off, sub,
+				(long long)rec->args[n].i);
+			break;
+		case LOG_ARG_INTMAX:
+			ret = log_snprintf(buf + off, size - off, sub,
+				(intmax_t)rec->args[n].i);
+			break;
+		case LOG_ARG_SIZE:
+			ret = log_snprintf(buf + off, size - off, sub,
+				(size_t)rec->args[n].i);
+			break;
+		case LOG_ARG_PTRDIFF:
+			ret = log_snprintf(buf + off, size - off, sub,
+				(ptrdiff_t)rec->args[n].i);
+			break;
+		case LOG_ARG_DOUBLE:
+		case LOG_ARG_LDOUBLE:
+			ret = log_snprintf(buf + off, size - off, sub,
+				rec->args[n].d);
+			break;
+		case LOG_ARG_PTR:
+			ret = log_snprintf(buf + off, size - off, sub,
+				rec->args[n].p);
+			break;
+		case LOG_ARG_STR:
+			ret = log_snprintf(buf + off, size - off, sub,
+				&rec->text[rec->args[n].str_off]);
+			break;
+		default:
+			ret = 0;
+			break;
+		}
+		n++;
+		if (ret > 0)
+			off = RTE_MIN(off + ret, size - 1);
+	}
+
+	buf[off] = '\0';
+	return off;
+}
+
+/*
+ * Store a message in the ring of the lcore, it is formatted on flush.
+ * Returns 0, -1 if it is dropped, or -2 if it cannot be stored.
+ */
+static int
+log_deferred_push(struct log_ring *r, uint32_t level, uint32_t logtype,
+		const char *format, va_list ap)
+{
+	uint32_t head = r->head;
+	struct log_record *rec;
+	va_list aq;
+	int ret;
+
+	if (head - r->tail >= RTE_LOG_DEFERRED_RING_SIZE) {
+		r->dropped++;
+		return -1;
+	}
+
+	rec = &r->records[head & LOG_DEFERRED_RING_MASK];
+	va_copy(aq, ap);
+	ret = log_record_fill(rec, format, aq);
+	va_end(aq);
+	if (ret < 0)
+		return -2;
+
+	rec->tsc = rte_rdtsc();
+	rec->loglevel = level;
+	rec->logtype = logtype;
+
+	rte_smp_wmb();
+	r->head = head + 1;
+	return 0;
+}
+
+/*
+ * Format a message which cannot be stored in the ring of an lcore, and
+ * queue it for the flush to keep the messages in order. Returns 0, or -2
+ * if the message is too long or the ring is full.
+ */
+static int
+log_deferred_line_push(struct log_line_ring *r, uint32_t level,
+		uint32_t logtype, const char *format, va_list ap)
+{
+	struct log_line *line;
+	uint32_t head;
+	va_list aq;
+	int ret;
+
+	rte_spinlock_lock(&r->lock);
+	head = r->head;
+	if (head - r->tail >= LOG_DEFERRED_LINES) {
+		rte_spinlock_unlock(&r->lock);
+		return -2;
+	}
+
+	line = &r->lines[head & LOG_DEFERRED_LINES_MASK];
+	va_copy(aq, ap);
+	ret = vsnprintf(line->text, sizeof(line->text), format, aq);
+	va_end(aq);
+	if (ret < 0 || ret >= (int)sizeof(line->text)) {
+		rte_spinlock_unlock(&r->lock);
+		return -2;
+	}
+
+	/* time stamped in the lock, the lines are in time order */
+	line->tsc = rte_rdtsc();
+	line->loglevel = level;
+	line->logtype = logtype;
+
+	rte_smp_wmb();
+	r->head = head + 1;
+	rte_spinlock_unlock(&r->lock);
+	return 0;
+}
+
+int
+rte_log_deferred_flush(void)
+{
+	struct log_line_ring *lr = log_deferred.lines;
+	char line[LOG_DEFERRED_LINE_MAX];
+	unsigned int i, count = 0, max;
+	FILE *f;
+
+	rte_spinlock_lock(&log_deferred.lock);
+
+	/* do not loop forever on lcores which keep logging */
+	max = lr != NULL ? LOG_DEFERRED_LINES : 0;
+	for (i = 0; i < RTE_MAX_LCORE; i++)
+		if (log_deferred.rings[i] != NULL)
+			max += RTE_LOG_DEFERRED_RING_SIZE;
+
+	while (count < max) {
+		struct log_ring *oldest = NULL;
+		const struct log_record *rec = NULL;
+		const struct log_line *ll = NULL;
+
+		/* write the messages of all lcores in time order */
+		for (i = 0; i < RTE_MAX_LCORE; i++) {
+			struct log_ring *r = log_deferred.rings[i];
+			const struct log_record *cur;
+
+			if (r == NULL || r->tail == r->head)
+				continue;
+			rte_smp_rmb();
+			cur = &r->records[r->tail & LOG_DEFERRED_RING_MASK];
+			if (rec == NULL || cur->tsc < rec->tsc) {
+				oldest = r;
+				rec = cur;
+			}
+		}
+		if (lr != NULL && lr->tail != lr->head) {
+			rte_smp_rmb();
+			ll = &lr->lines[lr->tail & LOG_DEFERRED_LINES_MASK];
+			if (rec != NULL && rec->tsc < ll->tsc)
+				ll = NULL;
+		}
+
+		f = log_stream_get();
+		if (ll != NULL) {
+			/* already formatted, written from its slot */
+			RTE_PER_LCORE(log_cur_msg).loglevel = ll->loglevel;
+			RTE_PER_LCORE(log_cur_msg).logtype = ll->logtype;
+			fputs(ll->text, f);
+			rte_smp_rmb();
+			lr->tail++;
+		} else if (oldest != NULL) {
+			log_record_format(rec, line, sizeof(line));
+			RTE_PER_LCORE(log_cur_msg).loglevel = rec->loglevel;
+			RTE_PER_LCORE(log_cur_msg).logtype = rec->logtype;
+
+			/* read the record before giving its slot back */
+			rte_smp_rmb();
+			oldest->tail++;
+			fputs(line, f);
+		} else {
+			break;
+		}
+		fflush(f);
+		count++;
+	}
+
+	rte_spinlock_unlock(&log_deferred.lock);
+	return count;
+}
+
+static int32_t
+log_deferred_service(void *args __rte_unused)
+{
+	rte_log_deferred_flush();
+	return 0;
+}
+
+/* write the pending messages when the process exits */
+static void
+log_deferred_atexit(void)
+{
+	if (log_deferred.enabled)
+		rte_log_deferred_flush();
+}
+
+int
+rte_log_deferred_enable(void)
+{
+	struct rte_config *cfg = rte_eal_get_configuration();
+	unsigned int i;
+
+	if (log_deferred.enabled)
+		return -EALREADY;
+
+	/* rings are kept when disabled, lcores may still be using them */
+	if (log_deferred.lines == NULL) {
+		log_deferred.lines = rte_zmalloc("log_lines",
+				sizeof(struct log_line_ring),
+				RTE_CACHE_LINE_SIZE);
+		if (log_deferred.lines == NULL)
+			return -ENOMEM;
+		rte_spinlock_init(&log_deferred.lines->lock);
+	}
+	for (i = 0; i < RTE_MAX_LCORE; i++) {
+		if (cfg->lcore_role[i] == ROLE_OFF ||
+				log_deferred.rings[i] != NULL)
+			continue;
+		log_deferred.rings[i] = rte_zmalloc_socket("log_ring",
+				sizeof(struct log_ring), RTE_CACHE_LINE_SIZE,
+				rte_lcore_to_socket_id(i));
+		if (log_deferred.rings[i] == NULL)
+			return -ENOMEM;
+	}
+
+	if (!log_deferred.atexit_registered &&
+			atexit(log_deferred_atexit) == 0)
+		log_deferred.atexit_registered = 1;
+
+	if (!log_deferred.service_registered) {
+		struct rte_service_spec service;
+
+		memset(&service, 0, sizeof(service));
+		snprintf(service.name, sizeof(service.name), "log");
+		service.callback = log_deferred_service;
+		service.socket_id = SOCKET_ID_ANY;
+		/* without service lcores the application flushes the logs */
+		if (rte_service_component_register(&service,
+				&log_deferred.service_id) == 0)
+			log_deferred.service_registered = 1;
+	}
+
+	rte_smp_wmb();
+	log_deferred.enabled = 1;
+	if (log_deferred.service_registered)
+		rte_service_component_runstate_set(log_deferred.service_id, 1);
+
+	return 0;
+}
+
+int
+rte_log_deferred_disable(void)
+{
+	if (!log_deferred.enabled)
+		return -EALREADY;
+
+	log_deferred.enabled = 0;
+	rte_smp_wmb();
+	if (log_deferred.service_registered)
+		rte_service_component_runstate_set(log_deferred.service_id, 0);
+	rte_log_deferred_flush();
+
+	return 0;
+}
+
+/*
+ * Generates a log message The message will be sent in the stream
+ * defined by the previous call to rte_openlog_stream().
+ */
+int
+rte_vlog(uint32_t level, uint32_t logtype, const char *format, va_list ap)
+{
+	int ret;
+	FILE *f;
 
 	if (level > rte_logs.level)
 		return 0;
@@ -370,6 +1025,31 @@ rte_vlog(uint32_t level, uint32_t logtype, const char *format, va_list ap)
 	if (level > rte_logs.dynamic_types[logtype].loglevel)
 		return 0;
 
+	/* critical messages are written at once, the process may die */
+	if (log_deferred.enabled && level > RTE_LOG_CRIT) {
+		unsigned int lcore_id = rte_lcore_id();
+
+		if (lcore_id < RTE_MAX_LCORE &&
+				log_deferred.rings[lcore_id] != NULL) {
+			ret = log_deferred_push(log_deferred.rings[lcore_id],
+					level, logtype, format, ap);
+			if (ret != -2)
+				return ret;
+		}
+
+		/* formatted now, but written by the flush to keep the order */
+		ret = log_deferred_line_push(log_deferred.lines, level,
+				logtype, format, ap);
+		if (ret != -2)
+			return ret;
+	}
+
+	/* keep the messages in order, rare unless the message is critical */
+	if (log_deferred.enabled)
+		rte_log_deferred_flush();
+
+	f = log_stream_get();
+
 	/* save loglevel and logtype in a global per-lcore variable */
 	RTE_PER_LCORE(log_cur_msg).loglevel = level;
 	RTE_PER_LCORE(log_cur_msg).logtype = logtype;
@@ -366,6 +366,9 @@ rte_memzone_lookup(const char *name)
 
 	mcfg = rte_eal_get_configuration()->mem_config;
 
+	/* the memzone may be in a memseg hotplugged by the primary process */
+	eal_memseg_hotplug_sync();
+
 	rte_rwlock_read_lock(&mcfg->mlock);
 
 	memzone = memzone_lookup_thread_unsafe(name);
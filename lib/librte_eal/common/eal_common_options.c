@@ -67,6 +67,8 @@ eal_short_options[] =
 	"m:" /* memory size */
 	"n:" /* memory channels */
 	"r:" /* memory ranks */
+	"s:" /* service coremask */
+	"S:" /* service corelist */
 	"v"  /* version */
 	"w:" /* pci-whitelist */
 	;
@@ -79,9 +81,12 @@ eal_long_options[] = {
 	{OPT_HELP,              0, NULL, OPT_HELP_NUM             },
 	{OPT_HUGE_DIR,          1, NULL, OPT_HUGE_DIR_NUM         },
 	{OPT_HUGE_UNLINK,       0, NULL, OPT_HUGE_UNLINK_NUM      },
+	{OPT_IN_MEMORY,         0, NULL, OPT_IN_MEMORY_NUM        },
 	{OPT_LCORES,            1, NULL, OPT_LCORES_NUM           },
+	{OPT_LOG_DEFERRED,      0, NULL, OPT_LOG_DEFERRED_NUM     },
 	{OPT_LOG_LEVEL,         1, NULL, OPT_LOG_LEVEL_NUM        },
 	{OPT_MASTER_LCORE,      1, NULL, OPT_MASTER_LCORE_NUM     },
+	{OPT_MEM_HOTPLUG,       0, NULL, OPT_MEM_HOTPLUG_NUM      },
 	{OPT_NO_HPET,           0, NULL, OPT_NO_HPET_NUM          },
 	{OPT_NO_HUGE,           0, NULL, OPT_NO_HUGE_NUM          },
 	{OPT_NO_PCI,            0, NULL, OPT_NO_PCI_NUM           },
@@ -91,6 +96,7 @@ eal_long_options[] = {
 	{OPT_PROC_TYPE,         1, NULL, OPT_PROC_TYPE_NUM        },
 	{OPT_SOCKET_MEM,        1, NULL, OPT_SOCKET_MEM_NUM       },
 	{OPT_SYSLOG,            1, NULL, OPT_SYSLOG_NUM           },
+	{OPT_TRACE,             1, NULL, OPT_TRACE_NUM            },
 	{OPT_VDEV,              1, NULL, OPT_VDEV_NUM             },
 	{OPT_VFIO_INTR,         1, NULL, OPT_VFIO_INTR_NUM        },
 	{OPT_VMWARE_TSC_MAP,    0, NULL, OPT_VMWARE_TSC_MAP_NUM   },
@@ -127,6 +133,8 @@ static const char dpdk_solib_path[] __attribute__((used)) =
 static int master_lcore_parsed;
 static int mem_parsed;
 static int core_parsed;
+/* lcores given with -s or -S, made service lcores by eal_adjust_config() */
+static uint8_t service_lcores[RTE_MAX_LCORE];
 
 void
 eal_reset_internal_config(struct internal_config *internal_cfg)
@@ -138,6 +146,7 @@ eal_reset_internal_config(struct internal_config *internal_cfg)
 	internal_cfg->force_nchannel = 0;
 	internal_cfg->hugefile_prefix = HUGEFILE_PREFIX_DEFAULT;
 	internal_cfg->hugepage_dir = NULL;
+	internal_cfg->trace_regex = NULL;
 	internal_cfg->force_sockets = 0;
 	/* zero out the NUMA config */
 	for (i = 0; i < RTE_MAX_NUMA_NODES; i++)
@@ -395,6 +404,98 @@ eal_parse_corelist(const char *corelist)
 	return 0;
 }
 
+static int
+eal_parse_service_coremask(const char *coremask)
+{
+	int i, j, idx = 0;
+	unsigned int count = 0;
+	char c;
+	int val;
+
+	if (coremask == NULL)
+		return -1;
+	/* Remove all blank characters ahead and after .
+	 * Remove 0x/0X if exists.
+	 */
+	while (isblank(*coremask))
+		coremask++;
+	if (coremask[0] == '0' && ((coremask[1] == 'x')
+		|| (coremask[1] == 'X')))
+		coremask += 2;
+	i = strlen(coremask);
+	while ((i > 0) && isblank(coremask[i - 1]))
+		i--;
+	if (i == 0)
+		return -1;
+
+	memset(service_lcores, 0, sizeof(service_lcores));
+	for (i = i - 1; i >= 0 && idx < RTE_MAX_LCORE; i--) {
+		c = coremask[i];
+		if (isxdigit(c) == 0)
+			return -1;
+		val = xdigit2val(c);
+		for (j = 0; j < BITS_PER_HEX && idx < RTE_MAX_LCORE;
+				j++, idx++) {
+			if ((1 << j) & val) {
+				service_lcores[idx] = 1;
+				count++;
+			}
+		}
+	}
+	for (; i >= 0; i--)
+		if (coremask[i] != '0')
+			return -1;
+	if (count == 0)
+		return -1;
+	return 0;
+}
+
+static int
+eal_parse_service_corelist(const char *corelist)
+{
+	unsigned int count = 0;
+	char *end = NULL;
+	int min, max, idx;
+
+	if (corelist == NULL)
+		return -1;
+
+	memset(service_lcores, 0, sizeof(service_lcores));
+	min = RTE_MAX_LCORE;
+	do {
+		while (isblank(*corelist))
+			corelist++;
+		if (*corelist == '\0')
+			return -1;
+		errno = 0;
+		idx = strtoul(corelist, &end, 10);
+		if (errno || end == NULL || idx >= RTE_MAX_LCORE)
+			return -1;
+		while (isblank(*end))
+			end++;
+		if (*end == '-') {
+			min = idx;
+		} else if ((*end == ',') || (*end == '\0')) {
+			max = idx;
+			if (min == RTE_MAX_LCORE)
+				min = idx;
+			for (idx = min; idx <= max; idx++) {
+				if (!service_lcores[idx]) {
+					service_lcores[idx] = 1;
+					count++;
+				}
+			}
+			min = RTE_MAX_LCORE;
+		} else
+			return -1;
+		corelist = end + 1;
+	} while (*end != '\0');
+
+	if (count == 0)
+		return -1;
+	return 0;
+}
+
 /* Changes the lcore id of the master thread */
 static int
 eal_parse_master_lcore(const char *arg)
@@ -826,6 +927,20 @@ eal_parse_common_option(int opt, const char *optarg,
 		}
 		core_parsed = 1;
 		break;
+	/* service coremask */
+	case 's':
+		if (eal_parse_service_coremask(optarg) < 0) {
+			RTE_LOG(ERR, EAL, "invalid service coremask\n");
+			return -1;
+		}
+		break;
+	/* service corelist */
+	case 'S':
+		if (eal_parse_service_corelist(optarg) < 0) {
+			RTE_LOG(ERR, EAL, "invalid service core list\n");
+			return -1;
+		}
+		break;
 	/* size of memory */
 	case 'm':
 		conf->memory = atoi(optarg);
@@ -868,10 +983,20 @@ eal_parse_common_option(int opt, const char *optarg,
 		conf->hugepage_unlink = 1;
 		break;
 
+	case OPT_IN_MEMORY_NUM:
+		conf->in_memory = 1;
+		/* in-memory is a superset of no-shconf */
+		conf->no_shconf = 1;
+		break;
+
 	case OPT_NO_HUGE_NUM:
 		conf->no_hugetlbfs = 1;
 		break;
 
+	case OPT_MEM_HOTPLUG_NUM:
+		conf->mem_hotplug = 1;
+		break;
+
 	case OPT_NO_PCI_NUM:
 		conf->no_pci = 1;
 		break;
@@ -915,6 +1040,14 @@ eal_parse_common_option(int opt, const char *optarg,
 		}
 		break;
 
+	case OPT_LOG_DEFERRED_NUM:
+		conf->log_deferred = 1;
+		break;
+
+	case OPT_TRACE_NUM:
+		conf->trace_regex = optarg;
+		break;
+
 	case OPT_LOG_LEVEL_NUM: {
 		if (eal_parse_log_level(optarg) < 0) {
 			RTE_LOG(ERR, EAL,
@@ -965,6 +1098,34 @@ eal_auto_detect_cores(struct rte_config *cfg)
 	cfg->lcore_count -= removed;
 }
 
+/* turn the lcores given with -s or -S into service lcores */
+static int
+eal_set_service_lcores(struct rte_config *cfg)
+{
+	unsigned int lcore_id;
+
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		if (!service_lcores[lcore_id])
+			continue;
+		if (cfg->lcore_role[lcore_id] != ROLE_RTE ||
+				(master_lcore_parsed &&
+				 lcore_id == cfg->master_lcore)) {
+			RTE_LOG(ERR, EAL, "lcore %u cannot be a service lcore\n",
+				lcore_id);
+			return -1;
+		}
+		cfg->lcore_role[lcore_id] = ROLE_SERVICE;
+		cfg->lcore_count--;
+	}
+
+	if (cfg->lcore_count == 0) {
+		RTE_LOG(ERR, EAL, "No lcore left for the application\n");
+		return -1;
+	}
+
+	return 0;
+}
+
 int
 eal_adjust_config(struct internal_config *internal_cfg)
 {
@@ -974,7 +1135,14 @@ eal_adjust_config(struct internal_config *internal_cfg)
 	if (!core_parsed)
 		eal_auto_detect_cores(cfg);
 
-	if (internal_config.process_type == RTE_PROC_AUTO)
+	if (eal_set_service_lcores(cfg) < 0)
+		return -1;
+
+	/* an in-memory process has no runtime config file to look for */
+	if (internal_config.process_type == RTE_PROC_AUTO &&
+			internal_config.in_memory)
+		internal_config.process_type = RTE_PROC_PRIMARY;
+	else if (internal_config.process_type == RTE_PROC_AUTO)
 		internal_config.process_type = eal_proc_type_detect();
 
 	/* default master lcore is the first one */
@@ -1025,6 +1193,13 @@ eal_check_common_options(struct internal_config *internal_cfg)
 		return -1;
 	}
 
+	if (internal_cfg->in_memory &&
+			internal_cfg->process_type == RTE_PROC_SECONDARY) {
+		RTE_LOG(ERR, EAL, "Option --"OPT_IN_MEMORY" cannot "
+			"be used with a secondary process\n");
+		return -1;
+	}
+
 	if (rte_eal_devargs_type_count(RTE_DEVTYPE_WHITELISTED_PCI) != 0 &&
 		rte_eal_devargs_type_count(RTE_DEVTYPE_BLACKLISTED_PCI) != 0) {
 		RTE_LOG(ERR, EAL, "Options blacklist (-b) and whitelist (-w) "
@@ -1053,8 +1228,12 @@ eal_common_usage(void)
 	       "                      '( )' can be omitted for single element group,\n"
 	       "                      '@' can be omitted if cpus and lcores have the same value\n"
 	       "  --"OPT_MASTER_LCORE" ID   Core ID that is used as master\n"
+	       "  -s SERVICE COREMASK Hexadecimal bitmask of cores to be used as service cores\n"
+	       "  -S SERVICE CORELIST List of cores to be used as service cores\n"
 	       "  -n CHANNELS         Number of memory channels\n"
 	       "  -m MB               Memory to allocate (see also --"OPT_SOCKET_MEM")\n"
+	       "  --"OPT_MEM_HOTPLUG"       Map more memory when the heap is exhausted\n"
+	       "                      and release it when freed\n"
 	       "  -r RANKS            Force number of memory ranks (don't detect)\n"
 	       "  -b, --"OPT_PCI_BLACKLIST" Add a PCI device in black list.\n"
 	       "                      Prevent EAL from using this PCI device. The argument\n"
@@ -1075,6 +1254,11 @@ eal_common_usage(void)
 	       "  --"OPT_LOG_LEVEL"=<int>   Set global log level\n"
 	       "  --"OPT_LOG_LEVEL"=<type-regexp>,<int>\n"
 	       "                      Set specific log level\n"
+	       "  --"OPT_LOG_DEFERRED"      Store the logs of the lcores in rings, written\n"
+	       "                      later by the log service\n"
+	       "  --"OPT_TRACE"=<regexp>  Enable the tracepoints matching the regexp\n"
+	       "  --"OPT_IN_MEMORY"         Operate entirely in memory. This will\n"
+	       "                      disable secondary process support\n"
 	       "  -v                  Display version information on startup\n"
 	       "  -h, --help          This help\n"
 	       "\nEAL options for DEBUG use only:\n"
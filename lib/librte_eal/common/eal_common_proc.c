@@ -30,13 +30,33 @@
  *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <stdio.h>
+#include <dirent.h>
+#include <errno.h>
 #include <fcntl.h>
+#include <fnmatch.h>
+#include <inttypes.h>
+#include <libgen.h>
+#include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/queue.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <rte_common.h>
+#include <rte_cycles.h>
 #include <rte_eal.h>
+#include <rte_errno.h>
+#include <rte_lcore.h>
+#include <rte_log.h>
 
 #include "eal_filesystem.h"
 #include "eal_internal_cfg.h"
+#include "eal_private.h"
 
 int
 rte_eal_primary_proc_alive(const char *config_file_path)
@@ -59,3 +79,893 @@ rte_eal_primary_proc_alive(const char *config_file_path)
 
 	return !!ret;
 }
+
+/*
+ * Multi-process channel.
+ *
+ * Each process binds a datagram unix socket: the primary process uses
+ * eal_mp_socket_path(), the secondary processes append their pid and a
+ * TSC value to it. A primary process finds the secondary processes by
+ * listing the sockets of the directory. A thread per process receives
+ * the messages, runs the actions and wakes up the pending requests.
+ */
+
+enum mp_type {
+	MP_MSG,  /* one-way message */
+	MP_REQ,  /* request expecting a reply */
+	MP_REP,  /* reply to a request */
+	MP_IGN,  /* reply to a request with no action registered */
+	MP_WAKE, /* wake the thread up to check the asynchronous requests */
+};
+
+struct mp_msg_internal {
+	int type;
+	struct rte_mp_msg msg;
+};
+
+struct action_entry {
+	TAILQ_ENTRY(action_entry) next;
+	char action_name[RTE_MP_MAX_NAME_LEN];
+	rte_mp_t action;
+};
+
+/* replies of an asynchronous request, sent to n_pending + nb_received peers */
+struct async_request_param {
+	TAILQ_ENTRY(async_request_param) next;
+	rte_mp_async_reply_t clb;
+	struct rte_mp_msg request;
+	struct rte_mp_reply user_reply;
+	struct timespec end;
+	int n_pending;
+};
+
+/* request waiting for the reply of one peer */
+struct pending_request {
+	TAILQ_ENTRY(pending_request) next;
+	char dst[PATH_MAX];
+	char name[RTE_MP_MAX_NAME_LEN];
+	int reply_received; /* 1 if replied, -1 if ignored */
+	struct rte_mp_msg reply;
+	pthread_cond_t cond; /* synchronous request only */
+	struct async_request_param *param; /* NULL if synchronous */
+};
+
+TAILQ_HEAD(action_entry_list, action_entry);
+TAILQ_HEAD(pending_request_list, pending_request);
+TAILQ_HEAD(async_request_list, async_request_param);
+
+static struct action_entry_list action_entry_list =
+	TAILQ_HEAD_INITIALIZER(action_entry_list);
+static pthread_mutex_t mp_mutex_action = PTHREAD_MUTEX_INITIALIZER;
+
+static struct pending_request_list pending_requests =
+	TAILQ_HEAD_INITIALIZER(pending_requests);
+static struct async_request_list async_requests =
+	TAILQ_HEAD_INITIALIZER(async_requests);
+static pthread_mutex_t mp_mutex_request = PTHREAD_MUTEX_INITIALIZER;
+static pthread_condattr_t mp_cond_attr;
+
+static int mp_fd = -1;
+static pthread_t mp_handle_tid;
+static char mp_path[PATH_MAX];      /* socket of this process */
+static char mp_primary[PATH_MAX];   /* socket of the primary process */
+static char mp_dir[PATH_MAX];       /* directory of the sockets */
+static char mp_filter[PATH_MAX];    /* pattern of the secondary sockets */
+
+static struct action_entry *
+find_action_entry_by_name(const char *name)
+{
+	struct action_entry *entry;
+
+	TAILQ_FOREACH(entry, &action_entry_list, next) {
+		if (strncmp(entry->action_name, name,
+				RTE_MP_MAX_NAME_LEN) == 0)
+			break;
+	}
+
+	return entry;
+}
+
+static struct pending_request *
+find_pending_request(const char *dst, const char *name)
+{
+	struct pending_request *req;
+
+	TAILQ_FOREACH(req, &pending_requests, next) {
+		if (strcmp(req->dst, dst) == 0 &&
+				strncmp(req->name, name,
+					RTE_MP_MAX_NAME_LEN) == 0)
+			break;
+	}
+
+	return req;
+}
+
+static int
+validate_action_name(const char *name)
+{
+	size_t len;
+
+	if (name == NULL) {
+		RTE_LOG(ERR, EAL, "Action name cannot be NULL\n");
+		rte_errno = EINVAL;
+		return -1;
+	}
+	len = strnlen(name, RTE_MP_MAX_NAME_LEN);
+	if (len == 0) {
+		RTE_LOG(ERR, EAL, "Length of action name is zero\n");
+		rte_errno = EINVAL;
+		return -1;
+	}
+	if (len == RTE_MP_MAX_NAME_LEN) {
+		RTE_LOG(ERR, EAL, "Action name is too long\n");
+		rte_errno = EINVAL;
+		return -1;
+	}
+	return 0;
+}
+
+static int
+check_input(const struct rte_mp_msg *msg)
+{
+	if (msg == NULL) {
+		RTE_LOG(ERR, EAL, "Msg cannot be NULL\n");
+		rte_errno = EINVAL;
+		return -1;
+	}
+	if (validate_action_name(msg->name) < 0)
+		return -1;
+	if (msg->len_param < 0 || msg->len_param > RTE_MP_MAX_PARAM_LEN) {
+		RTE_LOG(ERR, EAL, "Message data is too long\n");
+		rte_errno = E2BIG;
+		return -1;
+	}
+	if (msg->num_fds < 0 || msg->num_fds > RTE_MP_MAX_FD_NUM) {
+		RTE_LOG(ERR, EAL, "Cannot send more than %d FDs\n",
+			RTE_MP_MAX_FD_NUM);
+		rte_errno = E2BIG;
+		return -1;
+	}
+	if (mp_fd < 0) {
+		RTE_LOG(ERR, EAL, "Multi-process channel is disabled\n");
+		rte_errno = ENOTSUP;
+		return -1;
+	}
+	return 0;
+}
+
+static void
+close_fds(const struct rte_mp_msg *msg)
+{
+	int i;
+
+	for (i = 0; i < msg->num_fds; i++)
+		close(msg->fds[i]);
+}
+
+int
+rte_mp_action_register(const char *name, rte_mp_t action)
+{
+	struct action_entry *entry;
+
+	if (validate_action_name(name) < 0)
+		return -1;
+	if (action == NULL) {
+		rte_errno = EINVAL;
+		return -1;
+	}
+	if (internal_config.no_shconf) {
+		RTE_LOG(ERR, EAL, "Multi-process channel is disabled\n");
+		rte_errno = ENOTSUP;
+		return -1;
+	}
+
+	entry = malloc(sizeof(struct action_entry));
+	if (entry == NULL) {
+		rte_errno = ENOMEM;
+		return -1;
+	}
+	snprintf(entry->action_name, sizeof(entry->action_name), "%s", name);
+	entry->action = action;
+
+	pthread_mutex_lock(&mp_mutex_action);
+	if (find_action_entry_by_name(name) != NULL) {
+		pthread_mutex_unlock(&mp_mutex_action);
+		rte_errno = EEXIST;
+		free(entry);
+		return -1;
+	}
+	TAILQ_INSERT_TAIL(&action_entry_list, entry, next);
+	pthread_mutex_unlock(&mp_mutex_action);
+	return 0;
+}
+
+void
+rte_mp_action_unregister(const char *name)
+{
+	struct action_entry *entry;
+
+	if (validate_action_name(name) < 0)
+		return;
+
+	pthread_mutex_lock(&mp_mutex_action);
+	entry = find_action_entry_by_name(name);
+	if (entry != NULL)
+		TAILQ_REMOVE(&action_entry_list, entry, next);
+	pthread_mutex_unlock(&mp_mutex_action);
+	free(entry);
+}
+
+/*
+ * Send a message to one peer.
+ * Return 1 if sent, 0 if the peer is a secondary process which is gone,
+ * -1 on error.
+ */
+static int
+send_msg(const char *dst_path, const struct rte_mp_msg *msg, int type)
+{
+	struct mp_msg_internal m;
+	struct sockaddr_un dst;
+	struct msghdr msgh;
+	struct iovec iov;
+	struct cmsghdr *cmsg;
+	char control[CMSG_SPACE(sizeof(msg->fds))];
+	int fd_size = msg->num_fds * sizeof(int);
+	ssize_t snd;
+
+	memset(&m, 0, sizeof(m));
+	m.type = type;
+	memcpy(&m.msg, msg, sizeof(*msg));
+
+	memset(&dst, 0, sizeof(dst));
+	dst.sun_family = AF_UNIX;
+	snprintf(dst.sun_path, sizeof(dst.sun_path), "%s", dst_path);
+
+	memset(&msgh, 0, sizeof(msgh));
+	memset(control, 0, sizeof(control));
+
+	iov.iov_base = &m;
+	iov.iov_len = sizeof(m);
+
+	msgh.msg_name = &dst;
+	msgh.msg_namelen = sizeof(dst);
+	msgh.msg_iov = &iov;
+	msgh.msg_iovlen = 1;
+
+	if (fd_size > 0) {
+		msgh.msg_control = control;
+		msgh.msg_controllen = CMSG_SPACE(fd_size);
+
+		cmsg = CMSG_FIRSTHDR(&msgh);
+		cmsg->cmsg_len = CMSG_LEN(fd_size);
+		cmsg->cmsg_level = SOL_SOCKET;
+		cmsg->cmsg_type = SCM_RIGHTS;
+		memcpy(CMSG_DATA(cmsg), msg->fds, fd_size);
+	}
+
+	do {
+		snd = sendmsg(mp_fd, &msgh, 0);
+	} while (snd < 0 && errno == EINTR);
+
+	if (snd < 0) {
+		rte_errno = errno;
+		/* a secondary process exited without removing its socket */
+		if ((errno == ECONNREFUSED || errno == ENOENT) &&
+				rte_eal_process_type() == RTE_PROC_PRIMARY) {
+			unlink(dst_path);
+			return 0;
+		}
+		RTE_LOG(ERR, EAL, "Failed to send to %s: %s\n",
+			dst_path, strerror(errno));
+		return -1;
+	}
+
+	return 1;
+}
+
+/*
+ * Call fn for the socket of each secondary process.
+ * Return -1 if one of the calls failed, 0 otherwise.
+ */
+static int
+for_each_secondary(int (*fn)(const char *dst, void *arg), void *arg)
+{
+	char path[PATH_MAX];
+	struct dirent *ent;
+	DIR *dir;
+	int ret = 0;
+
+	dir = opendir(mp_dir);
+	if (dir == NULL) {
+		RTE_LOG(ERR, EAL, "Unable to open directory %s\n", mp_dir);
+		rte_errno = errno;
+		return -1;
+	}
+
+	while ((ent = readdir(dir)) != NULL) {
+		if (fnmatch(mp_filter, ent->d_name, 0) != 0)
+			continue;
+
+		snprintf(path, sizeof(path), "%s/%s", mp_dir, ent->d_name);
+		if (fn(path, arg) < 0)
+			ret = -1;
+	}
+
+	closedir(dir);
+	return ret;
+}
+
+static int
+send_msg_one(const char *dst, void *arg)
+{
+	return send_msg(dst, arg, MP_MSG);
+}
+
+int
+rte_mp_sendmsg(struct rte_mp_msg *msg)
+{
+	if (check_input(msg) < 0)
+		return -1;
+
+	RTE_LOG(DEBUG, EAL, "sendmsg: %s\n", msg->name);
+
+	if (rte_eal_process_type() == RTE_PROC_SECONDARY)
+		return send_msg(mp_primary, msg, MP_MSG) < 0 ? -1 : 0;
+
+	return for_each_secondary(send_msg_one, msg);
+}
+
+int
+rte_mp_reply(struct rte_mp_msg *msg, const void *peer)
+{
+	if (check_input(msg) < 0)
+		return -1;
+
+	if (peer == NULL) {
+		RTE_LOG(ERR, EAL, "peer is not specified\n");
+		rte_errno = EINVAL;
+		return -1;
+	}
+
+	return send_msg(peer, msg, MP_REP) < 0 ? -1 : 0;
+}
+
+/* get the absolute time of the end of a request, ts from now */
+static void
+get_end_time(const struct timespec *ts, struct timespec *end)
+{
+	clock_gettime(CLOCK_MONOTONIC, end);
+	end->tv_sec += ts->tv_sec;
+	end->tv_nsec += ts->tv_nsec;
+	if (end->tv_nsec >= 1000000000L) {
+		end->tv_sec++;
+		end->tv_nsec -= 1000000000L;
+	}
+}
+
+/* called with mp_mutex_request held, which is released while waiting */
+static int
+mp_request_sync(const char *dst, struct rte_mp_msg *req,
+		struct rte_mp_reply *reply, const struct timespec *end)
+{
+	struct pending_request pending_req;
+	struct rte_mp_msg *msgs;
+	int ret;
+
+	if (find_pending_request(dst, req->name) != NULL) {
+		RTE_LOG(ERR, EAL, "A pending request %s:%s\n",
+			dst, req->name);
+		rte_errno = EEXIST;
+		return -1;
+	}
+
+	memset(&pending_req, 0, sizeof(pending_req));
+	snprintf(pending_req.dst, sizeof(pending_req.dst), "%s", dst);
+	snprintf(pending_req.name, sizeof(pending_req.name), "%s", req->name);
+	pthread_cond_init(&pending_req.cond, &mp_cond_attr);
+
+	TAILQ_INSERT_TAIL(&pending_requests, &pending_req, next);
+
+	ret = send_msg(dst, req, MP_REQ);
+	if (ret <= 0)
+		goto out;
+	reply->nb_sent++;
+
+	do {
+		ret = pthread_cond_timedwait(&pending_req.cond,
+				&mp_mutex_request, end);
+	} while (pending_req.reply_received == 0 && ret != ETIMEDOUT);
+
+	if (pending_req.reply_received == 0) {
+		RTE_LOG(ERR, EAL, "Fail to recv reply for request %s:%s\n",
+			dst, req->name);
+		rte_errno = ETIMEDOUT;
+		ret = -1;
+		goto out;
+	}
+
+	ret = 0;
+	if (pending_req.reply_received < 0) {
+		/* the peer has no action for this request */
+		reply->nb_sent--;
+		goto out;
+	}
+
+	msgs = realloc(reply->msgs,
+			sizeof(*msgs) * (reply->nb_received + 1));
+	if (msgs == NULL) {
+		RTE_LOG(ERR, EAL, "Fail to alloc reply for request %s:%s\n",
+			dst, req->name);
+		close_fds(&pending_req.reply);
+		rte_errno = ENOMEM;
+		ret = -1;
+		goto out;
+	}
+	memcpy(&msgs[reply->nb_received++], &pending_req.reply,
+		sizeof(*msgs));
+	reply->msgs = msgs;
+
+out:
+	TAILQ_REMOVE(&pending_requests, &pending_req, next);
+	pthread_cond_destroy(&pending_req.cond);
+	return ret < 0 ? -1 : 0;
+}
+
+struct sync_request_args {
+	struct rte_mp_msg *req;
+	struct rte_mp_reply *reply;
+	const struct timespec *end;
+};
+
+static int
+mp_request_sync_one(const char *dst, void *arg)
+{
+	struct sync_request_args *args = arg;
+
+	return mp_request_sync(dst, args->req, args->reply, args->end);
+}
+
+int
+rte_mp_request_sync(struct rte_mp_msg *req, struct rte_mp_reply *reply,
+		const struct timespec *ts)
+{
+	struct sync_request_args args;
+	struct timespec end;
+	int ret;
+
+	if (check_input(req) < 0)
+		return -1;
+
+	if (reply == NULL || ts == NULL) {
+		rte_errno = EINVAL;
+		return -1;
+	}
+
+	if (pthread_equal(pthread_self(), mp_handle_tid)) {
+		RTE_LOG(ERR, EAL, "Cannot send a request from an action\n");
+		rte_errno = EDEADLK;
+		return -1;
+	}
+
+	RTE_LOG(DEBUG, EAL, "request: %s\n", req->name);
+
+	reply->nb_sent = 0;
+	reply->nb_received = 0;
+	reply->msgs = NULL;
+
+	get_end_time(ts, &end);
+
+	pthread_mutex_lock(&mp_mutex_request);
+	if (rte_eal_process_type() == RTE_PROC_SECONDARY) {
+		ret = mp_request_sync(mp_primary, req, reply, &end);
+	} else {
+		args.req = req;
+		args.reply = reply;
+		args.end = &end;
+		ret = for_each_secondary(mp_request_sync_one, &args);
+	}
+	pthread_mutex_unlock(&mp_mutex_request);
+
+	return ret;
+}
+
+/* called with mp_mutex_request held */
+static int
+mp_request_async_one(const char *dst, void *arg)
+{
+	struct async_request_param *param = arg;
+	struct pending_request *pending_req;
+	int ret;
+
+	if (find_pending_request(dst, param->request.name) != NULL) {
+		RTE_LOG(ERR, EAL, "A pending request %s:%s\n",
+			dst, param->request.name);
+		rte_errno = EEXIST;
+		return -1;
+	}
+
+	pending_req = calloc(1, sizeof(*pending_req));
+	if (pending_req == NULL) {
+		rte_errno = ENOMEM;
+		return -1;
+	}
+	snprintf(pending_req->dst, sizeof(pending_req->dst), "%s", dst);
+	snprintf(pending_req->name, sizeof(pending_req->name), "%s",
+		param->request.name);
+	pending_req->param = param;
+
+	ret = send_msg(dst, &param->request, MP_REQ);
+	if (ret <= 0) {
+		free(pending_req);
+		return ret;
+	}
+
+	TAILQ_INSERT_TAIL(&pending_requests, pending_req, next);
+	param->user_reply.nb_sent++;
+	param->n_pending++;
+	return 0;
+}
+
+/* called with mp_mutex_request held */
+static void
+remove_async_pending(struct async_request_param *param)
+{
+	struct pending_request *req, *next;
+
+	for (req = TAILQ_FIRST(&pending_requests); req != NULL; req = next) {
+		next = TAILQ_NEXT(req, next);
+		if (req->param != param)
+			continue;
+		TAILQ_REMOVE(&pending_requests, req, next);
+		free(req);
+		param->n_pending--;
+	}
+}
+
+static void
+wake_mp_handle(void)
+{
+	struct rte_mp_msg msg;
+
+	memset(&msg, 0, sizeof(msg));
+	send_msg(mp_path, &msg, MP_WAKE);
+}
+
+int
+rte_mp_request_async(struct rte_mp_msg *req, const struct timespec *ts,
+		rte_mp_async_reply_t clb)
+{
+	struct async_request_param *param;
+	int ret;
+
+	if (check_input(req) < 0)
+		return -1;
+
+	if (ts == NULL || clb == NULL) {
+		rte_errno = EINVAL;
+		return -1;
+	}
+
+	RTE_LOG(DEBUG, EAL, "request: %s\n", req->name);
+
+	param = calloc(1, sizeof(*param));
+	if (param == NULL) {
+		rte_errno = ENOMEM;
+		return -1;
+	}
+	param->clb = clb;
+	memcpy(&param->request, req, sizeof(*req));
+	get_end_time(ts, &param->end);
+
+	pthread_mutex_lock(&mp_mutex_request);
+	if (rte_eal_process_type() == RTE_PROC_SECONDARY)
+		ret = mp_request_async_one(mp_primary, param);
+	else
+		ret = for_each_secondary(mp_request_async_one, param);
+
+	if (ret < 0) {
+		/* no reply can be processed before the lock is released */
+		remove_async_pending(param);
+		pthread_mutex_unlock(&mp_mutex_request);
+		free(param);
+		return -1;
+	}
+	TAILQ_INSERT_TAIL(&async_requests, param, next);
+	pthread_mutex_unlock(&mp_mutex_request);
+
+	/* let the thread complete the request or arm its timeout */
+	wake_mp_handle();
+	return 0;
+}
+
+/* called with mp_mutex_request held */
+static void
+async_reply(struct pending_request *req, const struct mp_msg_internal *m)
+{
+	struct async_request_param *param = req->param;
+	struct rte_mp_reply *reply = &param->user_reply;
+	struct rte_mp_msg *msgs;
+
+	TAILQ_REMOVE(&pending_requests, req, next);
+	param->n_pending--;
+
+	if (m->type == MP_IGN) {
+		reply->nb_sent--;
+	} else {
+		msgs = realloc(reply->msgs,
+				sizeof(*msgs) * (reply->nb_received + 1));
+		if (msgs == NULL) {
+			RTE_LOG(ERR, EAL,
+				"Fail to alloc reply for request %s:%s\n",
+				req->dst, req->name);
+			close_fds(&m->msg);
+		} else {
+			memcpy(&msgs[reply->nb_received++], &m->msg,
+				sizeof(*msgs));
+			reply->msgs = msgs;
+		}
+	}
+
+	free(req);
+}
+
+static int
+timespec_cmp(const struct timespec *a, const struct timespec *b)
+{
+	if (a->tv_sec != b->tv_sec)
+		return a->tv_sec < b->tv_sec ? -1 : 1;
+	if (a->tv_nsec != b->tv_nsec)
+		return a->tv_nsec < b->tv_nsec ? -1 : 1;
+	return 0;
+}
+
+/*
+ * Time out the expired asynchronous requests and call the callbacks of
+ * the completed ones. Return the poll() timeout until the next expiry.
+ */
+static int
+process_async_requests(void)
+{
+	struct async_request_list done = TAILQ_HEAD_INITIALIZER(done);
+	struct async_request_param *param, *next;
+	struct timespec now;
+	int64_t timeout_ms, ms;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	timeout_ms = -1;
+
+	pthread_mutex_lock(&mp_mutex_request);
+	for (param = TAILQ_FIRST(&async_requests); param != NULL;
+			param = next) {
+		next = TAILQ_NEXT(param, next);
+
+		if (param->n_pending > 0 &&
+				timespec_cmp(&param->end, &now) <= 0) {
+			RTE_LOG(ERR, EAL, "Request %s timed out\n",
+				param->request.name);
+			remove_async_pending(param);
+		}
+
+		if (param->n_pending == 0) {
+			TAILQ_REMOVE(&async_requests, param, next);
+			TAILQ_INSERT_TAIL(&done, param, next);
+			continue;
+		}
+
+		ms = (param->end.tv_sec - now.tv_sec) * 1000 +
+			(param->end.tv_nsec - now.tv_nsec + 999999) / 1000000;
+		if (timeout_ms < 0 || ms < timeout_ms)
+			timeout_ms = ms;
+	}
+	pthread_mutex_unlock(&mp_mutex_request);
+
+	while ((param = TAILQ_FIRST(&done)) != NULL) {
+		TAILQ_REMOVE(&done, param, next);
+		param->clb(&param->request, &param->user_reply);
+		free(param->user_reply.msgs);
+		free(param);
+	}
+
+	return timeout_ms > INT_MAX ? INT_MAX : (int)timeout_ms;
+}
+
+static int
+read_msg(struct mp_msg_internal *m, struct sockaddr_un *s)
+{
+	char control[CMSG_SPACE(sizeof(m->msg.fds))];
+	struct cmsghdr *cmsg;
+	struct msghdr msgh;
+	struct iovec iov;
+	int num_fds = 0;
+	int ret;
+
+	memset(&msgh, 0, sizeof(msgh));
+	memset(s, 0, sizeof(*s));
+	iov.iov_base = m;
+	iov.iov_len  = sizeof(*m);
+
+	msgh.msg_name = s;
+	msgh.msg_namelen = sizeof(*s) - 1; /* keep the path terminated */
+	msgh.msg_iov = &iov;
+	msgh.msg_iovlen = 1;
+	msgh.msg_control = control;
+	msgh.msg_controllen = sizeof(control);
+
+	ret = recvmsg(mp_fd, &msgh, 0);
+	if (ret <= 0) {
+		if (ret < 0 && errno != EINTR)
+			RTE_LOG(ERR, EAL, "recvmsg failed, %s\n",
+				strerror(errno));
+		return -1;
+	}
+
+	for (cmsg = CMSG_FIRSTHDR(&msgh); cmsg != NULL;
+			cmsg = CMSG_NXTHDR(&msgh, cmsg)) {
+		if (cmsg->cmsg_level == SOL_SOCKET &&
+				cmsg->cmsg_type == SCM_RIGHTS) {
+			num_fds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+			memcpy(m->msg.fds, CMSG_DATA(cmsg),
+				num_fds * sizeof(int));
+			break;
+		}
+	}
+
+	if (ret != sizeof(*m) || (msgh.msg_flags & MSG_CTRUNC) ||
+			m->msg.num_fds != num_fds ||
+			m->msg.len_param < 0 ||
+			m->msg.len_param > RTE_MP_MAX_PARAM_LEN ||
+			strnlen(m->msg.name, RTE_MP_MAX_NAME_LEN) ==
+				RTE_MP_MAX_NAME_LEN) {
+		RTE_LOG(ERR, EAL, "invalid received message\n");
+		m->msg.num_fds = num_fds;
+		close_fds(&m->msg);
+		return -1;
+	}
+
+	return 0;
+}
+
+static void
+process_msg(struct mp_msg_internal *m, struct sockaddr_un *s)
+{
+	struct rte_mp_msg *msg = &m->msg;
+	struct pending_request *req;
+	struct action_entry *entry;
+	struct rte_mp_msg dummy;
+	rte_mp_t action = NULL;
+
+	RTE_LOG(DEBUG, EAL, "msg: %s\n", msg->name);
+
+	if (m->type == MP_WAKE)
+		return;
+
+	if (m->type == MP_REP || m->type == MP_IGN) {
+		pthread_mutex_lock(&mp_mutex_request);
+		req = find_pending_request(s->sun_path, msg->name);
+		if (req == NULL) {
+			/* the request has timed out */
+			close_fds(msg);
+		} else if (req->param != NULL) {
+			async_reply(req, m);
+		} else {
+			memcpy(&req->reply, msg, sizeof(*msg));
+			req->reply_received = m->type == MP_REP ? 1 : -1;
+			pthread_cond_signal(&req->cond);
+		}
+		pthread_mutex_unlock(&mp_mutex_request);
+		return;
+	}
+
+	pthread_mutex_lock(&mp_mutex_action);
+	entry = find_action_entry_by_name(msg->name);
+	if (entry != NULL)
+		action = entry->action;
+	pthread_mutex_unlock(&mp_mutex_action);
+
+	if (action == NULL) {
+		close_fds(msg);
+		if (m->type == MP_REQ) {
+			/* do not let the requester wait for the timeout */
+			memset(&dummy, 0, sizeof(dummy));
+			snprintf(dummy.name, sizeof(dummy.name), "%s",
+				msg->name);
+			send_msg(s->sun_path, &dummy, MP_IGN);
+		} else {
+			RTE_LOG(ERR, EAL, "Cannot find action: %s\n",
+				msg->name);
+		}
+		return;
+	}
+
+	if (action(msg, s->sun_path) < 0)
+		RTE_LOG(ERR, EAL, "Fail to handle message: %s\n", msg->name);
+}
+
+static __attribute__((noreturn)) void *
+mp_handle(void *arg __rte_unused)
+{
+	struct mp_msg_internal msg;
+	struct sockaddr_un sa;
+	struct pollfd pfd;
+	int timeout = -1;
+
+	pfd.fd = mp_fd;
+	pfd.events = POLLIN;
+
+	for (;;) {
+		if (poll(&pfd, 1, timeout) > 0 && read_msg(&msg, &sa) == 0)
+			process_msg(&msg, &sa);
+		timeout = process_async_requests();
+	}
+}
+
+int
+rte_mp_channel_init(void)
+{
+	char path[PATH_MAX];
+	struct sockaddr_un un;
+	char thread_name[RTE_MAX_THREAD_NAME_LEN];
+	int fd;
+
+	/* no socket file is created, so there is no secondary process */
+	if (internal_config.no_shconf) {
+		RTE_LOG(DEBUG, EAL,
+			"No shared files mode, multi-process channel disabled\n");
+		return 0;
+	}
+
+	snprintf(mp_primary, sizeof(mp_primary), "%s", eal_mp_socket_path());
+	snprintf(path, sizeof(path), "%s", mp_primary);
+	snprintf(mp_dir, sizeof(mp_dir), "%s", dirname(path));
+	snprintf(path, sizeof(path), "%s", mp_primary);
+	snprintf(mp_filter, sizeof(mp_filter), "%s_*", basename(path));
+
+	if (rte_eal_process_type() == RTE_PROC_PRIMARY)
+		snprintf(mp_path, sizeof(mp_path), "%s", mp_primary);
+	else
+		snprintf(mp_path, sizeof(mp_path), "%s_%d_%"PRIx64,
+			mp_primary, getpid(), rte_rdtsc());
+
+	memset(&un, 0, sizeof(un));
+	un.sun_family = AF_UNIX;
+	if (strlen(mp_path) >= sizeof(un.sun_path)) {
+		RTE_LOG(ERR, EAL, "Socket path %s is too long\n", mp_path);
+		return -1;
+	}
+	strcpy(un.sun_path, mp_path);
+
+	fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+	if (fd < 0) {
+		RTE_LOG(ERR, EAL, "Failed to create unix socket\n");
+		return -1;
+	}
+
+	unlink(mp_path);
+	if (bind(fd, (struct sockaddr *)&un, sizeof(un)) < 0) {
+		RTE_LOG(ERR, EAL, "Failed to bind %s: %s\n",
+			mp_path, strerror(errno));
+		close(fd);
+		return -1;
+	}
+
+	pthread_condattr_init(&mp_cond_attr);
+	pthread_condattr_setclock(&mp_cond_attr, CLOCK_MONOTONIC);
+
+	mp_fd = fd;
+	if (pthread_create(&mp_handle_tid, NULL, mp_handle, NULL) != 0) {
+		RTE_LOG(ERR, EAL, "Failed to create mp thread: %s\n",
+			strerror(errno));
+		mp_fd = -1;
+		close(fd);
+		unlink(mp_path);
+		return -1;
+	}
+
+	/* Set thread_name for aid in debugging. */
+	snprintf(thread_name, RTE_MAX_THREAD_NAME_LEN, "rte_mp_handle");
+	if (rte_thread_setname(mp_handle_tid, thread_name) < 0)
+		RTE_LOG(DEBUG, EAL, "Failed to set thread name for mp thread\n");
+
+	RTE_LOG(DEBUG, EAL, "Multi-process socket %s\n", mp_path);
+	return 0;
+}
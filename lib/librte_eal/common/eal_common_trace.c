@@ -0,0 +1,370 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+#include <regex.h>
+#include <limits.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include <rte_common.h>
+#include <rte_byteorder.h>
+#include <rte_cycles.h>
+#include <rte_eal.h>
+#include <rte_lcore.h>
+#include <rte_log.h>
+#include <rte_malloc.h>
+#include <rte_spinlock.h>
+#include <rte_version.h>
+#include <rte_trace.h>
+
+#define TRACE_BUF_MASK (RTE_TRACE_BUF_SIZE - 1)
+
+/* magic number of the CTF packets */
+#define TRACE_CTF_MAGIC 0xC1FC1FC1
+
+/* an event, with the layout of the CTF stream files */
+struct trace_event {
+	uint64_t tsc;
+	uint16_t id;
+	uint16_t nb_args;
+	uint32_t reserved;
+	uint64_t args[RTE_TRACE_MAX_ARGS];
+};
+
+/* the events of an lcore, the last RTE_TRACE_BUF_SIZE are kept */
+struct trace_buf {
+	uint64_t head;
+	struct trace_event events[RTE_TRACE_BUF_SIZE] __rte_cache_aligned;
+};
+
+/* header of the CTF stream files */
+struct trace_packet_header {
+	uint32_t magic;
+	uint32_t stream_id;
+	uint32_t lcore_id;
+	uint32_t reserved;
+};
+
+static struct rte_trace_point *trace_points[RTE_TRACE_POINT_MAX];
+static unsigned int trace_points_count;
+static struct trace_buf *trace_bufs[RTE_MAX_LCORE];
+/* serializes the control functions */
+static rte_spinlock_t trace_lock = RTE_SPINLOCK_INITIALIZER;
+
+void
+rte_trace_point_register(struct rte_trace_point *tp)
+{
+	if (trace_points_count == RTE_TRACE_POINT_MAX) {
+		RTE_LOG(ERR, EAL, "Too many tracepoints, %s not registered\n",
+			tp->name);
+		return;
+	}
+	tp->id = trace_points_count;
+	trace_points[trace_points_count++] = tp;
+}
+
+void
+__rte_trace_point_emit(struct rte_trace_point *tp, const uint64_t *args,
+		unsigned int nb_args)
+{
+	unsigned int lcore_id = rte_lcore_id();
+	struct trace_event *ev;
+	struct trace_buf *buf;
+	unsigned int i;
+
+	if (lcore_id >= RTE_MAX_LCORE)
+		return;
+	buf = trace_bufs[lcore_id];
+	if (buf == NULL)
+		return;
+
+	ev = &buf->events[buf->head & TRACE_BUF_MASK];
+	ev->tsc = rte_rdtsc();
+	ev->id = tp->id;
+	ev->nb_args = nb_args;
+	for (i = 0; i < nb_args; i++)
+		ev->args[i] = args[i];
+	for (; i < RTE_TRACE_MAX_ARGS; i++)
+		ev->args[i] = 0;
+	buf->head++;
+}
+
+struct rte_trace_point *
+rte_trace_point_lookup(const char *name)
+{
+	unsigned int i;
+
+	if (name == NULL)
+		return NULL;
+
+	for (i = 0; i < trace_points_count; i++)
+		if (strcmp(trace_points[i]->name, name) == 0)
+			return trace_points[i];
+	return NULL;
+}
+
+/* allocate the buffers of the lcores, once */
+static int
+trace_bufs_alloc(void)
+{
+	struct rte_config *cfg = rte_eal_get_configuration();
+	unsigned int i;
+
+	for (i = 0; i < RTE_MAX_LCORE; i++) {
+		if (cfg->lcore_role[i] == ROLE_OFF || trace_bufs[i] != NULL)
+			continue;
+		trace_bufs[i] = rte_zmalloc_socket("trace_buf",
+				sizeof(struct trace_buf), RTE_CACHE_LINE_SIZE,
+				rte_lcore_to_socket_id(i));
+		if (trace_bufs[i] == NULL)
+			return -ENOMEM;
+	}
+	return 0;
+}
+
+static int
+trace_point_enable(struct rte_trace_point *tp, int enable)
+{
+	if (enable) {
+		int ret = trace_bufs_alloc();
+
+		if (ret < 0)
+			return ret;
+	}
+	rte_smp_wmb();
+	tp->enabled = !!enable;
+	return 0;
+}
+
+int
+rte_trace_point_enable(struct rte_trace_point *tp, int enable)
+{
+	int ret;
+
+	if (tp == NULL || tp->id >= trace_points_count ||
+			trace_points[tp->id] != tp)
+		return -EINVAL;
+
+	rte_spinlock_lock(&trace_lock);
+	ret = trace_point_enable(tp, enable);
+	rte_spinlock_unlock(&trace_lock);
+	return ret;
+}
+
+int
+rte_trace_regexp(const char *pattern, int enable)
+{
+	regex_t r;
+	unsigned int i;
+	int count = 0;
+	int ret;
+
+	if (pattern == NULL || regcomp(&r, pattern, 0) != 0)
+		return -EINVAL;
+
+	rte_spinlock_lock(&trace_lock);
+	for (i = 0; i < trace_points_count; i++) {
+		if (regexec(&r, trace_points[i]->name, 0, NULL, 0) != 0)
+			continue;
+		ret = trace_point_enable(trace_points[i], enable);
+		if (ret < 0) {
+			count = ret;
+			break;
+		}
+		count++;
+	}
+	rte_spinlock_unlock(&trace_lock);
+
+	regfree(&r);
+	return count;
+}
+
+/* write the CTF metadata, describing the layout of the stream files */
+static int
+trace_save_metadata(FILE *f)
+{
+	uint64_t hz = rte_get_tsc_hz();
+	struct timespec ts;
+	uint64_t tsc, tsc_ns;
+	int64_t offset_ns;
+	unsigned int i, j;
+
+	/* offset of the TSC clock from the Epoch */
+	clock_gettime(CLOCK_REALTIME, &ts);
+	tsc = rte_rdtsc();
+	tsc_ns = (tsc / hz) * NS_PER_S + (tsc % hz) * NS_PER_S / hz;
+	offset_ns = (int64_t)ts.tv_sec * NS_PER_S + ts.tv_nsec -
+		(int64_t)tsc_ns;
+
+	fprintf(f, "/* CTF 1.8 */\n\n"
+		"typealias integer { size = 16; align = 8; signed = false; }"
+		" := uint16_t;\n"
+		"typealias integer { size = 32; align = 8; signed = false; }"
+		" := uint32_t;\n"
+		"typealias integer { size = 64; align = 8; signed = false; }"
+		" := uint64_t;\n\n"
+		"trace {\n"
+		"\tmajor = 1;\n"
+		"\tminor = 8;\n"
+		"\tbyte_order = %s;\n"
+		"\tpacket.header := struct {\n"
+		"\t\tuint32_t magic;\n"
+		"\t\tuint32_t stream_id;\n"
+		"\t};\n"
+		"};\n\n"
+		"env {\n"
+		"\tdpdk_version = \"%s\";\n"
+		"};\n\n"
+		"clock {\n"
+		"\tname = \"tsc\";\n"
+		"\tfreq = %" PRIu64 ";\n"
+		"\toffset_s = %" PRId64 ";\n"
+		"\toffset = %" PRId64 ";\n"
+		"};\n\n"
+		"typealias integer { size = 64; align = 8; signed = false;"
+		" map = clock.tsc.value; } := uint64_clock_t;\n\n"
+		"stream {\n"
+		"\tid = 0;\n"
+		"\tpacket.context := struct {\n"
+		"\t\tuint32_t lcore_id;\n"
+		"\t\tuint32_t reserved;\n"
+		"\t};\n"
+		"\tevent.header := struct {\n"
+		"\t\tuint64_clock_t timestamp;\n"
+		"\t\tuint16_t id;\n"
+		"\t\tuint16_t nb_args;\n"
+		"\t\tuint32_t reserved;\n"
+		"\t};\n"
+		"};\n",
+		RTE_BYTE_ORDER == RTE_LITTLE_ENDIAN ? "le" : "be",
+		rte_version(), hz,
+		offset_ns / (int64_t)NS_PER_S,
+		(offset_ns % (int64_t)NS_PER_S) * (int64_t)hz /
+			(int64_t)NS_PER_S);
+
+	for (i = 0; i < trace_points_count; i++) {
+		fprintf(f, "\nevent {\n"
+			"\tname = \"%s\";\n"
+			"\tid = %u;\n"
+			"\tstream_id = 0;\n"
+			"\tfields := struct {\n",
+			trace_points[i]->name, i);
+		for (j = 0; j < RTE_TRACE_MAX_ARGS; j++)
+			fprintf(f, "\t\tuint64_t arg%u;\n", j);
+		fprintf(f, "\t};\n};\n");
+	}
+
+	return ferror(f) ? -EIO : 0;
+}
+
+/* write the events of an lcore in a CTF stream file, oldest first */
+static int
+trace_save_lcore(FILE *f, unsigned int lcore_id,
+		const struct trace_buf *buf)
+{
+	struct trace_packet_header hdr = {
+		.magic = TRACE_CTF_MAGIC,
+		.stream_id = 0,
+		.lcore_id = lcore_id,
+	};
+	uint64_t head = buf->head;
+	uint64_t i = head > RTE_TRACE_BUF_SIZE ? head - RTE_TRACE_BUF_SIZE : 0;
+
+	fwrite(&hdr, sizeof(hdr), 1, f);
+	for (; i < head; i++)
+		fwrite(&buf->events[i & TRACE_BUF_MASK],
+			sizeof(struct trace_event), 1, f);
+
+	return ferror(f) ? -EIO : 0;
+}
+
+int
+rte_trace_save(const char *dir)
+{
+	char path[PATH_MAX];
+	unsigned int i;
+	FILE *f;
+	int ret;
+
+	if (dir == NULL)
+		return -EINVAL;
+	if (mkdir(dir, 0700) < 0 && errno != EEXIST)
+		return -errno;
+
+	snprintf(path, sizeof(path), "%s/metadata", dir);
+	f = fopen(path, "w");
+	if (f == NULL)
+		return -errno;
+	ret = trace_save_metadata(f);
+	fclose(f);
+	if (ret < 0)
+		return ret;
+
+	for (i = 0; i < RTE_MAX_LCORE; i++) {
+		if (trace_bufs[i] == NULL || trace_bufs[i]->head == 0)
+			continue;
+		snprintf(path, sizeof(path), "%s/channel0_%u", dir, i);
+		f = fopen(path, "w");
+		if (f == NULL)
+			return -errno;
+		ret = trace_save_lcore(f, i, trace_bufs[i]);
+		fclose(f);
+		if (ret < 0)
+			return ret;
+	}
+
+	return 0;
+}
+
+void
+rte_trace_dump(FILE *f)
+{
+	unsigned int i;
+
+	fprintf(f, "%u tracepoints:\n", trace_points_count);
+	for (i = 0; i < trace_points_count; i++)
+		fprintf(f, "  id %u: %s, %s\n", i, trace_points[i]->name,
+			trace_points[i]->enabled ? "enabled" : "disabled");
+
+	for (i = 0; i < RTE_MAX_LCORE; i++) {
+		if (trace_bufs[i] == NULL || trace_bufs[i]->head == 0)
+			continue;
+		fprintf(f, "lcore %u: %" PRIu64 " events recorded\n", i,
+			trace_bufs[i]->head);
+	}
+}
@@ -67,6 +67,23 @@ eal_runtime_config_path(void)
 	return buffer;
 }
 
+/** Path of the multi-process channel socket of the primary process. */
+#define MP_SOCKET_FMT "%s/.%s_unix"
+
+static inline const char *
+eal_mp_socket_path(void)
+{
+	static char buffer[PATH_MAX]; /* static so auto-zeroed */
+	const char *directory = default_config_dir;
+	const char *home_dir = getenv("HOME");
+
+	if (getuid() != 0 && home_dir != NULL)
+		directory = home_dir;
+	snprintf(buffer, sizeof(buffer) - 1, MP_SOCKET_FMT, directory,
+			internal_config.hugefile_prefix);
+	return buffer;
+}
+
 /** Path of hugepage info file. */
 #define HUGEPAGE_INFO_FMT "%s/.%s_hugepage_info"
 
@@ -87,6 +104,7 @@ eal_hugepage_info_path(void)
 /** String format for hugepage map files. */
 #define HUGEFILE_FMT "%s/%smap_%d"
 #define TEMP_HUGEFILE_FMT "%s/%smap_temp_%d"
+#define HOTPLUG_HUGEFILE_FMT "%s/%smap_hotplug_%d"
 
 static inline const char *
 eal_get_hugefile_path(char *buffer, size_t buflen, const char *hugedir, int f_id)
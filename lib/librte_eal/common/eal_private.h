@@ -36,6 +36,7 @@
 
 #include <stdbool.h>
 #include <stdio.h>
+#include <rte_memory.h>
 #include <rte_pci.h>
 
 /**
@@ -246,6 +247,17 @@ int pci_uio_map_resource_by_index(struct rte_pci_device *dev, int res_idx,
  */
 int rte_eal_tailqs_init(void);
 
+/**
+ * Create the socket and the thread of the multi-process channel, used by
+ * rte_mp_sendmsg() and the other rte_mp functions.
+ *
+ * This function is private to EAL.
+ *
+ * @return
+ *   0 on success, -1 on error
+ */
+int rte_mp_channel_init(void);
+
 /**
  * Init interrupt handling.
  *
@@ -327,6 +339,38 @@ int rte_eal_hugepage_init(void);
  */
 int rte_eal_hugepage_attach(void);
 
+/**
+ * Map a new memory segment of at least len bytes on a socket, for the
+ * heap to grow when it is exhausted (--mem-hotplug, primary process only).
+ * The memseg is appended to the memseg table.
+ *
+ * This function is private to the EAL.
+ *
+ * @return
+ *   The index of the new memseg, or -1 on failure.
+ */
+int eal_memseg_hotplug_add(int socket_id, size_t len);
+
+/**
+ * Unmap a hotplugged memory segment. Only the last used memseg of the
+ * table can be removed, so that the table never has holes. Only the
+ * primary process removes memsegs.
+ *
+ * This function is private to the EAL.
+ *
+ * @return
+ *   0 on success, -1 if the memseg cannot be removed.
+ */
+int eal_memseg_hotplug_remove(struct rte_memseg *ms);
+
+/**
+ * Map in a secondary process the memsegs hotplugged by the primary
+ * process since the last call, and unmap the removed ones.
+ *
+ * This function is private to the EAL.
+ */
+void eal_memseg_hotplug_sync(void);
+
 /**
  * Returns true if the system is able to obtain
  * physical addresses. Return false if using DMA
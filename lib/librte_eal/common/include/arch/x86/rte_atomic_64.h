@@ -196,4 +196,30 @@ static inline void rte_atomic64_clear(rte_atomic64_t *v)
 }
 #endif
 
+/*------------------------ 128 bit atomic operations -------------------------*/
+
+static inline int
+rte_atomic128_cmpset(volatile rte_int128_t *dst, rte_int128_t *exp,
+		const rte_int128_t *src)
+{
+	uint8_t res;
+
+	asm volatile (
+			MPLOCKED
+			"cmpxchg16b %[dst];"
+			"sete %[res];"
+			: [dst] "=m" (dst->val[0]),  /* output */
+			  "=a" (exp->val[0]),
+			  "=d" (exp->val[1]),
+			  [res] "=r" (res)
+			: "b" (src->val[0]),         /* input */
+			  "c" (src->val[1]),
+			  "a" (exp->val[0]),
+			  "d" (exp->val[1]),
+			  "m" (dst->val[0])
+			: "memory");                 /* no-clobber list */
+
+	return res;
+}
+
 #endif /* _RTE_ATOMIC_X86_64_H_ */
@@ -970,4 +970,65 @@ static inline void rte_atomic64_clear(rte_atomic64_t *v)
 }
 #endif
 
+/*------------------------ 128 bit atomic operations -------------------------*/
+
+#ifdef __SIZEOF_INT128__
+
+/**
+ * 128-bit integer structure, aligned for the 128-bit atomic operations.
+ */
+RTE_STD_C11
+typedef struct {
+	RTE_STD_C11
+	union {
+		uint64_t val[2];     /**< Value as two 64-bit words. */
+		__int128 int128;     /**< Value as a 128-bit integer. */
+	};
+} __rte_aligned(16) rte_int128_t;
+
+#ifdef __DOXYGEN__
+
+/**
+ * An atomic compare and set function used by lock-free data structures.
+ * (atomic) equivalent to:
+ *   if (*dst == *exp)
+ *     *dst = *src (all 128-bit words)
+ *   else
+ *     *exp = *dst
+ *
+ * This function is only implemented on the 64-bit architectures which
+ * provide a 128-bit compare and swap (x86_64, and arm64 with
+ * RTE_FORCE_INTRINSICS).
+ *
+ * @param dst
+ *   The destination into which the value will be written.
+ * @param exp
+ *   Pointer to the expected value. If the operation fails, it is updated
+ *   with the current value of *dst.
+ * @param src
+ *   Pointer to the new value.
+ * @return
+ *   Non-zero on success; 0 on failure.
+ */
+static inline int
+rte_atomic128_cmpset(volatile rte_int128_t *dst, rte_int128_t *exp,
+		const rte_int128_t *src);
+
+#endif /* __DOXYGEN__ */
+
+#if defined(RTE_FORCE_INTRINSICS) && defined(RTE_ARCH_ARM64)
+static inline int
+rte_atomic128_cmpset(volatile rte_int128_t *dst, rte_int128_t *exp,
+		const rte_int128_t *src)
+{
+	__int128 old = exp->int128;
+
+	exp->int128 = __sync_val_compare_and_swap(&dst->int128, old,
+			src->int128);
+	return exp->int128 == old;
+}
+#endif
+
+#endif /* __SIZEOF_INT128__ */
+
 #endif /* _RTE_ATOMIC_H_ */
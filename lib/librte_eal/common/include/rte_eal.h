@@ -42,6 +42,7 @@
 
 #include <stdint.h>
 #include <sched.h>
+#include <time.h>
 
 #include <rte_per_lcore.h>
 #include <rte_config.h>
@@ -56,11 +57,12 @@ extern "C" {
 #define RTE_MAX_THREAD_NAME_LEN 16
 
 /**
- * The lcore role (used in RTE or not).
+ * The lcore role (used in RTE, as a service lcore, or not).
  */
 enum rte_lcore_role_t {
 	ROLE_RTE,
 	ROLE_OFF,
+	ROLE_SERVICE,
 };
 
 /**
@@ -205,6 +207,149 @@ int rte_eal_init(int argc, char **argv);
  */
 int rte_eal_primary_proc_alive(const char *config_file_path);
 
+#define RTE_MP_MAX_FD_NUM	8    /**< The max amount of fds in a message */
+#define RTE_MP_MAX_NAME_LEN	64   /**< The max length of an action name */
+#define RTE_MP_MAX_PARAM_LEN	256  /**< The max length of the parameters */
+
+/**
+ * A message exchanged between the primary and the secondary processes.
+ */
+struct rte_mp_msg {
+	char name[RTE_MP_MAX_NAME_LEN]; /**< Name of the action */
+	int len_param;                  /**< Number of bytes used in param */
+	int num_fds;                    /**< Number of fds used in fds */
+	uint8_t param[RTE_MP_MAX_PARAM_LEN]; /**< Action specific data */
+	int fds[RTE_MP_MAX_FD_NUM];     /**< Fds passed to the peer */
+};
+
+/**
+ * The replies collected by a request.
+ */
+struct rte_mp_reply {
+	int nb_sent;             /**< Number of processes the request went to */
+	int nb_received;         /**< Number of replies in msgs */
+	struct rte_mp_msg *msgs; /**< Replies, to be freed by the caller */
+};
+
+/**
+ * Action function typedef used by the other process to send a message.
+ *
+ * @param msg
+ *   The message received. The fds it carries belong to the action.
+ * @param peer
+ *   An opaque identifier of the sender, to be given to rte_mp_reply().
+ * @return
+ *   0 on success, a negative value on error.
+ */
+typedef int (*rte_mp_t)(const struct rte_mp_msg *msg, const void *peer);
+
+/**
+ * Function typedef called when all the replies to an asynchronous request
+ * are received or timed out.
+ *
+ * @param request
+ *   The request sent.
+ * @param reply
+ *   The replies received. The msgs array is freed after the call.
+ * @return
+ *   0 on success, a negative value on error.
+ */
+typedef int (*rte_mp_async_reply_t)(const struct rte_mp_msg *request,
+		const struct rte_mp_reply *reply);
+
+/**
+ * Register an action to run when a message with this name is received.
+ *
+ * Actions run in the EAL multi-process thread, one at a time. They must
+ * not call rte_mp_request_sync().
+ *
+ * @param name
+ *   The name of the action, at most RTE_MP_MAX_NAME_LEN - 1 characters.
+ * @param action
+ *   The function to call.
+ * @return
+ *   0 on success, -1 with rte_errno set on error:
+ *   - EINVAL: invalid name.
+ *   - EEXIST: an action is already registered with this name.
+ *   - ENOMEM: out of memory.
+ *   - ENOTSUP: no multi-process channel (--no-shconf).
+ */
+int rte_mp_action_register(const char *name, rte_mp_t action);
+
+/**
+ * Unregister an action.
+ *
+ * @param name
+ *   The name of the action.
+ */
+void rte_mp_action_unregister(const char *name);
+
+/**
+ * Send a message without waiting for an answer.
+ *
+ * A primary process sends it to all the secondary processes, a secondary
+ * process sends it to the primary process.
+ *
+ * @param msg
+ *   The message to send.
+ * @return
+ *   0 on success, -1 with rte_errno set on error.
+ */
+int rte_mp_sendmsg(struct rte_mp_msg *msg);
+
+/**
+ * Send a request and wait for the replies.
+ *
+ * A primary process sends it to all the secondary processes, a secondary
+ * process sends it to the primary process. A process with no action of
+ * this name ignores the request, which is not counted in reply->nb_sent.
+ * This function must not be called from an action.
+ *
+ * @param req
+ *   The request to send.
+ * @param reply
+ *   The replies received. reply->msgs must be freed with free().
+ * @param ts
+ *   The maximum time to wait for the replies.
+ * @return
+ *   0 on success, -1 with rte_errno set on error:
+ *   - ETIMEDOUT: a peer did not reply in time.
+ *   - EDEADLK: called from an action.
+ */
+int rte_mp_request_sync(struct rte_mp_msg *req, struct rte_mp_reply *reply,
+		const struct timespec *ts);
+
+/**
+ * Send a request and return without waiting for the replies.
+ *
+ * The callback is called in the EAL multi-process thread when all the
+ * peers have replied or when the timeout expires, also when the request
+ * could not be sent to any peer.
+ *
+ * @param req
+ *   The request to send.
+ * @param ts
+ *   The maximum time to wait for the replies.
+ * @param clb
+ *   The function to call with the replies.
+ * @return
+ *   0 on success, -1 with rte_errno set on error.
+ */
+int rte_mp_request_async(struct rte_mp_msg *req, const struct timespec *ts,
+		rte_mp_async_reply_t clb);
+
+/**
+ * Reply to a request, from its action.
+ *
+ * @param msg
+ *   The reply. Its name must be the name of the request.
+ * @param peer
+ *   The peer given to the action.
+ * @return
+ *   0 on success, -1 with rte_errno set on error.
+ */
+int rte_mp_reply(struct rte_mp_msg *msg, const void *peer);
+
 /**
  * Usage function typedef used by the application usage function.
  *
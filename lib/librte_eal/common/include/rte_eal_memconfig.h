@@ -39,11 +39,25 @@
 #include <rte_memzone.h>
 #include <rte_malloc_heap.h>
 #include <rte_rwlock.h>
+#include <rte_spinlock.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/** Maximum length of the backing file path of a hotplugged memseg. */
+#define RTE_MEMSEG_HOTPLUG_PATH_LEN 256
+
+/**
+ * Descriptor of a memory segment mapped at runtime (memory hotplug).
+ * Only the primary process adds and removes such segments, secondary
+ * processes map them again from the backing file.
+ */
+struct rte_memseg_hotplug {
+	uint32_t gen;   /**< hotplug_gen when added, 0 if not hotplugged. */
+	char path[RTE_MEMSEG_HOTPLUG_PATH_LEN]; /**< Empty if anonymous. */
+};
+
 /**
  * the structure for the memory configuration for the RTE.
  * Used by the rte_config structure. It is separated out, as for multi-process
@@ -78,6 +92,11 @@ struct rte_mem_config {
 	/* Heaps of Malloc per socket */
 	struct malloc_heap malloc_heaps[RTE_MAX_NUMA_NODES];
 
+	/* memory hotplug, nested in the heap locks */
+	rte_spinlock_t hotplug_lock; /**< Protects hotplug memseg updates. */
+	volatile uint32_t hotplug_gen; /**< Incremented at each memseg change. */
+	struct rte_memseg_hotplug hotplug[RTE_MAX_MEMSEG]; /**< Per memseg. */
+
 	/* address of mem_config in primary process. used to map shared config into
 	 * exact same address the primary process maps it.
 	 */
@@ -250,6 +250,54 @@ int rte_log_register(const char *name);
  */
 void rte_log_dump(FILE *f);
 
+/**
+ * Enable the deferred logging mode.
+ *
+ * In deferred mode, the messages logged by an EAL lcore are not written by
+ * this lcore: it copies the format, the arguments and a time stamp in a
+ * ring of the lcore, without taking any lock. The messages are formatted
+ * and written in time order by rte_log_deferred_flush(), which is run by
+ * the "log" service, see rte_service.h, or called by the application, and
+ * when the process exits.
+ *
+ * The level and type filtering is done before the message is stored.
+ * The messages of level RTE_LOG_CRIT or more critical are written at once,
+ * after the pending messages. The messages of non-EAL threads, the
+ * messages with a format not handled in deferred mode (positional
+ * arguments, wide characters, %n) and the messages with too long a format
+ * or string arguments are formatted by the caller, and queued in a shared
+ * ring to be written in order by rte_log_deferred_flush(); they are only
+ * written at once if this ring is full or if they are longer than 1KB.
+ * When the ring of an lcore is full, its messages are dropped, see
+ * rte_log_dump(), and rte_log() returns a negative value.
+ *
+ * A deferred message is not formatted when it is logged: rte_log() and
+ * rte_vlog() return 0 instead of the number of characters written.
+ *
+ * @return
+ *   - 0: Success.
+ *   - (-EALREADY): The deferred mode is already enabled.
+ *   - (-ENOMEM): The rings cannot be allocated.
+ */
+int rte_log_deferred_enable(void);
+
+/**
+ * Disable the deferred logging mode, and write the pending messages.
+ *
+ * @return
+ *   - 0: Success.
+ *   - (-EALREADY): The deferred mode is not enabled.
+ */
+int rte_log_deferred_disable(void);
+
+/**
+ * Format and write the messages stored in deferred mode.
+ *
+ * @return
+ *   The number of messages written.
+ */
+int rte_log_deferred_flush(void);
+
 /**
  * Generates a log message.
  *
@@ -304,7 +352,7 @@ int rte_log(uint32_t level, uint32_t logtype, const char *format, ...)
  * @param ap
  *   The va_list of the variable arguments required by the format.
  * @return
- *   - 0: Success.
+ *   - 0: Success, or the message is deferred, see rte_log_deferred_enable().
  *   - Negative on error.
  */
 int rte_vlog(uint32_t level, uint32_t logtype, const char *format, va_list ap)
@@ -58,6 +58,10 @@ struct rte_malloc_socket_stats {
 	unsigned free_count;       /**< Number of free elements on heap */
 	unsigned alloc_count;      /**< Number of allocated elements on heap */
 	size_t heap_allocsz_bytes; /**< Total allocated bytes on heap */
+	unsigned cache_count;      /**< Number of elements in lcore caches */
+	size_t cache_sz_bytes;     /**< Total bytes held in lcore caches */
+	uint64_t cache_hits;       /**< Allocations served by lcore caches */
+	uint64_t cache_misses;     /**< Cacheable allocations not served */
 };
 
 /**
@@ -0,0 +1,367 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _RTE_SERVICE_H_
+#define _RTE_SERVICE_H_
+
+/**
+ * @file
+ *
+ * RTE Service API
+ *
+ * Components such as a software event scheduler, a timer manager or a
+ * statistics poller need CPU cycles to run, which are usually given by
+ * calling a function of the component from a loop of the application.
+ * These components can instead register a service, see
+ * rte_service_component.h. The application maps the services to service
+ * lcores, which run the services mapped to them in a loop, with per-service
+ * cycle accounting. So housekeeping work can be packed on a few lcores.
+ *
+ * Service lcores are EAL lcores given with the -s or -S EAL option, or
+ * added with rte_service_lcore_add(). They are not part of the lcores
+ * used by rte_eal_mp_remote_launch() or RTE_LCORE_FOREACH().
+ *
+ * A service which is not multi-thread safe (no RTE_SERVICE_CAP_MT_SAFE
+ * capability) is run by one lcore at a time, even when mapped to several.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Maximum length of a service name, including the terminating '\0'. */
+#define RTE_SERVICE_NAME_MAX 32
+
+/** The service can be run by several lcores at the same time. */
+#define RTE_SERVICE_CAP_MT_SAFE (1 << 0)
+
+/** Number of calls to the service callback, see rte_service_attr_get(). */
+#define RTE_SERVICE_ATTR_CALL_COUNT 0
+/** Cycles spent in the service callback, see rte_service_attr_get(). */
+#define RTE_SERVICE_ATTR_CYCLES 1
+
+/**
+ * Return the number of registered services.
+ *
+ * The service ids are in the range [0, count) when no service was
+ * unregistered.
+ *
+ * @return
+ *   The number of registered services.
+ */
+uint32_t rte_service_get_count(void);
+
+/**
+ * Get the id of a service from its name.
+ *
+ * @param name
+ *   The name of the service.
+ * @param service_id
+ *   Pointer to store the id of the service.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): Invalid parameter.
+ *   - (-ENODEV): No service has this name.
+ */
+int32_t rte_service_get_by_name(const char *name, uint32_t *service_id);
+
+/**
+ * Get the name of a service.
+ *
+ * @param id
+ *   The id of the service.
+ * @return
+ *   The name of the service, or NULL if the id is invalid.
+ */
+const char *rte_service_get_name(uint32_t id);
+
+/**
+ * Check if a service has a capability.
+ *
+ * @param id
+ *   The id of the service.
+ * @param capability
+ *   A RTE_SERVICE_CAP_* flag.
+ * @return
+ *   1 if the service has the capability, 0 if not, or -EINVAL if the id
+ *   is invalid.
+ */
+int32_t rte_service_probe_capability(uint32_t id, uint32_t capability);
+
+/**
+ * Map or unmap a service to a service lcore.
+ *
+ * @param service_id
+ *   The id of the service.
+ * @param lcore
+ *   The id of the service lcore.
+ * @param enable
+ *   1 to map the service, 0 to unmap it.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): Invalid service id, or the lcore is not a service lcore.
+ */
+int32_t rte_service_map_lcore_set(uint32_t service_id, uint32_t lcore,
+		uint32_t enable);
+
+/**
+ * Check if a service is mapped to a service lcore.
+ *
+ * @param service_id
+ *   The id of the service.
+ * @param lcore
+ *   The id of the service lcore.
+ * @return
+ *   1 if the service is mapped to the lcore, 0 if not, or -EINVAL if a
+ *   parameter is invalid.
+ */
+int32_t rte_service_map_lcore_get(uint32_t service_id, uint32_t lcore);
+
+/**
+ * Set the application run state of a service.
+ *
+ * A service is run when both the application and the component started
+ * it.
+ *
+ * @param id
+ *   The id of the service.
+ * @param runstate
+ *   1 to start the service, 0 to stop it.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): Invalid service id.
+ */
+int32_t rte_service_runstate_set(uint32_t id, uint32_t runstate);
+
+/**
+ * Get the run state of a service.
+ *
+ * @param id
+ *   The id of the service.
+ * @return
+ *   1 if the service is started by both the application and the
+ *   component, 0 if not, or -EINVAL if the id is invalid.
+ */
+int32_t rte_service_runstate_get(uint32_t id);
+
+/**
+ * Enable or disable the statistics of a service.
+ *
+ * The statistics cost two reads of the time stamp counter at each call of
+ * the service callback. They are disabled by default.
+ *
+ * @param id
+ *   The id of the service.
+ * @param enable
+ *   1 to enable the statistics, 0 to disable them.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): Invalid service id.
+ */
+int32_t rte_service_set_stats_enable(uint32_t id, int32_t enable);
+
+/**
+ * Get a statistic of a service.
+ *
+ * @param id
+ *   The id of the service.
+ * @param attr_id
+ *   RTE_SERVICE_ATTR_CALL_COUNT or RTE_SERVICE_ATTR_CYCLES.
+ * @param attr_value
+ *   Pointer to store the value of the statistic.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): Invalid parameter.
+ */
+int32_t rte_service_attr_get(uint32_t id, uint32_t attr_id,
+		uint64_t *attr_value);
+
+/**
+ * Reset the statistics of a service.
+ *
+ * @param id
+ *   The id of the service.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): Invalid service id.
+ */
+int32_t rte_service_attr_reset_all(uint32_t id);
+
+/**
+ * Run one iteration of a service on the calling lcore.
+ *
+ * This allows an application lcore to run a service itself, for instance
+ * when there are no service lcores.
+ *
+ * @param id
+ *   The id of the service.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): Invalid service id.
+ *   - (-ENOEXEC): The service is not started.
+ *   - (-EBUSY): The service is not multi-thread safe, and is running on
+ *     another lcore.
+ */
+int32_t rte_service_run_iter_on_app_lcore(uint32_t id);
+
+/**
+ * Make an lcore a service lcore.
+ *
+ * The lcore must be an EAL lcore, other than the master lcore, which is
+ * not running a function. It is not used by rte_eal_mp_remote_launch()
+ * any more.
+ *
+ * @param lcore
+ *   The id of the lcore.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): The lcore cannot become a service lcore.
+ *   - (-EALREADY): The lcore is already a service lcore.
+ *   - (-EBUSY): The lcore is running a function.
+ */
+int32_t rte_service_lcore_add(uint32_t lcore);
+
+/**
+ * Make a service lcore an application lcore again.
+ *
+ * @param lcore
+ *   The id of the service lcore.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): The lcore is not a service lcore.
+ *   - (-EBUSY): The service lcore is running.
+ */
+int32_t rte_service_lcore_del(uint32_t lcore);
+
+/**
+ * Start running the services mapped to a service lcore.
+ *
+ * @param lcore
+ *   The id of the service lcore.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): The lcore is not a service lcore.
+ *   - (-EALREADY): The service lcore is already running.
+ */
+int32_t rte_service_lcore_start(uint32_t lcore);
+
+/**
+ * Stop a service lcore.
+ *
+ * The lcore stops after the current iteration of its services, this
+ * function waits for it.
+ *
+ * @param lcore
+ *   The id of the service lcore.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): The lcore is not a service lcore.
+ *   - (-EALREADY): The service lcore is already stopped.
+ */
+int32_t rte_service_lcore_stop(uint32_t lcore);
+
+/**
+ * Return the number of service lcores.
+ *
+ * @return
+ *   The number of service lcores.
+ */
+int32_t rte_service_lcore_count(void);
+
+/**
+ * Get the ids of the service lcores.
+ *
+ * @param array
+ *   Array to store the lcore ids.
+ * @param n
+ *   The size of the array.
+ * @return
+ *   The number of service lcores, -EINVAL if the array is NULL, or -ENOMEM
+ *   if the array is too small.
+ */
+int32_t rte_service_lcore_list(uint32_t array[], uint32_t n);
+
+/**
+ * Return the number of services mapped to a service lcore.
+ *
+ * @param lcore
+ *   The id of the service lcore.
+ * @return
+ *   The number of services, or -EINVAL if the lcore is not a service lcore.
+ */
+int32_t rte_service_lcore_count_services(uint32_t lcore);
+
+/**
+ * Stop all service lcores, unmap all services and give the service lcores
+ * back to the application.
+ *
+ * @return
+ *   0 on success.
+ */
+int32_t rte_service_lcore_reset_all(void);
+
+/**
+ * Map all services to the service lcores and start them.
+ *
+ * Each service is mapped to one service lcore, in a round-robin way,
+ * then all services and service lcores are started. This is done by the
+ * EAL at initialization when service lcores are given with the -s or -S
+ * EAL option.
+ *
+ * @return
+ *   - 0: Success.
+ *   - (-ENOTSUP): There are no service lcores.
+ */
+int32_t rte_service_start_with_defaults(void);
+
+/**
+ * Dump the state and statistics of a service, or of all services.
+ *
+ * @param f
+ *   A pointer to a file for output.
+ * @param id
+ *   The id of the service, or UINT32_MAX for all services.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): Invalid service id.
+ */
+int32_t rte_service_dump(FILE *f, uint32_t id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RTE_SERVICE_H_ */
@@ -0,0 +1,149 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _RTE_SERVICE_COMPONENT_H_
+#define _RTE_SERVICE_COMPONENT_H_
+
+/**
+ * @file
+ *
+ * RTE Service Component API
+ *
+ * Include this file if you are writing a component that requires CPU cycles
+ * to operate, and you wish to run the component using service cores: a
+ * software event scheduler, a timer manager, a statistics poller...
+ * The component registers a service, and the application maps it to the
+ * service lcores which run it.
+ */
+
+#include <stdint.h>
+
+#include <rte_service.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Signature of a callback function run by a service.
+ *
+ * @param args
+ *   The callback_userdata of the service.
+ * @return
+ *   Unused for now.
+ */
+typedef int32_t (*rte_service_func)(void *args);
+
+/**
+ * The specification of a service, given at registration.
+ */
+struct rte_service_spec {
+	/** The name of the service. */
+	char name[RTE_SERVICE_NAME_MAX];
+	/** The callback run each time the service is scheduled. */
+	rte_service_func callback;
+	/** The argument of the callback. */
+	void *callback_userdata;
+	/** Flags RTE_SERVICE_CAP_* of the service. */
+	uint32_t capabilities;
+	/** NUMA socket of the service, or SOCKET_ID_ANY. */
+	int socket_id;
+};
+
+/**
+ * Register a new service.
+ *
+ * A service is a callback which is called repeatedly by the service
+ * lcores it is mapped to, while it is running. It is stopped until both
+ * the component (with rte_service_component_runstate_set()) and the
+ * application (with rte_service_runstate_set()) start it.
+ *
+ * @param spec
+ *   The specification of the service. Its name must be unique.
+ * @param service_id
+ *   Pointer to store the id of the new service. May be NULL.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): Invalid specification, or a service has the same name.
+ *   - (-ENOSPC): No more space for services.
+ */
+int32_t rte_service_component_register(const struct rte_service_spec *spec,
+		uint32_t *service_id);
+
+/**
+ * Unregister a service.
+ *
+ * The service must not be running on any lcore any more when this function
+ * is called.
+ *
+ * @param id
+ *   The id of the service.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): Invalid service id.
+ */
+int32_t rte_service_component_unregister(uint32_t id);
+
+/**
+ * Set the component run state of a service.
+ *
+ * The component stops its service when it cannot be run, for instance
+ * while the device it polls is not configured.
+ *
+ * @param id
+ *   The id of the service.
+ * @param runstate
+ *   1 to start the service, 0 to stop it.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): Invalid service id.
+ */
+int32_t rte_service_component_runstate_set(uint32_t id, uint32_t runstate);
+
+/**
+ * Initialize the service library.
+ *
+ * Called by the EAL at initialization, before the devices are probed.
+ *
+ * @return
+ *   - 0: Success.
+ *   - (-EALREADY): The service library is already initialized.
+ *   - (-ENOMEM): The service data cannot be allocated.
+ */
+int32_t rte_service_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RTE_SERVICE_COMPONENT_H_ */
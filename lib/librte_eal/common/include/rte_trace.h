@@ -0,0 +1,218 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _RTE_TRACE_H_
+#define _RTE_TRACE_H_
+
+/**
+ * @file
+ *
+ * RTE Trace API
+ *
+ * A tracepoint records an event, made of a TSC time stamp, the id of the
+ * tracepoint and up to RTE_TRACE_MAX_ARGS integer arguments, in a buffer
+ * of the calling lcore. The buffer of each lcore keeps the last
+ * RTE_TRACE_BUF_SIZE events. The events are saved in the Common Trace
+ * Format (CTF) with rte_trace_save(), to be read by tools such as
+ * babeltrace.
+ *
+ * The tracepoints are disabled by default, and enabled at runtime by name
+ * with rte_trace_regexp() or the --trace EAL option. A disabled tracepoint
+ * costs a load and a predictable branch. The events of non-EAL threads are
+ * not recorded.
+ *
+ * A tracepoint is defined once with RTE_TRACE_POINT_DEFINE(), declared with
+ * RTE_TRACE_POINT_DECLARE() where it is used, and emitted with RTE_TRACE().
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include <rte_common.h>
+#include <rte_branch_prediction.h>
+#include <rte_eal.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Maximum number of arguments of a trace event. */
+#define RTE_TRACE_MAX_ARGS 4
+
+/** Maximum number of tracepoints. */
+#define RTE_TRACE_POINT_MAX 256
+
+/**
+ * A tracepoint. Use RTE_TRACE_POINT_DEFINE() to define one.
+ */
+struct rte_trace_point {
+	volatile uint32_t enabled; /**< Non-zero when events are recorded. */
+	uint16_t id;               /**< Identifier set at registration. */
+	const char *name;          /**< Name, the name of the definition. */
+};
+
+/**
+ * Register a tracepoint. Called by the constructor defined by
+ * RTE_TRACE_POINT_DEFINE().
+ *
+ * @param tp
+ *   The tracepoint.
+ */
+void rte_trace_point_register(struct rte_trace_point *tp);
+
+/**
+ * Record an event of an enabled tracepoint. Use RTE_TRACE().
+ *
+ * @param tp
+ *   The tracepoint.
+ * @param args
+ *   The arguments of the event.
+ * @param nb_args
+ *   The number of arguments, at most RTE_TRACE_MAX_ARGS.
+ */
+void __rte_trace_point_emit(struct rte_trace_point *tp,
+		const uint64_t *args, unsigned int nb_args);
+
+/**
+ * Define a tracepoint. It must be defined once, in a .c file.
+ *
+ * @param tp
+ *   The name of the tracepoint, a C identifier.
+ */
+#define RTE_TRACE_POINT_DEFINE(tp)					\
+struct rte_trace_point __rte_trace_ ## tp = { .name = RTE_STR(tp) };	\
+RTE_INIT(__rte_trace_register_ ## tp);					\
+static void __rte_trace_register_ ## tp(void)				\
+{									\
+	rte_trace_point_register(&__rte_trace_ ## tp);			\
+}
+
+/**
+ * Declare a tracepoint defined in another file.
+ *
+ * @param tp
+ *   The name of the tracepoint.
+ */
+#define RTE_TRACE_POINT_DECLARE(tp)					\
+	extern struct rte_trace_point __rte_trace_ ## tp
+
+/**
+ * Record an event if the tracepoint is enabled.
+ *
+ * The arguments are only evaluated when the tracepoint is enabled.
+ *
+ * @param tp
+ *   The name of the tracepoint.
+ * @param ...
+ *   Up to RTE_TRACE_MAX_ARGS integer arguments. Pointers must be cast to
+ *   uintptr_t.
+ */
+#define RTE_TRACE(tp, ...) do {						\
+	if (unlikely(__rte_trace_ ## tp.enabled)) {			\
+		const uint64_t __rte_trace_args[] = { 0, ## __VA_ARGS__ }; \
+		RTE_BUILD_BUG_ON(RTE_DIM(__rte_trace_args) - 1 >	\
+				RTE_TRACE_MAX_ARGS);			\
+		__rte_trace_point_emit(&__rte_trace_ ## tp,		\
+			&__rte_trace_args[1],				\
+			RTE_DIM(__rte_trace_args) - 1);			\
+	}								\
+} while (0)
+
+/**
+ * Get a tracepoint from its name.
+ *
+ * @param name
+ *   The name of the tracepoint.
+ * @return
+ *   The tracepoint, or NULL if not found.
+ */
+struct rte_trace_point *rte_trace_point_lookup(const char *name);
+
+/**
+ * Enable or disable a tracepoint.
+ *
+ * The trace buffers of the lcores are allocated when a tracepoint is
+ * enabled for the first time.
+ *
+ * @param tp
+ *   The tracepoint.
+ * @param enable
+ *   1 to enable the tracepoint, 0 to disable it.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): Invalid tracepoint.
+ *   - (-ENOMEM): The trace buffers cannot be allocated.
+ */
+int rte_trace_point_enable(struct rte_trace_point *tp, int enable);
+
+/**
+ * Enable or disable the tracepoints matching a regular expression.
+ *
+ * @param pattern
+ *   The regular expression matching the names of the tracepoints.
+ * @param enable
+ *   1 to enable the tracepoints, 0 to disable them.
+ * @return
+ *   The number of matching tracepoints on success, -EINVAL if the pattern
+ *   is invalid, or -ENOMEM if the trace buffers cannot be allocated.
+ */
+int rte_trace_regexp(const char *pattern, int enable);
+
+/**
+ * Save the events recorded by all lcores in the Common Trace Format.
+ *
+ * The directory gets a metadata file and one stream file per lcore having
+ * events. The events recorded while saving may be inconsistent, so the
+ * tracepoints are better disabled first.
+ *
+ * @param dir
+ *   The directory of the trace, created if needed.
+ * @return
+ *   - 0: Success.
+ *   - Negative errno value on failure.
+ */
+int rte_trace_save(const char *dir);
+
+/**
+ * Dump the tracepoints and the number of events of each lcore.
+ *
+ * @param f
+ *   A pointer to a file for output.
+ */
+void rte_trace_dump(FILE *f);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RTE_TRACE_H_ */
@@ -190,8 +190,8 @@ malloc_elem_free_list_insert(struct malloc_elem *elem)
 /*
  * Remove the specified element from its heap's free list.
  */
-static void
-elem_free_list_remove(struct malloc_elem *elem)
+void
+malloc_elem_free_list_remove(struct malloc_elem *elem)
 {
 	LIST_REMOVE(elem, free_list);
 }
@@ -211,7 +211,7 @@ malloc_elem_alloc(struct malloc_elem *elem, size_t size, unsigned align,
 	const size_t trailer_size = elem->size - old_elem_size - size -
 		MALLOC_ELEM_OVERHEAD;
 
-	elem_free_list_remove(elem);
+	malloc_elem_free_list_remove(elem);
 
 	if (trailer_size > MALLOC_ELEM_OVERHEAD + MIN_DATA_SIZE) {
 		/* split it, too much free space after elem */
@@ -264,23 +264,17 @@ join_elem(struct malloc_elem *elem1, struct malloc_elem *elem2)
 }
 
 /*
- * free a malloc_elem block by adding it to the free list. If the
- * blocks either immediately before or immediately after newly freed block
- * are also free, the blocks are merged together.
+ * free a malloc_elem block, with the heap already locked.
  */
-int
-malloc_elem_free(struct malloc_elem *elem)
+static void
+elem_free_locked(struct malloc_heap *heap, struct malloc_elem *elem)
 {
-	if (!malloc_elem_cookies_ok(elem) || elem->state != ELEM_BUSY)
-		return -1;
-
-	rte_spinlock_lock(&(elem->heap->lock));
 	size_t sz = elem->size - sizeof(*elem);
 	uint8_t *ptr = (uint8_t *)&elem[1];
 	struct malloc_elem *next = RTE_PTR_ADD(elem, elem->size);
 	if (next->state == ELEM_FREE){
 		/* remove from free list, join to this one */
-		elem_free_list_remove(next);
+		malloc_elem_free_list_remove(next);
 		join_elem(elem, next);
 		sz += sizeof(*elem);
 	}
@@ -289,7 +283,7 @@ malloc_elem_free(struct malloc_elem *elem)
 	 * need to re-insert in free list, as that element's size is changing
 	 */
 	if (elem->prev != NULL && elem->prev->state == ELEM_FREE) {
-		elem_free_list_remove(elem->prev);
+		malloc_elem_free_list_remove(elem->prev);
 		join_elem(elem->prev, elem);
 		sz += sizeof(*elem);
 		ptr -= sizeof(*elem);
@@ -298,15 +292,52 @@ malloc_elem_free(struct malloc_elem *elem)
 	malloc_elem_free_list_insert(elem);
 
 	/* decrease heap's count of allocated elements */
-	elem->heap->alloc_count--;
+	heap->alloc_count--;
 
 	memset(ptr, 0, sz);
 
-	rte_spinlock_unlock(&(elem->heap->lock));
+	/* a hotplugged memseg which is entirely free goes back to the OS */
+	if (elem->prev == NULL && malloc_heap_memseg_is_free(heap, elem->ms))
+		malloc_heap_release_memsegs(heap);
+}
+
+/*
+ * free a malloc_elem block by adding it to the free list. If the
+ * blocks either immediately before or immediately after newly freed block
+ * are also free, the blocks are merged together.
+ */
+int
+malloc_elem_free(struct malloc_elem *elem)
+{
+	struct malloc_heap *heap;
+
+	if (!malloc_elem_cookies_ok(elem) || elem->state != ELEM_BUSY)
+		return -1;
+
+	heap = elem->heap;
+	rte_spinlock_lock(&heap->lock);
+	elem_free_locked(heap, elem);
+	rte_spinlock_unlock(&heap->lock);
 
 	return 0;
 }
 
+/*
+ * free several malloc_elem blocks of the same heap, taking the heap lock
+ * only once. The blocks must have been checked by the caller.
+ */
+void
+malloc_elem_free_bulk(struct malloc_heap *heap, struct malloc_elem **elems,
+		unsigned int n)
+{
+	unsigned int i;
+
+	rte_spinlock_lock(&heap->lock);
+	for (i = 0; i < n; i++)
+		elem_free_locked(heap, elems[i]);
+	rte_spinlock_unlock(&heap->lock);
+}
+
 /*
  * attempt to resize a malloc_elem by expanding into any free space
  * immediately after it in memory.
@@ -330,7 +361,7 @@ malloc_elem_resize(struct malloc_elem *elem, size_t size)
 	/* we now know the element fits, so remove from free list,
 	 * join the two
 	 */
-	elem_free_list_remove(next);
+	malloc_elem_free_list_remove(next);
 	join_elem(elem, next);
 
 	if (elem->size - new_size >= MIN_DATA_SIZE + MALLOC_ELEM_OVERHEAD){
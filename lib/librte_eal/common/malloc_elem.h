@@ -42,7 +42,8 @@ struct malloc_heap;
 enum elem_state {
 	ELEM_FREE = 0,
 	ELEM_BUSY,
-	ELEM_PAD  /* element is a padding-only header */
+	ELEM_PAD,  /* element is a padding-only header */
+	ELEM_CACHED /* element is held in an lcore cache of rte_malloc */
 };
 
 struct malloc_elem {
@@ -170,6 +171,13 @@ malloc_elem_alloc(struct malloc_elem *elem, size_t size,
 int
 malloc_elem_free(struct malloc_elem *elem);
 
+/*
+ * free several malloc_elem blocks of the same heap at once.
+ */
+void
+malloc_elem_free_bulk(struct malloc_heap *heap, struct malloc_elem **elems,
+		unsigned int n);
+
 /*
  * attempt to resize a malloc_elem by expanding into any free space
  * immediately after it in memory.
@@ -189,4 +197,10 @@ malloc_elem_free_list_index(size_t size);
 void
 malloc_elem_free_list_insert(struct malloc_elem *elem);
 
+/*
+ * Remove element from its heap's free list.
+ */
+void
+malloc_elem_free_list_remove(struct malloc_elem *elem);
+
 #endif /* MALLOC_ELEM_H_ */
@@ -52,6 +52,7 @@
 
 #include "malloc_elem.h"
 #include "malloc_heap.h"
+#include "eal_private.h"
 
 static unsigned
 check_hugepage_sz(unsigned flags, uint64_t hugepage_sz)
@@ -90,6 +91,18 @@ check_hugepage_sz(unsigned flags, uint64_t hugepage_sz)
 	return check_flag & flags;
 }
 
+/*
+ * Get the dummy malloc_elem header set at the end of a memseg.
+ */
+static struct malloc_elem *
+memseg_end_elem(const struct rte_memseg *ms)
+{
+	struct malloc_elem *end_elem = RTE_PTR_ADD(ms->addr,
+			ms->len - MALLOC_ELEM_OVERHEAD);
+
+	return RTE_PTR_ALIGN_FLOOR(end_elem, RTE_CACHE_LINE_SIZE);
+}
+
 /*
  * Expand the heap with a memseg.
  * This reserves the zone and sets a dummy malloc_elem header at the end
@@ -101,9 +114,7 @@ malloc_heap_add_memseg(struct malloc_heap *heap, struct rte_memseg *ms)
 {
 	/* allocate the memory block headers, one at end, one at start */
 	struct malloc_elem *start_elem = (struct malloc_elem *)ms->addr;
-	struct malloc_elem *end_elem = RTE_PTR_ADD(ms->addr,
-			ms->len - MALLOC_ELEM_OVERHEAD);
-	end_elem = RTE_PTR_ALIGN_FLOOR(end_elem, RTE_CACHE_LINE_SIZE);
+	struct malloc_elem *end_elem = memseg_end_elem(ms);
 	const size_t elem_size = (uintptr_t)end_elem - (uintptr_t)start_elem;
 
 	malloc_elem_init(start_elem, heap, ms, elem_size);
@@ -145,11 +156,108 @@ find_suitable_element(struct malloc_heap *heap, size_t size,
 	return NULL;
 }
 
+/*
+ * Grow the heap with a hotplugged memseg big enough for a block of data of
+ * the requested size, alignment and boundary. Called with the heap locked.
+ */
+static int
+malloc_heap_grow(struct malloc_heap *heap, size_t size, size_t align,
+		size_t bound)
+{
+	struct rte_mem_config *mcfg = rte_eal_get_configuration()->mem_config;
+	size_t len;
+	int idx;
+
+	/* room for the start and end headers, the alignment padding and,
+	 * in the worst case, the data pushed behind a boundary */
+	len = size + align + 2 * MALLOC_ELEM_OVERHEAD + RTE_CACHE_LINE_SIZE;
+	if (bound != 0)
+		len += size;
+
+	idx = eal_memseg_hotplug_add(heap - mcfg->malloc_heaps, len);
+	if (idx < 0)
+		return -1;
+
+	malloc_heap_add_memseg(heap, &mcfg->memseg[idx]);
+	return 0;
+}
+
+/*
+ * Return true if the memseg was hotplugged in this heap and has no
+ * allocated element left. Called with the heap locked.
+ */
+int
+malloc_heap_memseg_is_free(const struct malloc_heap *heap,
+		const struct rte_memseg *ms)
+{
+	struct rte_mem_config *mcfg = rte_eal_get_configuration()->mem_config;
+	const struct malloc_elem *start_elem = ms->addr;
+
+	if (mcfg->hotplug[ms - mcfg->memseg].gen == 0)
+		return 0;
+	rte_rmb();
+
+	/* the heap may not have added the memseg yet */
+	return start_elem->heap == heap && start_elem->state == ELEM_FREE &&
+		RTE_PTR_ADD(start_elem, start_elem->size) ==
+			memseg_end_elem(ms);
+}
+
+/*
+ * Give back to the OS the hotplugged memsegs at the end of the memseg
+ * table, as long as they are entirely free. The table never has holes, so
+ * a free memseg followed by a used one is released later, along with it.
+ * Called with the given heap locked; the heaps of the other sockets are
+ * only try-locked to respect the lock order. Only the primary process
+ * removes memsegs, memory freed by a secondary process stays in the heap.
+ */
+void
+malloc_heap_release_memsegs(struct malloc_heap *locked_heap)
+{
+	struct rte_mem_config *mcfg = rte_eal_get_configuration()->mem_config;
+	struct malloc_elem *start_elem;
+	struct malloc_heap *heap;
+	struct rte_memseg *ms;
+	int idx, released;
+
+	if (rte_eal_process_type() != RTE_PROC_PRIMARY)
+		return;
+
+	do {
+		for (idx = RTE_MAX_MEMSEG - 1; idx >= 0; idx--)
+			if (mcfg->memseg[idx].len != 0)
+				break;
+		if (idx < 0 || mcfg->hotplug[idx].gen == 0)
+			return;
+
+		ms = &mcfg->memseg[idx];
+		heap = &mcfg->malloc_heaps[ms->socket_id];
+		if (heap != locked_heap && !rte_spinlock_trylock(&heap->lock))
+			return;
+
+		released = 0;
+		if (malloc_heap_memseg_is_free(heap, ms)) {
+			start_elem = ms->addr;
+			malloc_elem_free_list_remove(start_elem);
+			heap->total_size -= start_elem->size;
+			released = eal_memseg_hotplug_remove(ms) == 0;
+			if (!released) {
+				/* a memseg was added meanwhile */
+				heap->total_size += start_elem->size;
+				malloc_elem_free_list_insert(start_elem);
+			}
+		}
+
+		if (heap != locked_heap)
+			rte_spinlock_unlock(&heap->lock);
+	} while (released);
+}
+
 /*
  * Main function to allocate a block of memory from the heap.
  * It locks the free list, scans it, and adds a new memseg if the
- * scan fails. Once the new memseg is added, it re-scans and should return
- * the new element after releasing the lock.
+ * scan fails (only with --mem-hotplug). Once the new memseg is added, it
+ * re-scans and should return the new element after releasing the lock.
  */
 void *
 malloc_heap_alloc(struct malloc_heap *heap,
@@ -161,9 +269,21 @@ malloc_heap_alloc(struct malloc_heap *heap,
 	size = RTE_CACHE_LINE_ROUNDUP(size);
 	align = RTE_CACHE_LINE_ROUNDUP(align);
 
+	eal_memseg_hotplug_sync();
+
 	rte_spinlock_lock(&heap->lock);
 
 	elem = find_suitable_element(heap, size, flags, align, bound);
+	/* a new memseg may have any page size, so only grow when the page
+	 * size is not forced; a zero size asks for the biggest element */
+	if (elem == NULL && size != 0 &&
+			((flags & ~RTE_MEMZONE_SIZE_HINT_ONLY) == 0 ||
+			 (flags & RTE_MEMZONE_SIZE_HINT_ONLY)) &&
+			malloc_heap_grow(heap, size, align, bound) == 0) {
+		elem = find_suitable_element(heap, size, flags, align, bound);
+		if (elem == NULL)
+			malloc_heap_release_memsegs(heap);
+	}
 	if (elem != NULL) {
 		elem = malloc_elem_alloc(elem, size, align, bound);
 		/* increase heap's count of allocated elements */
@@ -174,6 +294,35 @@ malloc_heap_alloc(struct malloc_heap *heap,
 	return elem == NULL ? NULL : (void *)(&elem[1]);
 }
 
+/*
+ * Allocate up to n blocks of data of the same size, with the default
+ * alignment, taking the heap lock only once. The heap does not grow.
+ * Returns the number of blocks allocated.
+ */
+unsigned int
+malloc_heap_alloc_bulk(struct malloc_heap *heap, size_t size, void **objs,
+		unsigned int n)
+{
+	struct malloc_elem *elem;
+	unsigned int i;
+
+	size = RTE_CACHE_LINE_ROUNDUP(size);
+
+	rte_spinlock_lock(&heap->lock);
+	for (i = 0; i < n; i++) {
+		elem = find_suitable_element(heap, size, 0,
+				RTE_CACHE_LINE_SIZE, 0);
+		if (elem == NULL)
+			break;
+		elem = malloc_elem_alloc(elem, size, RTE_CACHE_LINE_SIZE, 0);
+		heap->alloc_count++;
+		objs[i] = &elem[1];
+	}
+	rte_spinlock_unlock(&heap->lock);
+
+	return i;
+}
+
 /*
  * Function to retrieve data for heap on given socket
  */
@@ -56,6 +56,17 @@ void *
 malloc_heap_alloc(struct malloc_heap *heap,	const char *type, size_t size,
 		unsigned flags, size_t align, size_t bound);
 
+unsigned int
+malloc_heap_alloc_bulk(struct malloc_heap *heap, size_t size, void **objs,
+		unsigned int n);
+
+int
+malloc_heap_memseg_is_free(const struct malloc_heap *heap,
+		const struct rte_memseg *ms);
+
+void
+malloc_heap_release_memsegs(struct malloc_heap *heap);
+
 int
 malloc_heap_get_stats(const struct malloc_heap *heap,
 		struct rte_malloc_socket_stats *socket_stats);
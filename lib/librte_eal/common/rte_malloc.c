@@ -32,6 +32,7 @@
  */
 
 #include <stdint.h>
+#include <inttypes.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <string.h>
@@ -52,13 +53,205 @@
 #include <rte_malloc.h>
 #include "malloc_elem.h"
 #include "malloc_heap.h"
+#include "eal_private.h"
 
+#if RTE_MALLOC_LCORE_CACHE_SIZE > 0
+
+/*
+ * Small objects are kept in per-lcore caches in front of the heaps, so that
+ * frequent allocations and frees of small sizes do not contend on the heap
+ * lock. There is one cache per size class, from one cache line up to
+ * MALLOC_CACHE_MAX_SIZE. The caches are private to each process.
+ * Each cache has its own lock, only contended when an allocation failing
+ * in another lcore flushes it. Elements held by a cache are in the
+ * ELEM_CACHED state.
+ */
+#define MALLOC_CACHE_NUM_CLASSES 4
+#define MALLOC_CACHE_MAX_SIZE (RTE_CACHE_LINE_SIZE << \
+		(MALLOC_CACHE_NUM_CLASSES - 1))
+#define MALLOC_CACHE_BULK (RTE_MALLOC_LCORE_CACHE_SIZE / 2 > 0 ? \
+		RTE_MALLOC_LCORE_CACHE_SIZE / 2 : 1)
+
+struct malloc_lcore_class_cache {
+	unsigned int len;
+	void *objs[RTE_MALLOC_LCORE_CACHE_SIZE];
+};
+
+struct malloc_lcore_cache {
+	rte_spinlock_t lock;
+	struct malloc_lcore_class_cache classes[MALLOC_CACHE_NUM_CLASSES];
+	uint64_t hits;
+	uint64_t misses;
+} __rte_cache_aligned;
+
+static struct malloc_lcore_cache malloc_lcore_caches[RTE_MAX_LCORE];
+
+/* return the size class index for a size, or -1 if it is not cacheable */
+static inline int
+malloc_cache_class(size_t size)
+{
+	int idx = 0;
+
+	if (size > MALLOC_CACHE_MAX_SIZE)
+		return -1;
+	while ((size_t)(RTE_CACHE_LINE_SIZE << idx) < size)
+		idx++;
+	return idx;
+}
+
+/*
+ * give back the n last elements of a class cache to their heap, with the
+ * cache locked
+ */
+static void
+malloc_cache_flush_class(struct malloc_lcore_class_cache *cc, unsigned int n)
+{
+	struct malloc_elem *elems[RTE_MALLOC_LCORE_CACHE_SIZE];
+	unsigned int i;
+
+	for (i = 0; i < n; i++) {
+		elems[i] = malloc_elem_from_data(cc->objs[cc->len - n + i]);
+		elems[i]->state = ELEM_BUSY;
+	}
+	cc->len -= n;
+	malloc_elem_free_bulk(elems[0]->heap, elems, n);
+}
+
+/* give back everything cached by all lcores to the heaps */
+static void
+malloc_cache_flush_all(void)
+{
+	struct malloc_lcore_cache *cache;
+	unsigned int lcore_id, i;
+
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		cache = &malloc_lcore_caches[lcore_id];
+		rte_spinlock_lock(&cache->lock);
+		for (i = 0; i < MALLOC_CACHE_NUM_CLASSES; i++)
+			if (cache->classes[i].len > 0)
+				malloc_cache_flush_class(&cache->classes[i],
+						cache->classes[i].len);
+		rte_spinlock_unlock(&cache->lock);
+	}
+}
+
+static void *
+malloc_cache_get(unsigned int lcore_id, struct malloc_heap *heap, int idx)
+{
+	struct malloc_lcore_cache *cache = &malloc_lcore_caches[lcore_id];
+	struct malloc_lcore_class_cache *cc = &cache->classes[idx];
+	struct malloc_elem *elem;
+	unsigned int i;
+	void *ret = NULL;
+
+	rte_spinlock_lock(&cache->lock);
+	if (cc->len == 0) {
+		cache->misses++;
+		eal_memseg_hotplug_sync();
+		cc->len = malloc_heap_alloc_bulk(heap,
+				RTE_CACHE_LINE_SIZE << idx, cc->objs,
+				MALLOC_CACHE_BULK);
+		for (i = 0; i < cc->len; i++)
+			malloc_elem_from_data(cc->objs[i])->state =
+				ELEM_CACHED;
+	} else
+		cache->hits++;
+
+	if (cc->len > 0) {
+		ret = cc->objs[--cc->len];
+		elem = malloc_elem_from_data(ret);
+		elem->state = ELEM_BUSY;
+	}
+	rte_spinlock_unlock(&cache->lock);
+
+	return ret;
+}
+
+/*
+ * put an element in the cache of the calling lcore, return 0 if it was
+ * cached or -1 if it has to be freed to the heap
+ */
+static int
+malloc_cache_put(struct malloc_elem *elem, void *addr)
+{
+	struct rte_mem_config *mcfg = rte_eal_get_configuration()->mem_config;
+	unsigned int lcore_id = rte_lcore_id();
+	struct malloc_lcore_cache *cache;
+	struct malloc_lcore_class_cache *cc;
+	struct malloc_heap *heap;
+	size_t size;
+	int idx;
+
+	/* a cached element freed again fails in the heap as a double free */
+	if (lcore_id == LCORE_ID_ANY || elem->pad != 0 ||
+			elem->state != ELEM_BUSY)
+		return -1;
+	heap = &mcfg->malloc_heaps[malloc_get_numa_socket()];
+	if (elem->heap != heap)
+		return -1;
+	size = elem->size - MALLOC_ELEM_OVERHEAD;
+	idx = malloc_cache_class(size);
+	if (idx < 0 || size != (size_t)(RTE_CACHE_LINE_SIZE << idx))
+		return -1;
+
+	/* the heap zeroes freed memory, rte_zmalloc relies on it */
+	memset(addr, 0, size);
+
+	cache = &malloc_lcore_caches[lcore_id];
+	cc = &cache->classes[idx];
+	rte_spinlock_lock(&cache->lock);
+	if (cc->len == RTE_MALLOC_LCORE_CACHE_SIZE)
+		malloc_cache_flush_class(cc, MALLOC_CACHE_BULK);
+	elem->state = ELEM_CACHED;
+	cc->objs[cc->len++] = addr;
+	rte_spinlock_unlock(&cache->lock);
+	return 0;
+}
+
+/* add the cache counters of all lcores of a socket to the stats */
+static void
+malloc_cache_get_stats(int socket, struct rte_malloc_socket_stats *stats)
+{
+	unsigned int lcore_id, i;
+
+	stats->cache_count = 0;
+	stats->cache_sz_bytes = 0;
+	stats->cache_hits = 0;
+	stats->cache_misses = 0;
+
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		struct malloc_lcore_cache *cache =
+			&malloc_lcore_caches[lcore_id];
+
+		if (!rte_lcore_is_enabled(lcore_id) ||
+				(int)rte_lcore_to_socket_id(lcore_id) != socket)
+			continue;
+		for (i = 0; i < MALLOC_CACHE_NUM_CLASSES; i++) {
+			stats->cache_count += cache->classes[i].len;
+			stats->cache_sz_bytes += cache->classes[i].len *
+				(RTE_CACHE_LINE_SIZE << i);
+		}
+		stats->cache_hits += cache->hits;
+		stats->cache_misses += cache->misses;
+	}
+}
+
+#endif /* RTE_MALLOC_LCORE_CACHE_SIZE > 0 */
 
 /* Free the memory space back to heap */
 void rte_free(void *addr)
 {
+	struct malloc_elem *elem;
+
 	if (addr == NULL) return;
-	if (malloc_elem_free(malloc_elem_from_data(addr)) < 0)
+	elem = malloc_elem_from_data(addr);
+#if RTE_MALLOC_LCORE_CACHE_SIZE > 0
+	if (elem != NULL && malloc_elem_cookies_ok(elem) &&
+			malloc_cache_put(elem, addr) == 0)
+		return;
+#endif
+	eal_memseg_hotplug_sync();
+	if (malloc_elem_free(elem) < 0)
 		rte_panic("Fatal error: Invalid memory\n");
 }
 
@@ -88,8 +281,30 @@ rte_malloc_socket(const char *type, size_t size, unsigned align, int socket_arg)
 	if (socket >= RTE_MAX_NUMA_NODES)
 		return NULL;
 
+#if RTE_MALLOC_LCORE_CACHE_SIZE > 0
+	unsigned int lcore_id = rte_lcore_id();
+	int idx = malloc_cache_class(size);
+
+	if (idx >= 0 && align <= RTE_CACHE_LINE_SIZE &&
+			lcore_id != LCORE_ID_ANY &&
+			socket == (int)malloc_get_numa_socket()) {
+		ret = malloc_cache_get(lcore_id, &mcfg->malloc_heaps[socket],
+				idx);
+		if (ret != NULL)
+			return ret;
+	}
+#endif
+
 	ret = malloc_heap_alloc(&mcfg->malloc_heaps[socket], type,
 				size, 0, align == 0 ? 1 : align, 0);
+#if RTE_MALLOC_LCORE_CACHE_SIZE > 0
+	/* memory held by the lcore caches may be enough */
+	if (ret == NULL) {
+		malloc_cache_flush_all();
+		ret = malloc_heap_alloc(&mcfg->malloc_heaps[socket], type,
+					size, 0, align == 0 ? 1 : align, 0);
+	}
+#endif
 	if (ret != NULL || socket_arg != SOCKET_ID_ANY)
 		return ret;
 
@@ -207,7 +422,19 @@ rte_malloc_get_socket_stats(int socket,
 	if (socket >= RTE_MAX_NUMA_NODES || socket < 0)
 		return -1;
 
-	return malloc_heap_get_stats(&mcfg->malloc_heaps[socket], socket_stats);
+	if (malloc_heap_get_stats(&mcfg->malloc_heaps[socket],
+				socket_stats) < 0)
+		return -1;
+
+#if RTE_MALLOC_LCORE_CACHE_SIZE > 0
+	malloc_cache_get_stats(socket, socket_stats);
+#else
+	socket_stats->cache_count = 0;
+	socket_stats->cache_sz_bytes = 0;
+	socket_stats->cache_hits = 0;
+	socket_stats->cache_misses = 0;
+#endif
+	return 0;
 }
 
 /*
@@ -231,6 +458,11 @@ rte_malloc_dump_stats(FILE *f, __rte_unused const char *type)
 				sock_stats.greatest_free_size);
 		fprintf(f, "\tAlloc_count:%u,\n",sock_stats.alloc_count);
 		fprintf(f, "\tFree_count:%u,\n", sock_stats.free_count);
+		fprintf(f, "\tCache_count:%u,\n", sock_stats.cache_count);
+		fprintf(f, "\tCache_size:%zu,\n", sock_stats.cache_sz_bytes);
+		fprintf(f, "\tCache_hits:%"PRIu64",\n", sock_stats.cache_hits);
+		fprintf(f, "\tCache_misses:%"PRIu64",\n",
+				sock_stats.cache_misses);
 	}
 	return;
 }
@@ -0,0 +1,737 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+
+#include <rte_common.h>
+#include <rte_memory.h>
+#include <rte_eal.h>
+#include <rte_lcore.h>
+#include <rte_launch.h>
+#include <rte_atomic.h>
+#include <rte_cycles.h>
+#include <rte_malloc.h>
+#include <rte_log.h>
+#include <rte_service.h>
+#include <rte_service_component.h>
+
+#define RTE_SERVICE_NUM_MAX 64
+
+#define SERVICE_F_REGISTERED    (1 << 0)
+#define SERVICE_F_STATS_ENABLED (1 << 1)
+
+/* runstates of the services and of the service lcores */
+#define RUNSTATE_STOPPED 0
+#define RUNSTATE_RUNNING 1
+
+/* internal representation of a service */
+struct rte_service_spec_impl {
+	/* public part of the service */
+	struct rte_service_spec spec;
+
+	/* taken by the lcore running a service which is not MT safe */
+	rte_atomic32_t execute_lock;
+
+	/* the service is run when both are RUNSTATE_RUNNING */
+	volatile uint8_t comp_runstate;
+	volatile uint8_t app_runstate;
+
+	/* SERVICE_F_* flags */
+	uint8_t internal_flags;
+
+	/* number of service lcores the service is mapped to */
+	rte_atomic32_t num_mapped_cores;
+
+	/* statistics of the service when run by non-EAL threads */
+	rte_atomic64_t calls;
+	rte_atomic64_t cycles_spent;
+} __rte_cache_aligned;
+
+/* state of an lcore with respect to services */
+struct core_state {
+	/* bit i is set when service i is mapped to the lcore */
+	volatile uint64_t service_mask;
+	volatile uint8_t runstate;
+	uint8_t is_service_core;
+	/* statistics of the services run by the lcore */
+	uint64_t calls_per_service[RTE_SERVICE_NUM_MAX];
+	uint64_t cycles_per_service[RTE_SERVICE_NUM_MAX];
+} __rte_cache_aligned;
+
+static uint32_t rte_service_count;
+static struct rte_service_spec_impl *rte_services;
+static struct core_state *lcore_states;
+
+int32_t
+rte_service_init(void)
+{
+	struct rte_config *cfg = rte_eal_get_configuration();
+	unsigned int i;
+
+	if (rte_services != NULL)
+		return -EALREADY;
+
+	rte_services = rte_calloc("rte_services", RTE_SERVICE_NUM_MAX,
+			sizeof(struct rte_service_spec_impl),
+			RTE_CACHE_LINE_SIZE);
+	if (rte_services == NULL) {
+		RTE_LOG(ERR, EAL, "error allocating rte services array\n");
+		return -ENOMEM;
+	}
+
+	lcore_states = rte_calloc("rte_service_core_states", RTE_MAX_LCORE,
+			sizeof(struct core_state), RTE_CACHE_LINE_SIZE);
+	if (lcore_states == NULL) {
+		RTE_LOG(ERR, EAL, "error allocating core states array\n");
+		rte_free(rte_services);
+		rte_services = NULL;
+		return -ENOMEM;
+	}
+
+	/* the lcores given with -s or -S are service lcores already */
+	for (i = 0; i < RTE_MAX_LCORE; i++)
+		if (cfg->lcore_role[i] == ROLE_SERVICE)
+			lcore_states[i].is_service_core = 1;
+
+	return 0;
+}
+
+/* returns the service if the id is valid and registered, or NULL */
+static inline struct rte_service_spec_impl *
+service_get(uint32_t id)
+{
+	if (rte_services == NULL || id >= RTE_SERVICE_NUM_MAX ||
+			!(rte_services[id].internal_flags &
+			  SERVICE_F_REGISTERED))
+		return NULL;
+	return &rte_services[id];
+}
+
+/* returns the state of the service lcore, or NULL */
+static inline struct core_state *
+service_lcore_get(uint32_t lcore)
+{
+	if (lcore_states == NULL || lcore >= RTE_MAX_LCORE ||
+			!lcore_states[lcore].is_service_core)
+		return NULL;
+	return &lcore_states[lcore];
+}
+
+static inline int
+service_mt_safe(const struct rte_service_spec_impl *s)
+{
+	return !!(s->spec.capabilities & RTE_SERVICE_CAP_MT_SAFE);
+}
+
+uint32_t
+rte_service_get_count(void)
+{
+	return rte_service_count;
+}
+
+int32_t
+rte_service_get_by_name(const char *name, uint32_t *service_id)
+{
+	uint32_t i;
+
+	if (name == NULL || service_id == NULL)
+		return -EINVAL;
+
+	for (i = 0; i < RTE_SERVICE_NUM_MAX; i++) {
+		if (service_get(i) != NULL &&
+				strcmp(name, rte_services[i].spec.name) == 0) {
+			*service_id = i;
+			return 0;
+		}
+	}
+
+	return -ENODEV;
+}
+
+const char *
+rte_service_get_name(uint32_t id)
+{
+	struct rte_service_spec_impl *s = service_get(id);
+
+	if (s == NULL)
+		return NULL;
+	return s->spec.name;
+}
+
+int32_t
+rte_service_probe_capability(uint32_t id, uint32_t capability)
+{
+	struct rte_service_spec_impl *s = service_get(id);
+
+	if (s == NULL)
+		return -EINVAL;
+	return !!(s->spec.capabilities & capability);
+}
+
+int32_t
+rte_service_component_register(const struct rte_service_spec *spec,
+		uint32_t *service_id)
+{
+	uint32_t i, free_slot = RTE_SERVICE_NUM_MAX;
+	struct rte_service_spec_impl *s;
+
+	if (rte_services == NULL || spec == NULL ||
+			spec->callback == NULL || spec->name[0] == '\0')
+		return -EINVAL;
+
+	for (i = 0; i < RTE_SERVICE_NUM_MAX; i++) {
+		if (service_get(i) == NULL) {
+			if (free_slot == RTE_SERVICE_NUM_MAX)
+				free_slot = i;
+			continue;
+		}
+		if (strncmp(spec->name, rte_services[i].spec.name,
+				RTE_SERVICE_NAME_MAX) == 0)
+			return -EINVAL;
+	}
+	if (free_slot == RTE_SERVICE_NUM_MAX)
+		return -ENOSPC;
+
+	s = &rte_services[free_slot];
+	memset(s, 0, sizeof(*s));
+	s->spec = *spec;
+	s->spec.name[RTE_SERVICE_NAME_MAX - 1] = '\0';
+	s->comp_runstate = RUNSTATE_STOPPED;
+	s->app_runstate = RUNSTATE_STOPPED;
+
+	rte_smp_wmb();
+	s->internal_flags |= SERVICE_F_REGISTERED;
+	rte_service_count++;
+
+	if (service_id != NULL)
+		*service_id = free_slot;
+
+	return 0;
+}
+
+int32_t
+rte_service_component_unregister(uint32_t id)
+{
+	struct rte_service_spec_impl *s = service_get(id);
+	const uint64_t service_mask = UINT64_C(1) << id;
+	uint32_t i;
+
+	if (s == NULL)
+		return -EINVAL;
+
+	rte_service_count--;
+	rte_smp_wmb();
+
+	s->internal_flags &= ~(SERVICE_F_REGISTERED);
+
+	/* clear the run-bit in all cores */
+	for (i = 0; i < RTE_MAX_LCORE; i++) {
+		lcore_states[i].service_mask &= ~service_mask;
+		lcore_states[i].calls_per_service[id] = 0;
+		lcore_states[i].cycles_per_service[id] = 0;
+	}
+
+	memset(&s->spec, 0, sizeof(s->spec));
+
+	return 0;
+}
+
+int32_t
+rte_service_component_runstate_set(uint32_t id, uint32_t runstate)
+{
+	struct rte_service_spec_impl *s = service_get(id);
+
+	if (s == NULL)
+		return -EINVAL;
+
+	s->comp_runstate = runstate ? RUNSTATE_RUNNING : RUNSTATE_STOPPED;
+	rte_smp_wmb();
+	return 0;
+}
+
+int32_t
+rte_service_runstate_set(uint32_t id, uint32_t runstate)
+{
+	struct rte_service_spec_impl *s = service_get(id);
+
+	if (s == NULL)
+		return -EINVAL;
+
+	s->app_runstate = runstate ? RUNSTATE_RUNNING : RUNSTATE_STOPPED;
+	rte_smp_wmb();
+	return 0;
+}
+
+int32_t
+rte_service_runstate_get(uint32_t id)
+{
+	struct rte_service_spec_impl *s = service_get(id);
+
+	if (s == NULL)
+		return -EINVAL;
+
+	rte_smp_rmb();
+	return s->comp_runstate == RUNSTATE_RUNNING &&
+		s->app_runstate == RUNSTATE_RUNNING;
+}
+
+/* run one iteration of service id, cs is NULL for non-EAL threads */
+static inline int32_t
+service_run(uint32_t id, struct rte_service_spec_impl *s,
+		struct core_state *cs)
+{
+	if (s->comp_runstate != RUNSTATE_RUNNING ||
+			s->app_runstate != RUNSTATE_RUNNING)
+		return -ENOEXEC;
+
+	/* a service which is not MT safe is run by one lcore at a time */
+	if (!service_mt_safe(s) &&
+			rte_atomic32_test_and_set(&s->execute_lock) == 0)
+		return -EBUSY;
+
+	if (s->internal_flags & SERVICE_F_STATS_ENABLED) {
+		uint64_t start = rte_rdtsc();
+		uint64_t cycles;
+
+		s->spec.callback(s->spec.callback_userdata);
+		cycles = rte_rdtsc() - start;
+
+		if (cs != NULL) {
+			cs->calls_per_service[id]++;
+			cs->cycles_per_service[id] += cycles;
+		} else {
+			rte_atomic64_inc(&s->calls);
+			rte_atomic64_add(&s->cycles_spent, cycles);
+		}
+	} else
+		s->spec.callback(s->spec.callback_userdata);
+
+	if (!service_mt_safe(s))
+		rte_atomic32_clear(&s->execute_lock);
+
+	return 0;
+}
+
+int32_t
+rte_service_run_iter_on_app_lcore(uint32_t id)
+{
+	struct rte_service_spec_impl *s = service_get(id);
+	unsigned int lcore = rte_lcore_id();
+
+	if (s == NULL)
+		return -EINVAL;
+
+	rte_smp_rmb();
+	return service_run(id, s,
+		lcore < RTE_MAX_LCORE ? &lcore_states[lcore] : NULL);
+}
+
+/* main loop of the service lcores */
+static int32_t
+service_runner_func(void *arg)
+{
+	struct core_state *cs = &lcore_states[rte_lcore_id()];
+
+	RTE_SET_USED(arg);
+
+	while (cs->runstate == RUNSTATE_RUNNING) {
+		uint64_t mask = cs->service_mask;
+
+		while (mask != 0) {
+			uint32_t id = __builtin_ctzll(mask);
+			struct rte_service_spec_impl *s = &rte_services[id];
+
+			mask &= mask - 1;
+			if (s->internal_flags & SERVICE_F_REGISTERED)
+				service_run(id, s, cs);
+		}
+
+		rte_smp_rmb();
+	}
+
+	return 0;
+}
+
+int32_t
+rte_service_set_stats_enable(uint32_t id, int32_t enable)
+{
+	struct rte_service_spec_impl *s = service_get(id);
+
+	if (s == NULL)
+		return -EINVAL;
+
+	if (enable)
+		s->internal_flags |= SERVICE_F_STATS_ENABLED;
+	else
+		s->internal_flags &= ~(SERVICE_F_STATS_ENABLED);
+
+	return 0;
+}
+
+/* sum the per-lcore statistics of a service */
+static void
+service_stats_get(uint32_t id, uint64_t *calls, uint64_t *cycles)
+{
+	struct rte_service_spec_impl *s = &rte_services[id];
+	uint32_t i;
+
+	*calls = rte_atomic64_read(&s->calls);
+	*cycles = rte_atomic64_read(&s->cycles_spent);
+	for (i = 0; i < RTE_MAX_LCORE; i++) {
+		*calls += lcore_states[i].calls_per_service[id];
+		*cycles += lcore_states[i].cycles_per_service[id];
+	}
+}
+
+int32_t
+rte_service_attr_get(uint32_t id, uint32_t attr_id, uint64_t *attr_value)
+{
+	uint64_t calls, cycles;
+
+	if (service_get(id) == NULL || attr_value == NULL)
+		return -EINVAL;
+
+	service_stats_get(id, &calls, &cycles);
+
+	switch (attr_id) {
+	case RTE_SERVICE_ATTR_CALL_COUNT:
+		*attr_value = calls;
+		return 0;
+	case RTE_SERVICE_ATTR_CYCLES:
+		*attr_value = cycles;
+		return 0;
+	default:
+		return -EINVAL;
+	}
+}
+
+int32_t
+rte_service_attr_reset_all(uint32_t id)
+{
+	struct rte_service_spec_impl *s = service_get(id);
+	uint32_t i;
+
+	if (s == NULL)
+		return -EINVAL;
+
+	rte_atomic64_clear(&s->calls);
+	rte_atomic64_clear(&s->cycles_spent);
+	for (i = 0; i < RTE_MAX_LCORE; i++) {
+		lcore_states[i].calls_per_service[id] = 0;
+		lcore_states[i].cycles_per_service[id] = 0;
+	}
+
+	return 0;
+}
+
+int32_t
+rte_service_map_lcore_set(uint32_t id, uint32_t lcore, uint32_t enable)
+{
+	struct rte_service_spec_impl *s = service_get(id);
+	struct core_state *cs = service_lcore_get(lcore);
+	const uint64_t sid_mask = UINT64_C(1) << id;
+
+	if (s == NULL || cs == NULL)
+		return -EINVAL;
+
+	if (enable && !(cs->service_mask & sid_mask)) {
+		cs->service_mask |= sid_mask;
+		rte_atomic32_inc(&s->num_mapped_cores);
+	} else if (!enable && (cs->service_mask & sid_mask)) {
+		cs->service_mask &= ~sid_mask;
+		rte_atomic32_dec(&s->num_mapped_cores);
+	}
+
+	return 0;
+}
+
+int32_t
+rte_service_map_lcore_get(uint32_t id, uint32_t lcore)
+{
+	struct core_state *cs = service_lcore_get(lcore);
+
+	if (service_get(id) == NULL || cs == NULL)
+		return -EINVAL;
+
+	return !!(cs->service_mask & (UINT64_C(1) << id));
+}
+
+/* unmap all services from a service lcore */
+static void
+service_lcore_unmap_all(struct core_state *cs)
+{
+	uint64_t mask = cs->service_mask;
+
+	cs->service_mask = 0;
+	while (mask != 0) {
+		uint32_t id = __builtin_ctzll(mask);
+
+		mask &= mask - 1;
+		rte_atomic32_dec(&rte_services[id].num_mapped_cores);
+	}
+}
+
+int32_t
+rte_service_lcore_add(uint32_t lcore)
+{
+	struct rte_config *cfg = rte_eal_get_configuration();
+	struct core_state *cs;
+
+	if (lcore_states == NULL || lcore >= RTE_MAX_LCORE)
+		return -EINVAL;
+
+	cs = &lcore_states[lcore];
+	if (cs->is_service_core)
+		return -EALREADY;
+
+	if (lcore == cfg->master_lcore ||
+			cfg->lcore_role[lcore] != ROLE_RTE)
+		return -EINVAL;
+
+	if (rte_eal_get_lcore_state(lcore) == RUNNING)
+		return -EBUSY;
+	/* back to WAIT so that the service lcore can be launched */
+	rte_eal_wait_lcore(lcore);
+
+	cs->service_mask = 0;
+	cs->runstate = RUNSTATE_STOPPED;
+	cs->is_service_core = 1;
+
+	cfg->lcore_role[lcore] = ROLE_SERVICE;
+	cfg->lcore_count--;
+
+	return 0;
+}
+
+int32_t
+rte_service_lcore_del(uint32_t lcore)
+{
+	struct rte_config *cfg = rte_eal_get_configuration();
+	struct core_state *cs = service_lcore_get(lcore);
+
+	if (cs == NULL)
+		return -EINVAL;
+
+	if (cs->runstate != RUNSTATE_STOPPED)
+		return -EBUSY;
+
+	service_lcore_unmap_all(cs);
+	cs->is_service_core = 0;
+
+	cfg->lcore_role[lcore] = ROLE_RTE;
+	cfg->lcore_count++;
+
+	return 0;
+}
+
+int32_t
+rte_service_lcore_start(uint32_t lcore)
+{
+	struct core_state *cs = service_lcore_get(lcore);
+	int ret;
+
+	if (cs == NULL)
+		return -EINVAL;
+
+	if (cs->runstate == RUNSTATE_RUNNING)
+		return -EALREADY;
+
+	cs->runstate = RUNSTATE_RUNNING;
+	rte_smp_wmb();
+
+	ret = rte_eal_remote_launch(service_runner_func, NULL, lcore);
+	if (ret < 0)
+		cs->runstate = RUNSTATE_STOPPED;
+
+	return ret;
+}
+
+int32_t
+rte_service_lcore_stop(uint32_t lcore)
+{
+	struct core_state *cs = service_lcore_get(lcore);
+
+	if (cs == NULL)
+		return -EINVAL;
+
+	if (cs->runstate == RUNSTATE_STOPPED)
+		return -EALREADY;
+
+	cs->runstate = RUNSTATE_STOPPED;
+	rte_smp_wmb();
+
+	/* the runner returns after the current iteration of its services */
+	rte_eal_wait_lcore(lcore);
+
+	return 0;
+}
+
+int32_t
+rte_service_lcore_count(void)
+{
+	int32_t count = 0;
+	uint32_t i;
+
+	for (i = 0; i < RTE_MAX_LCORE; i++)
+		count += service_lcore_get(i) != NULL;
+
+	return count;
+}
+
+int32_t
+rte_service_lcore_list(uint32_t array[], uint32_t n)
+{
+	uint32_t count = rte_service_lcore_count();
+	uint32_t i, idx = 0;
+
+	if (array == NULL)
+		return -EINVAL;
+
+	if (count > n)
+		return -ENOMEM;
+
+	for (i = 0; i < RTE_MAX_LCORE; i++)
+		if (service_lcore_get(i) != NULL)
+			array[idx++] = i;
+
+	return count;
+}
+
+int32_t
+rte_service_lcore_count_services(uint32_t lcore)
+{
+	struct core_state *cs = service_lcore_get(lcore);
+
+	if (cs == NULL)
+		return -EINVAL;
+
+	return __builtin_popcountll(cs->service_mask);
+}
+
+int32_t
+rte_service_lcore_reset_all(void)
+{
+	uint32_t i;
+
+	for (i = 0; i < RTE_MAX_LCORE; i++) {
+		if (service_lcore_get(i) == NULL)
+			continue;
+		rte_service_lcore_stop(i);
+		rte_service_lcore_del(i);
+	}
+
+	return 0;
+}
+
+int32_t
+rte_service_start_with_defaults(void)
+{
+	uint32_t ids[RTE_MAX_LCORE];
+	int32_t count = rte_service_lcore_list(ids, RTE_MAX_LCORE);
+	uint32_t i, j = 0;
+	int32_t ret;
+
+	if (count <= 0)
+		return -ENOTSUP;
+
+	/* spread the services over the service lcores */
+	for (i = 0; i < RTE_SERVICE_NUM_MAX; i++) {
+		if (service_get(i) == NULL)
+			continue;
+		rte_service_map_lcore_set(i, ids[j++ % count], 1);
+		rte_service_runstate_set(i, 1);
+	}
+
+	for (i = 0; i < (uint32_t)count; i++) {
+		ret = rte_service_lcore_start(ids[i]);
+		if (ret < 0 && ret != -EALREADY)
+			return ret;
+	}
+
+	return 0;
+}
+
+static void
+service_dump_one(FILE *f, uint32_t id)
+{
+	struct rte_service_spec_impl *s = &rte_services[id];
+	uint64_t calls, cycles;
+
+	service_stats_get(id, &calls, &cycles);
+
+	fprintf(f, "  %s: %s, mapped to %d lcore(s), stats %s\n",
+		s->spec.name,
+		rte_service_runstate_get(id) ? "running" : "stopped",
+		rte_atomic32_read(&s->num_mapped_cores),
+		(s->internal_flags & SERVICE_F_STATS_ENABLED) ? "on" : "off");
+	fprintf(f, "    calls %"PRIu64"\tcycles %"PRIu64"\tavg %"PRIu64"\n",
+		calls, cycles, calls == 0 ? 0 : cycles / calls);
+}
+
+int32_t
+rte_service_dump(FILE *f, uint32_t id)
+{
+	uint32_t i;
+
+	if (f == NULL)
+		return -EINVAL;
+
+	if (id != UINT32_MAX) {
+		if (service_get(id) == NULL)
+			return -EINVAL;
+		fprintf(f, "Service %u:\n", id);
+		service_dump_one(f, id);
+		return 0;
+	}
+
+	fprintf(f, "Services (%u):\n", rte_service_count);
+	for (i = 0; i < RTE_SERVICE_NUM_MAX; i++)
+		if (service_get(i) != NULL)
+			service_dump_one(f, i);
+
+	fprintf(f, "Service lcores (%d):\n", rte_service_lcore_count());
+	for (i = 0; i < RTE_MAX_LCORE; i++) {
+		struct core_state *cs = service_lcore_get(i);
+
+		if (cs == NULL)
+			continue;
+		fprintf(f, "  lcore %u: %s, services 0x%"PRIx64"\n", i,
+			cs->runstate == RUNSTATE_RUNNING ?
+			"running" : "stopped", cs->service_mask);
+	}
+
+	return 0;
+}
@@ -77,6 +77,8 @@
 #include <rte_common.h>
 #include <rte_version.h>
 #include <rte_atomic.h>
+#include <rte_service_component.h>
+#include <rte_trace.h>
 #include <malloc_heap.h>
 
 #include "eal_private.h"
@@ -651,6 +653,15 @@ eal_parse_args(int argc, char **argv)
 		goto out;
 	}
 
+	/* --xen-dom0 memory is fixed by the dom0_mm driver */
+	if (internal_config.xen_dom0_support && internal_config.mem_hotplug) {
+		RTE_LOG(ERR, EAL, "Options --"OPT_MEM_HOTPLUG" cannot be "
+			"specified together with --"OPT_XEN_DOM0"\n");
+		eal_usage(prgname);
+		ret = -1;
+		goto out;
+	}
+
 	if (optind >= 0)
 		argv[optind-1] = prgname;
 	ret = optind-1;
@@ -724,11 +735,10 @@ static int rte_eal_vfio_setup(void)
 
 	if (vfio_enabled) {
 
-		/* if we are primary process, create a thread to communicate with
-		 * secondary processes. the thread will use a socket to wait for
-		 * requests from secondary process to send open file descriptors,
-		 * because VFIO does not allow multiple open descriptors on a group or
-		 * VFIO container.
+		/* if we are primary process, register an action of the
+		 * multi-process channel to send open file descriptors to the
+		 * secondary processes, because VFIO does not allow multiple open
+		 * descriptors on a group or VFIO container.
 		 */
 		if (internal_config.process_type == RTE_PROC_PRIMARY &&
 				vfio_mp_sync_setup() < 0)
@@ -830,6 +840,14 @@ rte_eal_init(int argc, char **argv)
 		return -1;
 	}
 
+	if (rte_mp_channel_init() < 0) {
+		rte_eal_init_alert("Cannot init multi-process channel\n");
+		if (rte_eal_process_type() == RTE_PROC_PRIMARY) {
+			rte_errno = EFAULT;
+			return -1;
+		}
+	}
+
 #ifdef VFIO_PRESENT
 	if (rte_eal_vfio_setup() < 0) {
 		rte_eal_init_alert("Cannot init VFIO\n");
@@ -896,7 +914,11 @@ rte_eal_init(int argc, char **argv)
 		return -1;
 	}
 
-	RTE_LCORE_FOREACH_SLAVE(i) {
+	for (i = 0; i < RTE_MAX_LCORE; i++) {
+		/* service lcores need a thread too */
+		if (i == (int)rte_config.master_lcore ||
+				rte_config.lcore_role[i] == ROLE_OFF)
+			continue;
 
 		/*
 		 * create communication pipes between master thread
@@ -932,6 +954,27 @@ rte_eal_init(int argc, char **argv)
 	rte_eal_mp_remote_launch(sync_func, NULL, SKIP_MASTER);
 	rte_eal_mp_wait_lcore();
 
+	/* initialize services so that vdevs can register theirs when probed */
+	ret = rte_service_init();
+	if (ret) {
+		rte_eal_init_alert("rte_service_init() failed\n");
+		rte_errno = -ret;
+		return -1;
+	}
+
+	if (internal_config.log_deferred && rte_log_deferred_enable() < 0) {
+		rte_eal_init_alert("Cannot enable deferred logging\n");
+		rte_errno = ENOMEM;
+		return -1;
+	}
+
+	if (internal_config.trace_regex != NULL &&
+			rte_trace_regexp(internal_config.trace_regex, 1) < 0) {
+		rte_eal_init_alert("Cannot enable tracepoints\n");
+		rte_errno = EINVAL;
+		return -1;
+	}
+
 	/* Probe all the buses and devices/drivers on them */
 	if (rte_bus_probe()) {
 		rte_eal_init_alert("Cannot probe devices\n");
@@ -939,6 +982,13 @@ rte_eal_init(int argc, char **argv)
 		return -1;
 	}
 
+	/* run the services on the service lcores given with -s or -S */
+	ret = rte_service_start_with_defaults();
+	if (ret < 0 && ret != -ENOTSUP) {
+		rte_errno = -ret;
+		return -1;
+	}
+
 	rte_eal_mcfg_complete();
 
 	return fctret;
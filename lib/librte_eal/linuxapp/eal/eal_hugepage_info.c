@@ -305,6 +305,18 @@ eal_hugepage_info_init(void)
 			rte_str_to_size(&dirent->d_name[dirent_start_len]);
 		hpi->hugedir = get_hugepage_dir(hpi->hugepage_sz);
 
+		/* in-memory mode maps anonymous hugepages, so neither a
+		 * mountpoint nor the directory lock is needed */
+		if (internal_config.in_memory) {
+			hpi->num_pages[0] = get_num_hugepages(dirent->d_name);
+#ifndef RTE_ARCH_64
+			hpi->num_pages[0] = RTE_MIN(hpi->num_pages[0],
+					RTE_PGSIZE_1G / hpi->hugepage_sz);
+#endif
+			num_sizes++;
+			continue;
+		}
+
 		/* first, check if we have a mountpoint */
 		if (hpi->hugedir == NULL) {
 			uint32_t num_pages;
@@ -359,7 +371,8 @@ eal_hugepage_info_init(void)
 
 	/* now we have all info, check we have at least one valid size */
 	for (i = 0; i < num_sizes; i++)
-		if (internal_config.hugepage_info[i].hugedir != NULL &&
+		if ((internal_config.hugepage_info[i].hugedir != NULL ||
+		     internal_config.in_memory) &&
 		    internal_config.hugepage_info[i].num_pages[0] > 0)
 			return 0;
 
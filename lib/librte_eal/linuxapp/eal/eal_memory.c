@@ -83,6 +83,8 @@
 #include <sys/time.h>
 #include <signal.h>
 #include <setjmp.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
 
 #include <rte_log.h>
 #include <rte_memory.h>
@@ -102,6 +104,11 @@
 
 #define PFN_MASK_SIZE	8
 
+/* older kernel headers lack the hugepage size selection flags for mmap() */
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT	26
+#endif
+
 #ifdef RTE_LIBRTE_XEN_DOM0
 int rte_xen_dom0_supported(void)
 {
@@ -954,6 +961,185 @@ huge_recover_sigbus(void)
 	}
 }
 
+/*
+ * Map one anonymous hugepage region of len bytes in in-memory mode. If
+ * socket_id is not SOCKET_ID_ANY the region is bound to that NUMA node
+ * before being faulted in. Each page is then appended to the memseg
+ * array, starting a new memseg whenever the socket changes or the
+ * physical addresses are not contiguous. Returns the number of bytes
+ * actually mapped, which may be less than len on SIGBUS.
+ */
+static uint64_t
+map_in_memory_region(struct rte_mem_config *mcfg, int *seg_idx,
+		uint64_t hugepage_sz, uint64_t len, int socket_id)
+{
+	static phys_addr_t fake_physaddr;
+	struct rte_memseg *ms = NULL;
+	uint64_t off, mapped = 0;
+	unsigned int flags;
+	char *addr;
+
+	/* explicitly select the page size, not the system default one */
+	flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB |
+		(unsigned int)__builtin_ctzll(hugepage_sz) << MAP_HUGE_SHIFT;
+	addr = mmap(NULL, len, PROT_READ | PROT_WRITE, flags, -1, 0);
+	if (addr == MAP_FAILED) {
+		RTE_LOG(DEBUG, EAL, "%s(): mmap failed: %s\n", __func__,
+				strerror(errno));
+		return 0;
+	}
+
+	if (socket_id != SOCKET_ID_ANY) {
+		unsigned long nodemask[RTE_MAX_NUMA_NODES / 64 + 1] = { 0 };
+
+		nodemask[socket_id / 64] = 1UL << (socket_id % 64);
+		if (syscall(__NR_mbind, addr, len, MPOL_BIND, nodemask,
+				RTE_MAX_NUMA_NODES + 1, 0) < 0)
+			RTE_LOG(DEBUG, EAL, "%s(): cannot bind memory to "
+				"socket %d: %s\n", __func__, socket_id,
+				strerror(errno));
+	}
+
+	if (*seg_idx >= 0)
+		ms = &mcfg->memseg[*seg_idx];
+
+	for (off = 0; off < len; off += hugepage_sz) {
+		void *va = addr + off;
+		phys_addr_t pa;
+		int status = -1;
+
+		/* hugetlb limits are enforced at fault time, see
+		 * map_all_hugepages() */
+		if (huge_wrap_sigsetjmp()) {
+			RTE_LOG(DEBUG, EAL, "SIGBUS: Cannot mmap more "
+				"hugepages of size %u MB\n",
+				(unsigned int)(hugepage_sz / 0x100000));
+			munmap(va, len - off);
+			break;
+		}
+		*(int *)va = 0;
+
+		if (syscall(__NR_move_pages, 0, 1UL, &va, NULL, &status,
+				0) < 0 || status < 0)
+			status = socket_id == SOCKET_ID_ANY ? 0 : socket_id;
+
+		if (phys_addrs_available) {
+			pa = rte_mem_virt2phy(va);
+			if (pa == RTE_BAD_PHYS_ADDR) {
+				munmap(va, len - off);
+				break;
+			}
+		} else {
+			pa = fake_physaddr;
+			fake_physaddr += hugepage_sz;
+		}
+
+		if (ms != NULL && ms->socket_id == status &&
+				ms->hugepage_sz == hugepage_sz &&
+				ms->phys_addr + ms->len == pa &&
+				RTE_PTR_ADD(ms->addr, ms->len) == va) {
+			ms->len += hugepage_sz;
+		} else {
+			if (*seg_idx + 1 == RTE_MAX_MEMSEG) {
+				RTE_LOG(ERR, EAL, "Current %s=%d is not "
+					"enough for in-memory mode\n",
+					RTE_STR(CONFIG_RTE_MAX_MEMSEG),
+					RTE_MAX_MEMSEG);
+				munmap(va, len - off);
+				break;
+			}
+			*seg_idx += 1;
+			ms = &mcfg->memseg[*seg_idx];
+			ms->phys_addr = pa;
+			ms->addr = va;
+			ms->len = hugepage_sz;
+			ms->socket_id = status;
+			ms->hugepage_sz = hugepage_sz;
+		}
+		mapped += hugepage_sz;
+	}
+
+	return mapped;
+}
+
+/*
+ * In-memory hugepage initialization: instead of creating one file per page
+ * in hugetlbfs and sharing the page table with secondary processes, map
+ * anonymous hugepages of the largest available size directly. Nothing is
+ * written to the filesystem.
+ */
+static int
+hugepage_init_in_memory(struct rte_mem_config *mcfg)
+{
+	struct hugepage_info *hpi = NULL;
+	uint64_t hugepage_sz, mapped;
+	int i, seg_idx = -1;
+
+	/* hugepage_info is sorted from the largest page size */
+	for (i = 0; i < (int)internal_config.num_hugepage_sizes; i++) {
+		if (internal_config.hugepage_info[i].num_pages[0] > 0) {
+			hpi = &internal_config.hugepage_info[i];
+			break;
+		}
+	}
+	if (hpi == NULL)
+		return -1;
+	hugepage_sz = hpi->hugepage_sz;
+
+	huge_register_sigbus();
+
+	if (internal_config.force_sockets) {
+		for (i = 0; i < RTE_MAX_NUMA_NODES; i++) {
+			uint64_t len = RTE_ALIGN_CEIL(
+				internal_config.socket_mem[i], hugepage_sz);
+
+			if (len == 0)
+				continue;
+			mapped = map_in_memory_region(mcfg, &seg_idx,
+					hugepage_sz, len, i);
+			if (mapped < len) {
+				RTE_LOG(ERR, EAL, "Not enough memory available"
+					" on socket %d! Requested: %uMB,"
+					" available: %uMB\n", i,
+					(unsigned int)(len / 0x100000),
+					(unsigned int)(mapped / 0x100000));
+				goto fail;
+			}
+		}
+	} else {
+		uint64_t len = internal_config.memory;
+
+		if (len == 0)
+			len = hugepage_sz * hpi->num_pages[0];
+		len = RTE_ALIGN_CEIL(len, hugepage_sz);
+		mapped = map_in_memory_region(mcfg, &seg_idx, hugepage_sz,
+				len, SOCKET_ID_ANY);
+		if (mapped == 0 || (internal_config.memory != 0 &&
+				mapped < len)) {
+			RTE_LOG(ERR, EAL, "Not enough memory available!"
+				" Requested: %uMB, available: %uMB\n",
+				(unsigned int)(len / 0x100000),
+				(unsigned int)(mapped / 0x100000));
+			goto fail;
+		}
+		internal_config.memory = mapped;
+	}
+
+	huge_recover_sigbus();
+
+	RTE_LOG(DEBUG, EAL, "In-memory mode: %d memseg(s) of %uMB pages\n",
+		seg_idx + 1, (unsigned int)(hugepage_sz / 0x100000));
+	return 0;
+
+fail:
+	huge_recover_sigbus();
+	for (i = 0; i <= seg_idx; i++) {
+		munmap(mcfg->memseg[i].addr, mcfg->memseg[i].len);
+		memset(&mcfg->memseg[i], 0, sizeof(mcfg->memseg[i]));
+	}
+	return -1;
+}
+
 /*
  * Prepare physical memory mapping: fill configuration structure with
  * these infos, return 0 on success.
@@ -1003,6 +1189,10 @@ rte_eal_hugepage_init(void)
 		return 0;
 	}
 
+	/* no hugetlbfs files nor shared page table in in-memory mode */
+	if (internal_config.in_memory)
+		return hugepage_init_in_memory(mcfg);
+
 /* check if app runs on Xen Dom0 */
 	if (internal_config.xen_dom0_support) {
 #ifdef RTE_LIBRTE_XEN_DOM0
@@ -1363,6 +1553,10 @@ rte_eal_hugepage_attach(void)
 		if (mcfg->memseg[s].len == 0)
 			break;
 
+		/* hotplugged memsegs are mapped by eal_memseg_hotplug_sync */
+		if (mcfg->hotplug[s].gen != 0)
+			continue;
+
 		/*
 		 * fdzero is mmapped to get a contiguous block of virtual
 		 * addresses of the appropriate memseg size.
@@ -1418,6 +1612,12 @@ rte_eal_hugepage_attach(void)
 		void *addr, *base_addr;
 		uintptr_t offset = 0;
 		size_t mapping_size;
+
+		if (mcfg->hotplug[s].gen != 0) {
+			s++;
+			continue;
+		}
+
 		/*
 		 * free previously mapped memory so we can map the
 		 * hugepages into the space
@@ -1458,6 +1658,8 @@ rte_eal_hugepage_attach(void)
 	munmap(hp, size);
 	close(fd_zero);
 	close(fd_hugepage);
+
+	eal_memseg_hotplug_sync();
 	return 0;
 
 error:
@@ -1472,6 +1674,328 @@ rte_eal_hugepage_attach(void)
 	return -1;
 }
 
+/*
+ * Memory hotplug: with --mem-hotplug, the heaps grow at runtime with new
+ * memsegs, each one backed by a single hugetlbfs file (anonymous memory in
+ * in-memory and no-huge modes), and give them back when entirely free.
+ * The memseg table is updated by the primary process only. Secondary
+ * processes map the new memsegs from their backing file when they sync.
+ */
+
+/* in no-huge mode, memory is added by chunks of this size */
+#define HOTPLUG_NO_HUGE_CHUNK RTE_PGSIZE_2M
+
+/* memsegs mapped by this secondary process, by index */
+static uint32_t hotplug_local_gen;
+static uint32_t hotplug_local_seg_gen[RTE_MAX_MEMSEG];
+static struct {
+	void *addr;
+	size_t len;
+} hotplug_local_seg[RTE_MAX_MEMSEG];
+
+/*
+ * Choose the page size of a new memseg of len bytes: the smallest size
+ * holding it in a single page, which is always physically contiguous, or
+ * else the largest size.
+ */
+static struct hugepage_info *
+hotplug_get_hugepage_info(size_t len)
+{
+	struct hugepage_info *hpi, *best = NULL;
+	unsigned int i;
+
+	/* hugepage_info is sorted from the largest page size */
+	for (i = 0; i < internal_config.num_hugepage_sizes; i++) {
+		hpi = &internal_config.hugepage_info[i];
+		if (hpi->hugedir == NULL && !internal_config.in_memory)
+			continue;
+		if (best == NULL || hpi->hugepage_sz >= len)
+			best = hpi;
+	}
+
+	return best;
+}
+
+/* fault in all the pages of a new memseg, 0 on success */
+static int
+hotplug_touch_pages(void *addr, size_t len, uint64_t page_sz)
+{
+	uint64_t off;
+	int ret = 0;
+
+	huge_register_sigbus();
+	for (off = 0; off < len; off += page_sz) {
+		/* hugetlb limits are enforced at fault time, see
+		 * map_all_hugepages() */
+		if (huge_wrap_sigsetjmp()) {
+			RTE_LOG(DEBUG, EAL, "SIGBUS: Cannot hotplug %u MB of "
+				"hugepages\n", (unsigned int)(len / 0x100000));
+			ret = -1;
+			break;
+		}
+		*(volatile int *)RTE_PTR_ADD(addr, off) = 0;
+	}
+	huge_recover_sigbus();
+
+	return ret;
+}
+
+int
+eal_memseg_hotplug_add(int socket_id, size_t len)
+{
+	struct rte_mem_config *mcfg = rte_eal_get_configuration()->mem_config;
+	struct rte_memseg_hotplug *hp;
+	struct hugepage_info *hpi;
+	struct rte_memseg *ms;
+	uint64_t hugepage_sz, off;
+	phys_addr_t physaddr;
+	void *addr = MAP_FAILED;
+	int idx, fd = -1, status = -1;
+
+	if (!internal_config.mem_hotplug ||
+			rte_eal_process_type() != RTE_PROC_PRIMARY)
+		return -1;
+
+	/* no-huge memory is not NUMA aware, it is all on socket 0 */
+	if (internal_config.no_hugetlbfs && socket_id != 0)
+		return -1;
+
+	rte_spinlock_lock(&mcfg->hotplug_lock);
+
+	for (idx = 0; idx < RTE_MAX_MEMSEG; idx++)
+		if (mcfg->memseg[idx].len == 0)
+			break;
+	if (idx == RTE_MAX_MEMSEG) {
+		RTE_LOG(ERR, EAL, "Cannot hotplug memory: %s=%d is not "
+			"enough\n", RTE_STR(CONFIG_RTE_MAX_MEMSEG),
+			RTE_MAX_MEMSEG);
+		goto fail;
+	}
+	ms = &mcfg->memseg[idx];
+	hp = &mcfg->hotplug[idx];
+	hp->path[0] = '\0';
+
+	if (internal_config.no_hugetlbfs) {
+		hugepage_sz = RTE_PGSIZE_4K;
+		len = RTE_ALIGN_CEIL(len, HOTPLUG_NO_HUGE_CHUNK);
+		addr = mmap(NULL, len, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	} else {
+		hpi = hotplug_get_hugepage_info(len);
+		if (hpi == NULL)
+			goto fail;
+		hugepage_sz = hpi->hugepage_sz;
+		len = RTE_ALIGN_CEIL(len, hugepage_sz);
+
+		if (internal_config.in_memory) {
+			addr = mmap(NULL, len, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB |
+				(unsigned int)__builtin_ctzll(hugepage_sz) <<
+				MAP_HUGE_SHIFT, -1, 0);
+		} else {
+			if (snprintf(hp->path, sizeof(hp->path),
+					HOTPLUG_HUGEFILE_FMT, hpi->hugedir,
+					internal_config.hugefile_prefix, idx) >=
+					(int)sizeof(hp->path)) {
+				RTE_LOG(ERR, EAL, "Hugepage directory path "
+					"%s is too long to hotplug memory\n",
+					hpi->hugedir);
+				hp->path[0] = '\0';
+				goto fail;
+			}
+			fd = open(hp->path, O_CREAT | O_RDWR, 0600);
+			if (fd < 0) {
+				RTE_LOG(DEBUG, EAL, "%s(): open failed: %s\n",
+					__func__, strerror(errno));
+				hp->path[0] = '\0';
+				goto fail;
+			}
+			addr = mmap(NULL, len, PROT_READ | PROT_WRITE,
+					MAP_SHARED, fd, 0);
+		}
+	}
+	if (addr == MAP_FAILED) {
+		RTE_LOG(DEBUG, EAL, "%s(): mmap failed: %s\n", __func__,
+				strerror(errno));
+		goto fail;
+	}
+
+	/* bind the memory to the heap socket before faulting it in */
+	if (!internal_config.no_hugetlbfs) {
+		unsigned long nodemask[RTE_MAX_NUMA_NODES / 64 + 1] = { 0 };
+
+		nodemask[socket_id / 64] = 1UL << (socket_id % 64);
+		if (syscall(__NR_mbind, addr, len, MPOL_BIND, nodemask,
+				RTE_MAX_NUMA_NODES + 1, 0) < 0)
+			RTE_LOG(DEBUG, EAL, "%s(): cannot bind memory to "
+				"socket %d: %s\n", __func__, socket_id,
+				strerror(errno));
+	}
+
+	if (hotplug_touch_pages(addr, len, hugepage_sz) < 0)
+		goto fail;
+
+	if (!internal_config.no_hugetlbfs &&
+			syscall(__NR_move_pages, 0, 1UL, &addr, NULL,
+				&status, 0) == 0 &&
+			status >= 0 && status != socket_id) {
+		RTE_LOG(DEBUG, EAL, "Cannot hotplug memory on socket %d, "
+			"got socket %d\n", socket_id, status);
+		goto fail;
+	}
+
+	/* a memseg must be physically contiguous */
+	if (internal_config.no_hugetlbfs || !phys_addrs_available) {
+		physaddr = (phys_addr_t)(uintptr_t)addr;
+	} else {
+		physaddr = rte_mem_virt2phy(addr);
+		for (off = hugepage_sz; off < len; off += hugepage_sz) {
+			if (rte_mem_virt2phy(RTE_PTR_ADD(addr, off)) !=
+					physaddr + off) {
+				RTE_LOG(DEBUG, EAL, "Cannot hotplug %u MB: "
+					"pages are not physically "
+					"contiguous\n",
+					(unsigned int)(len / 0x100000));
+				goto fail;
+			}
+		}
+	}
+
+	if (fd >= 0) {
+		/* shared lock, as for the other hugepage files */
+		if (flock(fd, LOCK_SH | LOCK_NB) == -1)
+			goto fail;
+		close(fd);
+		fd = -1;
+		if (internal_config.hugepage_unlink) {
+			unlink(hp->path);
+			hp->path[0] = '\0';
+		}
+	}
+
+	ms->phys_addr = physaddr;
+	ms->addr = addr;
+	ms->hugepage_sz = hugepage_sz;
+	ms->socket_id = socket_id;
+	ms->nchannel = mcfg->nchannel;
+	ms->nrank = mcfg->nrank;
+	ms->len = len;
+	rte_wmb();
+	hp->gen = ++mcfg->hotplug_gen;
+
+	rte_spinlock_unlock(&mcfg->hotplug_lock);
+
+	RTE_LOG(DEBUG, EAL, "Hotplugged memseg %d: %zu MB on socket %d\n",
+		idx, len / 0x100000, socket_id);
+	return idx;
+
+fail:
+	if (addr != MAP_FAILED)
+		munmap(addr, len);
+	if (fd >= 0) {
+		close(fd);
+		unlink(hp->path);
+		hp->path[0] = '\0';
+	}
+	rte_spinlock_unlock(&mcfg->hotplug_lock);
+	return -1;
+}
+
+int
+eal_memseg_hotplug_remove(struct rte_memseg *ms)
+{
+	struct rte_mem_config *mcfg = rte_eal_get_configuration()->mem_config;
+	int idx = ms - mcfg->memseg;
+	struct rte_memseg_hotplug *hp = &mcfg->hotplug[idx];
+
+	/* the mappings of the primary process cannot be removed from here */
+	if (rte_eal_process_type() != RTE_PROC_PRIMARY)
+		return -1;
+
+	rte_spinlock_lock(&mcfg->hotplug_lock);
+
+	/* keep the memseg table without holes */
+	if (hp->gen == 0 || (idx + 1 < RTE_MAX_MEMSEG &&
+			mcfg->memseg[idx + 1].len != 0)) {
+		rte_spinlock_unlock(&mcfg->hotplug_lock);
+		return -1;
+	}
+
+	RTE_LOG(DEBUG, EAL, "Removing hotplugged memseg %d: %zu MB\n",
+		idx, ms->len / 0x100000);
+
+	hp->gen = 0;
+	mcfg->hotplug_gen++;
+	rte_wmb();
+	munmap(ms->addr, ms->len);
+	if (hp->path[0] != '\0')
+		unlink(hp->path);
+	hp->path[0] = '\0';
+	memset(ms, 0, sizeof(*ms));
+
+	rte_spinlock_unlock(&mcfg->hotplug_lock);
+	return 0;
+}
+
+void
+eal_memseg_hotplug_sync(void)
+{
+	struct rte_mem_config *mcfg = rte_eal_get_configuration()->mem_config;
+	struct rte_memseg_hotplug *hp;
+	struct rte_memseg *ms;
+	void *addr;
+	int i, fd;
+
+	if (rte_eal_process_type() != RTE_PROC_SECONDARY ||
+			hotplug_local_gen == mcfg->hotplug_gen)
+		return;
+
+	rte_spinlock_lock(&mcfg->hotplug_lock);
+
+	for (i = 0; i < RTE_MAX_MEMSEG; i++) {
+		hp = &mcfg->hotplug[i];
+		ms = &mcfg->memseg[i];
+		if (hotplug_local_seg_gen[i] == hp->gen)
+			continue;
+
+		/* the memseg was removed, or removed and added again */
+		if (hotplug_local_seg_gen[i] != 0) {
+			munmap(hotplug_local_seg[i].addr,
+				hotplug_local_seg[i].len);
+			hotplug_local_seg_gen[i] = 0;
+		}
+		if (hp->gen == 0)
+			continue;
+
+		if (hp->path[0] == '\0') {
+			RTE_LOG(ERR, EAL, "Cannot map hotplugged memseg %d: "
+				"no backing file\n", i);
+			continue;
+		}
+		fd = open(hp->path, O_RDWR);
+		if (fd < 0) {
+			RTE_LOG(ERR, EAL, "Could not open %s\n", hp->path);
+			continue;
+		}
+		addr = mmap(ms->addr, ms->len, PROT_READ | PROT_WRITE,
+				MAP_SHARED, fd, 0);
+		close(fd);
+		if (addr != ms->addr) {
+			RTE_LOG(ERR, EAL, "Could not map hotplugged memseg %d "
+				"at [%p]\n", i, ms->addr);
+			if (addr != MAP_FAILED)
+				munmap(addr, ms->len);
+			continue;
+		}
+		hotplug_local_seg[i].addr = addr;
+		hotplug_local_seg[i].len = ms->len;
+		hotplug_local_seg_gen[i] = hp->gen;
+	}
+	hotplug_local_gen = mcfg->hotplug_gen;
+
+	rte_spinlock_unlock(&mcfg->hotplug_lock);
+}
+
 bool
 rte_eal_using_phys_addrs(void)
 {
@@ -129,47 +129,18 @@ vfio_get_group_fd(int iommu_group_no)
 		return vfio_group_fd;
 	}
 	/* if we're in a secondary process, request group fd from the primary
-	 * process via our socket
+	 * process via the multi-process channel
 	 */
-	else {
-		int socket_fd, ret;
-
-		socket_fd = vfio_mp_sync_connect_to_primary();
-
-		if (socket_fd < 0) {
-			RTE_LOG(ERR, EAL, "  cannot connect to primary process!\n");
-			return -1;
-		}
-		if (vfio_mp_sync_send_request(socket_fd, SOCKET_REQ_GROUP) < 0) {
-			RTE_LOG(ERR, EAL, "  cannot request container fd!\n");
-			close(socket_fd);
-			return -1;
-		}
-		if (vfio_mp_sync_send_request(socket_fd, iommu_group_no) < 0) {
-			RTE_LOG(ERR, EAL, "  cannot send group number!\n");
-			close(socket_fd);
-			return -1;
-		}
-		ret = vfio_mp_sync_receive_request(socket_fd);
-		switch (ret) {
-		case SOCKET_NO_FD:
-			close(socket_fd);
-			return 0;
-		case SOCKET_OK:
-			vfio_group_fd = vfio_mp_sync_receive_fd(socket_fd);
-			/* if we got the fd, return it */
-			if (vfio_group_fd > 0) {
-				close(socket_fd);
-				return vfio_group_fd;
-			}
-			/* fall-through on error */
-		default:
-			RTE_LOG(ERR, EAL, "  cannot get container fd!\n");
-			close(socket_fd);
-			return -1;
-		}
+	switch (vfio_mp_sync_request(SOCKET_REQ_GROUP, iommu_group_no,
+			&vfio_group_fd)) {
+	case SOCKET_NO_FD:
+		return 0;
+	case SOCKET_OK:
+		return vfio_group_fd;
+	default:
+		RTE_LOG(ERR, EAL, "  cannot get group fd!\n");
+		return -1;
 	}
-	return -1;
 }
 
 
@@ -224,8 +195,7 @@ vfio_group_device_count(int vfio_group_fd)
 int
 clear_group(int vfio_group_fd)
 {
-	int i;
-	int socket_fd, ret;
+	int i, ret;
 
 	if (internal_config.process_type == RTE_PROC_PRIMARY) {
 
@@ -240,41 +210,18 @@ clear_group(int vfio_group_fd)
 	}
 
 	/* This is just for SECONDARY processes */
-	socket_fd = vfio_mp_sync_connect_to_primary();
-
-	if (socket_fd < 0) {
-		RTE_LOG(ERR, EAL, "  cannot connect to primary process!\n");
-		return -1;
-	}
-
-	if (vfio_mp_sync_send_request(socket_fd, SOCKET_CLR_GROUP) < 0) {
-		RTE_LOG(ERR, EAL, "  cannot request container fd!\n");
-		close(socket_fd);
-		return -1;
-	}
-
-	if (vfio_mp_sync_send_request(socket_fd, vfio_group_fd) < 0) {
-		RTE_LOG(ERR, EAL, "  cannot send group fd!\n");
-		close(socket_fd);
-		return -1;
-	}
-
-	ret = vfio_mp_sync_receive_request(socket_fd);
+	ret = vfio_mp_sync_request(SOCKET_CLR_GROUP, vfio_group_fd, NULL);
 	switch (ret) {
 	case SOCKET_NO_FD:
 		RTE_LOG(ERR, EAL, "  BAD VFIO group fd!\n");
-		close(socket_fd);
 		break;
 	case SOCKET_OK:
-		close(socket_fd);
 		return 0;
 	case SOCKET_ERR:
 		RTE_LOG(ERR, EAL, "  Socket error\n");
-		close(socket_fd);
 		break;
 	default:
 		RTE_LOG(ERR, EAL, "  UNKNOWN reply, %d\n", ret);
-		close(socket_fd);
 	}
 	return -1;
 }
@@ -619,31 +566,15 @@ vfio_get_container_fd(void)
 	} else {
 		/*
 		 * if we're in a secondary process, request container fd from the
-		 * primary process via our socket
+		 * primary process via the multi-process channel
 		 */
-		int socket_fd;
-
-		socket_fd = vfio_mp_sync_connect_to_primary();
-		if (socket_fd < 0) {
-			RTE_LOG(ERR, EAL, "  cannot connect to primary process!\n");
-			return -1;
-		}
-		if (vfio_mp_sync_send_request(socket_fd, SOCKET_REQ_CONTAINER) < 0) {
-			RTE_LOG(ERR, EAL, "  cannot request container fd!\n");
-			close(socket_fd);
-			return -1;
-		}
-		vfio_container_fd = vfio_mp_sync_receive_fd(socket_fd);
-		if (vfio_container_fd < 0) {
+		if (vfio_mp_sync_request(SOCKET_REQ_CONTAINER, 0,
+				&vfio_container_fd) != SOCKET_OK) {
 			RTE_LOG(ERR, EAL, "  cannot get container fd!\n");
-			close(socket_fd);
 			return -1;
 		}
-		close(socket_fd);
 		return vfio_container_fd;
 	}
-
-	return -1;
 }
 
 int
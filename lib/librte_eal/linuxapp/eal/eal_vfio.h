@@ -118,15 +118,6 @@ struct vfio_iommu_spapr_tce_info {
 
 #define VFIO_MAX_GROUPS 64
 
-/*
- * Function prototypes for VFIO multiprocess sync functions
- */
-int vfio_mp_sync_send_request(int socket, int req);
-int vfio_mp_sync_receive_request(int socket);
-int vfio_mp_sync_send_fd(int socket, int fd);
-int vfio_mp_sync_receive_fd(int socket);
-int vfio_mp_sync_connect_to_primary(void);
-
 /*
  * we don't need to store device fd's anywhere since they can be obtained from
  * the group fd via an ioctl() call.
@@ -208,8 +199,24 @@ int vfio_is_enabled(const char *modname);
 int pci_vfio_enable(void);
 int pci_vfio_is_enabled(void);
 
+/* register the VFIO action of the primary process */
 int vfio_mp_sync_setup(void);
 
+/*
+ * Send a request to the primary process, with the group number or fd
+ * in data. Returns the SOCKET_* result; on SOCKET_OK, *fd is set to the
+ * container or group fd if requested.
+ */
+int vfio_mp_sync_request(int req, int data, int *fd);
+
+#define EAL_VFIO_MP "eal_vfio_mp_sync"
+
+struct vfio_mp_param {
+	int req;
+	int result;
+	int data;
+};
+
 #define SOCKET_REQ_CONTAINER 0x100
 #define SOCKET_REQ_GROUP 0x200
 #define SOCKET_CLR_GROUP 0x300
@@ -74,6 +74,11 @@ static struct rte_eth_dev_data *rte_eth_dev_data;
 static uint8_t eth_dev_last_created_port;
 static uint8_t nb_ports;
 
+#ifdef RTE_ETHDEV_TRACE
+RTE_TRACE_POINT_DEFINE(ethdev_rx_burst);
+RTE_TRACE_POINT_DEFINE(ethdev_tx_burst);
+#endif
+
 /* spinlock for eth device callbacks */
 static rte_spinlock_t rte_eth_dev_cb_lock = RTE_SPINLOCK_INITIALIZER;
 
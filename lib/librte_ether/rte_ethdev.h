@@ -182,6 +182,7 @@ extern "C" {
 #include <rte_dev.h>
 #include <rte_devargs.h>
 #include <rte_errno.h>
+#include <rte_trace.h>
 #include "rte_ether.h"
 #include "rte_eth_ctrl.h"
 #include "rte_dev_info.h"
@@ -2674,6 +2675,13 @@ int rte_eth_dev_get_vlan_offload(uint8_t port_id);
  */
 int rte_eth_dev_set_vlan_pvid(uint8_t port_id, uint16_t pvid, int on);
 
+#ifdef RTE_ETHDEV_TRACE
+/** Tracepoint of rte_eth_rx_burst(): port, queue, number of packets. */
+RTE_TRACE_POINT_DECLARE(ethdev_rx_burst);
+/** Tracepoint of rte_eth_tx_burst(): port, queue, number of packets. */
+RTE_TRACE_POINT_DECLARE(ethdev_tx_burst);
+#endif
+
 /**
  *
  * Retrieve a burst of input packets from a receive queue of an Ethernet
@@ -2786,6 +2794,10 @@ rte_eth_rx_burst(uint8_t port_id, uint16_t queue_id,
 	}
 #endif
 
+#ifdef RTE_ETHDEV_TRACE
+	RTE_TRACE(ethdev_rx_burst, port_id, queue_id, nb_rx);
+#endif
+
 	return nb_rx;
 }
 
@@ -3042,7 +3054,14 @@ rte_eth_tx_burst(uint8_t port_id, uint16_t queue_id,
 	}
 #endif
 
-	return (*dev->tx_pkt_burst)(dev->data->tx_queues[queue_id], tx_pkts, nb_pkts);
+	uint16_t nb_tx = (*dev->tx_pkt_burst)(dev->data->tx_queues[queue_id],
+			tx_pkts, nb_pkts);
+
+#ifdef RTE_ETHDEV_TRACE
+	RTE_TRACE(ethdev_tx_burst, port_id, queue_id, nb_tx);
+#endif
+
+	return nb_tx;
 }
 
 /**
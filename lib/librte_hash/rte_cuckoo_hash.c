@@ -57,6 +57,7 @@
 #include <rte_spinlock.h>
 #include <rte_ring.h>
 #include <rte_compat.h>
+#include <rte_rcu_qsbr.h>
 
 #include "rte_hash.h"
 #include "rte_cuckoo_hash.h"
@@ -118,12 +119,18 @@ rte_hash_create(const struct rte_hash_parameters *params)
 	struct rte_tailq_entry *te = NULL;
 	struct rte_hash_list *hash_list;
 	struct rte_ring *r = NULL;
+	struct rte_ring *r_ext = NULL;
 	char hash_name[RTE_HASH_NAMESIZE];
 	void *k = NULL;
 	void *buckets = NULL;
+	void *buckets_ext = NULL;
+	uint32_t *ext_bkt_to_free = NULL;
 	char ring_name[RTE_RING_NAMESIZE];
 	unsigned num_key_slots;
 	unsigned hw_trans_mem_support = 0;
+	unsigned readwrite_concur_lf_support = 0;
+	unsigned ext_table_support = 0;
+	uint32_t *tbl_chng_cnt = NULL;
 	unsigned i;
 
 	hash_list = RTE_TAILQ_CAST(rte_hash_tailq.head, rte_hash_list);
@@ -147,6 +154,12 @@ rte_hash_create(const struct rte_hash_parameters *params)
 	if (params->extra_flag & RTE_HASH_EXTRA_FLAGS_TRANS_MEM_SUPPORT)
 		hw_trans_mem_support = 1;
 
+	if (params->extra_flag & RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF)
+		readwrite_concur_lf_support = 1;
+
+	if (params->extra_flag & RTE_HASH_EXTRA_FLAGS_EXT_TABLE)
+		ext_table_support = 1;
+
 	/* Store all keys and leave the first entry as a dummy entry for lookup_bulk */
 	if (hw_trans_mem_support)
 		/*
@@ -160,14 +173,38 @@ rte_hash_create(const struct rte_hash_parameters *params)
 		num_key_slots = params->entries + 1;
 
 	snprintf(ring_name, sizeof(ring_name), "HT_%s", params->name);
-	/* Create ring (Dummy slot index is not enqueued) */
-	r = rte_ring_create(ring_name, rte_align32pow2(num_key_slots - 1),
+	/*
+	 * Create ring (Dummy slot index is not enqueued). A ring holds one
+	 * object less than its size, so that all entries can be stored.
+	 */
+	r = rte_ring_create(ring_name, rte_align32pow2(num_key_slots),
 			params->socket_id, 0);
 	if (r == NULL) {
 		RTE_LOG(ERR, HASH, "memory allocation failed\n");
 		goto err;
 	}
 
+	const uint32_t num_buckets = rte_align32pow2(params->entries)
+					/ RTE_HASH_BUCKET_ENTRIES;
+
+	/*
+	 * Create ring for extendable buckets. As many extendable buckets
+	 * as main buckets is enough to store all entries in a single chain
+	 * (Dummy bucket index 0 is not enqueued)
+	 */
+	if (ext_table_support) {
+		snprintf(ring_name, sizeof(ring_name), "HT_EXT_%s",
+				params->name);
+		r_ext = rte_ring_create(ring_name,
+				rte_align32pow2(num_buckets + 1),
+				params->socket_id, 0);
+		if (r_ext == NULL) {
+			RTE_LOG(ERR, HASH, "ext buckets memory allocation "
+					"failed\n");
+			goto err;
+		}
+	}
+
 	snprintf(hash_name, sizeof(hash_name), "HT_%s", params->name);
 
 	rte_rwlock_write_lock(RTE_EAL_TAILQ_RWLOCK);
@@ -200,9 +237,6 @@ rte_hash_create(const struct rte_hash_parameters *params)
 		goto err_unlock;
 	}
 
-	const uint32_t num_buckets = rte_align32pow2(params->entries)
-					/ RTE_HASH_BUCKET_ENTRIES;
-
 	buckets = rte_zmalloc_socket(NULL,
 				num_buckets * sizeof(struct rte_hash_bucket),
 				RTE_CACHE_LINE_SIZE, params->socket_id);
@@ -212,6 +246,33 @@ rte_hash_create(const struct rte_hash_parameters *params)
 		goto err_unlock;
 	}
 
+	if (ext_table_support) {
+		buckets_ext = rte_zmalloc_socket(NULL,
+				num_buckets * sizeof(struct rte_hash_bucket),
+				RTE_CACHE_LINE_SIZE, params->socket_id);
+		if (buckets_ext == NULL) {
+			RTE_LOG(ERR, HASH, "ext buckets memory allocation "
+					"failed\n");
+			goto err_unlock;
+		}
+		/*
+		 * With lock-free lookups, an emptied extendable bucket is
+		 * only recycled when the key slot last removed from it is
+		 * freed, once no reader can be walking the bucket anymore.
+		 */
+		if (readwrite_concur_lf_support) {
+			ext_bkt_to_free = rte_zmalloc_socket(NULL,
+					sizeof(uint32_t) * num_key_slots,
+					RTE_CACHE_LINE_SIZE,
+					params->socket_id);
+			if (ext_bkt_to_free == NULL) {
+				RTE_LOG(ERR, HASH, "ext bkt to free memory "
+						"allocation failed\n");
+				goto err_unlock;
+			}
+		}
+	}
+
 	const uint32_t key_entry_size = sizeof(struct rte_hash_key) + params->key_len;
 	const uint64_t key_tbl_size = (uint64_t) key_entry_size * num_key_slots;
 
@@ -223,6 +284,14 @@ rte_hash_create(const struct rte_hash_parameters *params)
 		goto err_unlock;
 	}
 
+	tbl_chng_cnt = rte_zmalloc_socket(NULL, sizeof(uint32_t),
+			RTE_CACHE_LINE_SIZE, params->socket_id);
+
+	if (tbl_chng_cnt == NULL) {
+		RTE_LOG(ERR, HASH, "memory allocation failed\n");
+		goto err_unlock;
+	}
+
 /*
  * If x86 architecture is used, select appropriate compare function,
  * which may use x86 intrinsics, otherwise use memcmp
@@ -283,13 +352,21 @@ rte_hash_create(const struct rte_hash_parameters *params)
 	h->key_store = k;
 	h->free_slots = r;
 	h->hw_trans_mem_support = hw_trans_mem_support;
+	h->readwrite_concur_lf_support = readwrite_concur_lf_support;
+	h->tbl_chng_cnt = tbl_chng_cnt;
+	h->ext_table_support = ext_table_support;
+	h->free_ext_bkts = r_ext;
+	h->buckets_ext = buckets_ext;
+	h->ext_bkt_to_free = ext_bkt_to_free;
 
 #if defined(RTE_ARCH_X86)
-	if (rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX2))
-		h->sig_cmp_fn = RTE_HASH_COMPARE_AVX2;
-	else if (rte_cpu_get_flag_enabled(RTE_CPUFLAG_SSE2))
+	if (rte_cpu_get_flag_enabled(RTE_CPUFLAG_SSE2))
 		h->sig_cmp_fn = RTE_HASH_COMPARE_SSE;
 	else
+#elif defined(RTE_ARCH_ARM64)
+	if (rte_cpu_get_flag_enabled(RTE_CPUFLAG_NEON))
+		h->sig_cmp_fn = RTE_HASH_COMPARE_NEON;
+	else
 #endif
 		h->sig_cmp_fn = RTE_HASH_COMPARE_SCALAR;
 
@@ -297,22 +374,38 @@ rte_hash_create(const struct rte_hash_parameters *params)
 	 * support.
 	 */
 	if (params->extra_flag & RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_ADD) {
-		if (h->hw_trans_mem_support) {
+		if (h->hw_trans_mem_support)
 			h->add_key = ADD_KEY_MULTIWRITER_TM;
-		} else {
+		else
 			h->add_key = ADD_KEY_MULTIWRITER;
-			h->multiwriter_lock = rte_malloc(NULL,
-							sizeof(rte_spinlock_t),
-							LCORE_CACHE_SIZE);
-			rte_spinlock_init(h->multiwriter_lock);
-		}
 	} else
 		h->add_key = ADD_KEY_SINGLEWRITER;
 
+	/*
+	 * The lock also serializes the TM writers when they fall back
+	 * to the extendable buckets or reclaim key slots
+	 */
+	if (h->add_key != ADD_KEY_SINGLEWRITER) {
+		h->multiwriter_lock = rte_malloc(NULL,
+						sizeof(rte_spinlock_t),
+						LCORE_CACHE_SIZE);
+		if (h->multiwriter_lock == NULL) {
+			RTE_LOG(ERR, HASH, "memory allocation failed\n");
+			goto err_unlock;
+		}
+		rte_spinlock_init(h->multiwriter_lock);
+	}
+
 	/* Populate free slots ring. Entry zero is reserved for key misses. */
 	for (i = 1; i < params->entries + 1; i++)
 		rte_ring_sp_enqueue(r, (void *)((uintptr_t) i));
 
+	/* Populate free ext buckets ring. Entry zero is reserved too. */
+	if (ext_table_support) {
+		for (i = 1; i <= num_buckets; i++)
+			rte_ring_sp_enqueue(r_ext, (void *)((uintptr_t) i));
+	}
+
 	te->data = (void *) h;
 	TAILQ_INSERT_TAIL(hash_list, te, next);
 	rte_rwlock_write_unlock(RTE_EAL_TAILQ_RWLOCK);
@@ -322,10 +415,18 @@ rte_hash_create(const struct rte_hash_parameters *params)
 	rte_rwlock_write_unlock(RTE_EAL_TAILQ_RWLOCK);
 err:
 	rte_ring_free(r);
+	rte_ring_free(r_ext);
 	rte_free(te);
+	if (h != NULL) {
+		rte_free(h->local_free_slots);
+		rte_free(h->multiwriter_lock);
+	}
 	rte_free(h);
 	rte_free(buckets);
+	rte_free(buckets_ext);
+	rte_free(ext_bkt_to_free);
 	rte_free(k);
+	rte_free(tbl_chng_cnt);
 	return NULL;
 }
 
@@ -357,14 +458,21 @@ rte_hash_free(struct rte_hash *h)
 
 	rte_rwlock_write_unlock(RTE_EAL_TAILQ_RWLOCK);
 
+	/* Wait for the readers of the deleted keys before freeing them */
+	rte_rcu_qsbr_dq_delete(h->dq);
+	rte_free(h->hash_rcu_cfg);
+
 	if (h->hw_trans_mem_support)
 		rte_free(h->local_free_slots);
 
-	if (h->add_key == ADD_KEY_MULTIWRITER)
-		rte_free(h->multiwriter_lock);
+	rte_free(h->multiwriter_lock);
 	rte_ring_free(h->free_slots);
+	rte_ring_free(h->free_ext_bkts);
 	rte_free(h->key_store);
 	rte_free(h->buckets);
+	rte_free(h->buckets_ext);
+	rte_free(h->ext_bkt_to_free);
+	rte_free(h->tbl_chng_cnt);
 	rte_free(h);
 	rte_free(te);
 }
@@ -376,16 +484,40 @@ rte_hash_hash(const struct rte_hash *h, const void *key)
 	return h->hash_func(key, h->key_len, h->hash_func_init_val);
 }
 
-/* Calc the secondary hash value from the primary hash value of a given key */
-static inline hash_sig_t
-rte_hash_secondary_hash(const hash_sig_t primary_hash)
+/*
+ * A cuckoo move copies an entry to its alternative bucket, then overwrites
+ * its old location. A lock-free reader searching both buckets in between
+ * can miss the key, so let it know it has to search again.
+ */
+static inline void
+tbl_chng_cnt_bump(const struct rte_hash *h)
+{
+	if (!h->readwrite_concur_lf_support)
+		return;
+
+	/* Copy in the alternative bucket visible before the counter */
+	rte_smp_wmb();
+	*(volatile uint32_t *)h->tbl_chng_cnt += 1;
+	/* Counter visible before the old location is overwritten */
+	rte_smp_wmb();
+}
+
+static inline uint32_t
+tbl_chng_cnt_load(const struct rte_hash *h)
 {
-	static const unsigned all_bits_shift = 12;
-	static const unsigned alt_bits_xor = 0x5bd1e995;
+	uint32_t cnt = *(volatile uint32_t *)h->tbl_chng_cnt;
 
-	uint32_t tag = primary_hash >> all_bits_shift;
+	/* Bucket reads must not be done before loading the counter */
+	rte_smp_rmb();
+	return cnt;
+}
 
-	return primary_hash ^ ((tag + 1) * alt_bits_xor);
+static inline int
+tbl_chng_cnt_changed(const struct rte_hash *h, uint32_t cnt)
+{
+	/* Bucket reads must be done before loading the counter again */
+	rte_smp_rmb();
+	return *(volatile uint32_t *)h->tbl_chng_cnt != cnt;
 }
 
 void
@@ -393,10 +525,20 @@ rte_hash_reset(struct rte_hash *h)
 {
 	void *ptr;
 	unsigned i;
+	uint32_t num_key_slots;
 
 	if (h == NULL)
 		return;
 
+	/* Empty the defer queue before the free slots ring is refilled */
+	if (h->hash_rcu_cfg != NULL) {
+		rte_rcu_qsbr_synchronize(h->hash_rcu_cfg->v,
+					RTE_QSBR_THRID_INVALID);
+		if (h->dq != NULL)
+			rte_rcu_qsbr_dq_reclaim(h->dq, UINT32_MAX,
+						NULL, NULL, NULL);
+	}
+
 	memset(h->buckets, 0, h->num_buckets * sizeof(struct rte_hash_bucket));
 	memset(h->key_store, 0, h->key_entry_size * (h->entries + 1));
 
@@ -408,6 +550,30 @@ rte_hash_reset(struct rte_hash *h)
 	for (i = 1; i < h->entries + 1; i++)
 		rte_ring_sp_enqueue(h->free_slots, (void *)((uintptr_t) i));
 
+	if (h->ext_table_support) {
+		memset(h->buckets_ext, 0,
+			h->num_buckets * sizeof(struct rte_hash_bucket));
+
+		/* clear the free ext buckets ring */
+		while (rte_ring_dequeue(h->free_ext_bkts, &ptr) == 0)
+			rte_pause();
+
+		/* Repopulate the free ext buckets ring */
+		for (i = 1; i <= h->num_buckets; i++)
+			rte_ring_sp_enqueue(h->free_ext_bkts,
+					(void *)((uintptr_t) i));
+
+		if (h->readwrite_concur_lf_support) {
+			if (h->hw_trans_mem_support)
+				num_key_slots = h->entries + (RTE_MAX_LCORE -
+						1) * LCORE_CACHE_SIZE + 1;
+			else
+				num_key_slots = h->entries + 1;
+			memset(h->ext_bkt_to_free, 0,
+				sizeof(uint32_t) * num_key_slots);
+		}
+	}
+
 	if (h->hw_trans_mem_support) {
 		/* Reset local caches per lcore */
 		for (i = 0; i < RTE_MAX_LCORE; i++)
@@ -423,6 +589,7 @@ make_space_bucket(const struct rte_hash *h, struct rte_hash_bucket *bkt)
 	unsigned i, j;
 	int ret;
 	uint32_t next_bucket_idx;
+	uint32_t cur_bucket_idx = bkt - h->buckets;
 	struct rte_hash_bucket *next_bkt[RTE_HASH_BUCKET_ENTRIES];
 
 	/*
@@ -431,7 +598,8 @@ make_space_bucket(const struct rte_hash *h, struct rte_hash_bucket *bkt)
 	 */
 	for (i = 0; i < RTE_HASH_BUCKET_ENTRIES; i++) {
 		/* Search for space in alternative locations */
-		next_bucket_idx = bkt->sig_alt[i] & h->bucket_bitmask;
+		next_bucket_idx = get_alt_bucket_index(h, cur_bucket_idx,
+						bkt->sig_current[i]);
 		next_bkt[i] = &h->buckets[next_bucket_idx];
 		for (j = 0; j < RTE_HASH_BUCKET_ENTRIES; j++) {
 			if (next_bkt[i]->key_idx[j] == EMPTY_SLOT)
@@ -444,8 +612,7 @@ make_space_bucket(const struct rte_hash *h, struct rte_hash_bucket *bkt)
 
 	/* Alternative location has spare room (end of recursive function) */
 	if (i != RTE_HASH_BUCKET_ENTRIES) {
-		next_bkt[i]->sig_alt[j] = bkt->sig_current[i];
-		next_bkt[i]->sig_current[j] = bkt->sig_alt[i];
+		next_bkt[i]->sig_current[j] = bkt->sig_current[i];
 		next_bkt[i]->key_idx[j] = bkt->key_idx[i];
 		return i;
 	}
@@ -474,8 +641,8 @@ make_space_bucket(const struct rte_hash *h, struct rte_hash_bucket *bkt)
 	bkt->flag[i] = 0;
 	nr_pushes = 0;
 	if (ret >= 0) {
-		next_bkt[i]->sig_alt[ret] = bkt->sig_current[i];
-		next_bkt[i]->sig_current[ret] = bkt->sig_alt[i];
+		tbl_chng_cnt_bump(h);
+		next_bkt[i]->sig_current[ret] = bkt->sig_current[i];
 		next_bkt[i]->key_idx[ret] = bkt->key_idx[i];
 		return i;
 	} else
@@ -500,38 +667,14 @@ enqueue_slot_back(const struct rte_hash *h,
 		rte_ring_sp_enqueue(h->free_slots, slot_id);
 }
 
-static inline int32_t
-__rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
-						hash_sig_t sig, void *data)
+/* Get a free key slot, EMPTY_SLOT if none is left */
+static inline uint32_t
+alloc_slot(const struct rte_hash *h, struct lcore_cache *cached_free_slots)
 {
-	hash_sig_t alt_hash;
-	uint32_t prim_bucket_idx, sec_bucket_idx;
-	unsigned i;
-	struct rte_hash_bucket *prim_bkt, *sec_bkt;
-	struct rte_hash_key *new_k, *k, *keys = h->key_store;
-	void *slot_id = NULL;
-	uint32_t new_idx;
-	int ret;
 	unsigned n_slots;
-	unsigned lcore_id;
-	struct lcore_cache *cached_free_slots = NULL;
+	void *slot_id;
 
-	if (h->add_key == ADD_KEY_MULTIWRITER)
-		rte_spinlock_lock(h->multiwriter_lock);
-
-	prim_bucket_idx = sig & h->bucket_bitmask;
-	prim_bkt = &h->buckets[prim_bucket_idx];
-	rte_prefetch0(prim_bkt);
-
-	alt_hash = rte_hash_secondary_hash(sig);
-	sec_bucket_idx = alt_hash & h->bucket_bitmask;
-	sec_bkt = &h->buckets[sec_bucket_idx];
-	rte_prefetch0(sec_bkt);
-
-	/* Get a new slot for storing the new key */
 	if (h->hw_trans_mem_support) {
-		lcore_id = rte_lcore_id();
-		cached_free_slots = &h->local_free_slots[lcore_id];
 		/* Try to get a free slot from the local cache */
 		if (cached_free_slots->len == 0) {
 			/* Need to get another burst of free slots from global ring */
@@ -539,7 +682,7 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
 					cached_free_slots->objs,
 					LCORE_CACHE_SIZE, NULL);
 			if (n_slots == 0)
-				return -ENOSPC;
+				return EMPTY_SLOT;
 
 			cached_free_slots->len += n_slots;
 		}
@@ -549,74 +692,165 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
 		slot_id = cached_free_slots->objs[cached_free_slots->len];
 	} else {
 		if (rte_ring_sc_dequeue(h->free_slots, &slot_id) != 0)
-			return -ENOSPC;
+			return EMPTY_SLOT;
 	}
 
-	new_k = RTE_PTR_ADD(keys, (uintptr_t)slot_id * h->key_entry_size);
-	rte_prefetch0(new_k);
-	new_idx = (uint32_t)((uintptr_t) slot_id);
+	return (uint32_t)((uintptr_t)slot_id);
+}
+
+/* Search a key in one bucket and update its data if found */
+static inline int32_t
+search_and_update(const struct rte_hash *h, void *data, const void *key,
+	struct rte_hash_bucket *bkt, uint16_t sig)
+{
+	unsigned i;
+	struct rte_hash_key *k, *keys = h->key_store;
 
-	/* Check if key is already inserted in primary location */
 	for (i = 0; i < RTE_HASH_BUCKET_ENTRIES; i++) {
-		if (prim_bkt->sig_current[i] == sig &&
-				prim_bkt->sig_alt[i] == alt_hash) {
+		if (bkt->sig_current[i] == sig &&
+				bkt->key_idx[i] != EMPTY_SLOT) {
 			k = (struct rte_hash_key *) ((char *)keys +
-					prim_bkt->key_idx[i] * h->key_entry_size);
+					bkt->key_idx[i] * h->key_entry_size);
 			if (rte_hash_cmp_eq(key, k->key, h) == 0) {
-				/* Enqueue index of free slot back in the ring. */
-				enqueue_slot_back(h, cached_free_slots, slot_id);
 				/* Update data */
 				k->pdata = data;
 				/*
 				 * Return index where key is stored,
 				 * substracting the first dummy index
 				 */
-				return prim_bkt->key_idx[i] - 1;
+				return bkt->key_idx[i] - 1;
 			}
 		}
 	}
 
-	/* Check if key is already inserted in secondary location */
-	for (i = 0; i < RTE_HASH_BUCKET_ENTRIES; i++) {
-		if (sec_bkt->sig_alt[i] == sig &&
-				sec_bkt->sig_current[i] == alt_hash) {
-			k = (struct rte_hash_key *) ((char *)keys +
-					sec_bkt->key_idx[i] * h->key_entry_size);
-			if (rte_hash_cmp_eq(key, k->key, h) == 0) {
-				/* Enqueue index of free slot back in the ring. */
-				enqueue_slot_back(h, cached_free_slots, slot_id);
-				/* Update data */
-				k->pdata = data;
-				/*
-				 * Return index where key is stored,
-				 * substracting the first dummy index
-				 */
-				return sec_bkt->key_idx[i] - 1;
+	return -1;
+}
+
+/*
+ * Both buckets of the key are full and no cuckoo path frees an entry:
+ * store it in the extendable buckets chained to its secondary bucket.
+ */
+static inline int
+insert_ext_bucket(const struct rte_hash *h, struct rte_hash_bucket *sec_bkt,
+		uint16_t sig, uint32_t new_idx)
+{
+	struct rte_hash_bucket *cur_bkt, *last_bkt = sec_bkt;
+	void *ext_bkt_id;
+	unsigned i;
+
+	/* Use an empty entry of the chain if any */
+	for (cur_bkt = sec_bkt->next; cur_bkt != NULL;
+			cur_bkt = cur_bkt->next) {
+		for (i = 0; i < RTE_HASH_BUCKET_ENTRIES; i++) {
+			if (cur_bkt->key_idx[i] == EMPTY_SLOT) {
+				cur_bkt->sig_current[i] = sig;
+				cur_bkt->key_idx[i] = new_idx;
+				return 0;
 			}
 		}
+		last_bkt = cur_bkt;
+	}
+
+	/* Chain a new extendable bucket */
+	if (rte_ring_dequeue(h->free_ext_bkts, &ext_bkt_id) != 0)
+		return -ENOSPC;
+
+	cur_bkt = &h->buckets_ext[(uintptr_t)ext_bkt_id - 1];
+	cur_bkt->next = NULL;
+	cur_bkt->sig_current[0] = sig;
+	cur_bkt->key_idx[0] = new_idx;
+	/* Bucket filled before lookups can reach it */
+	rte_smp_wmb();
+	last_bkt->next = cur_bkt;
+
+	return 0;
+}
+
+static inline int32_t
+__rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
+						hash_sig_t sig, void *data)
+{
+	uint16_t short_sig;
+	uint32_t prim_bucket_idx, sec_bucket_idx;
+	unsigned i;
+	struct rte_hash_bucket *prim_bkt, *sec_bkt, *cur_bkt;
+	struct rte_hash_key *new_k, *keys = h->key_store;
+	uint32_t new_idx;
+	int32_t ret;
+	unsigned lcore_id;
+	struct lcore_cache *cached_free_slots = NULL;
+
+	if (h->add_key == ADD_KEY_MULTIWRITER)
+		rte_spinlock_lock(h->multiwriter_lock);
+
+	short_sig = get_short_sig(sig);
+	prim_bucket_idx = get_prim_bucket_index(h, sig);
+	prim_bkt = &h->buckets[prim_bucket_idx];
+	rte_prefetch0(prim_bkt);
+
+	sec_bucket_idx = get_alt_bucket_index(h, prim_bucket_idx, short_sig);
+	sec_bkt = &h->buckets[sec_bucket_idx];
+	rte_prefetch0(sec_bkt);
+
+	/* Get a new slot for storing the new key */
+	if (h->hw_trans_mem_support) {
+		lcore_id = rte_lcore_id();
+		cached_free_slots = &h->local_free_slots[lcore_id];
+	}
+	new_idx = alloc_slot(h, cached_free_slots);
+	if (new_idx == EMPTY_SLOT && h->dq != NULL) {
+		/* Reclaim the slots of deleted keys whose readers are gone */
+		if (h->add_key == ADD_KEY_MULTIWRITER_TM)
+			rte_spinlock_lock(h->multiwriter_lock);
+		rte_rcu_qsbr_dq_reclaim(h->dq, h->hash_rcu_cfg->max_reclaim_size,
+					NULL, NULL, NULL);
+		if (h->add_key == ADD_KEY_MULTIWRITER_TM)
+			rte_spinlock_unlock(h->multiwriter_lock);
+		new_idx = alloc_slot(h, cached_free_slots);
+	}
+	if (new_idx == EMPTY_SLOT) {
+		ret = -ENOSPC;
+		goto out_unlock;
+	}
+
+	new_k = RTE_PTR_ADD(keys, (uintptr_t)new_idx * h->key_entry_size);
+	rte_prefetch0(new_k);
+
+	/* Check if key is already inserted in primary location */
+	ret = search_and_update(h, data, key, prim_bkt, short_sig);
+	if (ret != -1)
+		goto out_slot_back;
+
+	/* Check if key is already inserted in secondary location */
+	for (cur_bkt = sec_bkt; cur_bkt != NULL; cur_bkt = cur_bkt->next) {
+		ret = search_and_update(h, data, key, cur_bkt, short_sig);
+		if (ret != -1)
+			goto out_slot_back;
 	}
 
 	/* Copy key */
 	rte_memcpy(new_k->key, key, h->key_len);
 	new_k->pdata = data;
+	/* Key and data visible before the bucket entry pointing to them */
+	rte_smp_wmb();
 
 #if defined(RTE_ARCH_X86) /* currently only x86 support HTM */
 	if (h->add_key == ADD_KEY_MULTIWRITER_TM) {
 		ret = rte_hash_cuckoo_insert_mw_tm(prim_bkt,
-				sig, alt_hash, new_idx);
+				short_sig, new_idx);
 		if (ret >= 0)
 			return new_idx - 1;
 
 		/* Primary bucket full, need to make space for new entry */
-		ret = rte_hash_cuckoo_make_space_mw_tm(h, prim_bkt, sig,
-							alt_hash, new_idx);
+		ret = rte_hash_cuckoo_make_space_mw_tm(h, prim_bkt,
+							short_sig, new_idx);
 
 		if (ret >= 0)
 			return new_idx - 1;
 
 		/* Also search secondary bucket to get better occupancy */
-		ret = rte_hash_cuckoo_make_space_mw_tm(h, sec_bkt, sig,
-							alt_hash, new_idx);
+		ret = rte_hash_cuckoo_make_space_mw_tm(h, sec_bkt,
+							short_sig, new_idx);
 
 		if (ret >= 0)
 			return new_idx - 1;
@@ -625,8 +859,7 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
 		for (i = 0; i < RTE_HASH_BUCKET_ENTRIES; i++) {
 			/* Check if slot is available */
 			if (likely(prim_bkt->key_idx[i] == EMPTY_SLOT)) {
-				prim_bkt->sig_current[i] = sig;
-				prim_bkt->sig_alt[i] = alt_hash;
+				prim_bkt->sig_current[i] = short_sig;
 				prim_bkt->key_idx[i] = new_idx;
 				break;
 			}
@@ -646,8 +879,8 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
 		 */
 		ret = make_space_bucket(h, prim_bkt);
 		if (ret >= 0) {
-			prim_bkt->sig_current[ret] = sig;
-			prim_bkt->sig_alt[ret] = alt_hash;
+			tbl_chng_cnt_bump(h);
+			prim_bkt->sig_current[ret] = short_sig;
 			prim_bkt->key_idx[ret] = new_idx;
 			if (h->add_key == ADD_KEY_MULTIWRITER)
 				rte_spinlock_unlock(h->multiwriter_lock);
@@ -656,9 +889,24 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key,
 #if defined(RTE_ARCH_X86)
 	}
 #endif
+
+	if (h->ext_table_support) {
+		/* Writers without the lock only insert in the main table */
+		if (h->add_key == ADD_KEY_MULTIWRITER_TM)
+			rte_spinlock_lock(h->multiwriter_lock);
+		ret = insert_ext_bucket(h, sec_bkt, short_sig, new_idx);
+		if (h->add_key == ADD_KEY_MULTIWRITER_TM)
+			rte_spinlock_unlock(h->multiwriter_lock);
+		if (ret == 0) {
+			ret = new_idx - 1;
+			goto out_unlock;
+		}
+	}
+
 	/* Error in addition, store new slot back in the ring and return error */
+out_slot_back:
 	enqueue_slot_back(h, cached_free_slots, (void *)((uintptr_t) new_idx));
-
+out_unlock:
 	if (h->add_key == ADD_KEY_MULTIWRITER)
 		rte_spinlock_unlock(h->multiwriter_lock);
 	return ret;
@@ -706,59 +954,80 @@ rte_hash_add_key_data(const struct rte_hash *h, const void *key, void *data)
 	else
 		return ret;
 }
+
+/* Search a key in one bucket */
 static inline int32_t
-__rte_hash_lookup_with_hash(const struct rte_hash *h, const void *key,
-					hash_sig_t sig, void **data)
+search_one_bucket(const struct rte_hash *h, const void *key, uint16_t sig,
+			void **data, const struct rte_hash_bucket *bkt)
 {
-	uint32_t bucket_idx;
-	hash_sig_t alt_hash;
 	unsigned i;
-	struct rte_hash_bucket *bkt;
+	uint32_t key_idx;
 	struct rte_hash_key *k, *keys = h->key_store;
 
-	bucket_idx = sig & h->bucket_bitmask;
-	bkt = &h->buckets[bucket_idx];
-
-	/* Check if key is in primary location */
 	for (i = 0; i < RTE_HASH_BUCKET_ENTRIES; i++) {
-		if (bkt->sig_current[i] == sig &&
-				bkt->key_idx[i] != EMPTY_SLOT) {
-			k = (struct rte_hash_key *) ((char *)keys +
-					bkt->key_idx[i] * h->key_entry_size);
-			if (rte_hash_cmp_eq(key, k->key, h) == 0) {
-				if (data != NULL)
-					*data = k->pdata;
-				/*
-				 * Return index where key is stored,
-				 * substracting the first dummy index
-				 */
-				return bkt->key_idx[i] - 1;
-			}
+		if (bkt->sig_current[i] != sig)
+			continue;
+		/* Read once, a concurrent writer may change it */
+		key_idx = bkt->key_idx[i];
+		if (key_idx == EMPTY_SLOT)
+			continue;
+		k = (struct rte_hash_key *) ((char *)keys +
+				key_idx * h->key_entry_size);
+		if (rte_hash_cmp_eq(key, k->key, h) == 0) {
+			if (data != NULL)
+				*data = k->pdata;
+			/*
+			 * Return index where key is stored,
+			 * substracting the first dummy index
+			 */
+			return key_idx - 1;
 		}
 	}
 
-	/* Calculate secondary hash */
-	alt_hash = rte_hash_secondary_hash(sig);
-	bucket_idx = alt_hash & h->bucket_bitmask;
-	bkt = &h->buckets[bucket_idx];
+	return -1;
+}
 
-	/* Check if key is in secondary location */
-	for (i = 0; i < RTE_HASH_BUCKET_ENTRIES; i++) {
-		if (bkt->sig_current[i] == alt_hash &&
-				bkt->sig_alt[i] == sig) {
-			k = (struct rte_hash_key *) ((char *)keys +
-					bkt->key_idx[i] * h->key_entry_size);
-			if (rte_hash_cmp_eq(key, k->key, h) == 0) {
-				if (data != NULL)
-					*data = k->pdata;
-				/*
-				 * Return index where key is stored,
-				 * substracting the first dummy index
-				 */
-				return bkt->key_idx[i] - 1;
-			}
+static inline int32_t
+__rte_hash_lookup_with_hash(const struct rte_hash *h, const void *key,
+					hash_sig_t sig, void **data)
+{
+	uint32_t prim_bucket_idx, sec_bucket_idx;
+	uint16_t short_sig;
+	const struct rte_hash_bucket *bkt;
+	uint32_t cnt_b;
+	int32_t ret;
+
+	short_sig = get_short_sig(sig);
+	prim_bucket_idx = get_prim_bucket_index(h, sig);
+	sec_bucket_idx = get_alt_bucket_index(h, prim_bucket_idx, short_sig);
+
+	do {
+		cnt_b = tbl_chng_cnt_load(h);
+
+		/* Check if key is in primary location */
+		bkt = &h->buckets[prim_bucket_idx];
+		ret = search_one_bucket(h, key, short_sig, data, bkt);
+		if (ret != -1)
+			return ret;
+
+		/* Check if key is in secondary location */
+		bkt = &h->buckets[sec_bucket_idx];
+		ret = search_one_bucket(h, key, short_sig, data, bkt);
+		if (ret != -1)
+			return ret;
+
+		/* Check if key is in the extendable buckets */
+		for (bkt = bkt->next; bkt != NULL; bkt = bkt->next) {
+			ret = search_one_bucket(h, key, short_sig, data, bkt);
+			if (ret != -1)
+				return ret;
 		}
-	}
+
+		/*
+		 * A cuckoo move may have taken the key to the bucket already
+		 * searched, search again if the table changed.
+		 */
+	} while (unlikely(tbl_chng_cnt_changed(h, cnt_b)));
 
 	return -ENOENT;
 }
@@ -794,13 +1063,11 @@ rte_hash_lookup_data(const struct rte_hash *h, const void *key, void **data)
 }
 
 static inline void
-remove_entry(const struct rte_hash *h, struct rte_hash_bucket *bkt, unsigned i)
+free_key_slot(const struct rte_hash *h, uint32_t key_idx)
 {
 	unsigned lcore_id, n_slots;
 	struct lcore_cache *cached_free_slots;
 
-	bkt->sig_current[i] = NULL_SIGNATURE;
-	bkt->sig_alt[i] = NULL_SIGNATURE;
 	if (h->hw_trans_mem_support) {
 		lcore_id = rte_lcore_id();
 		cached_free_slots = &h->local_free_slots[lcore_id];
@@ -814,29 +1081,101 @@ remove_entry(const struct rte_hash *h, struct rte_hash_bucket *bkt, unsigned i)
 		}
 		/* Put index of new free slot in cache. */
 		cached_free_slots->objs[cached_free_slots->len] =
-				(void *)((uintptr_t)bkt->key_idx[i]);
+				(void *)((uintptr_t)key_idx);
 		cached_free_slots->len++;
 	} else {
 		rte_ring_sp_enqueue(h->free_slots,
-				(void *)((uintptr_t)bkt->key_idx[i]));
+				(void *)((uintptr_t)key_idx));
+	}
+}
+
+/*
+ * Free the slot of a key deleted with lock-free lookups, along with the
+ * extendable bucket emptied by its removal
+ */
+static inline void
+recycle_key_slot(const struct rte_hash *h, uint32_t key_idx)
+{
+	if (h->ext_table_support && h->ext_bkt_to_free[key_idx] != 0) {
+		rte_ring_mp_enqueue(h->free_ext_bkts, (void *)((uintptr_t)
+				h->ext_bkt_to_free[key_idx]));
+		h->ext_bkt_to_free[key_idx] = 0;
+	}
+
+	free_key_slot(h, key_idx);
+}
+
+static void
+rcu_free_key(const struct rte_hash *h, uint32_t key_idx)
+{
+	struct rte_hash_rcu_config *cfg = h->hash_rcu_cfg;
+	struct rte_hash_key *k;
+
+	if (cfg->free_key_data_func != NULL) {
+		k = RTE_PTR_ADD(h->key_store,
+				(uintptr_t)key_idx * h->key_entry_size);
+		cfg->free_key_data_func(cfg->key_data_ptr, k->pdata);
+	}
+
+	recycle_key_slot(h, key_idx);
+}
+
+/* Defer queue callback, the readers of the keys are gone */
+static void
+rcu_free_key_slots(void *p, void *e, unsigned int n)
+{
+	const struct rte_hash *h = p;
+	uint32_t *key_idx = e;
+	unsigned int i;
+
+	for (i = 0; i < n; i++)
+		rcu_free_key(h, key_idx[i]);
+}
+
+/* Free the slot of a deleted key once lookups cannot reference it */
+static void
+rcu_defer_free_key(const struct rte_hash *h, uint32_t key_idx)
+{
+	int ret = -ENOSPC;
+
+	if (h->dq != NULL) {
+		/* Adding keys may reclaim from the queue concurrently */
+		if (h->multiwriter_lock != NULL)
+			rte_spinlock_lock(h->multiwriter_lock);
+		ret = rte_rcu_qsbr_dq_enqueue(h->dq, &key_idx);
+		if (h->multiwriter_lock != NULL)
+			rte_spinlock_unlock(h->multiwriter_lock);
+	}
+
+	/* Sync mode, or the queue is full of keys still referenced */
+	if (ret != 0) {
+		rte_rcu_qsbr_synchronize(h->hash_rcu_cfg->v,
+					RTE_QSBR_THRID_INVALID);
+		rcu_free_key(h, key_idx);
 	}
 }
 
+static inline void
+remove_entry(const struct rte_hash *h, struct rte_hash_bucket *bkt, unsigned i)
+{
+	bkt->sig_current[i] = NULL_SIGNATURE;
+	/*
+	 * Lock-free readers may still be comparing the key, the application
+	 * frees the slot once they are done.
+	 */
+	if (!h->readwrite_concur_lf_support)
+		free_key_slot(h, bkt->key_idx[i]);
+}
+
+/* Search a key in one bucket and remove it if found */
 static inline int32_t
-__rte_hash_del_key_with_hash(const struct rte_hash *h, const void *key,
-						hash_sig_t sig)
+search_and_remove(const struct rte_hash *h, const void *key,
+			struct rte_hash_bucket *bkt, uint16_t sig)
 {
-	uint32_t bucket_idx;
-	hash_sig_t alt_hash;
 	unsigned i;
-	struct rte_hash_bucket *bkt;
 	struct rte_hash_key *k, *keys = h->key_store;
 	int32_t ret;
 
-	bucket_idx = sig & h->bucket_bitmask;
-	bkt = &h->buckets[bucket_idx];
-
-	/* Check if key is in primary location */
 	for (i = 0; i < RTE_HASH_BUCKET_ENTRIES; i++) {
 		if (bkt->sig_current[i] == sig &&
 				bkt->key_idx[i] != EMPTY_SLOT) {
@@ -856,32 +1195,83 @@ __rte_hash_del_key_with_hash(const struct rte_hash *h, const void *key,
 		}
 	}
 
-	/* Calculate secondary hash */
-	alt_hash = rte_hash_secondary_hash(sig);
-	bucket_idx = alt_hash & h->bucket_bitmask;
-	bkt = &h->buckets[bucket_idx];
+	return -1;
+}
 
-	/* Check if key is in secondary location */
-	for (i = 0; i < RTE_HASH_BUCKET_ENTRIES; i++) {
-		if (bkt->sig_current[i] == alt_hash &&
-				bkt->key_idx[i] != EMPTY_SLOT) {
-			k = (struct rte_hash_key *) ((char *)keys +
-					bkt->key_idx[i] * h->key_entry_size);
-			if (rte_hash_cmp_eq(key, k->key, h) == 0) {
-				remove_entry(h, bkt, i);
+static inline int
+bucket_is_empty(const struct rte_hash_bucket *bkt)
+{
+	unsigned i;
 
-				/*
-				 * Return index where key is stored,
-				 * substracting the first dummy index
-				 */
-				ret = bkt->key_idx[i] - 1;
-				bkt->key_idx[i] = EMPTY_SLOT;
-				return ret;
-			}
+	for (i = 0; i < RTE_HASH_BUCKET_ENTRIES; i++)
+		if (bkt->key_idx[i] != EMPTY_SLOT)
+			return 0;
+	return 1;
+}
+
+/*
+ * Unlink an emptied extendable bucket from its chain. Its own next
+ * pointer is kept, lock-free readers walking it reach the rest of the
+ * chain; the bucket is recycled when the last key removed from it is
+ * freed by the application.
+ */
+static inline void
+unlink_ext_bucket(const struct rte_hash *h, struct rte_hash_bucket *prev_bkt,
+		struct rte_hash_bucket *bkt, int32_t position)
+{
+	uint32_t ext_bkt_id = bkt - h->buckets_ext + 1;
+
+	prev_bkt->next = bkt->next;
+	if (h->readwrite_concur_lf_support)
+		h->ext_bkt_to_free[position + 1] = ext_bkt_id;
+	else
+		rte_ring_sp_enqueue(h->free_ext_bkts,
+				(void *)((uintptr_t)ext_bkt_id));
+}
+
+static inline int32_t
+__rte_hash_del_key_with_hash(const struct rte_hash *h, const void *key,
+						hash_sig_t sig)
+{
+	uint32_t prim_bucket_idx, sec_bucket_idx;
+	uint16_t short_sig;
+	struct rte_hash_bucket *bkt, *prev_bkt;
+	int32_t ret;
+
+	short_sig = get_short_sig(sig);
+	prim_bucket_idx = get_prim_bucket_index(h, sig);
+	bkt = &h->buckets[prim_bucket_idx];
+
+	/* Check if key is in primary location */
+	ret = search_and_remove(h, key, bkt, short_sig);
+	if (ret != -1)
+		goto found;
+
+	sec_bucket_idx = get_alt_bucket_index(h, prim_bucket_idx, short_sig);
+	bkt = &h->buckets[sec_bucket_idx];
+
+	/* Check if key is in secondary location */
+	ret = search_and_remove(h, key, bkt, short_sig);
+	if (ret != -1)
+		goto found;
+
+	/* Check if key is in the extendable buckets */
+	for (prev_bkt = bkt, bkt = bkt->next; bkt != NULL;
+			prev_bkt = bkt, bkt = bkt->next) {
+		ret = search_and_remove(h, key, bkt, short_sig);
+		if (ret != -1) {
+			if (bucket_is_empty(bkt))
+				unlink_ext_bucket(h, prev_bkt, bkt, ret);
+			goto found;
 		}
 	}
 
 	return -ENOENT;
+
+found:
+	if (h->hash_rcu_cfg != NULL)
+		rcu_defer_free_key(h, ret + 1);
+	return ret;
 }
 
 int32_t
@@ -919,59 +1309,153 @@ rte_hash_get_key_with_position(const struct rte_hash *h, const int32_t position,
 	return 0;
 }
 
+int
+rte_hash_free_key_with_position(const struct rte_hash *h,
+				const int32_t position)
+{
+	uint32_t num_key_slots;
+
+	RETURN_IF_TRUE((h == NULL), -EINVAL);
+
+	/* Without a QS variable attached, which frees the slots itself */
+	if (!h->readwrite_concur_lf_support || h->hash_rcu_cfg != NULL)
+		return -EINVAL;
+
+	if (h->hw_trans_mem_support)
+		num_key_slots = h->entries + (RTE_MAX_LCORE - 1) *
+					LCORE_CACHE_SIZE + 1;
+	else
+		num_key_slots = h->entries + 1;
+
+	/* Out of bounds, the first slot is the dummy one */
+	if (position < 0 || (uint32_t)position >= num_key_slots - 1)
+		return -EINVAL;
+
+	recycle_key_slot(h, position + 1);
+	return 0;
+}
+
+int
+rte_hash_rcu_qsbr_add(struct rte_hash *h, struct rte_hash_rcu_config *cfg)
+{
+	struct rte_rcu_qsbr_dq_parameters params;
+	struct rte_hash_rcu_config *hash_rcu_cfg;
+	char rcu_dq_name[RTE_RCU_QSBR_DQ_NAMESIZE];
+	uint32_t num_key_slots;
+
+	if (h == NULL || cfg == NULL || cfg->v == NULL)
+		return -EINVAL;
+
+	/* Readers only hold references to keys with lock-free lookups */
+	if (!h->readwrite_concur_lf_support)
+		return -EINVAL;
+
+	if (h->hash_rcu_cfg != NULL)
+		return -EEXIST;
+
+	if (cfg->mode != RTE_HASH_QSBR_MODE_DQ &&
+			cfg->mode != RTE_HASH_QSBR_MODE_SYNC)
+		return -EINVAL;
+
+	hash_rcu_cfg = rte_zmalloc(NULL, sizeof(*hash_rcu_cfg), 0);
+	if (hash_rcu_cfg == NULL) {
+		RTE_LOG(ERR, HASH, "memory allocation failed\n");
+		return -ENOMEM;
+	}
+	*hash_rcu_cfg = *cfg;
+	if (hash_rcu_cfg->max_reclaim_size == 0)
+		hash_rcu_cfg->max_reclaim_size = RTE_HASH_RCU_DQ_RECLAIM_MAX;
+
+	if (cfg->mode == RTE_HASH_QSBR_MODE_DQ) {
+		if (h->hw_trans_mem_support)
+			num_key_slots = h->entries + (RTE_MAX_LCORE - 1) *
+						LCORE_CACHE_SIZE;
+		else
+			num_key_slots = h->entries;
+
+		/* Large enough by default to hold every deleted key */
+		snprintf(rcu_dq_name, sizeof(rcu_dq_name), "HASH_RCU_%s",
+				h->name);
+		memset(&params, 0, sizeof(params));
+		params.name = rcu_dq_name;
+		params.size = cfg->dq_size != 0 ? cfg->dq_size : num_key_slots;
+		params.esize = sizeof(uint32_t);
+		params.trigger_reclaim_limit = RTE_MIN(
+				cfg->trigger_reclaim_limit, params.size);
+		params.max_reclaim_size = hash_rcu_cfg->max_reclaim_size;
+		params.free_fn = rcu_free_key_slots;
+		params.p = h;
+		params.v = cfg->v;
+
+		h->dq = rte_rcu_qsbr_dq_create(&params);
+		if (h->dq == NULL) {
+			RTE_LOG(ERR, HASH, "HASH defer queue creation failed\n");
+			rte_free(hash_rcu_cfg);
+			return -ENOMEM;
+		}
+	}
+
+	h->hash_rcu_cfg = hash_rcu_cfg;
+	return 0;
+}
+
+/*
+ * Build the hit masks of a key in its two buckets. Each bucket entry takes
+ * two bits of a hit mask, which is the byte mask of a 16-bit vector compare;
+ * the scalar and NEON versions only set the lower bit of the two.
+ */
 static inline void
 compare_signatures(uint32_t *prim_hash_matches, uint32_t *sec_hash_matches,
 			const struct rte_hash_bucket *prim_bkt,
 			const struct rte_hash_bucket *sec_bkt,
-			hash_sig_t prim_hash, hash_sig_t sec_hash,
+			uint16_t sig,
 			enum rte_hash_sig_compare_function sig_cmp_fn)
 {
 	unsigned int i;
 
 	switch (sig_cmp_fn) {
-#ifdef RTE_MACHINE_CPUFLAG_AVX2
-	case RTE_HASH_COMPARE_AVX2:
-		*prim_hash_matches = _mm256_movemask_ps((__m256)_mm256_cmpeq_epi32(
-				_mm256_load_si256(
-					(__m256i const *)prim_bkt->sig_current),
-				_mm256_set1_epi32(prim_hash)));
-		*sec_hash_matches = _mm256_movemask_ps((__m256)_mm256_cmpeq_epi32(
-				_mm256_load_si256(
-					(__m256i const *)sec_bkt->sig_current),
-				_mm256_set1_epi32(sec_hash)));
-		break;
-#endif
 #ifdef RTE_MACHINE_CPUFLAG_SSE2
 	case RTE_HASH_COMPARE_SSE:
-		/* Compare the first 4 signatures in the bucket */
-		*prim_hash_matches = _mm_movemask_ps((__m128)_mm_cmpeq_epi16(
+		/* Compare all signatures in the bucket */
+		*prim_hash_matches = _mm_movemask_epi8(_mm_cmpeq_epi16(
 				_mm_load_si128(
 					(__m128i const *)prim_bkt->sig_current),
-				_mm_set1_epi32(prim_hash)));
-		*prim_hash_matches |= (_mm_movemask_ps((__m128)_mm_cmpeq_epi16(
-				_mm_load_si128(
-					(__m128i const *)&prim_bkt->sig_current[4]),
-				_mm_set1_epi32(prim_hash)))) << 4;
-		/* Compare the first 4 signatures in the bucket */
-		*sec_hash_matches = _mm_movemask_ps((__m128)_mm_cmpeq_epi16(
+				_mm_set1_epi16(sig)));
+		/* Compare all signatures in the bucket */
+		*sec_hash_matches = _mm_movemask_epi8(_mm_cmpeq_epi16(
 				_mm_load_si128(
 					(__m128i const *)sec_bkt->sig_current),
-				_mm_set1_epi32(sec_hash)));
-		*sec_hash_matches |= (_mm_movemask_ps((__m128)_mm_cmpeq_epi16(
-				_mm_load_si128(
-					(__m128i const *)&sec_bkt->sig_current[4]),
-				_mm_set1_epi32(sec_hash)))) << 4;
+				_mm_set1_epi16(sig)));
+		break;
+#endif
+#if defined(RTE_ARCH_ARM64) && defined(RTE_MACHINE_CPUFLAG_NEON)
+	case RTE_HASH_COMPARE_NEON: {
+		uint16x8_t vmat, vsig, x;
+		/* Move the top bit of entry i to bit 2 * i */
+		const int16x8_t shift = {-15, -13, -11, -9, -7, -5, -3, -1};
+
+		vsig = vld1q_dup_u16((uint16_t const *)&sig);
+		/* Compare all signatures in the primary bucket */
+		vmat = vceqq_u16(vsig,
+			vld1q_u16((uint16_t const *)prim_bkt->sig_current));
+		x = vshlq_u16(vandq_u16(vmat, vdupq_n_u16(0x8000)), shift);
+		*prim_hash_matches = (uint32_t)(vaddvq_u16(x));
+		/* Compare all signatures in the secondary bucket */
+		vmat = vceqq_u16(vsig,
+			vld1q_u16((uint16_t const *)sec_bkt->sig_current));
+		x = vshlq_u16(vandq_u16(vmat, vdupq_n_u16(0x8000)), shift);
+		*sec_hash_matches = (uint32_t)(vaddvq_u16(x));
 		break;
+	}
 #endif
 	default:
 		for (i = 0; i < RTE_HASH_BUCKET_ENTRIES; i++) {
 			*prim_hash_matches |=
-				((prim_hash == prim_bkt->sig_current[i]) << i);
+				((sig == prim_bkt->sig_current[i]) << (i << 1));
 			*sec_hash_matches |=
-				((sec_hash == sec_bkt->sig_current[i]) << i);
+				((sig == sec_bkt->sig_current[i]) << (i << 1));
 		}
 	}
-
 }
 
 #define PREFETCH_OFFSET 4
@@ -982,12 +1466,14 @@ __rte_hash_lookup_bulk(const struct rte_hash *h, const void **keys,
 {
 	uint64_t hits = 0;
 	int32_t i;
+	uint32_t cnt_b;
 	uint32_t prim_hash[RTE_HASH_LOOKUP_BULK_MAX];
-	uint32_t sec_hash[RTE_HASH_LOOKUP_BULK_MAX];
+	uint32_t prim_index[RTE_HASH_LOOKUP_BULK_MAX];
+	uint16_t sig[RTE_HASH_LOOKUP_BULK_MAX];
 	const struct rte_hash_bucket *primary_bkt[RTE_HASH_LOOKUP_BULK_MAX];
 	const struct rte_hash_bucket *secondary_bkt[RTE_HASH_LOOKUP_BULK_MAX];
-	uint32_t prim_hitmask[RTE_HASH_LOOKUP_BULK_MAX] = {0};
-	uint32_t sec_hitmask[RTE_HASH_LOOKUP_BULK_MAX] = {0};
+	uint32_t prim_hitmask[RTE_HASH_LOOKUP_BULK_MAX];
+	uint32_t sec_hitmask[RTE_HASH_LOOKUP_BULK_MAX];
 
 	/* Prefetch first keys */
 	for (i = 0; i < PREFETCH_OFFSET && i < num_keys; i++)
@@ -1001,10 +1487,12 @@ __rte_hash_lookup_bulk(const struct rte_hash *h, const void **keys,
 		rte_prefetch0(keys[i + PREFETCH_OFFSET]);
 
 		prim_hash[i] = rte_hash_hash(h, keys[i]);
-		sec_hash[i] = rte_hash_secondary_hash(prim_hash[i]);
+		sig[i] = get_short_sig(prim_hash[i]);
+		prim_index[i] = get_prim_bucket_index(h, prim_hash[i]);
 
-		primary_bkt[i] = &h->buckets[prim_hash[i] & h->bucket_bitmask];
-		secondary_bkt[i] = &h->buckets[sec_hash[i] & h->bucket_bitmask];
+		primary_bkt[i] = &h->buckets[prim_index[i]];
+		secondary_bkt[i] = &h->buckets[get_alt_bucket_index(h,
+						prim_index[i], sig[i])];
 
 		rte_prefetch0(primary_bkt[i]);
 		rte_prefetch0(secondary_bkt[i]);
@@ -1013,23 +1501,32 @@ __rte_hash_lookup_bulk(const struct rte_hash *h, const void **keys,
 	/* Calculate and prefetch rest of the buckets */
 	for (; i < num_keys; i++) {
 		prim_hash[i] = rte_hash_hash(h, keys[i]);
-		sec_hash[i] = rte_hash_secondary_hash(prim_hash[i]);
+		sig[i] = get_short_sig(prim_hash[i]);
+		prim_index[i] = get_prim_bucket_index(h, prim_hash[i]);
 
-		primary_bkt[i] = &h->buckets[prim_hash[i] & h->bucket_bitmask];
-		secondary_bkt[i] = &h->buckets[sec_hash[i] & h->bucket_bitmask];
+		primary_bkt[i] = &h->buckets[prim_index[i]];
+		secondary_bkt[i] = &h->buckets[get_alt_bucket_index(h,
+						prim_index[i], sig[i])];
 
 		rte_prefetch0(primary_bkt[i]);
 		rte_prefetch0(secondary_bkt[i]);
 	}
 
+retry:
+	cnt_b = tbl_chng_cnt_load(h);
+	hits = 0;
+
 	/* Compare signatures and prefetch key slot of first hit */
 	for (i = 0; i < num_keys; i++) {
+		prim_hitmask[i] = 0;
+		sec_hitmask[i] = 0;
 		compare_signatures(&prim_hitmask[i], &sec_hitmask[i],
 				primary_bkt[i], secondary_bkt[i],
-				prim_hash[i], sec_hash[i], h->sig_cmp_fn);
+				sig[i], h->sig_cmp_fn);
 
 		if (prim_hitmask[i]) {
-			uint32_t first_hit = __builtin_ctzl(prim_hitmask[i]);
+			uint32_t first_hit =
+					__builtin_ctzl(prim_hitmask[i]) >> 1;
 			uint32_t key_idx = primary_bkt[i]->key_idx[first_hit];
 			const struct rte_hash_key *key_slot =
 				(const struct rte_hash_key *)(
@@ -1040,7 +1537,8 @@ __rte_hash_lookup_bulk(const struct rte_hash *h, const void **keys,
 		}
 
 		if (sec_hitmask[i]) {
-			uint32_t first_hit = __builtin_ctzl(sec_hitmask[i]);
+			uint32_t first_hit =
+					__builtin_ctzl(sec_hitmask[i]) >> 1;
 			uint32_t key_idx = secondary_bkt[i]->key_idx[first_hit];
 			const struct rte_hash_key *key_slot =
 				(const struct rte_hash_key *)(
@@ -1054,7 +1552,8 @@ __rte_hash_lookup_bulk(const struct rte_hash *h, const void **keys,
 	for (i = 0; i < num_keys; i++) {
 		positions[i] = -ENOENT;
 		while (prim_hitmask[i]) {
-			uint32_t hit_index = __builtin_ctzl(prim_hitmask[i]);
+			uint32_t hit_index =
+					__builtin_ctzl(prim_hitmask[i]) >> 1;
 
 			uint32_t key_idx = primary_bkt[i]->key_idx[hit_index];
 			const struct rte_hash_key *key_slot =
@@ -1073,11 +1572,12 @@ __rte_hash_lookup_bulk(const struct rte_hash *h, const void **keys,
 				positions[i] = key_idx - 1;
 				goto next_key;
 			}
-			prim_hitmask[i] &= ~(1 << (hit_index));
+			prim_hitmask[i] &= ~(3U << (hit_index << 1));
 		}
 
 		while (sec_hitmask[i]) {
-			uint32_t hit_index = __builtin_ctzl(sec_hitmask[i]);
+			uint32_t hit_index =
+					__builtin_ctzl(sec_hitmask[i]) >> 1;
 
 			uint32_t key_idx = secondary_bkt[i]->key_idx[hit_index];
 			const struct rte_hash_key *key_slot =
@@ -1097,13 +1597,40 @@ __rte_hash_lookup_bulk(const struct rte_hash *h, const void **keys,
 				positions[i] = key_idx - 1;
 				goto next_key;
 			}
-			sec_hitmask[i] &= ~(1 << (hit_index));
+			sec_hitmask[i] &= ~(3U << (hit_index << 1));
+		}
+
+		/* Main table miss, search the extendable buckets if any */
+		if (h->ext_table_support) {
+			const struct rte_hash_bucket *bkt;
+			int32_t ret;
+
+			for (bkt = secondary_bkt[i]->next; bkt != NULL;
+					bkt = bkt->next) {
+				ret = search_one_bucket(h, keys[i],
+						sig[i],
+						data != NULL ? &data[i] : NULL,
+						bkt);
+				if (ret != -1) {
+					hits |= 1ULL << i;
+					positions[i] = ret;
+					goto next_key;
+				}
+			}
 		}
 
 next_key:
 		continue;
 	}
 
+	/*
+	 * Cuckoo moves may have hidden some keys while searching,
+	 * search again if the table changed and some keys missed.
+	 */
+	if (unlikely(__builtin_popcountl(hits) != num_keys &&
+			tbl_chng_cnt_changed(h, cnt_b)))
+		goto retry;
+
 	if (hit_mask != NULL)
 		*hit_mask = hits;
 }
@@ -1140,31 +1667,43 @@ int32_t
 rte_hash_iterate(const struct rte_hash *h, const void **key, void **data, uint32_t *next)
 {
 	uint32_t bucket_idx, idx, position;
+	const struct rte_hash_bucket *buckets;
 	struct rte_hash_key *next_key;
 
 	RETURN_IF_TRUE(((h == NULL) || (next == NULL)), -EINVAL);
 
-	const uint32_t total_entries = h->num_buckets * RTE_HASH_BUCKET_ENTRIES;
+	const uint32_t main_entries = h->num_buckets * RTE_HASH_BUCKET_ENTRIES;
+	/* Extendable buckets follow the main table, empty ones are skipped */
+	const uint32_t total_entries = h->ext_table_support ?
+					main_entries * 2 : main_entries;
 	/* Out of bounds */
 	if (*next >= total_entries)
 		return -ENOENT;
 
-	/* Calculate bucket and index of current iterator */
-	bucket_idx = *next / RTE_HASH_BUCKET_ENTRIES;
-	idx = *next % RTE_HASH_BUCKET_ENTRIES;
-
 	/* If current position is empty, go to the next one */
-	while (h->buckets[bucket_idx].key_idx[idx] == EMPTY_SLOT) {
+	for (;;) {
+		/* Calculate bucket and index of current iterator */
+		if (*next < main_entries) {
+			buckets = h->buckets;
+			bucket_idx = *next / RTE_HASH_BUCKET_ENTRIES;
+		} else {
+			buckets = h->buckets_ext;
+			bucket_idx = (*next - main_entries) /
+					RTE_HASH_BUCKET_ENTRIES;
+		}
+		idx = *next % RTE_HASH_BUCKET_ENTRIES;
+
+		if (buckets[bucket_idx].key_idx[idx] != EMPTY_SLOT)
+			break;
+
 		(*next)++;
 		/* End of table */
 		if (*next == total_entries)
 			return -ENOENT;
-		bucket_idx = *next / RTE_HASH_BUCKET_ENTRIES;
-		idx = *next % RTE_HASH_BUCKET_ENTRIES;
 	}
 
 	/* Get position of entry in key table */
-	position = h->buckets[bucket_idx].key_idx[idx];
+	position = buckets[bucket_idx].key_idx[idx];
 	next_key = (struct rte_hash_key *) ((char *)h->key_store +
 				position * h->key_entry_size);
 	/* Return key and data */
@@ -44,6 +44,7 @@
 #endif
 
 #if defined(RTE_ARCH_ARM64)
+#include <rte_vect.h>
 #include "rte_cmp_arm64.h"
 #endif
 
@@ -167,19 +168,21 @@ struct rte_hash_key {
 enum rte_hash_sig_compare_function {
 	RTE_HASH_COMPARE_SCALAR = 0,
 	RTE_HASH_COMPARE_SSE,
-	RTE_HASH_COMPARE_AVX2,
+	RTE_HASH_COMPARE_NEON,
 	RTE_HASH_COMPARE_NUM
 };
 
 /** Bucket structure */
 struct rte_hash_bucket {
-	hash_sig_t sig_current[RTE_HASH_BUCKET_ENTRIES];
+	uint16_t sig_current[RTE_HASH_BUCKET_ENTRIES];
+	/**< Short signatures, the upper half of the hash of the keys */
 
 	uint32_t key_idx[RTE_HASH_BUCKET_ENTRIES];
 
-	hash_sig_t sig_alt[RTE_HASH_BUCKET_ENTRIES];
-
 	uint8_t flag[RTE_HASH_BUCKET_ENTRIES];
+
+	struct rte_hash_bucket *next;
+	/**< Next extendable bucket chained to this one, if any */
 } __rte_cache_aligned;
 
 /** A hash table structure. */
@@ -197,6 +200,19 @@ struct rte_hash {
 	enum add_key_case add_key; /**< Multi-writer hash add behavior */
 
 	rte_spinlock_t *multiwriter_lock; /**< Multi-writer spinlock for w/o TM */
+	uint8_t readwrite_concur_lf_support;
+	/**< Lock-free lookups concurrent with add/delete */
+	uint8_t ext_table_support;     /**< Enable extendable bucket table */
+	struct rte_ring *free_ext_bkts;
+	/**< Ring that stores the indexes of the free extendable buckets */
+	uint32_t *ext_bkt_to_free;
+	/**< Extendable bucket to recycle when a key slot is freed, indexed
+	 * by key slot, with lock-free lookups only.
+	 */
+	struct rte_hash_rcu_config *hash_rcu_cfg;
+	/**< RCU configuration, NULL if no QS variable is attached */
+	struct rte_rcu_qsbr_dq *dq;
+	/**< Defer queue of the deleted key slots, in RCU DQ mode */
 
 	/* Fields used in lookup */
 
@@ -215,12 +231,44 @@ struct rte_hash {
 	uint32_t key_entry_size;         /**< Size of each key entry. */
 
 	void *key_store;                /**< Table storing all keys and data */
+	uint32_t *tbl_chng_cnt;
+	/**< Incremented before a cuckoo move overwrites the old location of
+	 * an entry, so lock-free readers can detect they may have missed it.
+	 */
 	struct rte_hash_bucket *buckets;
 	/**< Table with buckets storing all the	hash values and key indexes
 	 * to the key table.
 	 */
+	struct rte_hash_bucket *buckets_ext;
+	/**< Extendable buckets, chained to the buckets of the main table
+	 * when both buckets of a key are full.
+	 */
 } __rte_cache_aligned;
 
+/*
+ * The short signature of a key is stored in its buckets, and is the same in
+ * both. Its alternative bucket only depends on its current bucket and short
+ * signature, so that entries can be moved without their full hash.
+ */
+static inline uint16_t
+get_short_sig(const hash_sig_t hash)
+{
+	return hash >> 16;
+}
+
+static inline uint32_t
+get_prim_bucket_index(const struct rte_hash *h, const hash_sig_t hash)
+{
+	return hash & h->bucket_bitmask;
+}
+
+static inline uint32_t
+get_alt_bucket_index(const struct rte_hash *h,
+			uint32_t cur_bkt_idx, uint16_t sig)
+{
+	return (cur_bkt_idx ^ sig) & h->bucket_bitmask;
+}
+
 struct queue_node {
 	struct rte_hash_bucket *bkt; /* Current bucket on the bfs search */
 
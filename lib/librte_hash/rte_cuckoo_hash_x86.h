@@ -40,7 +40,7 @@
  */
 static inline unsigned
 rte_hash_cuckoo_insert_mw_tm(struct rte_hash_bucket *prim_bkt,
-		hash_sig_t sig, hash_sig_t alt_hash, uint32_t new_idx)
+		uint16_t sig, uint32_t new_idx)
 {
 	unsigned i, status;
 	unsigned try = 0;
@@ -55,7 +55,6 @@ rte_hash_cuckoo_insert_mw_tm(struct rte_hash_bucket *prim_bkt,
 				/* Check if slot is available */
 				if (likely(prim_bkt->key_idx[i] == EMPTY_SLOT)) {
 					prim_bkt->sig_current[i] = sig;
-					prim_bkt->sig_alt[i] = alt_hash;
 					prim_bkt->key_idx[i] = new_idx;
 					break;
 				}
@@ -77,12 +76,12 @@ rte_hash_cuckoo_insert_mw_tm(struct rte_hash_bucket *prim_bkt,
 }
 
 /* Shift buckets along provided cuckoo_path (@leaf and @leaf_slot) and fill
- * the path head with new entry (sig, alt_hash, new_idx)
+ * the path head with new entry (sig, new_idx)
  */
 static inline int
 rte_hash_cuckoo_move_insert_mw_tm(const struct rte_hash *h,
 			struct queue_node *leaf, uint32_t leaf_slot,
-			hash_sig_t sig, hash_sig_t alt_hash, uint32_t new_idx)
+			uint16_t sig, uint32_t new_idx)
 {
 	unsigned try = 0;
 	unsigned status;
@@ -95,28 +94,29 @@ rte_hash_cuckoo_move_insert_mw_tm(const struct rte_hash *h,
 	while (try < RTE_HASH_TSX_MAX_RETRY) {
 		status = rte_xbegin();
 		if (likely(status == RTE_XBEGIN_STARTED)) {
+			/* The moves commit together with the counter, lock-free
+			 * readers that missed a moved key see it changed.
+			 */
+			if (h->readwrite_concur_lf_support &&
+			    curr_node->prev != NULL)
+				(*h->tbl_chng_cnt)++;
+
 			while (likely(curr_node->prev != NULL)) {
 				prev_node = curr_node->prev;
 				prev_bkt = prev_node->bkt;
 				prev_slot = curr_node->prev_slot;
 
-				prev_alt_bkt_idx
-					= prev_bkt->sig_alt[prev_slot]
-					    & h->bucket_bitmask;
+				prev_alt_bkt_idx = get_alt_bucket_index(h,
+					    prev_bkt - h->buckets,
+					    prev_bkt->sig_current[prev_slot]);
 
 				if (unlikely(&h->buckets[prev_alt_bkt_idx]
 					     != curr_bkt)) {
 					rte_xabort(RTE_XABORT_CUCKOO_PATH_INVALIDED);
 				}
 
-				/* Need to swap current/alt sig to allow later
-				 * Cuckoo insert to move elements back to its
-				 * primary bucket if available
-				 */
-				curr_bkt->sig_alt[curr_slot] =
-				    prev_bkt->sig_current[prev_slot];
 				curr_bkt->sig_current[curr_slot] =
-				    prev_bkt->sig_alt[prev_slot];
+				    prev_bkt->sig_current[prev_slot];
 				curr_bkt->key_idx[curr_slot]
 				    = prev_bkt->key_idx[prev_slot];
 
@@ -126,7 +126,6 @@ rte_hash_cuckoo_move_insert_mw_tm(const struct rte_hash *h,
 			}
 
 			curr_bkt->sig_current[curr_slot] = sig;
-			curr_bkt->sig_alt[curr_slot] = alt_hash;
 			curr_bkt->key_idx[curr_slot] = new_idx;
 
 			rte_xend();
@@ -151,8 +150,7 @@ rte_hash_cuckoo_move_insert_mw_tm(const struct rte_hash *h,
 static inline int
 rte_hash_cuckoo_make_space_mw_tm(const struct rte_hash *h,
 			struct rte_hash_bucket *bkt,
-			hash_sig_t sig, hash_sig_t alt_hash,
-			uint32_t new_idx)
+			uint16_t sig, uint32_t new_idx)
 {
 	unsigned i;
 	struct queue_node queue[RTE_HASH_BFS_QUEUE_MAX_LEN];
@@ -173,14 +171,14 @@ rte_hash_cuckoo_make_space_mw_tm(const struct rte_hash *h,
 		for (i = 0; i < RTE_HASH_BUCKET_ENTRIES; i++) {
 			if (curr_bkt->key_idx[i] == EMPTY_SLOT) {
 				if (likely(rte_hash_cuckoo_move_insert_mw_tm(h,
-						tail, i, sig,
-						alt_hash, new_idx) == 0))
+						tail, i, sig, new_idx) == 0))
 					return 0;
 			}
 
 			/* Enqueue new node and keep prev node info */
-			alt_bkt = &(h->buckets[curr_bkt->sig_alt[i]
-						    & h->bucket_bitmask]);
+			alt_bkt = &(h->buckets[get_alt_bucket_index(h,
+					curr_bkt - h->buckets,
+					curr_bkt->sig_current[i])]);
 			head->bkt = alt_bkt;
 			head->prev = tail;
 			head->prev_slot = i;
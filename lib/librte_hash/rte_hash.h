@@ -43,6 +43,8 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#include <rte_rcu_qsbr.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -63,6 +65,27 @@ extern "C" {
 /** Default behavior of insertion, single writer/multi writer */
 #define RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_ADD 0x02
 
+/**
+ * Lookups are lock-free and safe while keys are added or deleted.
+ * The key slot of a deleted key is not recycled until the application
+ * calls rte_hash_free_key_with_position(), once no reader can still
+ * reference it, or until the grace period of a QS variable attached with
+ * rte_hash_rcu_qsbr_add() is over.
+ */
+#define RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF 0x04
+
+/**
+ * Chain extendable buckets to a bucket when both buckets of a key are
+ * full, so that adding keys does not fail until the table holds its
+ * configured number of entries.
+ */
+#define RTE_HASH_EXTRA_FLAGS_EXT_TABLE 0x08
+
+/** Default maximum number of key slots reclaimed at once from the defer
+ * queue of a hash table.
+ */
+#define RTE_HASH_RCU_DQ_RECLAIM_MAX	16
+
 /** Signature of key that is stored internally. */
 typedef uint32_t hash_sig_t;
 
@@ -87,6 +110,45 @@ struct rte_hash_parameters {
 	uint8_t extra_flag;		/**< Indicate if additional parameters are present. */
 };
 
+/** Reclamation modes of the key slots of a hash table using RCU. */
+enum rte_hash_qsbr_mode {
+	RTE_HASH_QSBR_MODE_DQ = 0,
+	/**< Push deleted keys to a defer queue, reclaimed by later deletes
+	 * and by adds running out of key slots.
+	 */
+	RTE_HASH_QSBR_MODE_SYNC
+	/**< Delete waits for the grace period and frees the key slot */
+};
+
+/**
+ * Type of function called when the key slot of a deleted key is freed.
+ *
+ * @param p
+ *   Pointer given in the RCU configuration.
+ * @param key_data
+ *   Data of the deleted key.
+ */
+typedef void (*rte_hash_free_key_data)(void *p, void *key_data);
+
+/** RCU configuration of a hash table. */
+struct rte_hash_rcu_config {
+	struct rte_rcu_qsbr *v;		/**< QS variable of the readers. */
+	enum rte_hash_qsbr_mode mode;	/**< Reclamation mode. */
+	uint32_t dq_size;
+	/**< Size of the defer queue, 0 for the number of keys of the table */
+	uint32_t trigger_reclaim_limit;
+	/**< Deletes reclaim key slots once this many are in the defer
+	 * queue, 0 for every delete
+	 */
+	uint32_t max_reclaim_size;
+	/**< Maximum number of key slots reclaimed at once, 0 for
+	 * RTE_HASH_RCU_DQ_RECLAIM_MAX
+	 */
+	void *key_data_ptr;		/**< Pointer passed to the callback. */
+	rte_hash_free_key_data free_key_data_func;
+	/**< Called with the data of each freed key slot, may be NULL */
+};
+
 /** @internal A hash table structure. */
 struct rte_hash;
 
@@ -235,6 +297,9 @@ rte_hash_add_key_with_hash(const struct rte_hash *h, const void *key, hash_sig_t
  * Remove a key from an existing hash table.
  * This operation is not multi-thread safe
  * and should only be called from one thread.
+ * With RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF, the key slot stays reserved
+ * until freed with rte_hash_free_key_with_position(), or until the grace
+ * period is over if a QS variable is attached to the table.
  *
  * @param h
  *   Hash table to remove the key from.
@@ -254,6 +319,9 @@ rte_hash_del_key(const struct rte_hash *h, const void *key);
  * Remove a key from an existing hash table.
  * This operation is not multi-thread safe
  * and should only be called from one thread.
+ * With RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF, the key slot stays reserved
+ * until freed with rte_hash_free_key_with_position(), or until the grace
+ * period is over if a QS variable is attached to the table.
  *
  * @param h
  *   Hash table to remove the key from.
@@ -271,6 +339,27 @@ rte_hash_del_key(const struct rte_hash *h, const void *key);
 int32_t
 rte_hash_del_key_with_hash(const struct rte_hash *h, const void *key, hash_sig_t sig);
 
+/**
+ * Free the key slot of a deleted key, so it can be reused by a later add.
+ * Only needed, and only allowed, for tables created with
+ * RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF, where deleting a key does not
+ * free its slot, and without a QS variable attached. The caller must make
+ * sure no lookup started before the delete is still running.
+ * This operation is not multi-thread safe
+ * and should only be called from the writer thread.
+ *
+ * @param h
+ *   Hash table the key was deleted from.
+ * @param position
+ *   Position returned when the key was deleted.
+ * @return
+ *   - 0 if freed successfully
+ *   - -EINVAL if the parameters are invalid.
+ */
+int
+rte_hash_free_key_with_position(const struct rte_hash *h,
+				const int32_t position);
+
 /**
  * Find a key in the hash table given the position.
  * This operation is multi-thread safe.
@@ -448,6 +537,29 @@ rte_hash_lookup_bulk(const struct rte_hash *h, const void **keys,
  */
 int32_t
 rte_hash_iterate(const struct rte_hash *h, const void **key, void **data, uint32_t *next);
+
+/**
+ * Attach a QS variable to a hash table created with
+ * RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF. The key slots of deleted keys
+ * are then freed by the library once the reader threads registered with
+ * the QS variable have reported a quiescent state, instead of by
+ * rte_hash_free_key_with_position().
+ * This operation is not multi-thread safe
+ * and should be called before adding or deleting keys.
+ *
+ * @param h
+ *   Hash table.
+ * @param cfg
+ *   RCU configuration, copied.
+ * @return
+ *   - 0 on success.
+ *   - -EINVAL if the parameters are invalid, or the table does not have
+ *     lock-free lookups.
+ *   - -EEXIST if a QS variable is already attached.
+ *   - -ENOMEM if the defer queue cannot be allocated.
+ */
+int
+rte_hash_rcu_qsbr_add(struct rte_hash *h, struct rte_hash_rcu_config *cfg);
 #ifdef __cplusplus
 }
 #endif
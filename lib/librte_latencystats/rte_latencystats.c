@@ -37,6 +37,7 @@
 
 #include <rte_mbuf.h>
 #include <rte_log.h>
+#include <rte_errno.h>
 #include <rte_cycles.h>
 #include <rte_ethdev.h>
 #include <rte_metrics.h>
@@ -64,6 +65,27 @@ static uint64_t samp_intvl;
 static uint64_t timer_tsc;
 static uint64_t prev_tsc;
 
+/* mbuf field and flag marking the packets sampled at reception */
+static int timestamp_dynfield_offset = -1;
+static uint64_t timestamp_dynflag;
+
+static const struct rte_mbuf_dynfield timestamp_dynfield_desc = {
+	.name = "rte_latencystats_timestamp",
+	.size = sizeof(uint64_t),
+	.align = __alignof__(uint64_t),
+};
+
+static const struct rte_mbuf_dynflag timestamp_dynflag_desc = {
+	.name = "rte_latencystats_timestamp_flag",
+};
+
+static inline uint64_t *
+timestamp_dynfield(struct rte_mbuf *mbuf)
+{
+	return RTE_MBUF_DYNFIELD(mbuf, timestamp_dynfield_offset,
+		uint64_t *);
+}
+
 struct rte_latency_stats {
 	float min_latency; /**< Minimum latency in nano seconds */
 	float avg_latency; /**< Average latency in nano seconds */
@@ -154,7 +176,8 @@ add_time_stamps(uint8_t pid __rte_unused,
 		diff_tsc = now - prev_tsc;
 		timer_tsc += diff_tsc;
 		if (timer_tsc >= samp_intvl) {
-			pkts[i]->timestamp = now;
+			*timestamp_dynfield(pkts[i]) = now;
+			pkts[i]->ol_flags |= timestamp_dynflag;
 			timer_tsc = 0;
 		}
 		prev_tsc = now;
@@ -184,8 +207,8 @@ calc_latency(uint8_t pid __rte_unused,
 
 	now = rte_rdtsc();
 	for (i = 0; i < nb_pkts; i++) {
-		if (pkts[i]->timestamp)
-			latency[cnt++] = now - pkts[i]->timestamp;
+		if (pkts[i]->ol_flags & timestamp_dynflag)
+			latency[cnt++] = now - *timestamp_dynfield(pkts[i]);
 	}
 
 	for (i = 0; i < cnt; i++) {
@@ -233,6 +256,7 @@ rte_latencystats_init(uint64_t app_samp_intvl,
 	const char *ptr_strings[NUM_LATENCY_STATS] = {0};
 	const struct rte_memzone *mz = NULL;
 	const unsigned int flags = 0;
+	int ret;
 
 	if (rte_memzone_lookup(MZ_RTE_LATENCY_STATS))
 		return -EEXIST;
@@ -249,6 +273,20 @@ rte_latencystats_init(uint64_t app_samp_intvl,
 	glob_stats = mz->addr;
 	samp_intvl = app_samp_intvl * latencystat_cycles_per_ns();
 
+	/** Register the mbuf field and flag for the Rx timestamp */
+	timestamp_dynfield_offset =
+		rte_mbuf_dynfield_register(&timestamp_dynfield_desc);
+	ret = rte_mbuf_dynflag_register(&timestamp_dynflag_desc);
+	if (timestamp_dynfield_offset < 0 || ret < 0) {
+		ret = -rte_errno;
+		RTE_LOG(ERR, LATENCY_STATS,
+			"Cannot register mbuf field/flag for timestamp\n");
+		rte_memzone_free(mz);
+		glob_stats = NULL;
+		return ret;
+	}
+	timestamp_dynflag = 1ULL << ret;
+
 	/** Register latency stats with stats library */
 	for (i = 0; i < NUM_LATENCY_STATS; i++)
 		ptr_strings[i] = lat_stats_strings[i].name;
@@ -403,6 +403,7 @@ rte_lpm_free_v1604(struct rte_lpm *lpm)
 
 	rte_rwlock_write_unlock(RTE_EAL_TAILQ_RWLOCK);
 
+	rte_rcu_qsbr_dq_delete(lpm->dq);
 	rte_free(lpm->tbl8);
 	rte_free(lpm->rules_tbl);
 	rte_free(lpm);
@@ -693,7 +694,7 @@ tbl8_alloc_v20(struct rte_lpm_tbl_entry_v20 *tbl8)
 }
 
 static inline int32_t
-tbl8_alloc_v1604(struct rte_lpm_tbl_entry *tbl8, uint32_t number_tbl8s)
+__tbl8_alloc_v1604(struct rte_lpm_tbl_entry *tbl8, uint32_t number_tbl8s)
 {
 	uint32_t group_idx; /* tbl8 group index. */
 	struct rte_lpm_tbl_entry *tbl8_entry;
@@ -725,11 +726,51 @@ tbl8_free_v20(struct rte_lpm_tbl_entry_v20 *tbl8, uint32_t tbl8_group_start)
 	tbl8[tbl8_group_start].valid_group = INVALID;
 }
 
+static inline int32_t
+tbl8_alloc_v1604(struct rte_lpm *lpm)
+{
+	int32_t group_idx;
+
+	group_idx = __tbl8_alloc_v1604(lpm->tbl8, lpm->number_tbl8s);
+	if (group_idx == -ENOSPC && lpm->dq != NULL) {
+		/* Reclaim a group whose readers are gone */
+		rte_rcu_qsbr_dq_reclaim(lpm->dq, 1, NULL, NULL, NULL);
+		group_idx = __tbl8_alloc_v1604(lpm->tbl8, lpm->number_tbl8s);
+	}
+
+	return group_idx;
+}
+
+/* Defer queue callback, the readers of the groups are gone */
+static void
+tbl8_free_deferred(void *p, void *e, unsigned int n)
+{
+	struct rte_lpm *lpm = p;
+	uint32_t *tbl8_group_start = e;
+	unsigned int i;
+
+	for (i = 0; i < n; i++)
+		lpm->tbl8[tbl8_group_start[i]].valid_group = INVALID;
+}
+
 static inline void
-tbl8_free_v1604(struct rte_lpm_tbl_entry *tbl8, uint32_t tbl8_group_start)
+tbl8_free_v1604(struct rte_lpm *lpm, uint32_t tbl8_group_start)
 {
+	/*
+	 * Lookups may still walk the group through the tbl24 entry they
+	 * read before it was updated, it must not be reused before they
+	 * are done.
+	 */
+	if (lpm->dq != NULL &&
+			rte_rcu_qsbr_dq_enqueue(lpm->dq, &tbl8_group_start) == 0)
+		return;
+
+	/* Sync mode, or the queue is full of groups still referenced */
+	if (lpm->v != NULL)
+		rte_rcu_qsbr_synchronize(lpm->v, RTE_QSBR_THRID_INVALID);
+
 	/* Set tbl8 group invalid*/
-	tbl8[tbl8_group_start].valid_group = INVALID;
+	lpm->tbl8[tbl8_group_start].valid_group = INVALID;
 }
 
 static inline int32_t
@@ -1008,7 +1049,7 @@ add_depth_big_v1604(struct rte_lpm *lpm, uint32_t ip_masked, uint8_t depth,
 
 	if (!lpm->tbl24[tbl24_index].valid) {
 		/* Search for a free tbl8 group. */
-		tbl8_group_index = tbl8_alloc_v1604(lpm->tbl8, lpm->number_tbl8s);
+		tbl8_group_index = tbl8_alloc_v1604(lpm);
 
 		/* Check tbl8 allocation was successful. */
 		if (tbl8_group_index < 0) {
@@ -1045,7 +1086,7 @@ add_depth_big_v1604(struct rte_lpm *lpm, uint32_t ip_masked, uint8_t depth,
 	} /* If valid entry but not extended calculate the index into Table8. */
 	else if (lpm->tbl24[tbl24_index].valid_group == 0) {
 		/* Search for free tbl8 group. */
-		tbl8_group_index = tbl8_alloc_v1604(lpm->tbl8, lpm->number_tbl8s);
+		tbl8_group_index = tbl8_alloc_v1604(lpm);
 
 		if (tbl8_group_index < 0) {
 			return tbl8_group_index;
@@ -1738,7 +1779,7 @@ delete_depth_big_v1604(struct rte_lpm *lpm, uint32_t ip_masked,
 	if (tbl8_recycle_index == -EINVAL) {
 		/* Set tbl24 before freeing tbl8 to avoid race condition. */
 		lpm->tbl24[tbl24_index].valid = 0;
-		tbl8_free_v1604(lpm->tbl8, tbl8_group_start);
+		tbl8_free_v1604(lpm, tbl8_group_start);
 	} else if (tbl8_recycle_index > -1) {
 		/* Update tbl24 entry. */
 		struct rte_lpm_tbl_entry new_tbl24_entry = {
@@ -1750,7 +1791,7 @@ delete_depth_big_v1604(struct rte_lpm *lpm, uint32_t ip_masked,
 
 		/* Set tbl24 before freeing tbl8 to avoid race condition. */
 		lpm->tbl24[tbl24_index] = new_tbl24_entry;
-		tbl8_free_v1604(lpm->tbl8, tbl8_group_start);
+		tbl8_free_v1604(lpm, tbl8_group_start);
 	}
 #undef group_idx
 	return 0;
@@ -1892,6 +1933,14 @@ VERSION_SYMBOL(rte_lpm_delete_all, _v20, 2.0);
 void
 rte_lpm_delete_all_v1604(struct rte_lpm *lpm)
 {
+	/* Drain the defer queue before zeroing tbl8 */
+	if (lpm->v != NULL) {
+		rte_rcu_qsbr_synchronize(lpm->v, RTE_QSBR_THRID_INVALID);
+		if (lpm->dq != NULL)
+			rte_rcu_qsbr_dq_reclaim(lpm->dq, UINT32_MAX,
+						NULL, NULL, NULL);
+	}
+
 	/* Zero rule information. */
 	memset(lpm->rule_info, 0, sizeof(lpm->rule_info));
 
@@ -1908,3 +1957,45 @@ rte_lpm_delete_all_v1604(struct rte_lpm *lpm)
 BIND_DEFAULT_SYMBOL(rte_lpm_delete_all, _v1604, 16.04);
 MAP_STATIC_SYMBOL(void rte_lpm_delete_all(struct rte_lpm *lpm),
 		rte_lpm_delete_all_v1604);
+
+int
+rte_lpm_rcu_qsbr_add(struct rte_lpm *lpm, struct rte_lpm_rcu_config *cfg)
+{
+	struct rte_rcu_qsbr_dq_parameters params;
+	char rcu_dq_name[RTE_RCU_QSBR_DQ_NAMESIZE];
+
+	if (lpm == NULL || cfg == NULL || cfg->v == NULL)
+		return -EINVAL;
+
+	if (lpm->v != NULL)
+		return -EEXIST;
+
+	if (cfg->mode == RTE_LPM_QSBR_MODE_DQ) {
+		/* Large enough by default to hold every tbl8 group */
+		snprintf(rcu_dq_name, sizeof(rcu_dq_name), "LPM_RCU_%s",
+				lpm->name);
+		memset(&params, 0, sizeof(params));
+		params.name = rcu_dq_name;
+		params.size = cfg->dq_size != 0 ? cfg->dq_size :
+				lpm->number_tbl8s;
+		params.esize = sizeof(uint32_t);
+		params.trigger_reclaim_limit = RTE_MIN(cfg->reclaim_thd,
+				params.size);
+		params.max_reclaim_size = cfg->reclaim_max != 0 ?
+				cfg->reclaim_max : RTE_LPM_RCU_DQ_RECLAIM_MAX;
+		params.free_fn = tbl8_free_deferred;
+		params.p = lpm;
+		params.v = cfg->v;
+
+		lpm->dq = rte_rcu_qsbr_dq_create(&params);
+		if (lpm->dq == NULL) {
+			RTE_LOG(ERR, LPM, "LPM defer queue creation failed\n");
+			return -ENOMEM;
+		}
+	} else if (cfg->mode != RTE_LPM_QSBR_MODE_SYNC)
+		return -EINVAL;
+
+	lpm->v = cfg->v;
+	lpm->rcu_mode = cfg->mode;
+	return 0;
+}
@@ -49,6 +49,7 @@
 #include <rte_common.h>
 #include <rte_vect.h>
 #include <rte_compat.h>
+#include <rte_rcu_qsbr.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -76,6 +77,11 @@ extern "C" {
 #define RTE_LPM_TBL8_NUM_ENTRIES        (RTE_LPM_TBL8_NUM_GROUPS * \
 					RTE_LPM_TBL8_GROUP_NUM_ENTRIES)
 
+/** Default maximum number of tbl8 groups reclaimed at once from the defer
+ * queue of an LPM object.
+ */
+#define RTE_LPM_RCU_DQ_RECLAIM_MAX	16
+
 /** @internal Macro to enable/disable run-time checks. */
 #if defined(RTE_LIBRTE_LPM_DEBUG)
 #define RTE_LPM_RETURN_IF_TRUE(cond, retval) do { \
@@ -202,6 +208,32 @@ struct rte_lpm_v20 {
 			__rte_cache_aligned; /**< LPM rules. */
 };
 
+/** Reclamation modes of the tbl8 groups of an LPM object using RCU. */
+enum rte_lpm_qsbr_mode {
+	RTE_LPM_QSBR_MODE_DQ = 0,
+	/**< Push freed tbl8 groups to a defer queue, reclaimed by later
+	 * deletes and by adds running out of tbl8 groups.
+	 */
+	RTE_LPM_QSBR_MODE_SYNC
+	/**< Delete waits for the grace period and frees the tbl8 group */
+};
+
+/** RCU configuration of an LPM object. */
+struct rte_lpm_rcu_config {
+	struct rte_rcu_qsbr *v;	/**< QS variable of the readers. */
+	enum rte_lpm_qsbr_mode mode;	/**< Reclamation mode. */
+	uint32_t dq_size;
+	/**< Size of the defer queue, 0 for the number of tbl8 groups */
+	uint32_t reclaim_thd;
+	/**< Deletes reclaim tbl8 groups once this many are in the defer
+	 * queue, 0 for every delete
+	 */
+	uint32_t reclaim_max;
+	/**< Maximum number of tbl8 groups reclaimed at once, 0 for
+	 * RTE_LPM_RCU_DQ_RECLAIM_MAX
+	 */
+};
+
 struct rte_lpm {
 	/* LPM metadata. */
 	char name[RTE_LPM_NAMESIZE];        /**< Name of the lpm. */
@@ -214,6 +246,11 @@ struct rte_lpm {
 			__rte_cache_aligned; /**< LPM tbl24 table. */
 	struct rte_lpm_tbl_entry *tbl8; /**< LPM tbl8 table. */
 	struct rte_lpm_rule *rules_tbl; /**< LPM rules. */
+
+	/* RCU configuration, appended to keep the layout of the tables. */
+	struct rte_rcu_qsbr *v; /**< QS variable, NULL if not attached. */
+	enum rte_lpm_qsbr_mode rcu_mode; /**< tbl8 group reclamation mode. */
+	struct rte_rcu_qsbr_dq *dq; /**< Defer queue of the freed tbl8s. */
 };
 
 /**
@@ -356,6 +393,26 @@ rte_lpm_delete_all_v20(struct rte_lpm_v20 *lpm);
 void
 rte_lpm_delete_all_v1604(struct rte_lpm *lpm);
 
+/**
+ * Attach a QS variable to an LPM object. The tbl8 groups freed by deletes
+ * are then reused only once the reader threads registered with the QS
+ * variable have reported a quiescent state, so that lookups running
+ * concurrently with deletes never walk a recycled group.
+ * Should be called before adding rules.
+ *
+ * @param lpm
+ *   LPM object handle
+ * @param cfg
+ *   RCU configuration
+ * @return
+ *   - 0 on success
+ *   - -EINVAL if the parameters are invalid
+ *   - -EEXIST if a QS variable is already attached
+ *   - -ENOMEM if the defer queue cannot be allocated
+ */
+int
+rte_lpm_rcu_qsbr_add(struct rte_lpm *lpm, struct rte_lpm_rcu_config *cfg);
+
 /**
  * Lookup an IP into the LPM table.
  *
@@ -52,6 +52,8 @@
 #include <rte_errno.h>
 #include <rte_rwlock.h>
 #include <rte_spinlock.h>
+#include <rte_hash.h>
+#include <rte_jhash.h>
 
 #include "rte_lpm6.h"
 
@@ -63,11 +65,17 @@
 #define RTE_LPM6_LOOKUP_SUCCESS          0x20000000
 #define RTE_LPM6_TBL8_BITMASK            0x001FFFFF
 
+/* Smallest rules table rte_hash accepts (one bucket). */
+#define RTE_LPM6_RULES_MIN_ENTRIES                8
+
 #define ADD_FIRST_BYTE                            3
 #define LOOKUP_FIRST_BYTE                         4
 #define BYTE_SIZE                                 8
 #define BYTES2_SIZE                              16
 
+/* Owner table index of the tbl8 groups hanging from tbl24. */
+#define TBL24_IND                        UINT32_MAX
+
 #define lpm6_tbl8_gindex next_hop
 
 /** Flags for setting an entry as valid/invalid. */
@@ -101,6 +109,19 @@ struct rte_lpm6_rule {
 	uint8_t depth; /**< Rule depth. */
 };
 
+/** Rules tbl key, the next hop is stored as the key data. */
+struct rte_lpm6_rule_key {
+	uint8_t ip[RTE_LPM6_IPV6_ADDR_SIZE]; /**< Rule IP address. */
+	uint8_t depth; /**< Rule depth. */
+};
+
+/** Tbl8 group header. */
+struct rte_lpm6_tbl8_hdr {
+	uint32_t owner_tbl_ind;   /**< Owner tbl8 group, or TBL24_IND. */
+	uint32_t owner_entry_ind; /**< Owner entry pointing to the group. */
+	uint32_t ref_cnt;         /**< Rules ending here plus child groups. */
+};
+
 /** LPM6 structure. */
 struct rte_lpm6 {
 	/* LPM metadata. */
@@ -108,10 +129,12 @@ struct rte_lpm6 {
 	uint32_t max_rules;              /**< Max number of rules. */
 	uint32_t used_rules;             /**< Used rules so far. */
 	uint32_t number_tbl8s;           /**< Number of tbl8s to allocate. */
-	uint32_t next_tbl8;              /**< Next tbl8 to be used. */
+	uint32_t tbl8_pool_pos;          /**< Number of tbl8s in use. */
 
 	/* LPM Tables. */
-	struct rte_lpm6_rule *rules_tbl; /**< LPM rules. */
+	struct rte_hash *rules_tbl;      /**< LPM rules. */
+	uint32_t *tbl8_pool;             /**< Stack of free tbl8 indexes. */
+	struct rte_lpm6_tbl8_hdr *tbl8_hdrs; /**< Headers of the tbl8s. */
 	struct rte_lpm6_tbl_entry tbl24[RTE_LPM6_TBL24_NUM_ENTRIES]
 			__rte_cache_aligned; /**< LPM tbl24 table. */
 	struct rte_lpm6_tbl_entry tbl8[0]
@@ -142,6 +165,84 @@ mask_ip(uint8_t *ip, uint8_t depth)
 		}
 }
 
+/*
+ * Puts every tbl8 group back in the pool of free groups.
+ */
+static void
+tbl8_pool_init(struct rte_lpm6 *lpm)
+{
+	uint32_t i;
+
+	for (i = 0; i < lpm->number_tbl8s; i++)
+		lpm->tbl8_pool[i] = i;
+
+	lpm->tbl8_pool_pos = 0;
+}
+
+/*
+ * Takes a tbl8 group from the pool, clears it and records the entry of the
+ * owner table that is going to point to it.
+ */
+static int32_t
+tbl8_get(struct rte_lpm6 *lpm, uint32_t owner_tbl_ind,
+		uint32_t owner_entry_ind)
+{
+	struct rte_lpm6_tbl8_hdr *tbl8_hdr;
+	uint32_t tbl8_gindex;
+
+	if (lpm->tbl8_pool_pos == lpm->number_tbl8s)
+		return -ENOSPC;
+
+	tbl8_gindex = lpm->tbl8_pool[lpm->tbl8_pool_pos++];
+
+	memset(&lpm->tbl8[tbl8_gindex * RTE_LPM6_TBL8_GROUP_NUM_ENTRIES], 0,
+			sizeof(lpm->tbl8[0]) * RTE_LPM6_TBL8_GROUP_NUM_ENTRIES);
+
+	tbl8_hdr = &lpm->tbl8_hdrs[tbl8_gindex];
+	tbl8_hdr->owner_tbl_ind = owner_tbl_ind;
+	tbl8_hdr->owner_entry_ind = owner_entry_ind;
+	tbl8_hdr->ref_cnt = 0;
+
+	/* The new group keeps its owner group alive. */
+	if (owner_tbl_ind != TBL24_IND)
+		lpm->tbl8_hdrs[owner_tbl_ind].ref_cnt++;
+
+	return tbl8_gindex;
+}
+
+/*
+ * Unlinks an unused tbl8 group from its owner entry, which is overwritten
+ * with new_entry, and returns it to the pool. Owner groups left unused in
+ * turn are recycled the same way.
+ */
+static void
+tbl8_recycle(struct rte_lpm6 *lpm, uint32_t tbl8_gindex,
+		const struct rte_lpm6_tbl_entry *new_entry)
+{
+	struct rte_lpm6_tbl8_hdr *tbl8_hdr;
+	uint32_t owner_tbl_ind;
+
+	for (;;) {
+		tbl8_hdr = &lpm->tbl8_hdrs[tbl8_gindex];
+		owner_tbl_ind = tbl8_hdr->owner_tbl_ind;
+
+		if (owner_tbl_ind == TBL24_IND)
+			lpm->tbl24[tbl8_hdr->owner_entry_ind] = *new_entry;
+		else
+			lpm->tbl8[owner_tbl_ind *
+				RTE_LPM6_TBL8_GROUP_NUM_ENTRIES +
+				tbl8_hdr->owner_entry_ind] = *new_entry;
+
+		lpm->tbl8_pool[--lpm->tbl8_pool_pos] = tbl8_gindex;
+
+		if (owner_tbl_ind == TBL24_IND ||
+				--lpm->tbl8_hdrs[owner_tbl_ind].ref_cnt != 0)
+			return;
+
+		tbl8_gindex = owner_tbl_ind;
+	}
+}
+
 /*
  * Allocates memory for LPM object
  */
@@ -150,9 +251,13 @@ rte_lpm6_create(const char *name, int socket_id,
 		const struct rte_lpm6_config *config)
 {
 	char mem_name[RTE_LPM6_NAMESIZE];
+	char rules_name[RTE_HASH_NAMESIZE];
 	struct rte_lpm6 *lpm = NULL;
 	struct rte_tailq_entry *te;
-	uint64_t mem_size, rules_size;
+	struct rte_hash *rules_tbl;
+	uint32_t *tbl8_pool = NULL;
+	struct rte_lpm6_tbl8_hdr *tbl8_hdrs = NULL;
+	uint64_t mem_size;
 	struct rte_lpm6_list *lpm_list;
 
 	lpm_list = RTE_TAILQ_CAST(rte_lpm6_tailq.head, rte_lpm6_list);
@@ -167,12 +272,47 @@ rte_lpm6_create(const char *name, int socket_id,
 		return NULL;
 	}
 
+	/*
+	 * Create the rules table first, rte_hash_create() takes the tailq
+	 * lock itself.
+	 */
+	snprintf(rules_name, sizeof(rules_name), "LRH_%s", name);
+	struct rte_hash_parameters rule_hash_tbl_params = {
+		.name = rules_name,
+		.entries = RTE_MAX(config->max_rules,
+				(uint32_t)RTE_LPM6_RULES_MIN_ENTRIES),
+		.key_len = sizeof(struct rte_lpm6_rule_key),
+		.hash_func = rte_jhash,
+		.hash_func_init_val = 0,
+		.socket_id = socket_id,
+		.extra_flag = RTE_HASH_EXTRA_FLAGS_EXT_TABLE,
+	};
+
+	rules_tbl = rte_hash_create(&rule_hash_tbl_params);
+	if (rules_tbl == NULL) {
+		RTE_LOG(ERR, LPM, "LPM rules hash table allocation failed: %s (%d)\n",
+				rte_strerror(rte_errno), rte_errno);
+		return NULL;
+	}
+
+	tbl8_pool = rte_malloc_socket(NULL,
+			sizeof(uint32_t) * config->number_tbl8s,
+			RTE_CACHE_LINE_SIZE, socket_id);
+	tbl8_hdrs = rte_zmalloc_socket(NULL,
+			sizeof(struct rte_lpm6_tbl8_hdr) * config->number_tbl8s,
+			RTE_CACHE_LINE_SIZE, socket_id);
+	if (config->number_tbl8s != 0 &&
+			(tbl8_pool == NULL || tbl8_hdrs == NULL)) {
+		RTE_LOG(ERR, LPM, "LPM tbl8 pool allocation failed\n");
+		rte_errno = ENOMEM;
+		goto fail;
+	}
+
 	snprintf(mem_name, sizeof(mem_name), "LPM_%s", name);
 
 	/* Determine the amount of memory to allocate. */
 	mem_size = sizeof(*lpm) + (sizeof(lpm->tbl8[0]) *
 			RTE_LPM6_TBL8_GROUP_NUM_ENTRIES * config->number_tbl8s);
-	rules_size = sizeof(struct rte_lpm6_rule) * config->max_rules;
 
 	rte_rwlock_write_lock(RTE_EAL_TAILQ_RWLOCK);
 
@@ -205,21 +345,16 @@ rte_lpm6_create(const char *name, int socket_id,
 		goto exit;
 	}
 
-	lpm->rules_tbl = (struct rte_lpm6_rule *)rte_zmalloc_socket(NULL,
-			(size_t)rules_size, RTE_CACHE_LINE_SIZE, socket_id);
-
-	if (lpm->rules_tbl == NULL) {
-		RTE_LOG(ERR, LPM, "LPM rules_tbl allocation failed\n");
-		rte_free(lpm);
-		lpm = NULL;
-		rte_free(te);
-		goto exit;
-	}
-
 	/* Save user arguments. */
 	lpm->max_rules = config->max_rules;
 	lpm->number_tbl8s = config->number_tbl8s;
 	snprintf(lpm->name, sizeof(lpm->name), "%s", name);
+	lpm->rules_tbl = rules_tbl;
+	lpm->tbl8_pool = tbl8_pool;
+	lpm->tbl8_hdrs = tbl8_hdrs;
+
+	/* Every tbl8 group starts out free. */
+	tbl8_pool_init(lpm);
 
 	te->data = (void *) lpm;
 
@@ -228,7 +363,15 @@ rte_lpm6_create(const char *name, int socket_id,
 exit:
 	rte_rwlock_write_unlock(RTE_EAL_TAILQ_RWLOCK);
 
-	return lpm;
+	if (lpm != NULL)
+		return lpm;
+
+fail:
+	rte_free(tbl8_hdrs);
+	rte_free(tbl8_pool);
+	rte_hash_free(rules_tbl);
+
+	return NULL;
 }
 
 /*
@@ -259,6 +402,7 @@ rte_lpm6_find_existing(const char *name)
 	return l;
 }
 
+
 /*
  * Deallocates memory for given LPM table.
  */
@@ -287,76 +431,83 @@ rte_lpm6_free(struct rte_lpm6 *lpm)
 
 	rte_rwlock_write_unlock(RTE_EAL_TAILQ_RWLOCK);
 
-	rte_free(lpm->rules_tbl);
+	rte_free(lpm->tbl8_hdrs);
+	rte_free(lpm->tbl8_pool);
+	rte_hash_free(lpm->rules_tbl);
 	rte_free(lpm);
 	rte_free(te);
 }
 
+/*
+ * Fills the rules table key of a masked IP and depth.
+ */
+static inline void
+rule_key_init(struct rte_lpm6_rule_key *key, const uint8_t *ip, uint8_t depth)
+{
+	memcpy(key->ip, ip, RTE_LPM6_IPV6_ADDR_SIZE);
+	key->depth = depth;
+}
+
 /*
  * Checks if a rule already exists in the rules table and updates
  * the nexthop if so. Otherwise it adds a new rule if enough space is available.
+ * Returns 1 for a new rule, 0 for an updated one or a negative error code.
  */
-static inline int32_t
+static inline int
 rule_add(struct rte_lpm6 *lpm, uint8_t *ip, uint32_t next_hop, uint8_t depth)
 {
-	uint32_t rule_index;
+	struct rte_lpm6_rule_key rule_key;
+	int is_new_rule;
+	int ret;
 
-	/* Scan through rule list to see if rule already exists. */
-	for (rule_index = 0; rule_index < lpm->used_rules; rule_index++) {
+	rule_key_init(&rule_key, ip, depth);
 
-		/* If rule already exists update its next_hop and return. */
-		if ((memcmp (lpm->rules_tbl[rule_index].ip, ip,
-				RTE_LPM6_IPV6_ADDR_SIZE) == 0) &&
-				lpm->rules_tbl[rule_index].depth == depth) {
-			lpm->rules_tbl[rule_index].next_hop = next_hop;
-
-			return rule_index;
-		}
-	}
+	is_new_rule = rte_hash_lookup(lpm->rules_tbl, &rule_key) < 0;
 
 	/*
 	 * If rule does not exist check if there is space to add a new rule to
 	 * this rule group. If there is no space return error.
 	 */
-	if (lpm->used_rules == lpm->max_rules) {
+	if (is_new_rule && lpm->used_rules == lpm->max_rules)
 		return -ENOSPC;
-	}
 
-	/* If there is space for the new rule add it. */
-	rte_memcpy(lpm->rules_tbl[rule_index].ip, ip, RTE_LPM6_IPV6_ADDR_SIZE);
-	lpm->rules_tbl[rule_index].next_hop = next_hop;
-	lpm->rules_tbl[rule_index].depth = depth;
+	ret = rte_hash_add_key_data(lpm->rules_tbl, &rule_key,
+			(void *)(uintptr_t)next_hop);
+	if (ret < 0)
+		return ret;
 
 	/* Increment the used rules counter for this rule group. */
-	lpm->used_rules++;
+	if (is_new_rule)
+		lpm->used_rules++;
 
-	return rule_index;
+	return is_new_rule;
 }
 
 /*
  * Function that expands a rule across the data structure when a less-generic
  * one has been added before. It assures that every possible combination of bits
- * in the IP address returns a match.
+ * in the IP address returns a match. Entries of rules up to old_depth are
+ * replaced, which on deletion hands them over to a less specific rule.
  */
 static void
-expand_rule(struct rte_lpm6 *lpm, uint32_t tbl8_gindex, uint8_t depth,
-		uint32_t next_hop)
+expand_rule(struct rte_lpm6 *lpm, uint32_t tbl8_gindex, uint8_t old_depth,
+		uint8_t new_depth, uint32_t next_hop, uint8_t valid)
 {
 	uint32_t tbl8_group_end, tbl8_gindex_next, j;
 
 	tbl8_group_end = tbl8_gindex + RTE_LPM6_TBL8_GROUP_NUM_ENTRIES;
 
 	struct rte_lpm6_tbl_entry new_tbl8_entry = {
-		.valid = VALID,
-		.valid_group = VALID,
-		.depth = depth,
+		.valid = valid,
+		.valid_group = valid,
+		.depth = new_depth,
 		.next_hop = next_hop,
 		.ext_entry = 0,
 	};
 
 	for (j = tbl8_gindex; j < tbl8_group_end; j++) {
 		if (!lpm->tbl8[j].valid || (lpm->tbl8[j].ext_entry == 0
-				&& lpm->tbl8[j].depth <= depth)) {
+				&& lpm->tbl8[j].depth <= old_depth)) {
 
 			lpm->tbl8[j] = new_tbl8_entry;
 
@@ -364,20 +515,52 @@ expand_rule(struct rte_lpm6 *lpm, uint32_t tbl8_gindex, uint8_t depth,
 
 			tbl8_gindex_next = lpm->tbl8[j].lpm6_tbl8_gindex
 					* RTE_LPM6_TBL8_GROUP_NUM_ENTRIES;
-			expand_rule(lpm, tbl8_gindex_next, depth, next_hop);
+			expand_rule(lpm, tbl8_gindex_next, old_depth, new_depth,
+					next_hop, valid);
 		}
 	}
 }
 
+/*
+ * Returns the number of tbl8 groups needed to add a rule, so that adding it
+ * never fails halfway through the tables.
+ */
+static uint32_t
+tbl8_needed(const struct rte_lpm6 *lpm, const uint8_t *ip, uint8_t depth)
+{
+	const struct rte_lpm6_tbl_entry *tbl = lpm->tbl24;
+	uint32_t tbl_index;
+	uint8_t bits_covered = ADD_FIRST_BYTE * BYTE_SIZE;
+	uint8_t byte = ADD_FIRST_BYTE;
+
+	tbl_index = (ip[0] << BYTES2_SIZE) | (ip[1] << BYTE_SIZE) | ip[2];
+
+	while (depth > bits_covered) {
+		/* One new group per level from here on. */
+		if (!tbl[tbl_index].valid || tbl[tbl_index].ext_entry == 0)
+			return (depth - bits_covered + BYTE_SIZE - 1) / BYTE_SIZE;
+
+		tbl = &lpm->tbl8[tbl[tbl_index].lpm6_tbl8_gindex *
+				RTE_LPM6_TBL8_GROUP_NUM_ENTRIES];
+		tbl_index = ip[byte++];
+		bits_covered += BYTE_SIZE;
+	}
+
+	return 0;
+}
+
 /*
  * Partially adds a new route to the data structure (tbl24+tbl8s).
  * It returns 0 on success, a negative number on failure, or 1 if
  * the process needs to be continued by calling the function again.
+ * tbl_ind is the tbl8 group index of tbl, or TBL24_IND.
  */
 static inline int
 add_step(struct rte_lpm6 *lpm, struct rte_lpm6_tbl_entry *tbl,
-		struct rte_lpm6_tbl_entry **tbl_next, uint8_t *ip, uint8_t bytes,
-		uint8_t first_byte, uint8_t depth, uint32_t next_hop)
+		uint32_t tbl_ind, struct rte_lpm6_tbl_entry **tbl_next,
+		uint32_t *tbl_next_ind, uint8_t *ip, uint8_t bytes,
+		uint8_t first_byte, uint8_t depth, uint32_t next_hop,
+		int is_new_rule)
 {
 	uint32_t tbl_index, tbl_range, tbl8_group_start, tbl8_group_end, i;
 	int32_t tbl8_gindex;
@@ -428,10 +611,15 @@ add_step(struct rte_lpm6 *lpm, struct rte_lpm6_tbl_entry *tbl,
 				 */
 				tbl8_gindex = tbl[i].lpm6_tbl8_gindex *
 						RTE_LPM6_TBL8_GROUP_NUM_ENTRIES;
-				expand_rule(lpm, tbl8_gindex, depth, next_hop);
+				expand_rule(lpm, tbl8_gindex, depth, depth,
+						next_hop, VALID);
 			}
 		}
 
+		/* A new rule ending in a tbl8 group keeps the group alive. */
+		if (is_new_rule && tbl_ind != TBL24_IND)
+			lpm->tbl8_hdrs[tbl_ind].ref_cnt++;
+
 		return 0;
 	}
 	/*
@@ -441,9 +629,8 @@ add_step(struct rte_lpm6 *lpm, struct rte_lpm6_tbl_entry *tbl,
 	else {
 		/* If it's invalid a new tbl8 is needed */
 		if (!tbl[tbl_index].valid) {
-			if (lpm->next_tbl8 < lpm->number_tbl8s)
-				tbl8_gindex = (lpm->next_tbl8)++;
-			else
+			tbl8_gindex = tbl8_get(lpm, tbl_ind, tbl_index);
+			if (tbl8_gindex < 0)
 				return -ENOSPC;
 
 			struct rte_lpm6_tbl_entry new_tbl_entry = {
@@ -462,9 +649,8 @@ add_step(struct rte_lpm6 *lpm, struct rte_lpm6_tbl_entry *tbl,
 		 */
 		else if (tbl[tbl_index].ext_entry == 0) {
 			/* Search for free tbl8 group. */
-			if (lpm->next_tbl8 < lpm->number_tbl8s)
-				tbl8_gindex = (lpm->next_tbl8)++;
-			else
+			tbl8_gindex = tbl8_get(lpm, tbl_ind, tbl_index);
+			if (tbl8_gindex < 0)
 				return -ENOSPC;
 
 			tbl8_group_start = tbl8_gindex *
@@ -475,6 +661,7 @@ add_step(struct rte_lpm6 *lpm, struct rte_lpm6_tbl_entry *tbl,
 			/* Populate new tbl8 with tbl value. */
 			for (i = tbl8_group_start; i < tbl8_group_end; i++) {
 				lpm->tbl8[i].valid = VALID;
+				lpm->tbl8[i].valid_group = VALID;
 				lpm->tbl8[i].depth = tbl[tbl_index].depth;
 				lpm->tbl8[i].next_hop = tbl[tbl_index].next_hop;
 				lpm->tbl8[i].ext_entry = 0;
@@ -496,7 +683,8 @@ add_step(struct rte_lpm6 *lpm, struct rte_lpm6_tbl_entry *tbl,
 			tbl[tbl_index] = new_tbl_entry;
 		}
 
-		*tbl_next = &(lpm->tbl8[tbl[tbl_index].lpm6_tbl8_gindex *
+		*tbl_next_ind = tbl[tbl_index].lpm6_tbl8_gindex;
+		*tbl_next = &(lpm->tbl8[*tbl_next_ind *
 				RTE_LPM6_TBL8_GROUP_NUM_ENTRIES]);
 	}
 
@@ -519,8 +707,9 @@ rte_lpm6_add_v1705(struct rte_lpm6 *lpm, uint8_t *ip, uint8_t depth,
 		uint32_t next_hop)
 {
 	struct rte_lpm6_tbl_entry *tbl;
-	struct rte_lpm6_tbl_entry *tbl_next;
-	int32_t rule_index;
+	struct rte_lpm6_tbl_entry *tbl_next = NULL;
+	uint32_t tbl_ind, tbl_next_ind = 0;
+	int is_new_rule;
 	int status;
 	uint8_t masked_ip[RTE_LPM6_IPV6_ADDR_SIZE];
 	int i;
@@ -533,23 +722,28 @@ rte_lpm6_add_v1705(struct rte_lpm6 *lpm, uint8_t *ip, uint8_t depth,
 	memcpy(masked_ip, ip, RTE_LPM6_IPV6_ADDR_SIZE);
 	mask_ip(masked_ip, depth);
 
+	/*
+	 * Make sure there are enough tbl8 groups before touching anything,
+	 * so a failed add leaves the tables as they were.
+	 */
+	if (tbl8_needed(lpm, masked_ip, depth) >
+			lpm->number_tbl8s - lpm->tbl8_pool_pos)
+		return -ENOSPC;
+
 	/* Add the rule to the rule table. */
-	rule_index = rule_add(lpm, masked_ip, next_hop, depth);
+	is_new_rule = rule_add(lpm, masked_ip, next_hop, depth);
 
 	/* If there is no space available for new rule return error. */
-	if (rule_index < 0) {
-		return rule_index;
+	if (is_new_rule < 0) {
+		return is_new_rule;
 	}
 
 	/* Inspect the first three bytes through tbl24 on the first step. */
 	tbl = lpm->tbl24;
-	status = add_step (lpm, tbl, &tbl_next, masked_ip, ADD_FIRST_BYTE, 1,
-			depth, next_hop);
-	if (status < 0) {
-		rte_lpm6_delete(lpm, masked_ip, depth);
-
-		return status;
-	}
+	tbl_ind = TBL24_IND;
+	status = add_step(lpm, tbl, tbl_ind, &tbl_next, &tbl_next_ind,
+			masked_ip, ADD_FIRST_BYTE, 1, depth, next_hop,
+			is_new_rule);
 
 	/*
 	 * Inspect one by one the rest of the bytes until
@@ -557,13 +751,10 @@ rte_lpm6_add_v1705(struct rte_lpm6 *lpm, uint8_t *ip, uint8_t depth,
 	 */
 	for (i = ADD_FIRST_BYTE; i < RTE_LPM6_IPV6_ADDR_SIZE && status == 1; i++) {
 		tbl = tbl_next;
-		status = add_step (lpm, tbl, &tbl_next, masked_ip, 1, (uint8_t)(i+1),
-				depth, next_hop);
-		if (status < 0) {
-			rte_lpm6_delete(lpm, masked_ip, depth);
-
-			return status;
-		}
+		tbl_ind = tbl_next_ind;
+		status = add_step(lpm, tbl, tbl_ind, &tbl_next, &tbl_next_ind,
+				masked_ip, 1, (uint8_t)(i+1), depth, next_hop,
+				is_new_rule);
 	}
 
 	return status;
@@ -752,28 +943,26 @@ MAP_STATIC_SYMBOL(int rte_lpm6_lookup_bulk_func(const struct rte_lpm6 *lpm,
 				int32_t *next_hops, unsigned int n),
 		rte_lpm6_lookup_bulk_func_v1705);
 
+
 /*
- * Finds a rule in rule table.
+ * Finds a rule in rule table and returns its next hop.
  * NOTE: Valid range for depth parameter is 1 .. 128 inclusive.
  */
-static inline int32_t
-rule_find(struct rte_lpm6 *lpm, uint8_t *ip, uint8_t depth)
+static inline int
+rule_find(struct rte_lpm6 *lpm, uint8_t *ip, uint8_t depth,
+		uint32_t *next_hop)
 {
-	uint32_t rule_index;
+	struct rte_lpm6_rule_key rule_key;
+	void *data;
 
-	/* Scan used rules at given depth to find rule. */
-	for (rule_index = 0; rule_index < lpm->used_rules; rule_index++) {
-		/* If rule is found return the rule index. */
-		if ((memcmp (lpm->rules_tbl[rule_index].ip, ip,
-				RTE_LPM6_IPV6_ADDR_SIZE) == 0) &&
-				lpm->rules_tbl[rule_index].depth == depth) {
+	rule_key_init(&rule_key, ip, depth);
 
-			return rule_index;
-		}
-	}
+	if (rte_hash_lookup_data(lpm->rules_tbl, &rule_key, &data) < 0)
+		return -ENOENT;
+
+	*next_hop = (uint32_t)(uintptr_t)data;
 
-	/* If rule is not found return -ENOENT. */
-	return -ENOENT;
+	return 0;
 }
 
 /*
@@ -804,7 +993,6 @@ rte_lpm6_is_rule_present_v1705(struct rte_lpm6 *lpm, uint8_t *ip, uint8_t depth,
 		uint32_t *next_hop)
 {
 	uint8_t ip_masked[RTE_LPM6_IPV6_ADDR_SIZE];
-	int32_t rule_index;
 
 	/* Check user arguments. */
 	if ((lpm == NULL) || next_hop == NULL || ip == NULL ||
@@ -816,12 +1004,8 @@ rte_lpm6_is_rule_present_v1705(struct rte_lpm6 *lpm, uint8_t *ip, uint8_t depth,
 	mask_ip(ip_masked, depth);
 
 	/* Look for the rule using rule_find. */
-	rule_index = rule_find(lpm, ip_masked, depth);
-
-	if (rule_index >= 0) {
-		*next_hop = lpm->rules_tbl[rule_index].next_hop;
+	if (rule_find(lpm, ip_masked, depth, next_hop) == 0)
 		return 1;
-	}
 
 	/* If rule is not found return 0. */
 	return 0;
@@ -835,15 +1019,138 @@ MAP_STATIC_SYMBOL(int rte_lpm6_is_rule_present(struct rte_lpm6 *lpm,
  * Delete a rule from the rule table.
  * NOTE: Valid range for depth parameter is 1 .. 128 inclusive.
  */
-static inline void
-rule_delete(struct rte_lpm6 *lpm, int32_t rule_index)
+static inline int
+rule_delete(struct rte_lpm6 *lpm, uint8_t *ip, uint8_t depth)
+{
+	struct rte_lpm6_rule_key rule_key;
+
+	rule_key_init(&rule_key, ip, depth);
+
+	if (rte_hash_del_key(lpm->rules_tbl, &rule_key) < 0)
+		return -ENOENT;
+
+	lpm->used_rules--;
+
+	return 0;
+}
+
+/*
+ * Finds the most specific rule covering a masked IP at a smaller depth.
+ * Returns 1 and fills rule if there is one, 0 otherwise.
+ */
+static int
+rule_find_less_specific(struct rte_lpm6 *lpm, const uint8_t *ip,
+		uint8_t depth, struct rte_lpm6_rule *rule)
 {
+	memcpy(rule->ip, ip, RTE_LPM6_IPV6_ADDR_SIZE);
+
+	while (--depth > 0) {
+		mask_ip(rule->ip, depth);
+
+		if (rule_find(lpm, rule->ip, depth, &rule->next_hop) == 0) {
+			rule->depth = depth;
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Finds the range of entries a rule occupies in the table where it ends,
+ * and the tbl8 group index of that table (TBL24_IND for tbl24). The rule
+ * must be in the tables, which guarantees the path down to it exists.
+ */
+static void
+rule_find_range(struct rte_lpm6 *lpm, const uint8_t *ip, uint8_t depth,
+		struct rte_lpm6_tbl_entry **from,
+		struct rte_lpm6_tbl_entry **to, uint32_t *tbl_ind)
+{
+	struct rte_lpm6_tbl_entry *tbl;
+	uint32_t tbl_index;
+	uint8_t byte;
+
+	tbl_index = (ip[0] << BYTES2_SIZE) | (ip[1] << BYTE_SIZE) | ip[2];
+
+	if (depth <= ADD_FIRST_BYTE * BYTE_SIZE) {
+		*from = &lpm->tbl24[tbl_index];
+		*to = *from + (1 << (ADD_FIRST_BYTE * BYTE_SIZE - depth)) - 1;
+		*tbl_ind = TBL24_IND;
+		return;
+	}
+
+	*tbl_ind = lpm->tbl24[tbl_index].lpm6_tbl8_gindex;
+	tbl = &lpm->tbl8[*tbl_ind * RTE_LPM6_TBL8_GROUP_NUM_ENTRIES];
+	depth -= ADD_FIRST_BYTE * BYTE_SIZE;
+
+	/* Walk down the tbl8 groups until the one the rule ends in. */
+	for (byte = ADD_FIRST_BYTE; depth > BYTE_SIZE; byte++) {
+		*tbl_ind = tbl[ip[byte]].lpm6_tbl8_gindex;
+		tbl = &lpm->tbl8[*tbl_ind * RTE_LPM6_TBL8_GROUP_NUM_ENTRIES];
+		depth -= BYTE_SIZE;
+	}
+
+	*from = &tbl[ip[byte]];
+	*to = *from + (1 << (BYTE_SIZE - depth)) - 1;
+}
+
+/*
+ * Removes a rule from the rules table and from tbl24/tbl8s. The entries it
+ * occupied are handed over to the closest less specific rule, or
+ * invalidated if there is none, and the tbl8 groups it leaves unused are
+ * returned to the pool. Only the tbl8 groups below the rule are touched.
+ */
+static int
+delete_rule(struct rte_lpm6 *lpm, uint8_t *ip, uint8_t depth)
+{
+	struct rte_lpm6_tbl_entry *from, *to;
+	struct rte_lpm6_rule lsp_rule;
+	uint32_t tbl_ind;
+	int ret;
+
+	struct rte_lpm6_tbl_entry new_tbl_entry = {
+		.next_hop = 0,
+		.depth = 0,
+		.valid = INVALID,
+		.valid_group = INVALID,
+		.ext_entry = 0,
+	};
+
+	ret = rule_delete(lpm, ip, depth);
+	if (ret < 0)
+		return ret;
+
+	rule_find_range(lpm, ip, depth, &from, &to, &tbl_ind);
+
+	if (rule_find_less_specific(lpm, ip, depth, &lsp_rule)) {
+		new_tbl_entry.next_hop = lsp_rule.next_hop;
+		new_tbl_entry.depth = lsp_rule.depth;
+		new_tbl_entry.valid = VALID;
+		new_tbl_entry.valid_group = VALID;
+	}
+
 	/*
-	 * Overwrite redundant rule with last rule in group and decrement rule
-	 * counter.
+	 * If this was the last rule of its tbl8 group, the whole group is
+	 * covered by the less specific rule and can go back to the pool.
 	 */
-	lpm->rules_tbl[rule_index] = lpm->rules_tbl[lpm->used_rules-1];
-	lpm->used_rules--;
+	if (tbl_ind != TBL24_IND &&
+			--lpm->tbl8_hdrs[tbl_ind].ref_cnt == 0) {
+		tbl8_recycle(lpm, tbl_ind, &new_tbl_entry);
+		return 0;
+	}
+
+	for (; from <= to; from++) {
+		if (from->ext_entry == 1)
+			expand_rule(lpm, from->lpm6_tbl8_gindex *
+					RTE_LPM6_TBL8_GROUP_NUM_ENTRIES,
+					depth, new_tbl_entry.depth,
+					new_tbl_entry.next_hop,
+					new_tbl_entry.valid);
+		else if (from->depth == depth)
+			*from = new_tbl_entry;
+	}
+
+	return 0;
 }
 
 /*
@@ -852,9 +1159,7 @@ rule_delete(struct rte_lpm6 *lpm, int32_t rule_index)
 int
 rte_lpm6_delete(struct rte_lpm6 *lpm, uint8_t *ip, uint8_t depth)
 {
-	int32_t rule_to_delete_index;
 	uint8_t ip_masked[RTE_LPM6_IPV6_ADDR_SIZE];
-	unsigned i;
 
 	/*
 	 * Check input arguments.
@@ -867,41 +1172,7 @@ rte_lpm6_delete(struct rte_lpm6 *lpm, uint8_t *ip, uint8_t depth)
 	memcpy(ip_masked, ip, RTE_LPM6_IPV6_ADDR_SIZE);
 	mask_ip(ip_masked, depth);
 
-	/*
-	 * Find the index of the input rule, that needs to be deleted, in the
-	 * rule table.
-	 */
-	rule_to_delete_index = rule_find(lpm, ip_masked, depth);
-
-	/*
-	 * Check if rule_to_delete_index was found. If no rule was found the
-	 * function rule_find returns -ENOENT.
-	 */
-	if (rule_to_delete_index < 0)
-		return rule_to_delete_index;
-
-	/* Delete the rule from the rule table. */
-	rule_delete(lpm, rule_to_delete_index);
-
-	/*
-	 * Set all the table entries to 0 (ie delete every rule
-	 * from the data structure.
-	 */
-	lpm->next_tbl8 = 0;
-	memset(lpm->tbl24, 0, sizeof(lpm->tbl24));
-	memset(lpm->tbl8, 0, sizeof(lpm->tbl8[0])
-			* RTE_LPM6_TBL8_GROUP_NUM_ENTRIES * lpm->number_tbl8s);
-
-	/*
-	 * Add every rule again (except for the one that was removed from
-	 * the rules table).
-	 */
-	for (i = 0; i < lpm->used_rules; i++) {
-		rte_lpm6_add(lpm, lpm->rules_tbl[i].ip, lpm->rules_tbl[i].depth,
-				lpm->rules_tbl[i].next_hop);
-	}
-
-	return 0;
+	return delete_rule(lpm, ip_masked, depth);
 }
 
 /*
@@ -911,7 +1182,6 @@ int
 rte_lpm6_delete_bulk_func(struct rte_lpm6 *lpm,
 		uint8_t ips[][RTE_LPM6_IPV6_ADDR_SIZE], uint8_t *depths, unsigned n)
 {
-	int32_t rule_to_delete_index;
 	uint8_t ip_masked[RTE_LPM6_IPV6_ADDR_SIZE];
 	unsigned i;
 
@@ -923,43 +1193,15 @@ rte_lpm6_delete_bulk_func(struct rte_lpm6 *lpm,
 	}
 
 	for (i = 0; i < n; i++) {
+		if ((depths[i] < 1) || (depths[i] > RTE_LPM6_MAX_DEPTH))
+			continue;
+
 		/* Copy the IP and mask it to avoid modifying user's input data. */
 		memcpy(ip_masked, ips[i], RTE_LPM6_IPV6_ADDR_SIZE);
 		mask_ip(ip_masked, depths[i]);
 
-		/*
-		 * Find the index of the input rule, that needs to be deleted, in the
-		 * rule table.
-		 */
-		rule_to_delete_index = rule_find(lpm, ip_masked, depths[i]);
-
-		/*
-		 * Check if rule_to_delete_index was found. If no rule was found the
-		 * function rule_find returns -ENOENT.
-		 */
-		if (rule_to_delete_index < 0)
-			continue;
-
-		/* Delete the rule from the rule table. */
-		rule_delete(lpm, rule_to_delete_index);
-	}
-
-	/*
-	 * Set all the table entries to 0 (ie delete every rule
-	 * from the data structure.
-	 */
-	lpm->next_tbl8 = 0;
-	memset(lpm->tbl24, 0, sizeof(lpm->tbl24));
-	memset(lpm->tbl8, 0, sizeof(lpm->tbl8[0])
-			* RTE_LPM6_TBL8_GROUP_NUM_ENTRIES * lpm->number_tbl8s);
-
-	/*
-	 * Add every rule again (except for the ones that were removed from
-	 * the rules table).
-	 */
-	for (i = 0; i < lpm->used_rules; i++) {
-		rte_lpm6_add(lpm, lpm->rules_tbl[i].ip, lpm->rules_tbl[i].depth,
-				lpm->rules_tbl[i].next_hop);
+		/* Rules that are not in the table are skipped. */
+		delete_rule(lpm, ip_masked, depths[i]);
 	}
 
 	return 0;
@@ -974,8 +1216,8 @@ rte_lpm6_delete_all(struct rte_lpm6 *lpm)
 	/* Zero used rules counter. */
 	lpm->used_rules = 0;
 
-	/* Zero next tbl8 index. */
-	lpm->next_tbl8 = 0;
+	/* Return every tbl8 group to the pool. */
+	tbl8_pool_init(lpm);
 
 	/* Zero tbl24. */
 	memset(lpm->tbl24, 0, sizeof(lpm->tbl24));
@@ -985,5 +1227,5 @@ rte_lpm6_delete_all(struct rte_lpm6 *lpm)
 			RTE_LPM6_TBL8_GROUP_NUM_ENTRIES * lpm->number_tbl8s);
 
 	/* Delete all rules form the rules table. */
-	memset(lpm->rules_tbl, 0, sizeof(struct rte_lpm6_rule) * lpm->max_rules);
+	rte_hash_reset(lpm->rules_tbl);
 }
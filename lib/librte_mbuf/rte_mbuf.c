@@ -267,6 +267,148 @@ rte_pktmbuf_dump(FILE *f, const struct rte_mbuf *m, unsigned dump_len)
 	}
 }
 
+/* number of segments put back to a mempool at once */
+#define RTE_PKTMBUF_FREE_PENDING_SZ 64
+
+/* put the pending segments back to their mempool */
+static inline void
+__rte_pktmbuf_free_pending(struct rte_mbuf ** const pending,
+	unsigned int * const nb_pending)
+{
+	if (*nb_pending == 0)
+		return;
+
+	rte_mempool_put_bulk(pending[0]->pool, (void **)pending, *nb_pending);
+	*nb_pending = 0;
+}
+
+/* free a bulk of packet mbufs, grouping the segments by mempool */
+void
+rte_pktmbuf_free_bulk(struct rte_mbuf **mbufs, unsigned int count)
+{
+	struct rte_mbuf *pending[RTE_PKTMBUF_FREE_PENDING_SZ];
+	struct rte_mbuf *m, *m_next;
+	unsigned int nb_pending = 0;
+	unsigned int i;
+
+	for (i = 0; i < count; i++) {
+		m = mbufs[i];
+		if (unlikely(m == NULL))
+			continue;
+
+		__rte_mbuf_sanity_check(m, 1);
+
+		do {
+			m_next = m->next;
+			m = rte_pktmbuf_prefree_seg(m);
+			if (likely(m != NULL)) {
+				if (nb_pending == RTE_PKTMBUF_FREE_PENDING_SZ ||
+						(nb_pending != 0 &&
+						 pending[0]->pool != m->pool))
+					__rte_pktmbuf_free_pending(pending,
+						&nb_pending);
+				pending[nb_pending++] = m;
+			}
+			m = m_next;
+		} while (m != NULL);
+	}
+
+	__rte_pktmbuf_free_pending(pending, &nb_pending);
+}
+
+/* copy the packet metadata of m into the header mbuf mc */
+static inline void
+__rte_pktmbuf_copy_hdr(struct rte_mbuf *mc, const struct rte_mbuf *m)
+{
+	mc->port = m->port;
+	mc->vlan_tci = m->vlan_tci;
+	mc->vlan_tci_outer = m->vlan_tci_outer;
+	mc->tx_offload = m->tx_offload;
+	mc->hash = m->hash;
+	mc->packet_type = m->packet_type;
+	mc->timestamp = m->timestamp;
+	mc->seqn = m->seqn;
+	rte_mbuf_dynfield_copy(mc, m);
+	/* the copy owns its data, it is neither indirect nor external */
+	mc->ol_flags = m->ol_flags &
+		~(IND_ATTACHED_MBUF | EXT_ATTACHED_MBUF);
+}
+
+/* copy len data bytes of a packet mbuf at specified offset */
+struct rte_mbuf *
+rte_pktmbuf_copy(const struct rte_mbuf *m, struct rte_mempool *mp,
+	uint32_t off, uint32_t len)
+{
+	const struct rte_mbuf *seg = m;
+	struct rte_mbuf *mc, *m_last, **prev;
+	uint32_t copy_len;
+
+	__rte_mbuf_sanity_check(m, 1);
+
+	if (unlikely(off > rte_pktmbuf_pkt_len(m)))
+		return NULL;
+
+	mc = rte_pktmbuf_alloc(mp);
+	if (unlikely(mc == NULL))
+		return NULL;
+
+	__rte_pktmbuf_copy_hdr(mc, m);
+
+	/* truncated copy when len goes beyond the end of the packet */
+	len = RTE_MIN(len, rte_pktmbuf_pkt_len(m) - off);
+
+	/* skip the segments located before the offset */
+	while (off > 0 && off >= rte_pktmbuf_data_len(seg)) {
+		off -= rte_pktmbuf_data_len(seg);
+		seg = seg->next;
+	}
+
+	m_last = mc;
+	prev = &mc->next;
+
+	while (len > 0) {
+		/* the last copy segment is full, append a new one */
+		if (rte_pktmbuf_tailroom(m_last) == 0) {
+			if (unlikely(mc->nb_segs == UINT16_MAX))
+				goto fail;
+			m_last = rte_pktmbuf_alloc(mp);
+			if (unlikely(m_last == NULL))
+				goto fail;
+			/* the headroom is only useful in the first segment */
+			m_last->data_off = 0;
+			*prev = m_last;
+			prev = &m_last->next;
+			mc->nb_segs++;
+		}
+
+		copy_len = RTE_MIN(rte_pktmbuf_data_len(seg) - off, len);
+		copy_len = RTE_MIN(copy_len,
+				   (uint32_t)rte_pktmbuf_tailroom(m_last));
+
+		rte_memcpy(rte_pktmbuf_mtod_offset(m_last, char *,
+						   m_last->data_len),
+			   rte_pktmbuf_mtod_offset(seg, const char *, off),
+			   copy_len);
+
+		m_last->data_len += copy_len;
+		mc->pkt_len += copy_len;
+		off += copy_len;
+		len -= copy_len;
+
+		if (off == rte_pktmbuf_data_len(seg)) {
+			seg = seg->next;
+			off = 0;
+		}
+	}
+
+	__rte_mbuf_sanity_check(mc, 1);
+	return mc;
+
+fail:
+	rte_pktmbuf_free(mc);
+	return NULL;
+}
+
 /* read len data bytes in a mbuf at specified offset (internal) */
 const void *__rte_pktmbuf_read(const struct rte_mbuf *m, uint32_t off,
 	uint32_t len, void *buf)
@@ -0,0 +1,386 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+#include <rte_common.h>
+#include <rte_eal.h>
+#include <rte_eal_memconfig.h>
+#include <rte_errno.h>
+#include <rte_log.h>
+#include <rte_memzone.h>
+#include <rte_rwlock.h>
+#include <rte_mbuf.h>
+#include <rte_mbuf_dyn.h>
+
+#define RTE_MBUF_DYN_MZNAME "rte_mbuf_dyn"
+
+/* maximum number of dynamic fields, at least one byte each */
+#define RTE_MBUF_DYNFIELD_MAX \
+	(sizeof(((struct rte_mbuf *)0)->dynfield1))
+
+/* number of bits in ol_flags */
+#define RTE_MBUF_DYNFLAG_MAX 64
+
+struct mbuf_dynfield_elt {
+	struct rte_mbuf_dynfield params;
+	size_t offset;
+};
+
+struct mbuf_dynflag_elt {
+	struct rte_mbuf_dynflag params;
+	unsigned int bitnum;
+};
+
+/* registry shared by all processes, protected by the EAL tailq lock */
+struct mbuf_dyn_shm {
+	/* for each byte of the mbuf structure, 1 if it is free */
+	uint8_t free_space[sizeof(struct rte_mbuf)];
+	/* mask of the ol_flags bits that are free */
+	uint64_t free_flags;
+	unsigned int nb_fields;
+	struct mbuf_dynfield_elt fields[RTE_MBUF_DYNFIELD_MAX];
+	unsigned int nb_flags;
+	struct mbuf_dynflag_elt flags[RTE_MBUF_DYNFLAG_MAX];
+};
+
+static struct mbuf_dyn_shm *shm;
+
+/* fill the registry with the room left in the mbuf structure */
+static void
+init_shared_mem_content(void)
+{
+	unsigned int bit;
+
+	memset(shm, 0, sizeof(*shm));
+
+	memset(&shm->free_space[offsetof(struct rte_mbuf, dynfield1)], 1,
+	       sizeof(((struct rte_mbuf *)0)->dynfield1));
+
+	/* the bits between the last RX flag and the first TX flag */
+	RTE_BUILD_BUG_ON(PKT_RX_TIMESTAMP >= PKT_TX_MACSEC);
+	for (bit = __builtin_ctzll(PKT_RX_TIMESTAMP) + 1;
+	     bit < (unsigned int)__builtin_ctzll(PKT_TX_MACSEC); bit++)
+		shm->free_flags |= 1ULL << bit;
+}
+
+/* attach to the registry if it already exists, locked */
+static void
+attach_shared_mem(void)
+{
+	const struct rte_memzone *mz;
+
+	if (shm != NULL)
+		return;
+
+	mz = rte_memzone_lookup(RTE_MBUF_DYN_MZNAME);
+	if (mz != NULL)
+		shm = mz->addr;
+}
+
+/* attach to the registry, create it in the primary process, locked */
+static int
+init_shared_mem(void)
+{
+	const struct rte_memzone *mz;
+
+	attach_shared_mem();
+	if (shm != NULL)
+		return 0;
+
+	if (rte_eal_process_type() != RTE_PROC_PRIMARY) {
+		rte_errno = EPERM;
+		return -1;
+	}
+
+	mz = rte_memzone_reserve_aligned(RTE_MBUF_DYN_MZNAME,
+		sizeof(struct mbuf_dyn_shm), SOCKET_ID_ANY, 0,
+		RTE_CACHE_LINE_SIZE);
+	if (mz == NULL) {
+		RTE_LOG(ERR, MBUF, "Failed to get mbuf dyn shared memory\n");
+		rte_errno = ENOMEM;
+		return -1;
+	}
+
+	shm = mz->addr;
+	init_shared_mem_content();
+	return 0;
+}
+
+/* look for a dynamic field by name, locked */
+static struct mbuf_dynfield_elt *
+__mbuf_dynfield_lookup(const char *name)
+{
+	unsigned int i;
+
+	for (i = 0; i < shm->nb_fields; i++) {
+		if (strcmp(name, shm->fields[i].params.name) == 0)
+			return &shm->fields[i];
+	}
+
+	return NULL;
+}
+
+int
+rte_mbuf_dynfield_lookup(const char *name, struct rte_mbuf_dynfield *params)
+{
+	struct mbuf_dynfield_elt *elt = NULL;
+	int ret = -1;
+
+	rte_rwlock_read_lock(RTE_EAL_TAILQ_RWLOCK);
+	attach_shared_mem();
+	if (shm != NULL)
+		elt = __mbuf_dynfield_lookup(name);
+	if (elt != NULL) {
+		if (params != NULL)
+			*params = elt->params;
+		ret = (int)elt->offset;
+	}
+	rte_rwlock_read_unlock(RTE_EAL_TAILQ_RWLOCK);
+
+	if (ret < 0)
+		rte_errno = ENOENT;
+	return ret;
+}
+
+/* find the first free area matching the size and alignment, locked */
+static int
+mbuf_dynfield_find_space(size_t size, size_t align)
+{
+	size_t off, i;
+
+	for (off = 0; off + size <= sizeof(struct rte_mbuf); off += align) {
+		for (i = 0; i < size; i++) {
+			if (shm->free_space[off + i] == 0)
+				break;
+		}
+		if (i == size)
+			return (int)off;
+	}
+
+	return -1;
+}
+
+int
+rte_mbuf_dynfield_register(const struct rte_mbuf_dynfield *params)
+{
+	struct mbuf_dynfield_elt *elt;
+	int offset = -1;
+
+	if (params->name[0] == '\0' ||
+	    strnlen(params->name, RTE_MBUF_DYN_NAMESIZE) ==
+			RTE_MBUF_DYN_NAMESIZE ||
+	    params->size == 0 || params->align == 0 ||
+	    !rte_is_power_of_2(params->align) || params->flags != 0) {
+		rte_errno = EINVAL;
+		return -1;
+	}
+
+	rte_rwlock_write_lock(RTE_EAL_TAILQ_RWLOCK);
+
+	if (init_shared_mem() < 0)
+		goto out;
+
+	elt = __mbuf_dynfield_lookup(params->name);
+	if (elt != NULL) {
+		if (elt->params.size != params->size ||
+		    elt->params.align != params->align ||
+		    elt->params.flags != params->flags) {
+			rte_errno = EEXIST;
+			goto out;
+		}
+		offset = (int)elt->offset;
+		goto out;
+	}
+
+	if (shm->nb_fields == RTE_DIM(shm->fields)) {
+		rte_errno = ENOSPC;
+		goto out;
+	}
+
+	offset = mbuf_dynfield_find_space(params->size, params->align);
+	if (offset < 0) {
+		rte_errno = ENOSPC;
+		goto out;
+	}
+
+	elt = &shm->fields[shm->nb_fields];
+	elt->params = *params;
+	elt->offset = offset;
+	memset(&shm->free_space[offset], 0, params->size);
+	shm->nb_fields++;
+
+	RTE_LOG(DEBUG, MBUF,
+		"Registered dynamic field %s (sz=%zu, al=%zu, fl=0x%x) -> %d\n",
+		params->name, params->size, params->align, params->flags,
+		offset);
+
+out:
+	rte_rwlock_write_unlock(RTE_EAL_TAILQ_RWLOCK);
+	return offset;
+}
+
+/* look for a dynamic flag by name, locked */
+static struct mbuf_dynflag_elt *
+__mbuf_dynflag_lookup(const char *name)
+{
+	unsigned int i;
+
+	for (i = 0; i < shm->nb_flags; i++) {
+		if (strcmp(name, shm->flags[i].params.name) == 0)
+			return &shm->flags[i];
+	}
+
+	return NULL;
+}
+
+int
+rte_mbuf_dynflag_lookup(const char *name, struct rte_mbuf_dynflag *params)
+{
+	struct mbuf_dynflag_elt *elt = NULL;
+	int ret = -1;
+
+	rte_rwlock_read_lock(RTE_EAL_TAILQ_RWLOCK);
+	attach_shared_mem();
+	if (shm != NULL)
+		elt = __mbuf_dynflag_lookup(name);
+	if (elt != NULL) {
+		if (params != NULL)
+			*params = elt->params;
+		ret = (int)elt->bitnum;
+	}
+	rte_rwlock_read_unlock(RTE_EAL_TAILQ_RWLOCK);
+
+	if (ret < 0)
+		rte_errno = ENOENT;
+	return ret;
+}
+
+int
+rte_mbuf_dynflag_register(const struct rte_mbuf_dynflag *params)
+{
+	struct mbuf_dynflag_elt *elt;
+	int bitnum = -1;
+
+	if (params->name[0] == '\0' ||
+	    strnlen(params->name, RTE_MBUF_DYN_NAMESIZE) ==
+			RTE_MBUF_DYN_NAMESIZE ||
+	    params->flags != 0) {
+		rte_errno = EINVAL;
+		return -1;
+	}
+
+	rte_rwlock_write_lock(RTE_EAL_TAILQ_RWLOCK);
+
+	if (init_shared_mem() < 0)
+		goto out;
+
+	elt = __mbuf_dynflag_lookup(params->name);
+	if (elt != NULL) {
+		if (elt->params.flags != params->flags) {
+			rte_errno = EEXIST;
+			goto out;
+		}
+		bitnum = (int)elt->bitnum;
+		goto out;
+	}
+
+	if (shm->free_flags == 0) {
+		rte_errno = ENOSPC;
+		goto out;
+	}
+
+	bitnum = __builtin_ctzll(shm->free_flags);
+	elt = &shm->flags[shm->nb_flags];
+	elt->params = *params;
+	elt->bitnum = bitnum;
+	shm->free_flags &= ~(1ULL << bitnum);
+	shm->nb_flags++;
+
+	RTE_LOG(DEBUG, MBUF, "Registered dynamic flag %s (fl=0x%x) -> %d\n",
+		params->name, params->flags, bitnum);
+
+out:
+	rte_rwlock_write_unlock(RTE_EAL_TAILQ_RWLOCK);
+	return bitnum;
+}
+
+void
+rte_mbuf_dyn_dump(FILE *out)
+{
+	const struct mbuf_dynfield_elt *field;
+	const struct mbuf_dynflag_elt *flag;
+	unsigned int i;
+
+	rte_rwlock_read_lock(RTE_EAL_TAILQ_RWLOCK);
+
+	attach_shared_mem();
+	if (shm == NULL) {
+		fprintf(out, "No dynamic field or flag registered\n");
+		goto out;
+	}
+
+	fprintf(out, "Reserved fields:\n");
+	for (i = 0; i < shm->nb_fields; i++) {
+		field = &shm->fields[i];
+		fprintf(out, "  name=%s offset=%zu size=%zu align=%zu flags=%x\n",
+			field->params.name, field->offset, field->params.size,
+			field->params.align, field->params.flags);
+	}
+	fprintf(out, "Reserved flags:\n");
+	for (i = 0; i < shm->nb_flags; i++) {
+		flag = &shm->flags[i];
+		fprintf(out, "  name=%s bitnum=%u flags=%x\n",
+			flag->params.name, flag->bitnum, flag->params.flags);
+	}
+	fprintf(out, "Free space in mbuf (00 = free, ff = used):\n");
+	for (i = 0; i < sizeof(struct rte_mbuf); i++) {
+		if ((i % 8) == 0)
+			fprintf(out, "  %4.4x: ", i);
+		fprintf(out, "%2.2x%s", shm->free_space[i] ? 0 : 0xff,
+			(i % 8 != 7) ? " " : "\n");
+	}
+	fprintf(out, "Free bits in mbuf->ol_flags (0 = free, 1 = used):\n");
+	for (i = 0; i < RTE_MBUF_DYNFLAG_MAX; i++) {
+		if ((i % 8) == 0)
+			fprintf(out, "  %4.4x: ", i);
+		fprintf(out, "%1.1x%s", (shm->free_flags & (1ULL << i)) ? 0 : 1,
+			(i % 8 != 7) ? " " : "\n");
+	}
+
+out:
+	rte_rwlock_read_unlock(RTE_EAL_TAILQ_RWLOCK);
+}
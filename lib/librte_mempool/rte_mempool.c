@@ -68,6 +68,10 @@ static struct rte_tailq_elem rte_mempool_tailq = {
 };
 EAL_REGISTER_TAILQ(rte_mempool_tailq)
 
+/* user-owned caches attached to the running thread */
+RTE_DEFINE_PER_LCORE(struct rte_mempool_cache *,
+	_mempool_thread_cache[RTE_MEMPOOL_THREAD_CACHE_MAX]);
+
 #define CACHE_FLUSHTHRESH_MULTIPLIER 1.5
 #define CALC_CACHE_FLUSHTHRESH(c)	\
 	((typeof(c))((c) * CACHE_FLUSHTHRESH_MULTIPLIER))
@@ -730,6 +734,89 @@ rte_mempool_cache_free(struct rte_mempool_cache *cache)
 	rte_free(cache);
 }
 
+/* attach a user-owned cache to the calling thread */
+int
+rte_mempool_cache_attach(struct rte_mempool *mp,
+	struct rte_mempool_cache *cache)
+{
+	struct rte_mempool_cache **slot = NULL;
+	unsigned i;
+
+	if (mp == NULL || cache == NULL || cache->mp != NULL)
+		return -EINVAL;
+
+	for (i = 0; i < RTE_MEMPOOL_THREAD_CACHE_MAX; i++) {
+		struct rte_mempool_cache *c =
+			RTE_PER_LCORE(_mempool_thread_cache)[i];
+
+		if (c == NULL) {
+			if (slot == NULL)
+				slot = &RTE_PER_LCORE(_mempool_thread_cache)[i];
+		} else if (c->mp == mp) {
+			return -EEXIST;
+		}
+	}
+	if (slot == NULL)
+		return -ENOSPC;
+
+	rte_spinlock_lock(&mp->user_cache_lock);
+	cache->mp = mp;
+	STAILQ_INSERT_TAIL(&mp->user_caches, cache, next);
+	rte_spinlock_unlock(&mp->user_cache_lock);
+
+	*slot = cache;
+
+	return 0;
+}
+
+/* detach a user-owned cache from the calling thread */
+int
+rte_mempool_cache_detach(struct rte_mempool *mp,
+	struct rte_mempool_cache *cache)
+{
+	unsigned i;
+
+	if (mp == NULL || cache == NULL || cache->mp != mp)
+		return -EINVAL;
+
+	for (i = 0; i < RTE_MEMPOOL_THREAD_CACHE_MAX; i++) {
+		if (RTE_PER_LCORE(_mempool_thread_cache)[i] == cache)
+			break;
+	}
+	if (i == RTE_MEMPOOL_THREAD_CACHE_MAX)
+		return -EINVAL;
+
+	RTE_PER_LCORE(_mempool_thread_cache)[i] = NULL;
+
+	rte_spinlock_lock(&mp->user_cache_lock);
+	STAILQ_REMOVE(&mp->user_caches, cache, rte_mempool_cache, next);
+	cache->mp = NULL;
+	rte_spinlock_unlock(&mp->user_cache_lock);
+
+	return 0;
+}
+
+/* return the number of objects held in the user-owned caches of a mempool */
+static unsigned
+mempool_user_cache_count(const struct rte_mempool *mp, FILE *f)
+{
+	/* the lock is modified even if the mempool is not */
+	struct rte_mempool *mp_rw = (struct rte_mempool *)(uintptr_t)mp;
+	const struct rte_mempool_cache *cache;
+	unsigned count = 0;
+
+	rte_spinlock_lock(&mp_rw->user_cache_lock);
+	STAILQ_FOREACH(cache, &mp->user_caches, next) {
+		if (f != NULL)
+			fprintf(f, "    user_cache_count[%p]=%"PRIu32"\n",
+				cache, cache->len);
+		count += cache->len;
+	}
+	rte_spinlock_unlock(&mp_rw->user_cache_lock);
+
+	return count;
+}
+
 /* create an empty mempool */
 struct rte_mempool *
 rte_mempool_create_empty(const char *name, unsigned n, unsigned elt_size,
@@ -829,6 +916,8 @@ rte_mempool_create_empty(const char *name, unsigned n, unsigned elt_size,
 	mp->private_data_size = private_data_size;
 	STAILQ_INIT(&mp->elt_list);
 	STAILQ_INIT(&mp->mem_list);
+	rte_spinlock_init(&mp->user_cache_lock);
+	STAILQ_INIT(&mp->user_caches);
 
 	/*
 	 * local_cache pointer is set even if cache_size is zero.
@@ -978,12 +1067,12 @@ rte_mempool_avail_count(const struct rte_mempool *mp)
 	unsigned lcore_id;
 
 	count = rte_mempool_ops_get_count(mp);
+	count += mempool_user_cache_count(mp, NULL);
 
-	if (mp->cache_size == 0)
-		return count;
-
-	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++)
-		count += mp->local_cache[lcore_id].len;
+	if (mp->cache_size != 0) {
+		for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++)
+			count += mp->local_cache[lcore_id].len;
+	}
 
 	/*
 	 * due to race condition (access to len is not locked), the
@@ -1001,6 +1090,113 @@ rte_mempool_in_use_count(const struct rte_mempool *mp)
 	return mp->size - rte_mempool_avail_count(mp);
 }
 
+/* number of objects out of the common pool, summed over the lcores */
+static int64_t
+rte_mempool_out_count(const struct rte_mempool *mp)
+{
+	int64_t out = mp->out.cnt;
+	unsigned lcore_id;
+
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++)
+		out += mp->lcore_stats[lcore_id].out;
+
+	/* the counters of the lcores are not read at once */
+	if (out < 0)
+		return 0;
+	return out;
+}
+
+/* sum the usage statistics of all lcores, update the highest out read */
+int
+rte_mempool_stats_get(struct rte_mempool *mp,
+	struct rte_mempool_stats *stats)
+{
+	const struct rte_mempool_lcore_stats *lcore_stats;
+	unsigned lcore_id;
+	int64_t max;
+
+	if (mp == NULL || stats == NULL)
+		return -EINVAL;
+
+	memset(stats, 0, sizeof(*stats));
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		lcore_stats = &mp->lcore_stats[lcore_id];
+		stats->refill_bulk += lcore_stats->refill_bulk;
+		stats->refill_objs += lcore_stats->refill_objs;
+		stats->flush_bulk += lcore_stats->flush_bulk;
+		stats->flush_objs += lcore_stats->flush_objs;
+		stats->get_fail_bulk += lcore_stats->get_fail_bulk;
+		stats->get_fail_objs += lcore_stats->get_fail_objs;
+	}
+	stats->in_use = rte_mempool_in_use_count(mp);
+	stats->out = rte_mempool_out_count(mp);
+
+	do {
+		max = rte_atomic64_read(&mp->out_max_read);
+		if ((int64_t)stats->out <= max)
+			break;
+	} while (rte_atomic64_cmpset((volatile uint64_t *)&mp->out_max_read.cnt,
+			max, stats->out) == 0);
+	stats->out_max_read = RTE_MAX((int64_t)stats->out, max);
+
+	return 0;
+}
+
+/* clear the usage statistics, the highest out read restarts from now */
+void
+rte_mempool_stats_reset(struct rte_mempool *mp)
+{
+	struct rte_mempool_lcore_stats *lcore_stats;
+	unsigned lcore_id;
+	int64_t out;
+
+	/* the number of objects out of the common pool is kept */
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		lcore_stats = &mp->lcore_stats[lcore_id];
+		out = lcore_stats->out;
+		memset(lcore_stats, 0, sizeof(*lcore_stats));
+		lcore_stats->out = out;
+	}
+	rte_atomic64_set(&mp->out_max_read, rte_mempool_out_count(mp));
+}
+
+/* dump the usage statistics */
+static void
+rte_mempool_dump_usage(FILE *f, struct rte_mempool *mp)
+{
+	const struct rte_mempool_lcore_stats *lcore_stats;
+	struct rte_mempool_stats sum;
+	unsigned lcore_id;
+
+	rte_mempool_stats_get(mp, &sum);
+
+	fprintf(f, "  usage:\n");
+	fprintf(f, "    in_use=%"PRIu64"\n", sum.in_use);
+	fprintf(f, "    out=%"PRIu64"\n", sum.out);
+	fprintf(f, "    out_max_read=%"PRIu64"\n", sum.out_max_read);
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		lcore_stats = &mp->lcore_stats[lcore_id];
+		if (lcore_stats->refill_bulk == 0 &&
+				lcore_stats->flush_bulk == 0 &&
+				lcore_stats->get_fail_bulk == 0)
+			continue;
+		fprintf(f, "    lcore[%u]: refill_bulk=%"PRIu64
+			" refill_objs=%"PRIu64" flush_bulk=%"PRIu64
+			" flush_objs=%"PRIu64" get_fail_bulk=%"PRIu64
+			" get_fail_objs=%"PRIu64"\n", lcore_id,
+			lcore_stats->refill_bulk, lcore_stats->refill_objs,
+			lcore_stats->flush_bulk, lcore_stats->flush_objs,
+			lcore_stats->get_fail_bulk,
+			lcore_stats->get_fail_objs);
+	}
+	fprintf(f, "    refill_bulk=%"PRIu64"\n", sum.refill_bulk);
+	fprintf(f, "    refill_objs=%"PRIu64"\n", sum.refill_objs);
+	fprintf(f, "    flush_bulk=%"PRIu64"\n", sum.flush_bulk);
+	fprintf(f, "    flush_objs=%"PRIu64"\n", sum.flush_objs);
+	fprintf(f, "    get_fail_bulk=%"PRIu64"\n", sum.get_fail_bulk);
+	fprintf(f, "    get_fail_objs=%"PRIu64"\n", sum.get_fail_objs);
+}
+
 /* dump the cache status */
 static unsigned
 rte_mempool_dump_cache(FILE *f, const struct rte_mempool *mp)
@@ -1012,15 +1208,14 @@ rte_mempool_dump_cache(FILE *f, const struct rte_mempool *mp)
 	fprintf(f, "  internal cache infos:\n");
 	fprintf(f, "    cache_size=%"PRIu32"\n", mp->cache_size);
 
-	if (mp->cache_size == 0)
-		return count;
-
-	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+	for (lcore_id = 0; mp->cache_size != 0 && lcore_id < RTE_MAX_LCORE;
+			lcore_id++) {
 		cache_count = mp->local_cache[lcore_id].len;
 		fprintf(f, "    cache_count[%u]=%"PRIu32"\n",
 			lcore_id, cache_count);
 		count += cache_count;
 	}
+	count += mempool_user_cache_count(mp, f);
 	fprintf(f, "    total_cache_count=%u\n", count);
 	return count;
 }
@@ -1202,6 +1397,8 @@ rte_mempool_dump(FILE *f, struct rte_mempool *mp)
 		common_count = mp->size - cache_count;
 	fprintf(f, "  common_pool_count=%u\n", common_count);
 
+	rte_mempool_dump_usage(f, mp);
+
 	/* sum and dump statistics */
 #ifdef RTE_LIBRTE_MEMPOOL_DEBUG
 	memset(&sum, 0, sizeof(sum));
@@ -59,7 +59,8 @@
  * rte_mempool_get() or rte_mempool_put() performance will suffer when called
  * by non-EAL threads. Instead, non-EAL threads should call
  * rte_mempool_generic_get() or rte_mempool_generic_put() with a user cache
- * created with rte_mempool_cache_create().
+ * created with rte_mempool_cache_create(), or attach such a cache with
+ * rte_mempool_cache_attach().
  */
 
 #include <stdio.h>
@@ -70,6 +71,7 @@
 #include <sys/queue.h>
 
 #include <rte_spinlock.h>
+#include <rte_atomic.h>
 #include <rte_log.h>
 #include <rte_debug.h>
 #include <rte_lcore.h>
@@ -101,6 +103,43 @@ struct rte_mempool_debug_stats {
 } __rte_cache_aligned;
 #endif
 
+/**
+ * A structure that stores the always-on mempool statistics (per-lcore).
+ *
+ * Only the accesses to the common pool are counted, so that updating the
+ * statistics does not slow down the per-lcore cache fast path.
+ */
+struct rte_mempool_lcore_stats {
+	uint64_t refill_bulk;   /**< Number of gets from the common pool. */
+	uint64_t refill_objs;   /**< Objects got from the common pool. */
+	uint64_t flush_bulk;    /**< Number of puts to the common pool. */
+	uint64_t flush_objs;    /**< Objects put to the common pool. */
+	uint64_t get_fail_bulk; /**< Failed allocation number. */
+	uint64_t get_fail_objs; /**< Objects that failed to be allocated. */
+	/** Objects got from the common pool minus objects put back to it. */
+	int64_t out;
+} __rte_cache_aligned;
+
+/**
+ * A structure that stores the mempool usage statistics.
+ */
+struct rte_mempool_stats {
+	uint64_t in_use;        /**< Objects allocated, not in a cache. */
+	/** Objects out of the common pool, allocated or in a cache. */
+	uint64_t out;
+	/**
+	 * Highest out read by rte_mempool_stats_get() since the last reset.
+	 * It is not a high watermark: the peaks between two reads are missed.
+	 */
+	uint64_t out_max_read;
+	uint64_t refill_bulk;   /**< Number of gets from the common pool. */
+	uint64_t refill_objs;   /**< Objects got from the common pool. */
+	uint64_t flush_bulk;    /**< Number of puts to the common pool. */
+	uint64_t flush_objs;    /**< Objects put to the common pool. */
+	uint64_t get_fail_bulk; /**< Failed allocation number. */
+	uint64_t get_fail_objs; /**< Objects that failed to be allocated. */
+};
+
 /**
  * A structure that stores a per-core object cache.
  */
@@ -108,6 +147,10 @@ struct rte_mempool_cache {
 	uint32_t size;	      /**< Size of the cache */
 	uint32_t flushthresh; /**< Threshold before we flush excess elements */
 	uint32_t len;	      /**< Current cache count */
+	/** Mempool a user-owned cache is attached to, NULL if none. */
+	struct rte_mempool *mp;
+	/** Next in the list of user-owned caches attached to the mempool. */
+	STAILQ_ENTRY(rte_mempool_cache) next;
 	/*
 	 * Cache is allocated to this size to allow it to overflow in certain
 	 * cases to avoid needless emptying of cache.
@@ -115,6 +158,23 @@ struct rte_mempool_cache {
 	void *objs[RTE_MEMPOOL_CACHE_MAX_SIZE * 3]; /**< Cache objects */
 } __rte_cache_aligned;
 
+/**
+ * A list of user-owned caches attached to a mempool.
+ */
+STAILQ_HEAD(rte_mempool_cache_list, rte_mempool_cache);
+
+/**
+ * Maximum number of user-owned caches that can be attached to a thread,
+ * one per mempool.
+ */
+#define RTE_MEMPOOL_THREAD_CACHE_MAX 8
+
+/**
+ * @internal User-owned caches attached to the running thread.
+ */
+RTE_DECLARE_PER_LCORE(struct rte_mempool_cache *,
+	_mempool_thread_cache[RTE_MEMPOOL_THREAD_CACHE_MAX]);
+
 /**
  * A structure that stores the size of mempool elements.
  */
@@ -248,11 +308,21 @@ struct rte_mempool {
 
 	struct rte_mempool_cache *local_cache; /**< Per-lcore local cache */
 
+	rte_spinlock_t user_cache_lock;  /**< Protects user_caches. */
+	/** User-owned caches attached to threads using this mempool. */
+	struct rte_mempool_cache_list user_caches;
+
 	uint32_t populated_size;         /**< Number of populated objects. */
 	struct rte_mempool_objhdr_list elt_list; /**< List of objects in pool */
 	uint32_t nb_mem_chunks;          /**< Number of memory chunks */
 	struct rte_mempool_memhdr_list mem_list; /**< List of memory chunks */
 
+	/** Number of objects out of the common pool by non-EAL threads. */
+	rte_atomic64_t out __rte_cache_aligned;
+	rte_atomic64_t out_max_read;     /**< Highest out read. */
+	/** Per-lcore usage statistics. */
+	struct rte_mempool_lcore_stats lcore_stats[RTE_MAX_LCORE];
+
 #ifdef RTE_LIBRTE_MEMPOOL_DEBUG
 	/** Per-lcore statistics. */
 	struct rte_mempool_debug_stats stats[RTE_MAX_LCORE];
@@ -288,6 +358,45 @@ struct rte_mempool {
 #define __MEMPOOL_STAT_ADD(mp, name, n) do {} while(0)
 #endif
 
+/**
+ * @internal Update the always-on statistics.
+ *
+ * @param mp
+ *   A pointer to the mempool structure.
+ * @param name
+ *   Name of the statistics field to increment in the memory pool.
+ * @param n
+ *   Number to add to the object-oriented statistics.
+ */
+#define __MEMPOOL_LCORE_STAT_ADD(mp, name, n) do {			\
+		unsigned __lcore_id = rte_lcore_id();			\
+		if (__lcore_id < RTE_MAX_LCORE) {			\
+			mp->lcore_stats[__lcore_id].name##_objs += n;	\
+			mp->lcore_stats[__lcore_id].name##_bulk += 1;	\
+		}							\
+	} while (0)
+
+/**
+ * @internal Account objects leaving (n > 0) or entering (n < 0) the
+ * common pool. The counters are per lcore, only the non-EAL threads
+ * share an atomic counter.
+ *
+ * @param mp
+ *   A pointer to the mempool structure.
+ * @param n
+ *   Number of objects leaving the common pool.
+ */
+static inline void __attribute__((always_inline))
+__mempool_out_add(struct rte_mempool *mp, int64_t n)
+{
+	unsigned lcore_id = rte_lcore_id();
+
+	if (lcore_id < RTE_MAX_LCORE)
+		mp->lcore_stats[lcore_id].out += n;
+	else
+		rte_atomic64_add(&mp->out, n);
+}
+
 /**
  * Calculate the size of the mempool header.
  *
@@ -959,6 +1068,42 @@ uint32_t rte_mempool_mem_iter(struct rte_mempool *mp,
  */
 void rte_mempool_dump(FILE *f, struct rte_mempool *mp);
 
+/**
+ * Retrieve the usage statistics of a mempool.
+ *
+ * These statistics are always enabled. The per-lcore counters are summed
+ * over all lcores; they are updated when objects are got from or put
+ * back to the common pool, not when a cache is used. The accesses from
+ * non-EAL threads are not counted per lcore but are accounted for in
+ * the number of objects out of the common pool. This number is not
+ * tracked on each update: its maximum, out_max_read, is only updated by
+ * this function, so it is the highest number seen when reading the
+ * statistics, and the peaks between two reads are missed.
+ *
+ * @param mp
+ *   A pointer to the mempool structure.
+ * @param stats
+ *   A pointer to a structure to be filled with the statistics.
+ * @return
+ *   - 0: Success.
+ *   - -EINVAL: A parameter is NULL.
+ */
+int
+rte_mempool_stats_get(struct rte_mempool *mp,
+	struct rte_mempool_stats *stats);
+
+/**
+ * Reset the usage statistics of a mempool.
+ *
+ * The per-lcore counters are cleared and out_max_read is set to
+ * the current number of objects out of the common pool.
+ *
+ * @param mp
+ *   A pointer to the mempool structure.
+ */
+void
+rte_mempool_stats_reset(struct rte_mempool *mp);
+
 /**
  * Create a user-owned mempool cache.
  *
@@ -979,6 +1124,9 @@ rte_mempool_cache_create(uint32_t size, int socket_id);
 /**
  * Free a user-owned mempool cache.
  *
+ * If the cache was attached with rte_mempool_cache_attach(), it must be
+ * detached first.
+ *
  * @param cache
  *   A pointer to the mempool cache.
  */
@@ -997,27 +1145,107 @@ static inline void __attribute__((always_inline))
 rte_mempool_cache_flush(struct rte_mempool_cache *cache,
 			struct rte_mempool *mp)
 {
+	if (cache->len == 0)
+		return;
+
+	__MEMPOOL_LCORE_STAT_ADD(mp, flush, cache->len);
+	__mempool_out_add(mp, -(int64_t)cache->len);
 	rte_mempool_ops_enqueue_bulk(mp, cache->objs, cache->len);
 	cache->len = 0;
 }
 
 /**
- * Get a pointer to the per-lcore default mempool cache.
+ * Attach a user-owned mempool cache to the calling thread.
+ *
+ * The cache is registered in the mempool, so that the objects it holds
+ * are accounted for by rte_mempool_avail_count() and rte_mempool_dump().
+ * When the calling thread is a non-EAL thread, the cache also becomes its
+ * default cache for this mempool: it is returned by
+ * rte_mempool_default_cache() and used by rte_mempool_get() and
+ * rte_mempool_put(). EAL threads keep using their per-lcore cache.
+ *
+ * A thread can have at most RTE_MEMPOOL_THREAD_CACHE_MAX attached caches,
+ * one per mempool.
+ *
+ * @param mp
+ *   A pointer to the mempool structure.
+ * @param cache
+ *   A pointer to a cache created with rte_mempool_cache_create(), not
+ *   attached to any mempool.
+ * @return
+ *   - 0: Success.
+ *   - -EINVAL: A parameter is invalid or the cache is already attached.
+ *   - -EEXIST: The thread already has a cache attached to this mempool.
+ *   - -ENOSPC: The thread has too many attached caches.
+ */
+int
+rte_mempool_cache_attach(struct rte_mempool *mp,
+	struct rte_mempool_cache *cache);
+
+/**
+ * Detach a user-owned mempool cache from the calling thread.
+ *
+ * It must be called by the thread that attached the cache, before the
+ * mempool is freed. The objects held in the cache are not flushed: this
+ * should be done with rte_mempool_cache_flush() before detaching it.
+ *
+ * @param mp
+ *   A pointer to the mempool structure.
+ * @param cache
+ *   A pointer to the mempool cache attached with rte_mempool_cache_attach().
+ * @return
+ *   - 0: Success.
+ *   - -EINVAL: The cache is not attached to this mempool by this thread.
+ */
+int
+rte_mempool_cache_detach(struct rte_mempool *mp,
+	struct rte_mempool_cache *cache);
+
+/**
+ * @internal Get the user-owned cache attached to the running thread for
+ * a mempool.
+ *
+ * @param mp
+ *   A pointer to the mempool structure.
+ * @return
+ *   A pointer to the mempool cache or NULL if none is attached.
+ */
+static inline struct rte_mempool_cache *__attribute__((always_inline))
+__mempool_thread_cache(const struct rte_mempool *mp)
+{
+	struct rte_mempool_cache *cache;
+	unsigned i;
+
+	for (i = 0; i < RTE_MEMPOOL_THREAD_CACHE_MAX; i++) {
+		cache = RTE_PER_LCORE(_mempool_thread_cache)[i];
+		if (cache != NULL && cache->mp == mp)
+			return cache;
+	}
+
+	return NULL;
+}
+
+/**
+ * Get a pointer to the default mempool cache.
+ *
+ * This is the per-lcore cache for an EAL thread, or the cache attached
+ * with rte_mempool_cache_attach() for a non-EAL thread.
  *
  * @param mp
  *   A pointer to the mempool structure.
  * @param lcore_id
  *   The logical core id.
  * @return
- *   A pointer to the mempool cache or NULL if disabled or non-EAL thread.
+ *   A pointer to the mempool cache or NULL if disabled or non-EAL thread
+ *   without attached cache.
  */
 static inline struct rte_mempool_cache *__attribute__((always_inline))
 rte_mempool_default_cache(struct rte_mempool *mp, unsigned lcore_id)
 {
-	if (mp->cache_size == 0)
-		return NULL;
-
 	if (lcore_id >= RTE_MAX_LCORE)
+		return __mempool_thread_cache(mp);
+
+	if (mp->cache_size == 0)
 		return NULL;
 
 	return &mp->local_cache[lcore_id];
@@ -1066,14 +1294,18 @@ __mempool_generic_put(struct rte_mempool *mp, void * const *obj_table,
 	cache->len += n;
 
 	if (cache->len >= cache->flushthresh) {
-		rte_mempool_ops_enqueue_bulk(mp, &cache->objs[cache->size],
-				cache->len - cache->size);
+		n = cache->len - cache->size;
+		__MEMPOOL_LCORE_STAT_ADD(mp, flush, n);
+		__mempool_out_add(mp, -(int64_t)n);
+		rte_mempool_ops_enqueue_bulk(mp, &cache->objs[cache->size], n);
 		cache->len = cache->size;
 	}
 
 	return;
 
 ring_enqueue:
+	__MEMPOOL_LCORE_STAT_ADD(mp, flush, n);
+	__mempool_out_add(mp, -(int64_t)n);
 
 	/* push remaining objects in ring */
 #ifdef RTE_LIBRTE_MEMPOOL_DEBUG
@@ -1199,6 +1431,8 @@ __mempool_generic_get(struct rte_mempool *mp, void **obj_table,
 			goto ring_dequeue;
 		}
 
+		__MEMPOOL_LCORE_STAT_ADD(mp, refill, req);
+		__mempool_out_add(mp, req);
 		cache->len += req;
 	}
 
@@ -1217,10 +1451,14 @@ __mempool_generic_get(struct rte_mempool *mp, void **obj_table,
 	/* get remaining objects from ring */
 	ret = rte_mempool_ops_dequeue_bulk(mp, obj_table, n);
 
-	if (ret < 0)
+	if (ret < 0) {
 		__MEMPOOL_STAT_ADD(mp, get_fail, n);
-	else
+		__MEMPOOL_LCORE_STAT_ADD(mp, get_fail, n);
+	} else {
 		__MEMPOOL_STAT_ADD(mp, get_success, n);
+		__MEMPOOL_LCORE_STAT_ADD(mp, refill, n);
+		__mempool_out_add(mp, n);
+	}
 
 	return ret;
 }
@@ -0,0 +1,100 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <errno.h>
+
+#include <rte_common.h>
+#include <rte_mempool.h>
+#include <rte_metrics.h>
+
+#include "rte_mempoolstats.h"
+
+static const char * const mempoolstats_names[] = {
+	"in_use", "out", "out_max_read",
+	"refill_bulk", "refill_objs",
+	"flush_bulk", "flush_objs",
+	"get_fail_bulk", "get_fail_objs",
+};
+
+#define NUM_MEMPOOLSTATS RTE_DIM(mempoolstats_names)
+
+int
+rte_mempoolstats_reg(const struct rte_mempool *mp)
+{
+	char names[NUM_MEMPOOLSTATS][RTE_METRICS_MAX_NAME_LEN];
+	const char *names_ptr[NUM_MEMPOOLSTATS];
+	unsigned int i;
+	int ret;
+
+	if (mp == NULL)
+		return -EINVAL;
+
+	for (i = 0; i < NUM_MEMPOOLSTATS; i++) {
+		ret = snprintf(names[i], sizeof(names[i]), "%s_%s",
+			mp->name, mempoolstats_names[i]);
+		if (ret < 0 || ret >= (int)sizeof(names[i]))
+			return -ENAMETOOLONG;
+		names_ptr[i] = names[i];
+	}
+
+	return rte_metrics_reg_names(names_ptr, NUM_MEMPOOLSTATS);
+}
+
+int
+rte_mempoolstats_update(struct rte_mempool *mp, int key)
+{
+	struct rte_mempool_stats stats;
+	uint64_t values[NUM_MEMPOOLSTATS];
+	int ret;
+
+	if (key < 0)
+		return -EINVAL;
+
+	ret = rte_mempool_stats_get(mp, &stats);
+	if (ret < 0)
+		return ret;
+
+	values[0] = stats.in_use;
+	values[1] = stats.out;
+	values[2] = stats.out_max_read;
+	values[3] = stats.refill_bulk;
+	values[4] = stats.refill_objs;
+	values[5] = stats.flush_bulk;
+	values[6] = stats.flush_objs;
+	values[7] = stats.get_fail_bulk;
+	values[8] = stats.get_fail_objs;
+
+	return rte_metrics_update_values(RTE_METRICS_GLOBAL, key, values,
+		NUM_MEMPOOLSTATS);
+}
@@ -0,0 +1,84 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _RTE_MEMPOOLSTATS_H_
+#define _RTE_MEMPOOLSTATS_H_
+
+/**
+ * @file
+ * RTE mempool statistics
+ *
+ * Export the usage statistics of a mempool, as returned by
+ * rte_mempool_stats_get(), through the metrics library.
+ */
+
+#include <rte_mempool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Register the usage statistics of a mempool with the metrics library.
+ *
+ * The metrics are global and named after the mempool, for instance
+ * "<name>_out_max_read".
+ *
+ * @param mp
+ *   A pointer to the mempool structure.
+ *
+ * @return
+ *   - Key of the first registered metric on success
+ *   - Negative on error
+ */
+int rte_mempoolstats_reg(const struct rte_mempool *mp);
+
+/**
+ * Update the metrics of a mempool with its current usage statistics.
+ *
+ * @param mp
+ *   A pointer to the mempool structure.
+ * @param key
+ *   Key returned by rte_mempoolstats_reg() for this mempool.
+ *
+ * @return
+ *   - Zero on success
+ *   - Negative on error
+ */
+int rte_mempoolstats_update(struct rte_mempool *mp, int key);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RTE_MEMPOOLSTATS_H_ */
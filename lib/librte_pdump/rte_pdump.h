@@ -66,11 +66,11 @@ enum rte_pdump_socktype {
 /**
  * Initialize packet capturing handling
  *
- * Creates pthread and server socket for handling clients
- * requests to enable/disable rxtx callbacks.
+ * Registers the action of the EAL multi-process channel handling the
+ * requests of the secondary processes to enable/disable rxtx callbacks.
  *
  * @param path
- * directory path for server socket.
+ * unused, kept for compatibility.
  *
  * @return
  *    0 on success, -1 on error
@@ -81,7 +81,7 @@ rte_pdump_init(const char *path);
 /**
  * Un initialize packet capturing handling
  *
- * Cancels pthread, close server socket, removes server socket address.
+ * Unregisters the action of the EAL multi-process channel.
  *
  * @return
  *    0 on success, -1 on error
@@ -192,12 +192,9 @@ rte_pdump_disable_by_deviceid(char *device_id, uint16_t queue,
 				uint32_t flags);
 
 /**
- * Allows applications to set server and client socket paths.
- * If specified path is null default path will be selected, i.e.
- *"/var/run/" for root user and "$HOME" for non root user.
- * Clients also need to call this API to set their server path if the
- * server path is different from default path.
- * This API is not thread-safe.
+ * Does nothing, kept for compatibility.
+ * The requests go through the EAL multi-process channel, whose sockets
+ * are named after the EAL file prefix (--file-prefix).
  *
  * @param path
  * directory path for server or client socket.
@@ -207,7 +204,7 @@ rte_pdump_disable_by_deviceid(char *device_id, uint16_t queue,
  * specifies RTE_PDUMP_SOCKET_CLIENT if socket path is for client.
  *
  * @return
- * 0 on success, -EINVAL on error
+ * 0
  *
  */
 int
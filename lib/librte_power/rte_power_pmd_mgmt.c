@@ -0,0 +1,354 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_errno.h>
+#include <rte_ethdev.h>
+#include <rte_interrupts.h>
+#include <rte_lcore.h>
+#include <rte_log.h>
+#include <rte_malloc.h>
+
+#include "rte_power_pmd_mgmt.h"
+
+#define PMD_MGMT_DEFAULT_PAUSE_THRESHOLD 16
+#define PMD_MGMT_DEFAULT_PAUSE_US 1
+#define PMD_MGMT_DEFAULT_SLEEP_THRESHOLD 256
+#define PMD_MGMT_DEFAULT_SLEEP_US 10
+#define PMD_MGMT_DEFAULT_INTR_THRESHOLD 1024
+#define PMD_MGMT_DEFAULT_INTR_TIMEOUT_MS 10
+
+static const struct rte_power_pmd_mgmt_conf pmd_mgmt_default_conf = {
+	.pause_threshold = PMD_MGMT_DEFAULT_PAUSE_THRESHOLD,
+	.pause_us = PMD_MGMT_DEFAULT_PAUSE_US,
+	.sleep_threshold = PMD_MGMT_DEFAULT_SLEEP_THRESHOLD,
+	.sleep_us = PMD_MGMT_DEFAULT_SLEEP_US,
+	.intr_threshold = PMD_MGMT_DEFAULT_INTR_THRESHOLD,
+	.intr_timeout_ms = PMD_MGMT_DEFAULT_INTR_TIMEOUT_MS,
+};
+
+enum pmd_mgmt_intr_state {
+	PMD_MGMT_INTR_UNSET = 0, /**< queues not registered for wait yet */
+	PMD_MGMT_INTR_READY,     /**< all queues registered on the lcore */
+	PMD_MGMT_INTR_UNSUPPORTED, /**< some queue has no Rx interrupt */
+};
+
+struct pmd_mgmt_queue {
+	uint8_t port_id;
+	uint16_t queue_id;
+	int intr_added; /**< registered on the lcore epoll instance */
+	struct rte_eth_rxtx_callback *cb;
+};
+
+struct pmd_mgmt_lcore {
+	uint64_t empty_polls;   /**< consecutive empty polls */
+	unsigned int nb_queues;
+	enum pmd_mgmt_intr_state intr_state;
+	struct rte_power_pmd_mgmt_conf conf;
+	uint64_t pause_cycles;
+	struct timespec sleep_ts;
+	struct rte_power_pmd_mgmt_stats stats;
+	struct pmd_mgmt_queue queues[RTE_POWER_PMD_MGMT_MAX_QUEUES];
+} __rte_cache_aligned;
+
+static struct pmd_mgmt_lcore pmd_mgmt_lcores[RTE_MAX_LCORE];
+
+static void
+pmd_mgmt_intr_del(struct pmd_mgmt_queue *q)
+{
+	if (!q->intr_added)
+		return;
+	rte_eth_dev_rx_intr_ctl_q(q->port_id, q->queue_id,
+			RTE_EPOLL_PER_THREAD, RTE_INTR_EVENT_DEL, NULL);
+	q->intr_added = 0;
+}
+
+/* register every queue of the lcore on the epoll instance of the caller */
+static int
+pmd_mgmt_intr_setup(struct pmd_mgmt_lcore *lc)
+{
+	struct pmd_mgmt_queue *q;
+	unsigned int i;
+
+	for (i = 0; i < lc->nb_queues; i++) {
+		q = &lc->queues[i];
+		if (q->intr_added)
+			continue;
+		if (rte_eth_dev_rx_intr_ctl_q(q->port_id, q->queue_id,
+				RTE_EPOLL_PER_THREAD, RTE_INTR_EVENT_ADD,
+				NULL) < 0)
+			goto unsupported;
+		q->intr_added = 1;
+	}
+	lc->intr_state = PMD_MGMT_INTR_READY;
+	return 0;
+
+unsupported:
+	RTE_LOG(INFO, POWER,
+		"Port %u queue %u has no Rx interrupt, lcore %u will not "
+		"wait for interrupts\n", q->port_id, q->queue_id,
+		rte_lcore_id());
+	for (i = 0; i < lc->nb_queues; i++)
+		pmd_mgmt_intr_del(&lc->queues[i]);
+	lc->intr_state = PMD_MGMT_INTR_UNSUPPORTED;
+	return -ENOTSUP;
+}
+
+static int
+pmd_mgmt_intr_wait(struct pmd_mgmt_lcore *lc)
+{
+	struct rte_epoll_event ev[RTE_POWER_PMD_MGMT_MAX_QUEUES];
+	struct pmd_mgmt_queue *q;
+	unsigned int i, j;
+	int n;
+
+	if (lc->intr_state == PMD_MGMT_INTR_UNSUPPORTED)
+		return -ENOTSUP;
+	if (lc->intr_state == PMD_MGMT_INTR_UNSET &&
+	    pmd_mgmt_intr_setup(lc) < 0)
+		return -ENOTSUP;
+
+	for (i = 0; i < lc->nb_queues; i++) {
+		q = &lc->queues[i];
+		if (rte_eth_dev_rx_intr_enable(q->port_id, q->queue_id) < 0)
+			goto unsupported;
+	}
+
+	n = rte_epoll_wait(RTE_EPOLL_PER_THREAD, ev, lc->nb_queues,
+			lc->conf.intr_timeout_ms);
+	if (n > 0)
+		lc->stats.intr_wakeups++;
+
+	for (i = 0; i < lc->nb_queues; i++) {
+		q = &lc->queues[i];
+		rte_eth_dev_rx_intr_disable(q->port_id, q->queue_id);
+	}
+	return 0;
+
+unsupported:
+	RTE_LOG(INFO, POWER,
+		"Port %u queue %u cannot enable Rx interrupt, lcore %u will "
+		"not wait for interrupts\n", q->port_id, q->queue_id,
+		rte_lcore_id());
+	for (j = 0; j < i; j++)
+		rte_eth_dev_rx_intr_disable(lc->queues[j].port_id,
+				lc->queues[j].queue_id);
+	for (j = 0; j < lc->nb_queues; j++)
+		pmd_mgmt_intr_del(&lc->queues[j]);
+	lc->intr_state = PMD_MGMT_INTR_UNSUPPORTED;
+	return -ENOTSUP;
+}
+
+static void
+pmd_mgmt_idle(struct pmd_mgmt_lcore *lc, uint64_t rounds)
+{
+	const struct rte_power_pmd_mgmt_conf *conf = &lc->conf;
+	uint64_t start = rte_rdtsc();
+
+	if (conf->intr_threshold != 0 && rounds >= conf->intr_threshold &&
+	    pmd_mgmt_intr_wait(lc) == 0) {
+		lc->stats.intr_waits++;
+	} else if (conf->sleep_threshold != 0 &&
+		   rounds >= conf->sleep_threshold) {
+		nanosleep(&lc->sleep_ts, NULL);
+		lc->stats.sleeps++;
+	} else if (conf->pause_threshold != 0 &&
+		   rounds >= conf->pause_threshold) {
+		while (rte_rdtsc() - start < lc->pause_cycles)
+			rte_pause();
+		lc->stats.pauses++;
+	} else {
+		return;
+	}
+
+	lc->stats.idle_cycles += rte_rdtsc() - start;
+}
+
+static uint16_t
+pmd_mgmt_rx_cb(uint8_t port_id __rte_unused, uint16_t queue_id __rte_unused,
+	       struct rte_mbuf **pkts __rte_unused, uint16_t nb_rx,
+	       uint16_t max_pkts __rte_unused, void *user_param)
+{
+	struct pmd_mgmt_lcore *lc = user_param;
+
+	lc->stats.polls++;
+	if (likely(nb_rx != 0)) {
+		lc->empty_polls = 0;
+		return nb_rx;
+	}
+
+	lc->stats.empty_polls++;
+	/* only idle once every queue of the lcore came back empty */
+	if (++lc->empty_polls % lc->nb_queues == 0)
+		pmd_mgmt_idle(lc, lc->empty_polls / lc->nb_queues);
+
+	return 0;
+}
+
+static int
+pmd_mgmt_conf_check(const struct rte_power_pmd_mgmt_conf *conf)
+{
+	if ((conf->pause_threshold != 0 && conf->pause_us == 0) ||
+	    (conf->sleep_threshold != 0 && conf->sleep_us == 0) ||
+	    (conf->intr_threshold != 0 && conf->intr_timeout_ms == 0) ||
+	    conf->intr_timeout_ms > INT32_MAX)
+		return -EINVAL;
+	return 0;
+}
+
+static void
+pmd_mgmt_conf_apply(struct pmd_mgmt_lcore *lc,
+		const struct rte_power_pmd_mgmt_conf *conf)
+{
+	lc->conf = *conf;
+	lc->pause_cycles = rte_get_tsc_hz() * conf->pause_us / US_PER_S;
+	lc->sleep_ts.tv_sec = conf->sleep_us / US_PER_S;
+	lc->sleep_ts.tv_nsec = (conf->sleep_us % US_PER_S) * 1000;
+}
+
+static struct pmd_mgmt_queue *
+pmd_mgmt_queue_find(struct pmd_mgmt_lcore *lc, uint8_t port_id,
+		uint16_t queue_id)
+{
+	unsigned int i;
+
+	for (i = 0; i < lc->nb_queues; i++)
+		if (lc->queues[i].port_id == port_id &&
+		    lc->queues[i].queue_id == queue_id)
+			return &lc->queues[i];
+	return NULL;
+}
+
+int
+rte_power_pmd_mgmt_queue_enable(unsigned int lcore_id, uint8_t port_id,
+		uint16_t queue_id, const struct rte_power_pmd_mgmt_conf *conf)
+{
+	struct pmd_mgmt_lcore *lc;
+	struct pmd_mgmt_queue *q;
+	void *cb;
+
+	if (lcore_id >= RTE_MAX_LCORE || !rte_eth_dev_is_valid_port(port_id))
+		return -EINVAL;
+	if (conf == NULL)
+		conf = &pmd_mgmt_default_conf;
+	if (pmd_mgmt_conf_check(conf) < 0) {
+		RTE_LOG(ERR, POWER, "Invalid PMD idle policy for lcore %u\n",
+			lcore_id);
+		return -EINVAL;
+	}
+
+	lc = &pmd_mgmt_lcores[lcore_id];
+	if (pmd_mgmt_queue_find(lc, port_id, queue_id) != NULL)
+		return -EEXIST;
+	if (lc->nb_queues == RTE_POWER_PMD_MGMT_MAX_QUEUES)
+		return -ENOSPC;
+
+	pmd_mgmt_conf_apply(lc, conf);
+
+	cb = rte_eth_add_rx_callback(port_id, queue_id, pmd_mgmt_rx_cb, lc);
+	if (cb == NULL) {
+		RTE_LOG(ERR, POWER,
+			"Cannot add Rx callback on port %u queue %u: %s\n",
+			port_id, queue_id, rte_strerror(rte_errno));
+		return -rte_errno;
+	}
+
+	q = &lc->queues[lc->nb_queues++];
+	q->port_id = port_id;
+	q->queue_id = queue_id;
+	q->intr_added = 0;
+	q->cb = cb;
+
+	lc->empty_polls = 0;
+	lc->intr_state = PMD_MGMT_INTR_UNSET;
+
+	return 0;
+}
+
+int
+rte_power_pmd_mgmt_queue_disable(unsigned int lcore_id, uint8_t port_id,
+		uint16_t queue_id)
+{
+	struct pmd_mgmt_lcore *lc;
+	struct pmd_mgmt_queue *q;
+	int ret;
+
+	if (lcore_id >= RTE_MAX_LCORE)
+		return -EINVAL;
+
+	lc = &pmd_mgmt_lcores[lcore_id];
+	q = pmd_mgmt_queue_find(lc, port_id, queue_id);
+	if (q == NULL)
+		return -ENOENT;
+
+	ret = rte_eth_remove_rx_callback(port_id, queue_id, q->cb);
+	if (ret < 0)
+		return ret;
+	/* the lcore is not polling, nothing can still run the callback */
+	rte_free(q->cb);
+	pmd_mgmt_intr_del(q);
+
+	*q = lc->queues[--lc->nb_queues];
+	lc->empty_polls = 0;
+	/* the remaining queues may all support interrupts now */
+	lc->intr_state = PMD_MGMT_INTR_UNSET;
+
+	return 0;
+}
+
+int
+rte_power_pmd_mgmt_stats_get(unsigned int lcore_id,
+		struct rte_power_pmd_mgmt_stats *stats)
+{
+	if (lcore_id >= RTE_MAX_LCORE || stats == NULL)
+		return -EINVAL;
+
+	*stats = pmd_mgmt_lcores[lcore_id].stats;
+	return 0;
+}
+
+int
+rte_power_pmd_mgmt_stats_reset(unsigned int lcore_id)
+{
+	if (lcore_id >= RTE_MAX_LCORE)
+		return -EINVAL;
+
+	memset(&pmd_mgmt_lcores[lcore_id].stats, 0,
+		sizeof(struct rte_power_pmd_mgmt_stats));
+	return 0;
+}
@@ -0,0 +1,166 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _RTE_POWER_PMD_MGMT_H
+#define _RTE_POWER_PMD_MGMT_H
+
+/**
+ * @file
+ * RTE PMD Power Management
+ *
+ * Idle policy for lcores busy-polling ethdev Rx queues. The library hooks
+ * the Rx queues of an lcore with an Rx callback and counts the rounds in
+ * which every queue of the lcore came back empty. As the streak grows the
+ * lcore escalates from spinning on pause instructions, to short sleeps, to
+ * blocking on the Rx interrupts of its queues. Any received packet resets
+ * the streak and the lcore goes back to plain polling.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Maximum number of Rx queues managed on a single lcore. */
+#define RTE_POWER_PMD_MGMT_MAX_QUEUES 32
+
+/**
+ * Idle policy of an lcore. Thresholds are counted in empty rounds, a round
+ * being one poll of every managed queue of the lcore. A threshold of 0
+ * disables the corresponding stage; the highest enabled stage whose
+ * threshold has been reached is used.
+ */
+struct rte_power_pmd_mgmt_conf {
+	uint32_t pause_threshold; /**< Empty rounds before pausing. */
+	uint32_t pause_us;        /**< Time spent in pause per round. */
+	uint32_t sleep_threshold; /**< Empty rounds before sleeping. */
+	uint32_t sleep_us;        /**< Time slept per round. */
+	uint32_t intr_threshold;  /**< Empty rounds before waiting for intr. */
+	uint32_t intr_timeout_ms; /**< Upper bound of an intr wait. */
+};
+
+/** Idle statistics of an lcore. */
+struct rte_power_pmd_mgmt_stats {
+	uint64_t polls;        /**< Rx bursts on the managed queues. */
+	uint64_t empty_polls;  /**< Rx bursts that returned no packet. */
+	uint64_t pauses;       /**< Rounds idled with pause instructions. */
+	uint64_t sleeps;       /**< Rounds idled with a sleep. */
+	uint64_t intr_waits;   /**< Rounds idled waiting for Rx interrupts. */
+	uint64_t intr_wakeups; /**< Interrupt waits ended by an Rx event. */
+	uint64_t idle_cycles;  /**< TSC cycles spent idling. */
+};
+
+/**
+ * Put an Rx queue under the idle policy of an lcore.
+ *
+ * The queue must be polled by the given lcore only, and the lcore must not
+ * be polling while this function is called. The interrupt stage is only
+ * used when every queue of the lcore supports Rx interrupts, i.e. its port
+ * was configured with intr_conf.rxq set; otherwise the lcore stops at the
+ * sleep stage.
+ *
+ * @param lcore_id
+ *  lcore polling the queue.
+ * @param port_id
+ *  Port identifier of the Ethernet device.
+ * @param queue_id
+ *  Rx queue index.
+ * @param conf
+ *  Idle policy of the lcore, replacing any previous one. NULL selects the
+ *  default policy.
+ *
+ * @return
+ *  - 0 on success.
+ *  - -EINVAL on invalid parameters.
+ *  - -EEXIST if the queue is already managed.
+ *  - -ENOSPC if the lcore already manages RTE_POWER_PMD_MGMT_MAX_QUEUES.
+ *  - Other negative values if the Rx callback could not be installed.
+ */
+int rte_power_pmd_mgmt_queue_enable(unsigned int lcore_id, uint8_t port_id,
+		uint16_t queue_id, const struct rte_power_pmd_mgmt_conf *conf);
+
+/**
+ * Release an Rx queue from the idle policy of an lcore.
+ *
+ * The lcore must not be polling while this function is called.
+ *
+ * @param lcore_id
+ *  lcore polling the queue.
+ * @param port_id
+ *  Port identifier of the Ethernet device.
+ * @param queue_id
+ *  Rx queue index.
+ *
+ * @return
+ *  - 0 on success.
+ *  - -EINVAL on invalid parameters.
+ *  - -ENOENT if the queue is not managed by the lcore.
+ */
+int rte_power_pmd_mgmt_queue_disable(unsigned int lcore_id, uint8_t port_id,
+		uint16_t queue_id);
+
+/**
+ * Retrieve the idle statistics of an lcore. The counters are updated by
+ * the polling lcore without synchronization, a snapshot taken from another
+ * lcore may be slightly out of date.
+ *
+ * @param lcore_id
+ *  lcore to query.
+ * @param stats
+ *  Structure filled with the statistics.
+ *
+ * @return
+ *  - 0 on success.
+ *  - -EINVAL on invalid parameters.
+ */
+int rte_power_pmd_mgmt_stats_get(unsigned int lcore_id,
+		struct rte_power_pmd_mgmt_stats *stats);
+
+/**
+ * Reset the idle statistics of an lcore.
+ *
+ * @param lcore_id
+ *  lcore to reset.
+ *
+ * @return
+ *  - 0 on success.
+ *  - -EINVAL on invalid parameters.
+ */
+int rte_power_pmd_mgmt_stats_reset(unsigned int lcore_id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,347 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <errno.h>
+
+#include <rte_common.h>
+#include <rte_eal.h>
+#include <rte_log.h>
+#include <rte_memory.h>
+#include <rte_malloc.h>
+#include <rte_errno.h>
+
+#include "rte_rcu_qsbr.h"
+
+static int rcu_logtype;
+
+#define RCU_LOG(level, fmt, args...) \
+	rte_log(RTE_LOG_ ## level, rcu_logtype, "%s(): " fmt "\n", \
+		__func__, ##args)
+
+/* Defer queue entry: grace period token followed by the element */
+struct rcu_qsbr_dq_entry {
+	uint64_t token;
+	uint8_t elem[0] __rte_aligned(8);
+};
+
+struct rte_rcu_qsbr_dq {
+	char name[RTE_RCU_QSBR_DQ_NAMESIZE];
+	struct rte_rcu_qsbr *v;
+	uint32_t size;          /* Number of entries, power of 2 */
+	uint32_t mask;
+	uint32_t esize;         /* Element size given at creation */
+	uint32_t entry_size;    /* Entry size, token included */
+	uint32_t head;          /* Next entry to enqueue */
+	uint32_t tail;          /* Oldest entry */
+	uint32_t trigger_reclaim_limit;
+	uint32_t max_reclaim_size;
+	rte_rcu_qsbr_free_resource_t free_fn;
+	void *p;
+	uint8_t entries[0] __rte_cache_aligned;
+};
+
+size_t
+rte_rcu_qsbr_get_memsize(uint32_t max_threads)
+{
+	if (max_threads == 0) {
+		RCU_LOG(ERR, "Invalid max_threads %u", max_threads);
+		rte_errno = EINVAL;
+		return 0;
+	}
+
+	return sizeof(struct rte_rcu_qsbr) +
+		sizeof(struct rte_rcu_qsbr_cnt) * max_threads +
+		__RTE_QSBR_THRID_ARRAY_SIZE(max_threads);
+}
+
+int
+rte_rcu_qsbr_init(struct rte_rcu_qsbr *v, uint32_t max_threads)
+{
+	size_t sz;
+
+	if (v == NULL) {
+		RCU_LOG(ERR, "Invalid QS variable");
+		return -EINVAL;
+	}
+
+	sz = rte_rcu_qsbr_get_memsize(max_threads);
+	if (sz == 0)
+		return -EINVAL;
+
+	/* All the reader threads start offline and unregistered */
+	memset(v, 0, sz);
+	v->max_threads = max_threads;
+	v->num_elems = RTE_ALIGN_CEIL(max_threads,
+			__RTE_QSBR_THRID_ARRAY_ELM_SIZE) /
+			__RTE_QSBR_THRID_ARRAY_ELM_SIZE;
+	rte_atomic64_set(&v->token, RTE_QSBR_CNT_INIT);
+	v->acked_token = RTE_QSBR_CNT_INIT - 1;
+	rte_atomic32_init(&v->num_threads);
+
+	return 0;
+}
+
+/* Set or clear the bit of a thread in the registered thread bitmap */
+static int
+rcu_qsbr_thread_set(struct rte_rcu_qsbr *v, unsigned int thread_id,
+	int reg)
+{
+	volatile uint64_t *elm;
+	uint64_t bit, old;
+
+	if (v == NULL || thread_id >= v->max_threads) {
+		RCU_LOG(ERR, "Invalid QS variable or thread ID %u", thread_id);
+		return -EINVAL;
+	}
+
+	elm = __RTE_QSBR_THRID_ARRAY_ELM(v,
+			thread_id >> __RTE_QSBR_THRID_INDEX_SHIFT);
+	bit = 1ULL << (thread_id & __RTE_QSBR_THRID_MASK);
+
+	/* Other threads may update the same bitmap word concurrently */
+	do {
+		old = *elm;
+		if (!!(old & bit) == reg)
+			return 0;
+	} while (rte_atomic64_cmpset(elm, old,
+			reg ? old | bit : old & ~bit) == 0);
+
+	if (reg)
+		rte_atomic32_inc(&v->num_threads);
+	else
+		rte_atomic32_dec(&v->num_threads);
+
+	return 0;
+}
+
+int
+rte_rcu_qsbr_thread_register(struct rte_rcu_qsbr *v, unsigned int thread_id)
+{
+	return rcu_qsbr_thread_set(v, thread_id, 1);
+}
+
+int
+rte_rcu_qsbr_thread_unregister(struct rte_rcu_qsbr *v, unsigned int thread_id)
+{
+	return rcu_qsbr_thread_set(v, thread_id, 0);
+}
+
+void
+rte_rcu_qsbr_synchronize(struct rte_rcu_qsbr *v, unsigned int thread_id)
+{
+	uint64_t t;
+
+	RTE_ASSERT(v != NULL);
+
+	t = rte_rcu_qsbr_start(v);
+
+	/* A reader waiting for itself would never see its quiescent state */
+	if (thread_id != RTE_QSBR_THRID_INVALID)
+		rte_rcu_qsbr_quiescent(v, thread_id);
+
+	rte_rcu_qsbr_check(v, t, true);
+}
+
+int
+rte_rcu_qsbr_dump(FILE *f, struct rte_rcu_qsbr *v)
+{
+	volatile uint64_t *elm;
+	uint64_t bmap;
+	uint32_t i, j;
+
+	if (f == NULL || v == NULL)
+		return -EINVAL;
+
+	fprintf(f, "QS variable at %p\n", v);
+	fprintf(f, "  max threads = %u\n", v->max_threads);
+	fprintf(f, "  registered threads = %d\n",
+		rte_atomic32_read(&v->num_threads));
+	fprintf(f, "  token = %"PRIu64"\n", rte_atomic64_read(&v->token));
+	fprintf(f, "  acked token = %"PRIu64"\n", v->acked_token);
+
+	fprintf(f, "  quiescent state counters:\n");
+	for (i = 0; i < v->num_elems; i++) {
+		elm = __RTE_QSBR_THRID_ARRAY_ELM(v, i);
+		bmap = *elm;
+		while (bmap) {
+			j = __builtin_ctzll(bmap);
+			fprintf(f, "    thread %u: %"PRIu64"\n",
+				(i << __RTE_QSBR_THRID_INDEX_SHIFT) + j,
+				v->qsbr_cnt[(i << __RTE_QSBR_THRID_INDEX_SHIFT)
+					+ j].cnt);
+			bmap &= ~(1ULL << j);
+		}
+	}
+
+	return 0;
+}
+
+struct rte_rcu_qsbr_dq *
+rte_rcu_qsbr_dq_create(const struct rte_rcu_qsbr_dq_parameters *params)
+{
+	struct rte_rcu_qsbr_dq *dq;
+	uint32_t size, entry_size;
+
+	if (params == NULL || params->v == NULL || params->free_fn == NULL ||
+			params->size == 0 || params->esize == 0 ||
+			params->trigger_reclaim_limit > params->size ||
+			params->max_reclaim_size == 0) {
+		RCU_LOG(ERR, "Invalid defer queue parameters");
+		rte_errno = EINVAL;
+		return NULL;
+	}
+
+	size = rte_align32pow2(params->size);
+	entry_size = sizeof(struct rcu_qsbr_dq_entry) +
+		RTE_ALIGN_CEIL(params->esize, 8);
+
+	dq = rte_zmalloc(params->name, sizeof(*dq) +
+			(size_t)size * entry_size, RTE_CACHE_LINE_SIZE);
+	if (dq == NULL) {
+		RCU_LOG(ERR, "Cannot allocate defer queue");
+		rte_errno = ENOMEM;
+		return NULL;
+	}
+
+	if (params->name != NULL)
+		snprintf(dq->name, sizeof(dq->name), "%s", params->name);
+	dq->v = params->v;
+	dq->size = size;
+	dq->mask = size - 1;
+	dq->esize = params->esize;
+	dq->entry_size = entry_size;
+	dq->trigger_reclaim_limit = params->trigger_reclaim_limit;
+	dq->max_reclaim_size = params->max_reclaim_size;
+	dq->free_fn = params->free_fn;
+	dq->p = params->p;
+
+	return dq;
+}
+
+static inline struct rcu_qsbr_dq_entry *
+rcu_qsbr_dq_entry(struct rte_rcu_qsbr_dq *dq, uint32_t idx)
+{
+	return (struct rcu_qsbr_dq_entry *)
+		&dq->entries[(size_t)(idx & dq->mask) * dq->entry_size];
+}
+
+/* Free up to n elements in enqueue order, optionally waiting for them */
+static unsigned int
+rcu_qsbr_dq_free(struct rte_rcu_qsbr_dq *dq, unsigned int n, bool wait)
+{
+	struct rcu_qsbr_dq_entry *e;
+	unsigned int cnt = 0;
+
+	while (cnt < n && dq->tail != dq->head) {
+		e = rcu_qsbr_dq_entry(dq, dq->tail);
+		/* Tokens are increasing, the next entries are not ready */
+		if (rte_rcu_qsbr_check(dq->v, e->token, wait) == 0)
+			break;
+		dq->free_fn(dq->p, e->elem, 1);
+		dq->tail++;
+		cnt++;
+	}
+
+	return cnt;
+}
+
+int
+rte_rcu_qsbr_dq_enqueue(struct rte_rcu_qsbr_dq *dq, void *e)
+{
+	struct rcu_qsbr_dq_entry *entry;
+
+	if (dq == NULL || e == NULL)
+		return -EINVAL;
+
+	if (dq->head - dq->tail >= dq->trigger_reclaim_limit)
+		rcu_qsbr_dq_free(dq, dq->max_reclaim_size, false);
+
+	if (dq->head - dq->tail == dq->size) {
+		RCU_LOG(DEBUG, "Defer queue %s is full", dq->name);
+		return -ENOSPC;
+	}
+
+	/* The element was removed before the grace period starts */
+	entry = rcu_qsbr_dq_entry(dq, dq->head);
+	entry->token = rte_rcu_qsbr_start(dq->v);
+	memcpy(entry->elem, e, dq->esize);
+	dq->head++;
+
+	return 0;
+}
+
+int
+rte_rcu_qsbr_dq_reclaim(struct rte_rcu_qsbr_dq *dq, unsigned int n,
+	unsigned int *freed, unsigned int *pending, unsigned int *available)
+{
+	unsigned int cnt;
+
+	if (dq == NULL || n == 0)
+		return -EINVAL;
+
+	cnt = rcu_qsbr_dq_free(dq, n, false);
+
+	if (freed != NULL)
+		*freed = cnt;
+	if (pending != NULL)
+		*pending = dq->head - dq->tail;
+	if (available != NULL)
+		*available = dq->size - (dq->head - dq->tail);
+
+	return 0;
+}
+
+int
+rte_rcu_qsbr_dq_delete(struct rte_rcu_qsbr_dq *dq)
+{
+	if (dq == NULL)
+		return 0;
+
+	rcu_qsbr_dq_free(dq, dq->size, true);
+	rte_free(dq);
+
+	return 0;
+}
+
+RTE_INIT(rcu_init_log);
+static void
+rcu_init_log(void)
+{
+	rcu_logtype = rte_log_register("librte.rcu");
+	if (rcu_logtype >= 0)
+		rte_log_set_level(rcu_logtype, RTE_LOG_ERR);
+}
@@ -0,0 +1,469 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _RTE_RCU_QSBR_H_
+#define _RTE_RCU_QSBR_H_
+
+/**
+ * @file
+ * RTE Quiescent State Based Reclamation (QSBR)
+ *
+ * Lock-free readers of a data structure give writers no safe moment to free
+ * or reuse an element they removed. With QSBR, reader threads register with
+ * a QS variable and report a quiescent state whenever they hold no reference
+ * to the shared data, typically once per iteration of their polling loop.
+ * Once an element has been removed, a writer starts a grace period and may
+ * reuse the element once every registered reader has reported a quiescent
+ * state since then, or went offline.
+ *
+ * The reader side costs a load and a store per quiescent state report, and
+ * no atomic operation. Writers can either wait for the grace period or push
+ * the element to a defer queue, reclaimed when the grace period is over.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <rte_common.h>
+#include <rte_memory.h>
+#include <rte_atomic.h>
+#include <rte_debug.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Thread ID to pass when the caller is not a registered reader. */
+#define RTE_QSBR_THRID_INVALID 0xffffffff
+
+/** Counter of a reader thread that is offline. */
+#define RTE_QSBR_CNT_THR_OFFLINE 0
+
+/** Token of a QS variable after initialization. */
+#define RTE_QSBR_CNT_INIT 1
+
+/** Quiescent state counter of a reader thread. */
+struct rte_rcu_qsbr_cnt {
+	volatile uint64_t cnt;
+	/**< Last token seen in a quiescent state, 0 if the thread is offline */
+} __rte_cache_aligned;
+
+/* Registered thread IDs are kept in a bitmap of 64-bit words */
+#define __RTE_QSBR_THRID_INDEX_SHIFT 6
+#define __RTE_QSBR_THRID_MASK 0x3f
+#define __RTE_QSBR_THRID_ARRAY_ELM_SIZE (sizeof(uint64_t) * 8)
+#define __RTE_QSBR_THRID_ARRAY_SIZE(max_threads) \
+	RTE_ALIGN(RTE_ALIGN_CEIL(max_threads, \
+		__RTE_QSBR_THRID_ARRAY_ELM_SIZE) >> 3, RTE_CACHE_LINE_SIZE)
+#define __RTE_QSBR_THRID_ARRAY_ELM(v, i) \
+	((volatile uint64_t *)&(v)->qsbr_cnt[(v)->max_threads] + (i))
+
+/**
+ * QS variable, shared by the readers and the writers of one or more data
+ * structures. It is followed in memory by the counters of the reader
+ * threads and the bitmap of the registered ones, see
+ * rte_rcu_qsbr_get_memsize().
+ */
+struct rte_rcu_qsbr {
+	rte_atomic64_t token __rte_cache_aligned;
+	/**< Grace period counter, incremented by rte_rcu_qsbr_start() */
+	volatile uint64_t acked_token;
+	/**< Token acknowledged by all the readers in the last full check */
+
+	uint32_t num_elems __rte_cache_aligned;
+	/**< Number of 64-bit words in the registered thread bitmap */
+	rte_atomic32_t num_threads;
+	/**< Number of registered reader threads */
+	uint32_t max_threads;
+	/**< Maximum number of reader threads */
+
+	struct rte_rcu_qsbr_cnt qsbr_cnt[0] __rte_cache_aligned;
+	/**< Quiescent state counters of the 'max_threads' readers */
+} __rte_cache_aligned;
+
+/**
+ * Callback freeing resources from a defer queue.
+ *
+ * @param p
+ *   Pointer given in the defer queue parameters.
+ * @param e
+ *   Pointer to the first element to free.
+ * @param n
+ *   Number of elements to free.
+ */
+typedef void (*rte_rcu_qsbr_free_resource_t)(void *p, void *e, unsigned int n);
+
+/** Maximum length of a defer queue name. */
+#define RTE_RCU_QSBR_DQ_NAMESIZE 32
+
+/** Defer queue parameters. */
+struct rte_rcu_qsbr_dq_parameters {
+	const char *name;
+	/**< Name of the defer queue, used in logs */
+	uint32_t size;
+	/**< Number of elements, rounded up to a power of 2 */
+	uint32_t esize;
+	/**< Size of an element in bytes */
+	uint32_t trigger_reclaim_limit;
+	/**< Enqueues reclaim elements once this many are pending, 0 reclaims
+	 * on every enqueue
+	 */
+	uint32_t max_reclaim_size;
+	/**< Maximum number of elements reclaimed by an enqueue */
+	rte_rcu_qsbr_free_resource_t free_fn;
+	/**< Function freeing the reclaimed elements */
+	void *p;
+	/**< Pointer passed to free_fn */
+	struct rte_rcu_qsbr *v;
+	/**< QS variable of the readers of the elements */
+};
+
+/** Defer queue, opaque. */
+struct rte_rcu_qsbr_dq;
+
+/**
+ * Return the size of the memory to allocate for a QS variable.
+ *
+ * @param max_threads
+ *   Maximum number of reader threads using the QS variable.
+ * @return
+ *   Size in bytes, or 0 with rte_errno set to EINVAL if max_threads is 0.
+ */
+size_t
+rte_rcu_qsbr_get_memsize(uint32_t max_threads);
+
+/**
+ * Initialize a QS variable.
+ *
+ * @param v
+ *   QS variable, of the size returned by rte_rcu_qsbr_get_memsize() and
+ *   aligned on a cache line.
+ * @param max_threads
+ *   Maximum number of reader threads using the QS variable. Thread IDs
+ *   range from 0 to max_threads - 1.
+ * @return
+ *   - 0 on success.
+ *   - -EINVAL on invalid parameters.
+ */
+int
+rte_rcu_qsbr_init(struct rte_rcu_qsbr *v, uint32_t max_threads);
+
+/**
+ * Register a reader thread, so that writers wait for it. The thread stays
+ * offline until it calls rte_rcu_qsbr_thread_online().
+ *
+ * @param v
+ *   QS variable.
+ * @param thread_id
+ *   Reader thread ID, lower than max_threads, e.g. its lcore ID.
+ * @return
+ *   - 0 on success.
+ *   - -EINVAL on invalid parameters.
+ */
+int
+rte_rcu_qsbr_thread_register(struct rte_rcu_qsbr *v, unsigned int thread_id);
+
+/**
+ * Unregister a reader thread. It must be offline.
+ *
+ * @param v
+ *   QS variable.
+ * @param thread_id
+ *   Reader thread ID.
+ * @return
+ *   - 0 on success.
+ *   - -EINVAL on invalid parameters.
+ */
+int
+rte_rcu_qsbr_thread_unregister(struct rte_rcu_qsbr *v, unsigned int thread_id);
+
+/**
+ * Put a registered reader thread online, before it accesses the shared
+ * data structures. Writers wait for online threads only.
+ *
+ * @param v
+ *   QS variable.
+ * @param thread_id
+ *   Reader thread ID.
+ */
+static inline void
+rte_rcu_qsbr_thread_online(struct rte_rcu_qsbr *v, unsigned int thread_id)
+{
+	RTE_ASSERT(v != NULL && thread_id < v->max_threads);
+
+	/* A writer starting a grace period now waits for this thread */
+	v->qsbr_cnt[thread_id].cnt = rte_atomic64_read(&v->token);
+
+	/*
+	 * The counter must be visible before the thread loads shared data,
+	 * or a writer could miss it and free what the thread reads.
+	 */
+	rte_smp_mb();
+}
+
+/**
+ * Put a reader thread offline, e.g. before blocking. It must not hold any
+ * reference to the shared data structures, and writers stop waiting for it.
+ *
+ * @param v
+ *   QS variable.
+ * @param thread_id
+ *   Reader thread ID.
+ */
+static inline void
+rte_rcu_qsbr_thread_offline(struct rte_rcu_qsbr *v, unsigned int thread_id)
+{
+	RTE_ASSERT(v != NULL && thread_id < v->max_threads);
+
+	/* Loads of shared data complete before the counter store */
+	rte_smp_rmb();
+	v->qsbr_cnt[thread_id].cnt = RTE_QSBR_CNT_THR_OFFLINE;
+}
+
+/**
+ * Report a quiescent state: the reader thread does not hold any reference
+ * to the shared data structures anymore.
+ *
+ * @param v
+ *   QS variable.
+ * @param thread_id
+ *   Reader thread ID.
+ */
+static inline void
+rte_rcu_qsbr_quiescent(struct rte_rcu_qsbr *v, unsigned int thread_id)
+{
+	uint64_t t;
+
+	RTE_ASSERT(v != NULL && thread_id < v->max_threads);
+
+	t = rte_atomic64_read(&v->token);
+
+	/*
+	 * Loads of shared data done before the quiescent state complete
+	 * before the counter store, and the ones done after it are not
+	 * satisfied before the token load.
+	 */
+	rte_smp_rmb();
+	v->qsbr_cnt[thread_id].cnt = t;
+}
+
+/**
+ * Start a grace period, once elements have been removed from the shared
+ * data structures. Multiple writers may call it concurrently.
+ *
+ * @param v
+ *   QS variable.
+ * @return
+ *   Token to pass to rte_rcu_qsbr_check().
+ */
+static inline uint64_t
+rte_rcu_qsbr_start(struct rte_rcu_qsbr *v)
+{
+	RTE_ASSERT(v != NULL);
+
+	/* Full barrier: the removals are visible before the new token */
+	return rte_atomic64_add_return(&v->token, 1);
+}
+
+/* Scan the counters of all the registered readers */
+static inline int
+__rte_rcu_qsbr_check_all(struct rte_rcu_qsbr *v, uint64_t t, bool wait)
+{
+	uint32_t i, j, id;
+	uint64_t bmap, c;
+	volatile uint64_t *reg_thread_id;
+	uint64_t acked_token = UINT64_MAX;
+
+	for (i = 0, reg_thread_id = __RTE_QSBR_THRID_ARRAY_ELM(v, 0);
+			i < v->num_elems; i++, reg_thread_id++) {
+		bmap = *reg_thread_id;
+		id = i << __RTE_QSBR_THRID_INDEX_SHIFT;
+		while (bmap) {
+			j = __builtin_ctzll(bmap);
+			c = v->qsbr_cnt[id + j].cnt;
+
+			/* Online and not quiescent since the token */
+			if (unlikely(c != RTE_QSBR_CNT_THR_OFFLINE && c < t)) {
+				if (!wait)
+					return 0;
+				rte_pause();
+				/* The thread may have unregistered meanwhile */
+				bmap = *reg_thread_id;
+				continue;
+			}
+
+			if (c != RTE_QSBR_CNT_THR_OFFLINE && acked_token > c)
+				acked_token = c;
+			bmap &= ~(1ULL << j);
+		}
+	}
+
+	/*
+	 * Cache the least token seen, all the readers acknowledged it. A
+	 * concurrent writer may store a lower one, which is still acked.
+	 */
+	if (acked_token == UINT64_MAX)
+		acked_token = t;
+	if (acked_token > v->acked_token)
+		v->acked_token = acked_token;
+
+	/* Counter loads complete before the caller frees elements */
+	rte_smp_rmb();
+	return 1;
+}
+
+/**
+ * Check whether the grace period of a token is over, i.e. all the online
+ * reader threads reported a quiescent state since the token was returned
+ * by rte_rcu_qsbr_start(). The elements removed before that can be freed.
+ *
+ * @param v
+ *   QS variable.
+ * @param t
+ *   Token returned by rte_rcu_qsbr_start().
+ * @param wait
+ *   Wait until the grace period is over, instead of returning.
+ * @return
+ *   - 0 if the grace period is not over.
+ *   - 1 if it is.
+ */
+static inline int
+rte_rcu_qsbr_check(struct rte_rcu_qsbr *v, uint64_t t, bool wait)
+{
+	RTE_ASSERT(v != NULL);
+
+	/* Acknowledged by all the readers already */
+	if (likely(t <= v->acked_token)) {
+		rte_smp_rmb();
+		return 1;
+	}
+
+	return __rte_rcu_qsbr_check_all(v, t, wait);
+}
+
+/**
+ * Start a grace period and wait for it to be over.
+ *
+ * @param v
+ *   QS variable.
+ * @param thread_id
+ *   Reader thread ID of the caller, reporting a quiescent state first, or
+ *   RTE_QSBR_THRID_INVALID if the caller is not a reader.
+ */
+void
+rte_rcu_qsbr_synchronize(struct rte_rcu_qsbr *v, unsigned int thread_id);
+
+/**
+ * Dump the state of a QS variable.
+ *
+ * @param f
+ *   File to dump to.
+ * @param v
+ *   QS variable.
+ * @return
+ *   - 0 on success.
+ *   - -EINVAL on invalid parameters.
+ */
+int
+rte_rcu_qsbr_dump(FILE *f, struct rte_rcu_qsbr *v);
+
+/**
+ * Create a defer queue, holding removed elements until the grace period
+ * started by their removal is over. A defer queue is not multi-thread safe,
+ * its writers must be serialized.
+ *
+ * @param params
+ *   Defer queue parameters.
+ * @return
+ *   Defer queue on success, NULL otherwise with rte_errno set to EINVAL or
+ *   ENOMEM.
+ */
+struct rte_rcu_qsbr_dq *
+rte_rcu_qsbr_dq_create(const struct rte_rcu_qsbr_dq_parameters *params);
+
+/**
+ * Enqueue a removed element and start its grace period. Elements whose
+ * grace period is over are reclaimed first when the trigger limit is
+ * reached, or when the queue is full.
+ *
+ * @param dq
+ *   Defer queue.
+ * @param e
+ *   Element, of the size given at creation, copied into the queue.
+ * @return
+ *   - 0 on success.
+ *   - -EINVAL on invalid parameters.
+ *   - -ENOSPC if the queue is full of elements still in their grace period.
+ */
+int
+rte_rcu_qsbr_dq_enqueue(struct rte_rcu_qsbr_dq *dq, void *e);
+
+/**
+ * Free the elements whose grace period is over, in enqueue order.
+ *
+ * @param dq
+ *   Defer queue.
+ * @param n
+ *   Maximum number of elements to free.
+ * @param freed
+ *   If not NULL, number of elements freed.
+ * @param pending
+ *   If not NULL, number of elements left in the queue.
+ * @param available
+ *   If not NULL, number of free entries in the queue.
+ * @return
+ *   - 0 on success.
+ *   - -EINVAL on invalid parameters.
+ */
+int
+rte_rcu_qsbr_dq_reclaim(struct rte_rcu_qsbr_dq *dq, unsigned int n,
+	unsigned int *freed, unsigned int *pending, unsigned int *available);
+
+/**
+ * Free all the elements of a defer queue, waiting for their grace period,
+ * then free the queue.
+ *
+ * @param dq
+ *   Defer queue. NULL is a no-op.
+ * @return
+ *   0.
+ */
+int
+rte_rcu_qsbr_dq_delete(struct rte_rcu_qsbr_dq *dq);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RTE_RCU_QSBR_H_ */
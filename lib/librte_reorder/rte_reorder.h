@@ -52,6 +52,36 @@ extern "C" {
 
 struct rte_reorder_buffer;
 
+/** Sequence number type used by the reorder library. */
+typedef uint32_t rte_reorder_seqn_t;
+
+/** Name of the mbuf dynamic field holding the reorder sequence number. */
+#define RTE_REORDER_SEQN_DYNFIELD_NAME "rte_reorder_seqn_dynfield"
+
+/**
+ * Offset of the sequence number dynamic field in the mbuf, registered
+ * at the first creation or initialization of a reorder buffer.
+ */
+extern int rte_reorder_seqn_dynfield_offset;
+
+/**
+ * Read or write the reorder sequence number of a packet.
+ *
+ * The field is only valid once a reorder buffer has been created or
+ * initialized, before the first packet is marked.
+ *
+ * @param mbuf
+ *   The packet mbuf.
+ * @return
+ *   A pointer to the sequence number field in the mbuf.
+ */
+static inline rte_reorder_seqn_t *
+rte_reorder_seqn(struct rte_mbuf *mbuf)
+{
+	return RTE_MBUF_DYNFIELD(mbuf, rte_reorder_seqn_dynfield_offset,
+		rte_reorder_seqn_t *);
+}
+
 /**
  * Create a new reorder buffer instance
  *
@@ -133,7 +163,8 @@ rte_reorder_free(struct rte_reorder_buffer *b);
  * Insert given mbuf in reorder buffer in its correct position
  *
  * The given mbuf is to be reordered relative to other mbufs in the system.
- * The mbuf must contain a sequence number which is then used to place
+ * The mbuf must contain a sequence number, set with rte_reorder_seqn(),
+ * which is then used to place
  * the buffer in the correct position in the reorder buffer. Reordered
  * packets can later be taken from the buffer using the rte_reorder_drain()
  * API.
@@ -83,7 +83,10 @@
  * - Bulk enqueue.
  *
  * Note: the ring implementation is not preemptable. A lcore must not
- * be interrupted by another task that uses the same ring.
+ * be interrupted by another task that uses the same ring. When producers
+ * or consumers can be preempted (e.g. more threads than cores), the
+ * relaxed tail sync mode (RING_F_MP_RTS_ENQ / RING_F_MC_RTS_DEQ) avoids
+ * waiting for a specific preempted thread to update the tail.
  *
  */
 
@@ -124,11 +127,46 @@ struct rte_memzone; /* forward declaration, so as not to require memzone.h */
 #define CONS_ALIGN RTE_CACHE_LINE_SIZE
 #endif
 
+/** prod/cons sync types */
+enum rte_ring_sync_type {
+	RTE_RING_SYNC_MT,     /**< multi-thread safe (default mode) */
+	RTE_RING_SYNC_ST,     /**< single thread only */
+	RTE_RING_SYNC_MT_RTS, /**< multi-thread relaxed tail sync */
+};
+
 /* structure to hold a pair of head/tail values and other metadata */
 struct rte_ring_headtail {
 	volatile uint32_t head;  /**< Prod/consumer head. */
 	volatile uint32_t tail;  /**< Prod/consumer tail. */
-	uint32_t single;         /**< True if single prod/cons */
+	RTE_STD_C11
+	union {
+		/** sync type of prod/cons */
+		enum rte_ring_sync_type sync_type;
+		/** True if single prod/cons, kept for compatibility */
+		uint32_t single;
+	};
+};
+
+/* head or tail position with the number of operations that updated it */
+union rte_ring_rts_poscnt {
+	uint64_t raw;
+	struct {
+		uint32_t cnt; /**< head/tail reference counter */
+		uint32_t pos; /**< head/tail position */
+	} val;
+};
+
+/*
+ * structure to hold head/tail values for the relaxed tail sync mode.
+ * The tail position and the sync type are at the same offsets as in
+ * struct rte_ring_headtail, so that the generic status functions
+ * (rte_ring_count() and friends) work for both layouts.
+ */
+struct rte_ring_rts_headtail {
+	volatile union rte_ring_rts_poscnt tail; /**< Prod/consumer tail. */
+	enum rte_ring_sync_type sync_type; /**< sync type of prod/cons */
+	uint32_t htd_max;   /**< max allowed distance between head/tail */
+	volatile union rte_ring_rts_poscnt head; /**< Prod/consumer head. */
 };
 
 /**
@@ -155,14 +193,26 @@ struct rte_ring {
 	uint32_t mask;           /**< Mask (size-1) of ring. */
 
 	/** Ring producer status. */
-	struct rte_ring_headtail prod __rte_aligned(PROD_ALIGN);
+	RTE_STD_C11
+	union {
+		struct rte_ring_headtail prod;
+		struct rte_ring_rts_headtail rts_prod;
+	} __rte_aligned(PROD_ALIGN);
 
 	/** Ring consumer status. */
-	struct rte_ring_headtail cons __rte_aligned(CONS_ALIGN);
+	RTE_STD_C11
+	union {
+		struct rte_ring_headtail cons;
+		struct rte_ring_rts_headtail rts_cons;
+	} __rte_aligned(CONS_ALIGN);
 };
 
 #define RING_F_SP_ENQ 0x0001 /**< The default enqueue is "single-producer". */
 #define RING_F_SC_DEQ 0x0002 /**< The default dequeue is "single-consumer". */
+/** The default enqueue is "multi-producer relaxed tail sync". */
+#define RING_F_MP_RTS_ENQ 0x0008
+/** The default dequeue is "multi-consumer relaxed tail sync". */
+#define RING_F_MC_RTS_DEQ 0x0010
 #define RTE_RING_SZ_MASK  (unsigned)(0x0fffffff) /**< Ring size mask */
 
 /* @internal defines for passing to the enqueue dequeue worker functions */
@@ -170,6 +220,7 @@ struct rte_ring {
 #define __IS_MP 0
 #define __IS_SC 1
 #define __IS_MC 0
+#define __IS_RTS RTE_RING_SYNC_MT_RTS
 
 /**
  * Calculate the memory size needed for a ring
@@ -218,6 +269,17 @@ ssize_t rte_ring_get_memsize(unsigned count);
  *    - RING_F_SC_DEQ: If this flag is set, the default behavior when
  *      using ``rte_ring_dequeue()`` or ``rte_ring_dequeue_bulk()``
  *      is "single-consumer". Otherwise, it is "multi-consumers".
+ *    - RING_F_MP_RTS_ENQ: If this flag is set, the default behavior when
+ *      using ``rte_ring_enqueue()`` or ``rte_ring_enqueue_bulk()``
+ *      is "multi-producer relaxed tail sync" (RTS): a producer never
+ *      waits for a preceding, possibly preempted, producer to finish
+ *      before the tail is moved. Only the default enqueue functions
+ *      (without _sp/_mp in their name) may be used with such a ring.
+ *    - RING_F_MC_RTS_DEQ: If this flag is set, the default behavior when
+ *      using ``rte_ring_dequeue()`` or ``rte_ring_dequeue_bulk()``
+ *      is "multi-consumer relaxed tail sync". Only the default dequeue
+ *      functions (without _sc/_mc in their name) may be used with such
+ *      a ring.
  * @return
  *   0 on success, or a negative value on error.
  */
@@ -253,12 +315,24 @@ int rte_ring_init(struct rte_ring *r, const char *name, unsigned count,
  *    - RING_F_SC_DEQ: If this flag is set, the default behavior when
  *      using ``rte_ring_dequeue()`` or ``rte_ring_dequeue_bulk()``
  *      is "single-consumer". Otherwise, it is "multi-consumers".
+ *    - RING_F_MP_RTS_ENQ: If this flag is set, the default behavior when
+ *      using ``rte_ring_enqueue()`` or ``rte_ring_enqueue_bulk()``
+ *      is "multi-producer relaxed tail sync" (RTS): a producer never
+ *      waits for a preceding, possibly preempted, producer to finish
+ *      before the tail is moved. Only the default enqueue functions
+ *      (without _sp/_mp in their name) may be used with such a ring.
+ *    - RING_F_MC_RTS_DEQ: If this flag is set, the default behavior when
+ *      using ``rte_ring_dequeue()`` or ``rte_ring_dequeue_bulk()``
+ *      is "multi-consumer relaxed tail sync". Only the default dequeue
+ *      functions (without _sc/_mc in their name) may be used with such
+ *      a ring.
  * @return
  *   On success, the pointer to the new allocated ring. NULL on error with
  *    rte_errno set appropriately. Possible errno values include:
  *    - E_RTE_NO_CONFIG - function could not get pointer to rte_config structure
  *    - E_RTE_SECONDARY - function was called from a secondary process instance
- *    - EINVAL - count provided is not a power of 2
+ *    - EINVAL - count provided is not a power of 2, or conflicting
+ *		 sync flags were given
  *    - ENOSPC - the maximum number of memzones has already been allocated
  *    - EEXIST - a memzone with the same name already exists
  *    - ENOMEM - no appropriate memory area found in which to create memzone
@@ -423,6 +497,177 @@ __rte_ring_move_prod_head(struct rte_ring *r, int is_sp,
 	return n;
 }
 
+/*
+ * @internal Load a relaxed tail sync head or tail value atomically.
+ */
+static inline __attribute__((always_inline)) uint64_t
+__rte_ring_rts_load(const volatile union rte_ring_rts_poscnt *v)
+{
+#ifdef RTE_ARCH_64
+	return v->raw;
+#else
+	return rte_atomic64_read((rte_atomic64_t *)(uintptr_t)&v->raw);
+#endif
+}
+
+/**
+ * @internal This function updates the tail in relaxed tail sync mode
+ *
+ * Every finished enqueue/dequeue increments the tail counter. The thread
+ * whose increment makes it match the head counter, i.e. the last one to
+ * finish among those in progress, moves the tail position up to the head.
+ * A thread therefore never waits for another one to update the tail.
+ *
+ * @param ht
+ *   A pointer to the producer or consumer head/tail structure
+ */
+static inline __attribute__((always_inline)) void
+__rte_ring_rts_update_tail(struct rte_ring_rts_headtail *ht)
+{
+	union rte_ring_rts_poscnt h, ot, nt;
+
+	do {
+		ot.raw = __rte_ring_rts_load(&ht->tail);
+		rte_smp_rmb();
+		h.raw = __rte_ring_rts_load(&ht->head);
+
+		nt.raw = ot.raw;
+		if (++nt.val.cnt == h.val.cnt)
+			nt.val.pos = h.val.pos;
+	} while (unlikely(rte_atomic64_cmpset(&ht->tail.raw,
+			ot.raw, nt.raw) == 0));
+}
+
+/**
+ * @internal Wait until the distance between head and tail is within
+ * the htd_max limit, reloading the head meanwhile.
+ */
+static inline __attribute__((always_inline)) void
+__rte_ring_rts_head_wait(const struct rte_ring_rts_headtail *ht,
+		union rte_ring_rts_poscnt *h)
+{
+	const uint32_t max = ht->htd_max;
+
+	while (unlikely(h->val.pos - ht->tail.val.pos > max)) {
+		rte_pause();
+		h->raw = __rte_ring_rts_load(&ht->head);
+	}
+}
+
+/**
+ * @internal This function updates the producer head for enqueue in
+ * relaxed tail sync mode
+ *
+ * @param r
+ *   A pointer to the ring structure
+ * @param n
+ *   The number of elements we will want to enqueue, i.e. how far should the
+ *   head be moved
+ * @param behavior
+ *   RTE_RING_QUEUE_FIXED:    Enqueue a fixed number of items from a ring
+ *   RTE_RING_QUEUE_VARIABLE: Enqueue as many items as possible from ring
+ * @param old_head
+ *   Returns head value as it was before the move, i.e. where enqueue starts
+ * @param free_entries
+ *   Returns the amount of free space in the ring BEFORE head was moved
+ * @return
+ *   Actual number of objects enqueued.
+ *   If behavior == RTE_RING_QUEUE_FIXED, this will be 0 or n only.
+ */
+static inline __attribute__((always_inline)) unsigned int
+__rte_ring_rts_move_prod_head(struct rte_ring *r, unsigned int n,
+		enum rte_ring_queue_behavior behavior, uint32_t *old_head,
+		uint32_t *free_entries)
+{
+	const uint32_t mask = r->mask;
+	const unsigned int max = n;
+	union rte_ring_rts_poscnt nh, oh;
+
+	do {
+		/* Reset n to the initial burst count */
+		n = max;
+
+		oh.raw = __rte_ring_rts_load(&r->rts_prod.head);
+
+		/* do not let the head run too far ahead of the tail, so that
+		 * a preempted producer can only delay a bounded number of
+		 * entries from being visible to the consumers */
+		__rte_ring_rts_head_wait(&r->rts_prod, &oh);
+
+		rte_smp_rmb();
+		*free_entries = (mask + r->cons.tail - oh.val.pos);
+
+		/* check that we have enough room in ring */
+		if (unlikely(n > *free_entries))
+			n = (behavior == RTE_RING_QUEUE_FIXED) ?
+					0 : *free_entries;
+
+		if (n == 0)
+			break;
+
+		nh.val.pos = oh.val.pos + n;
+		nh.val.cnt = oh.val.cnt + 1;
+	} while (unlikely(rte_atomic64_cmpset(&r->rts_prod.head.raw,
+			oh.raw, nh.raw) == 0));
+
+	*old_head = oh.val.pos;
+	return n;
+}
+
+/**
+ * @internal This function updates the consumer head for dequeue in
+ * relaxed tail sync mode
+ *
+ * @param r
+ *   A pointer to the ring structure
+ * @param n
+ *   The number of elements we will want to dequeue, i.e. how far should the
+ *   head be moved
+ * @param behavior
+ *   RTE_RING_QUEUE_FIXED:    Dequeue a fixed number of items from a ring
+ *   RTE_RING_QUEUE_VARIABLE: Dequeue as many items as possible from ring
+ * @param old_head
+ *   Returns head value as it was before the move, i.e. where dequeue starts
+ * @param entries
+ *   Returns the number of entries in the ring BEFORE head was moved
+ * @return
+ *   - Actual number of objects dequeued.
+ *     If behavior == RTE_RING_QUEUE_FIXED, this will be 0 or n only.
+ */
+static inline __attribute__((always_inline)) unsigned int
+__rte_ring_rts_move_cons_head(struct rte_ring *r, unsigned int n,
+		enum rte_ring_queue_behavior behavior, uint32_t *old_head,
+		uint32_t *entries)
+{
+	const unsigned int max = n;
+	union rte_ring_rts_poscnt nh, oh;
+
+	do {
+		/* Restore n as it may change every loop */
+		n = max;
+
+		oh.raw = __rte_ring_rts_load(&r->rts_cons.head);
+		__rte_ring_rts_head_wait(&r->rts_cons, &oh);
+
+		rte_smp_rmb();
+		*entries = (r->prod.tail - oh.val.pos);
+
+		/* Set the actual entries for dequeue */
+		if (n > *entries)
+			n = (behavior == RTE_RING_QUEUE_FIXED) ? 0 : *entries;
+
+		if (unlikely(n == 0))
+			break;
+
+		nh.val.pos = oh.val.pos + n;
+		nh.val.cnt = oh.val.cnt + 1;
+	} while (unlikely(rte_atomic64_cmpset(&r->rts_cons.head.raw,
+			oh.raw, nh.raw) == 0));
+
+	*old_head = oh.val.pos;
+	return n;
+}
+
 /**
  * @internal Enqueue several objects on the ring
  *
@@ -436,7 +681,8 @@ __rte_ring_move_prod_head(struct rte_ring *r, int is_sp,
  *   RTE_RING_QUEUE_FIXED:    Enqueue a fixed number of items from a ring
  *   RTE_RING_QUEUE_VARIABLE: Enqueue as many items as possible from ring
  * @param is_sp
- *   Indicates whether to use single producer or multi-producer head update
+ *   Indicates whether to use single producer, multi-producer or
+ *   relaxed tail sync (__IS_RTS) head update
  * @param free_space
  *   returns the amount of space after the enqueue operation has finished
  * @return
@@ -448,18 +694,25 @@ __rte_ring_do_enqueue(struct rte_ring *r, void * const *obj_table,
 		 unsigned int n, enum rte_ring_queue_behavior behavior,
 		 int is_sp, unsigned int *free_space)
 {
-	uint32_t prod_head, prod_next;
+	uint32_t prod_head, prod_next = 0;
 	uint32_t free_entries;
 
-	n = __rte_ring_move_prod_head(r, is_sp, n, behavior,
-			&prod_head, &prod_next, &free_entries);
+	if (is_sp == __IS_RTS)
+		n = __rte_ring_rts_move_prod_head(r, n, behavior,
+				&prod_head, &free_entries);
+	else
+		n = __rte_ring_move_prod_head(r, is_sp, n, behavior,
+				&prod_head, &prod_next, &free_entries);
 	if (n == 0)
 		goto end;
 
 	ENQUEUE_PTRS(r, &r[1], prod_head, obj_table, n, void *);
 	rte_smp_wmb();
 
-	update_tail(&r->prod, prod_head, prod_next, is_sp);
+	if (is_sp == __IS_RTS)
+		__rte_ring_rts_update_tail(&r->rts_prod);
+	else
+		update_tail(&r->prod, prod_head, prod_next, is_sp);
 end:
 	if (free_space != NULL)
 		*free_space = free_entries - n;
@@ -541,7 +794,8 @@ __rte_ring_move_cons_head(struct rte_ring *r, int is_sc,
  *   RTE_RING_QUEUE_FIXED:    Dequeue a fixed number of items from a ring
  *   RTE_RING_QUEUE_VARIABLE: Dequeue as many items as possible from ring
  * @param is_sc
- *   Indicates whether to use single consumer or multi-consumer head update
+ *   Indicates whether to use single consumer, multi-consumer or
+ *   relaxed tail sync (__IS_RTS) head update
  * @param available
  *   returns the number of remaining ring entries after the dequeue has finished
  * @return
@@ -553,18 +807,25 @@ __rte_ring_do_dequeue(struct rte_ring *r, void **obj_table,
 		 unsigned int n, enum rte_ring_queue_behavior behavior,
 		 int is_sc, unsigned int *available)
 {
-	uint32_t cons_head, cons_next;
+	uint32_t cons_head, cons_next = 0;
 	uint32_t entries;
 
-	n = __rte_ring_move_cons_head(r, is_sc, n, behavior,
-			&cons_head, &cons_next, &entries);
+	if (is_sc == __IS_RTS)
+		n = __rte_ring_rts_move_cons_head(r, n, behavior,
+				&cons_head, &entries);
+	else
+		n = __rte_ring_move_cons_head(r, is_sc, n, behavior,
+				&cons_head, &cons_next, &entries);
 	if (n == 0)
 		goto end;
 
 	DEQUEUE_PTRS(r, &r[1], cons_head, obj_table, n, void *);
 	rte_smp_rmb();
 
-	update_tail(&r->cons, cons_head, cons_next, is_sc);
+	if (is_sc == __IS_RTS)
+		__rte_ring_rts_update_tail(&r->rts_cons);
+	else
+		update_tail(&r->cons, cons_head, cons_next, is_sc);
 
 end:
 	if (available != NULL)
@@ -924,6 +1185,89 @@ rte_ring_get_size(const struct rte_ring *r)
 	return r->size;
 }
 
+/**
+ * Return the maximum distance allowed between the producer head and tail
+ * of a ring in relaxed tail sync mode.
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @return
+ *   The producer head/tail distance limit, or UINT32_MAX if the producer
+ *   is not in relaxed tail sync mode.
+ */
+static inline uint32_t
+rte_ring_get_prod_htd_max(const struct rte_ring *r)
+{
+	if (r->prod.sync_type == RTE_RING_SYNC_MT_RTS)
+		return r->rts_prod.htd_max;
+	return UINT32_MAX;
+}
+
+/**
+ * Set the maximum distance allowed between the producer head and tail
+ * of a ring in relaxed tail sync mode.
+ *
+ * A producer never lets the head go further than this from the tail,
+ * which bounds the number of enqueued objects a preempted producer can
+ * keep hidden from the consumers. It should be set before the ring is
+ * used.
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @param v
+ *   The new head/tail distance limit.
+ * @return
+ *   - 0: Success.
+ *   - -ENOTSUP: The producer is not in relaxed tail sync mode.
+ */
+static inline int
+rte_ring_set_prod_htd_max(struct rte_ring *r, uint32_t v)
+{
+	if (r->prod.sync_type != RTE_RING_SYNC_MT_RTS)
+		return -ENOTSUP;
+	r->rts_prod.htd_max = v;
+	return 0;
+}
+
+/**
+ * Return the maximum distance allowed between the consumer head and tail
+ * of a ring in relaxed tail sync mode.
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @return
+ *   The consumer head/tail distance limit, or UINT32_MAX if the consumer
+ *   is not in relaxed tail sync mode.
+ */
+static inline uint32_t
+rte_ring_get_cons_htd_max(const struct rte_ring *r)
+{
+	if (r->cons.sync_type == RTE_RING_SYNC_MT_RTS)
+		return r->rts_cons.htd_max;
+	return UINT32_MAX;
+}
+
+/**
+ * Set the maximum distance allowed between the consumer head and tail
+ * of a ring in relaxed tail sync mode.
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @param v
+ *   The new head/tail distance limit.
+ * @return
+ *   - 0: Success.
+ *   - -ENOTSUP: The consumer is not in relaxed tail sync mode.
+ */
+static inline int
+rte_ring_set_cons_htd_max(struct rte_ring *r, uint32_t v)
+{
+	if (r->cons.sync_type != RTE_RING_SYNC_MT_RTS)
+		return -ENOTSUP;
+	r->rts_cons.htd_max = v;
+	return 0;
+}
+
 /**
  * Dump the status of all rings on the console
  *
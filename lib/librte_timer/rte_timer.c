@@ -36,6 +36,7 @@
 #include <stdint.h>
 #include <inttypes.h>
 #include <assert.h>
+#include <errno.h>
 #include <sys/queue.h>
 
 #include <rte_atomic.h>
@@ -51,11 +52,36 @@
 #include <rte_branch_prediction.h>
 #include <rte_spinlock.h>
 #include <rte_random.h>
+#include <rte_malloc.h>
 
 #include "rte_timer.h"
 
 LIST_HEAD(rte_timer_list, rte_timer);
 
+/*
+ * The timing wheel has TIMER_WHEEL_LEVELS levels of TIMER_WHEEL_SLOTS slots.
+ * A slot of level 0 holds the timers expiring in one tick, and a slot of
+ * level n the timers expiring in TIMER_WHEEL_SLOTS^n ticks. The timers of a
+ * slot of upper level are moved to the lower levels when the current tick
+ * reaches it (cascade).
+ */
+#define TIMER_WHEEL_BITS 8
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SLOTS - 1)
+#define TIMER_WHEEL_LEVELS 4
+#define TIMER_WHEEL_MAX_TICKS ((UINT64_C(1) << \
+		(TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) - 1)
+#define TIMER_WHEEL_TICK_NS 1000
+
+struct timer_wheel {
+	uint64_t cur_tick;     /**< next tick to process */
+	unsigned tick_shift;   /**< log2 of the tick length in timer cycles */
+	unsigned count;        /**< number of timers in the wheel */
+	/** bitmap of the slots which are not empty */
+	uint64_t used[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS / 64];
+	struct rte_timer *slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+};
+
 struct priv_timer {
 	struct rte_timer pending_head;  /**< dummy timer instance to head up list */
 	rte_spinlock_t list_lock;       /**< lock to protect list access */
@@ -72,39 +98,201 @@ struct priv_timer {
 	/** running timer on this lcore now */
 	struct rte_timer *running_tim;
 
+	/** timing wheel, if it is the backend in use */
+	struct timer_wheel *wheel;
+
 #ifdef RTE_LIBRTE_TIMER_DEBUG
 	/** per-lcore statistics */
 	struct rte_timer_debug_stats stats;
 #endif
 } __rte_cache_aligned;
 
-/** per-lcore private info for timers */
-static struct priv_timer priv_timer[RTE_MAX_LCORE];
+/** a set of per-lcore timer lists */
+struct rte_timer_data {
+	/** per-lcore private info for timers */
+	struct priv_timer priv_timer[RTE_MAX_LCORE];
+	/** timing wheels, allocated the first time this backend is used */
+	struct timer_wheel *wheels[RTE_MAX_LCORE];
+};
+
+#define TIMER_MAX_DATA 64
+
+/** default timer data, used by the API without timer data id */
+static struct rte_timer_data default_timer_data;
+
+/** timer data instances, indexed by id */
+static struct rte_timer_data *timer_data_arr[TIMER_MAX_DATA] = {
+	&default_timer_data,
+};
 
 /* when debug is enabled, store some statistics */
 #ifdef RTE_LIBRTE_TIMER_DEBUG
-#define __TIMER_STAT_ADD(name, n) do {					\
+#define __TIMER_STAT_ADD(priv_timer, name, n) do {			\
 		unsigned __lcore_id = rte_lcore_id();			\
 		if (__lcore_id < RTE_MAX_LCORE)				\
 			priv_timer[__lcore_id].stats.name += (n);	\
 	} while(0)
 #else
-#define __TIMER_STAT_ADD(name, n) do {} while(0)
+#define __TIMER_STAT_ADD(priv_timer, name, n) do {} while(0)
 #endif
 
+/* get a timer data instance from its id */
+static inline struct rte_timer_data *
+timer_data_get(uint32_t timer_data_id)
+{
+	if (timer_data_id >= TIMER_MAX_DATA)
+		return NULL;
+	return timer_data_arr[timer_data_id];
+}
+
+/* init the lists of a timer data instance */
+static void
+timer_data_init(struct rte_timer_data *data)
+{
+	unsigned lcore_id;
+
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id ++) {
+		rte_spinlock_init(&data->priv_timer[lcore_id].list_lock);
+		data->priv_timer[lcore_id].prev_lcore = lcore_id;
+		data->priv_timer[lcore_id].wheel = NULL;
+	}
+}
+
+/* return 1 if some timers are pending in a timer data instance */
+static int
+timer_data_busy(const struct rte_timer_data *data)
+{
+	const struct priv_timer *priv_timer = data->priv_timer;
+	unsigned lcore_id;
+
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		if (priv_timer[lcore_id].pending_head.sl_next[0] != NULL ||
+				(priv_timer[lcore_id].wheel != NULL &&
+				 priv_timer[lcore_id].wheel->count != 0))
+			return 1;
+	}
+	return 0;
+}
+
+/* select the backend of a timer data instance */
+static int
+timer_data_set_backend(struct rte_timer_data *data,
+		enum rte_timer_backend backend)
+{
+	struct timer_wheel *wheel;
+	uint64_t tick_cycles;
+	unsigned lcore_id, shift;
+
+	if (backend != RTE_TIMER_BACKEND_SKIPLIST &&
+			backend != RTE_TIMER_BACKEND_WHEEL)
+		return -EINVAL;
+
+	if (timer_data_busy(data))
+		return -EBUSY;
+
+	if (backend == RTE_TIMER_BACKEND_SKIPLIST) {
+		timer_data_init(data);
+		return 0;
+	}
+
+	/* the tick is the power of 2 of timer cycles closest to
+	 * TIMER_WHEEL_TICK_NS, rounded down */
+	tick_cycles = rte_get_timer_hz() * TIMER_WHEEL_TICK_NS / 1000000000;
+	shift = tick_cycles > 1 ? 63 - __builtin_clzll(tick_cycles) : 0;
+
+	RTE_LCORE_FOREACH(lcore_id) {
+		if (data->wheels[lcore_id] != NULL)
+			continue;
+		data->wheels[lcore_id] = rte_zmalloc_socket("timer_wheel",
+				sizeof(struct timer_wheel), RTE_CACHE_LINE_SIZE,
+				rte_lcore_to_socket_id(lcore_id));
+		if (data->wheels[lcore_id] == NULL)
+			return -ENOMEM;
+	}
+
+	timer_data_init(data);
+	RTE_LCORE_FOREACH(lcore_id) {
+		wheel = data->wheels[lcore_id];
+		wheel->tick_shift = shift;
+		wheel->cur_tick = rte_get_timer_cycles() >> shift;
+		data->priv_timer[lcore_id].wheel = wheel;
+	}
+
+	return 0;
+}
+
 /* Init the timer library. */
 void
 rte_timer_subsystem_init(void)
 {
+	/* since the default timer data is static, it's zeroed by default,
+	 * so only init some fields.
+	 */
+	timer_data_init(&default_timer_data);
+}
+
+/* Init the timer library with a given backend. */
+int
+rte_timer_subsystem_init_backend(enum rte_timer_backend backend)
+{
+	return timer_data_set_backend(&default_timer_data, backend);
+}
+
+/* Allocate a timer data instance */
+int
+rte_timer_data_alloc(uint32_t *id_ptr)
+{
+	struct rte_timer_data *data;
+	uint32_t id;
+
+	if (id_ptr == NULL)
+		return -EINVAL;
+
+	for (id = 0; id < TIMER_MAX_DATA; id++)
+		if (timer_data_arr[id] == NULL)
+			break;
+	if (id == TIMER_MAX_DATA)
+		return -ENOSPC;
+
+	data = rte_zmalloc("timer_data", sizeof(*data), RTE_CACHE_LINE_SIZE);
+	if (data == NULL)
+		return -ENOMEM;
+	timer_data_init(data);
+
+	timer_data_arr[id] = data;
+	*id_ptr = id;
+	return 0;
+}
+
+/* Free a timer data instance */
+int
+rte_timer_data_dealloc(uint32_t timer_data_id)
+{
+	struct rte_timer_data *data = timer_data_get(timer_data_id);
 	unsigned lcore_id;
 
-	/* since priv_timer is static, it's zeroed by default, so only init some
-	 * fields.
-	 */
-	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id ++) {
-		rte_spinlock_init(&priv_timer[lcore_id].list_lock);
-		priv_timer[lcore_id].prev_lcore = lcore_id;
-	}
+	if (data == NULL || data == &default_timer_data)
+		return -EINVAL;
+	if (timer_data_busy(data))
+		return -EBUSY;
+
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++)
+		rte_free(data->wheels[lcore_id]);
+	timer_data_arr[timer_data_id] = NULL;
+	rte_free(data);
+	return 0;
+}
+
+/* Select the backend of a timer data instance */
+int
+rte_timer_data_set_backend(uint32_t timer_data_id,
+		enum rte_timer_backend backend)
+{
+	struct rte_timer_data *data = timer_data_get(timer_data_id);
+
+	if (data == NULL)
+		return -EINVAL;
+	return timer_data_set_backend(data, backend);
 }
 
 /* Initialize the timer handle tim for use */
@@ -125,7 +313,8 @@ rte_timer_init(struct rte_timer *tim)
  */
 static int
 timer_set_config_state(struct rte_timer *tim,
-		       union rte_timer_status *ret_prev_status)
+		       union rte_timer_status *ret_prev_status,
+		       struct priv_timer *priv_timer)
 {
 	union rte_timer_status prev_status, status;
 	int success = 0;
@@ -237,7 +426,7 @@ timer_get_skiplist_level(unsigned curr_depth)
  */
 static void
 timer_get_prev_entries(uint64_t time_val, unsigned tim_lcore,
-		struct rte_timer **prev)
+		struct rte_timer **prev, struct priv_timer *priv_timer)
 {
 	unsigned lvl = priv_timer[tim_lcore].curr_skiplist_depth;
 	prev[lvl] = &priv_timer[tim_lcore].pending_head;
@@ -256,13 +445,13 @@ timer_get_prev_entries(uint64_t time_val, unsigned tim_lcore,
  */
 static void
 timer_get_prev_entries_for_node(struct rte_timer *tim, unsigned tim_lcore,
-		struct rte_timer **prev)
+		struct rte_timer **prev, struct priv_timer *priv_timer)
 {
 	int i;
 	/* to get a specific entry in the list, look for just lower than the time
 	 * values, and then increment on each level individually if necessary
 	 */
-	timer_get_prev_entries(tim->expire - 1, tim_lcore, prev);
+	timer_get_prev_entries(tim->expire - 1, tim_lcore, prev, priv_timer);
 	for (i = priv_timer[tim_lcore].curr_skiplist_depth - 1; i >= 0; i--) {
 		while (prev[i]->sl_next[i] != NULL &&
 				prev[i]->sl_next[i] != tim &&
@@ -271,27 +460,196 @@ timer_get_prev_entries_for_node(struct rte_timer *tim, unsigned tim_lcore,
 	}
 }
 
+/* return the first used slot of a wheel level from idx, or TIMER_WHEEL_SLOTS */
+static unsigned
+timer_wheel_next_used(const struct timer_wheel *wheel, unsigned lvl,
+		unsigned idx)
+{
+	uint64_t bits;
+	unsigned i = idx / 64;
+
+	if (idx >= TIMER_WHEEL_SLOTS)
+		return TIMER_WHEEL_SLOTS;
+	bits = wheel->used[lvl][i] & (UINT64_MAX << (idx % 64));
+	while (bits == 0) {
+		if (++i == TIMER_WHEEL_SLOTS / 64)
+			return TIMER_WHEEL_SLOTS;
+		bits = wheel->used[lvl][i];
+	}
+	return i * 64 + __builtin_ctzll(bits);
+}
+
+/* return the expiry tick of a timer, rounded up so that it is never early */
+static inline uint64_t
+timer_wheel_tick(const struct timer_wheel *wheel, const struct rte_timer *tim)
+{
+	return (tim->expire + (UINT64_C(1) << wheel->tick_shift) - 1) >>
+		wheel->tick_shift;
+}
+
+/* add a timer in the slot of its expiry tick */
+static void
+timer_wheel_insert(struct timer_wheel *wheel, struct rte_timer *tim)
+{
+	uint64_t tick, delta;
+	struct rte_timer **head;
+	unsigned lvl = 0, idx;
+
+	tick = timer_wheel_tick(wheel, tim);
+	if (tick < wheel->cur_tick)
+		tick = wheel->cur_tick;
+	delta = tick - wheel->cur_tick;
+	/* too far in the future: wait in the last slot, it will be
+	 * inserted again when this slot is cascaded */
+	if (delta > TIMER_WHEEL_MAX_TICKS) {
+		delta = TIMER_WHEEL_MAX_TICKS;
+		tick = wheel->cur_tick + delta;
+	}
+	while (delta >= (UINT64_C(1) << (TIMER_WHEEL_BITS * (lvl + 1))))
+		lvl++;
+	idx = (tick >> (TIMER_WHEEL_BITS * lvl)) & TIMER_WHEEL_MASK;
+
+	head = &wheel->slots[lvl][idx];
+	tim->wh_next = *head;
+	if (*head != NULL)
+		(*head)->wh_pprev = &tim->wh_next;
+	*head = tim;
+	tim->wh_pprev = head;
+	wheel->used[lvl][idx / 64] |= UINT64_C(1) << (idx % 64);
+}
+
+/* remove a timer from its slot, if it was not taken by the manager */
+static void
+timer_wheel_remove(struct timer_wheel *wheel, struct rte_timer *tim)
+{
+	struct rte_timer **first = &wheel->slots[0][0];
+	unsigned slot;
+
+	if (tim->wh_pprev == NULL)
+		return;
+
+	*tim->wh_pprev = tim->wh_next;
+	if (tim->wh_next != NULL)
+		tim->wh_next->wh_pprev = tim->wh_pprev;
+	else if (tim->wh_pprev >= first &&
+			tim->wh_pprev < first +
+				TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS &&
+			*tim->wh_pprev == NULL) {
+		/* the slot is empty now */
+		slot = tim->wh_pprev - first;
+		wheel->used[slot / TIMER_WHEEL_SLOTS][slot % TIMER_WHEEL_SLOTS / 64]
+			&= ~(UINT64_C(1) << (slot % 64));
+	}
+	tim->wh_pprev = NULL;
+	wheel->count--;
+}
+
+/* take all the timers of a slot */
+static struct rte_timer *
+timer_wheel_take_slot(struct timer_wheel *wheel, unsigned lvl, unsigned idx)
+{
+	struct rte_timer *list = wheel->slots[lvl][idx];
+
+	wheel->slots[lvl][idx] = NULL;
+	wheel->used[lvl][idx / 64] &= ~(UINT64_C(1) << (idx % 64));
+	return list;
+}
+
+/*
+ * Advance the wheel up to a tick included, and return the list of timers
+ * which expired, linked by wh_next. The timers are not in the wheel anymore.
+ */
+static struct rte_timer *
+timer_wheel_advance(struct timer_wheel *wheel, uint64_t end_tick)
+{
+	struct rte_timer *run_first = NULL, **run_last = &run_first;
+	struct rte_timer *tim, *next;
+	unsigned lvl, idx, next_idx;
+
+	while (wheel->cur_tick <= end_tick) {
+		idx = wheel->cur_tick & TIMER_WHEEL_MASK;
+
+		/* start of a new round: cascade the upper levels, the timers
+		 * which already expired go directly to the run list */
+		for (lvl = 1; idx == 0 && lvl < TIMER_WHEEL_LEVELS; lvl++) {
+			unsigned up_idx = (wheel->cur_tick >>
+				(TIMER_WHEEL_BITS * lvl)) & TIMER_WHEEL_MASK;
+
+			for (tim = timer_wheel_take_slot(wheel, lvl, up_idx);
+					tim != NULL; tim = next) {
+				next = tim->wh_next;
+				if (timer_wheel_tick(wheel, tim) > end_tick) {
+					timer_wheel_insert(wheel, tim);
+					continue;
+				}
+				tim->wh_pprev = NULL;
+				wheel->count--;
+				*run_last = tim;
+				run_last = &tim->wh_next;
+			}
+			*run_last = NULL;
+			if (up_idx != 0)
+				break;
+		}
+
+		tim = timer_wheel_take_slot(wheel, 0, idx);
+		if (tim != NULL) {
+			*run_last = tim;
+			for (; tim != NULL; tim = tim->wh_next) {
+				tim->wh_pprev = NULL;
+				wheel->count--;
+				run_last = &tim->wh_next;
+			}
+		}
+
+		/* skip the empty slots up to the end of the round */
+		next_idx = timer_wheel_next_used(wheel, 0, idx + 1);
+		if (wheel->cur_tick + (next_idx - idx) > end_tick + 1)
+			wheel->cur_tick = end_tick + 1;
+		else
+			wheel->cur_tick += next_idx - idx;
+	}
+
+	return run_first;
+}
+
 /*
  * add in list, lock if needed
  * timer must be in config state
  * timer must not be in a list
  */
 static void
-timer_add(struct rte_timer *tim, unsigned tim_lcore, int local_is_locked)
+timer_add(struct rte_timer *tim, unsigned tim_lcore, unsigned locked_lcore,
+		struct priv_timer *priv_timer)
 {
-	unsigned lcore_id = rte_lcore_id();
 	unsigned lvl;
 	struct rte_timer *prev[MAX_SKIPLIST_DEPTH+1];
 
-	/* if timer needs to be scheduled on another core, we need to
-	 * lock the list; if it is on local core, we need to lock if
-	 * we are not called from rte_timer_manage() */
-	if (tim_lcore != lcore_id || !local_is_locked)
+	/* we need to lock the list of the core, unless the caller, like
+	 * rte_timer_manage(), already did */
+	if (tim_lcore != locked_lcore)
 		rte_spinlock_lock(&priv_timer[tim_lcore].list_lock);
 
+	if (priv_timer[tim_lcore].wheel != NULL) {
+		struct timer_wheel *wheel = priv_timer[tim_lcore].wheel;
+
+		/* the manager does not advance an empty wheel: catch up
+		 * with the time spent idle, all its slots are empty */
+		if (wheel->count == 0) {
+			uint64_t cur_tick = rte_get_timer_cycles() >>
+				wheel->tick_shift;
+
+			if (cur_tick > wheel->cur_tick)
+				wheel->cur_tick = cur_tick;
+		}
+		timer_wheel_insert(wheel, tim);
+		wheel->count++;
+		goto unlock;
+	}
+
 	/* find where exactly this element goes in the list of elements
 	 * for each depth. */
-	timer_get_prev_entries(tim->expire, tim_lcore, prev);
+	timer_get_prev_entries(tim->expire, tim_lcore, prev, priv_timer);
 
 	/* now assign it a new level and add at that level */
 	const unsigned tim_level = timer_get_skiplist_level(
@@ -313,7 +671,8 @@ timer_add(struct rte_timer *tim, unsigned tim_lcore, int local_is_locked)
 	priv_timer[tim_lcore].pending_head.expire = priv_timer[tim_lcore].\
 			pending_head.sl_next[0]->expire;
 
-	if (tim_lcore != lcore_id || !local_is_locked)
+unlock:
+	if (tim_lcore != locked_lcore)
 		rte_spinlock_unlock(&priv_timer[tim_lcore].list_lock);
 }
 
@@ -324,19 +683,22 @@ timer_add(struct rte_timer *tim, unsigned tim_lcore, int local_is_locked)
  */
 static void
 timer_del(struct rte_timer *tim, union rte_timer_status prev_status,
-		int local_is_locked)
+		unsigned locked_lcore, struct priv_timer *priv_timer)
 {
-	unsigned lcore_id = rte_lcore_id();
 	unsigned prev_owner = prev_status.owner;
 	int i;
 	struct rte_timer *prev[MAX_SKIPLIST_DEPTH+1];
 
-	/* if timer needs is pending another core, we need to lock the
-	 * list; if it is on local core, we need to lock if we are not
-	 * called from rte_timer_manage() */
-	if (prev_owner != lcore_id || !local_is_locked)
+	/* we need to lock the list of the core where the timer is pending,
+	 * unless the caller, like rte_timer_manage(), already did */
+	if (prev_owner != locked_lcore)
 		rte_spinlock_lock(&priv_timer[prev_owner].list_lock);
 
+	if (priv_timer[prev_owner].wheel != NULL) {
+		timer_wheel_remove(priv_timer[prev_owner].wheel, tim);
+		goto unlock;
+	}
+
 	/* save the lowest list entry into the expire field of the dummy hdr.
 	 * NOTE: this is not atomic on 32-bit */
 	if (tim == priv_timer[prev_owner].pending_head.sl_next[0])
@@ -344,7 +706,7 @@ timer_del(struct rte_timer *tim, union rte_timer_status prev_status,
 				((tim->sl_next[0] == NULL) ? 0 : tim->sl_next[0]->expire);
 
 	/* adjust pointers from previous entries to point past this */
-	timer_get_prev_entries_for_node(tim, prev_owner, prev);
+	timer_get_prev_entries_for_node(tim, prev_owner, prev, priv_timer);
 	for (i = priv_timer[prev_owner].curr_skiplist_depth - 1; i >= 0; i--) {
 		if (prev[i]->sl_next[i] == tim)
 			prev[i]->sl_next[i] = tim->sl_next[i];
@@ -357,7 +719,8 @@ timer_del(struct rte_timer *tim, union rte_timer_status prev_status,
 		else
 			break;
 
-	if (prev_owner != lcore_id || !local_is_locked)
+unlock:
+	if (prev_owner != locked_lcore)
 		rte_spinlock_unlock(&priv_timer[prev_owner].list_lock);
 }
 
@@ -366,7 +729,8 @@ static int
 __rte_timer_reset(struct rte_timer *tim, uint64_t expire,
 		  uint64_t period, unsigned tim_lcore,
 		  rte_timer_cb_t fct, void *arg,
-		  int local_is_locked)
+		  unsigned locked_lcore,
+		  struct priv_timer *priv_timer)
 {
 	union rte_timer_status prev_status, status;
 	int ret;
@@ -388,11 +752,11 @@ __rte_timer_reset(struct rte_timer *tim, uint64_t expire,
 
 	/* wait that the timer is in correct status before update,
 	 * and mark it as being configured */
-	ret = timer_set_config_state(tim, &prev_status);
+	ret = timer_set_config_state(tim, &prev_status, priv_timer);
 	if (ret < 0)
 		return -1;
 
-	__TIMER_STAT_ADD(reset, 1);
+	__TIMER_STAT_ADD(priv_timer, reset, 1);
 	if (prev_status.state == RTE_TIMER_RUNNING &&
 	    lcore_id < RTE_MAX_LCORE) {
 		priv_timer[lcore_id].updated = 1;
@@ -400,8 +764,8 @@ __rte_timer_reset(struct rte_timer *tim, uint64_t expire,
 
 	/* remove it from list */
 	if (prev_status.state == RTE_TIMER_PENDING) {
-		timer_del(tim, prev_status, local_is_locked);
-		__TIMER_STAT_ADD(pending, -1);
+		timer_del(tim, prev_status, locked_lcore, priv_timer);
+		__TIMER_STAT_ADD(priv_timer, pending, -1);
 	}
 
 	tim->period = period;
@@ -409,8 +773,8 @@ __rte_timer_reset(struct rte_timer *tim, uint64_t expire,
 	tim->f = fct;
 	tim->arg = arg;
 
-	__TIMER_STAT_ADD(pending, 1);
-	timer_add(tim, tim_lcore, local_is_locked);
+	__TIMER_STAT_ADD(priv_timer, pending, 1);
+	timer_add(tim, tim_lcore, locked_lcore, priv_timer);
 
 	/* update state: as we are in CONFIG state, only us can modify
 	 * the state so we don't need to use cmpset() here */
@@ -422,11 +786,12 @@ __rte_timer_reset(struct rte_timer *tim, uint64_t expire,
 	return 0;
 }
 
-/* Reset and start the timer associated with the timer handle tim */
-int
-rte_timer_reset(struct rte_timer *tim, uint64_t ticks,
+/* Reset and start the timer on a timer data instance (private func) */
+static int
+timer_reset(struct rte_timer *tim, uint64_t ticks,
 		enum rte_timer_type type, unsigned tim_lcore,
-		rte_timer_cb_t fct, void *arg)
+		rte_timer_cb_t fct, void *arg,
+		struct priv_timer *priv_timer)
 {
 	uint64_t cur_time = rte_get_timer_cycles();
 	uint64_t period;
@@ -441,7 +806,31 @@ rte_timer_reset(struct rte_timer *tim, uint64_t ticks,
 		period = 0;
 
 	return __rte_timer_reset(tim,  cur_time + ticks, period, tim_lcore,
-			  fct, arg, 0);
+			  fct, arg, RTE_MAX_LCORE, priv_timer);
+}
+
+/* Reset and start the timer associated with the timer handle tim */
+int
+rte_timer_reset(struct rte_timer *tim, uint64_t ticks,
+		enum rte_timer_type type, unsigned tim_lcore,
+		rte_timer_cb_t fct, void *arg)
+{
+	return timer_reset(tim, ticks, type, tim_lcore, fct, arg,
+			default_timer_data.priv_timer);
+}
+
+/* Reset and start the timer on a given timer data instance */
+int
+rte_timer_alt_reset(uint32_t timer_data_id, struct rte_timer *tim,
+		    uint64_t ticks, enum rte_timer_type type,
+		    unsigned tim_lcore, rte_timer_cb_t fct, void *arg)
+{
+	struct rte_timer_data *data = timer_data_get(timer_data_id);
+
+	if (data == NULL)
+		return -EINVAL;
+	return timer_reset(tim, ticks, type, tim_lcore, fct, arg,
+			data->priv_timer);
 }
 
 /* loop until rte_timer_reset() succeed */
@@ -455,9 +844,9 @@ rte_timer_reset_sync(struct rte_timer *tim, uint64_t ticks,
 		rte_pause();
 }
 
-/* Stop the timer associated with the timer handle tim */
-int
-rte_timer_stop(struct rte_timer *tim)
+/* Stop the timer on a timer data instance (private func) */
+static int
+timer_stop(struct rte_timer *tim, struct priv_timer *priv_timer)
 {
 	union rte_timer_status prev_status, status;
 	unsigned lcore_id = rte_lcore_id();
@@ -465,11 +854,11 @@ rte_timer_stop(struct rte_timer *tim)
 
 	/* wait that the timer is in correct status before update,
 	 * and mark it as being configured */
-	ret = timer_set_config_state(tim, &prev_status);
+	ret = timer_set_config_state(tim, &prev_status, priv_timer);
 	if (ret < 0)
 		return -1;
 
-	__TIMER_STAT_ADD(stop, 1);
+	__TIMER_STAT_ADD(priv_timer, stop, 1);
 	if (prev_status.state == RTE_TIMER_RUNNING &&
 	    lcore_id < RTE_MAX_LCORE) {
 		priv_timer[lcore_id].updated = 1;
@@ -477,8 +866,8 @@ rte_timer_stop(struct rte_timer *tim)
 
 	/* remove it from list */
 	if (prev_status.state == RTE_TIMER_PENDING) {
-		timer_del(tim, prev_status, 0);
-		__TIMER_STAT_ADD(pending, -1);
+		timer_del(tim, prev_status, RTE_MAX_LCORE, priv_timer);
+		__TIMER_STAT_ADD(priv_timer, pending, -1);
 	}
 
 	/* mark timer as stopped */
@@ -490,6 +879,24 @@ rte_timer_stop(struct rte_timer *tim)
 	return 0;
 }
 
+/* Stop the timer associated with the timer handle tim */
+int
+rte_timer_stop(struct rte_timer *tim)
+{
+	return timer_stop(tim, default_timer_data.priv_timer);
+}
+
+/* Stop the timer on a given timer data instance */
+int
+rte_timer_alt_stop(uint32_t timer_data_id, struct rte_timer *tim)
+{
+	struct rte_timer_data *data = timer_data_get(timer_data_id);
+
+	if (data == NULL)
+		return -EINVAL;
+	return timer_stop(tim, data->priv_timer);
+}
+
 /* loop until rte_timer_stop() succeed */
 void
 rte_timer_stop_sync(struct rte_timer *tim)
@@ -505,23 +912,48 @@ rte_timer_pending(struct rte_timer *tim)
 	return tim->status.state == RTE_TIMER_PENDING;
 }
 
-/* must be called periodically, run all timer that expired */
-void rte_timer_manage(void)
+/*
+ * run all expired timers of the list of list_lcore on the calling lcore,
+ * with f, or with their own callback if f is NULL
+ */
+static void
+timer_manage(struct priv_timer *priv_timer, unsigned list_lcore,
+		rte_timer_alt_manage_cb_t f)
 {
 	union rte_timer_status status;
 	struct rte_timer *tim, *next_tim;
 	struct rte_timer *run_first_tim, **pprev;
 	unsigned lcore_id = rte_lcore_id();
 	struct rte_timer *prev[MAX_SKIPLIST_DEPTH + 1];
-	uint64_t cur_time;
+	struct timer_wheel *wheel;
+	uint64_t cur_time, cur_tick;
 	int i, ret;
 
 	/* timer manager only runs on EAL thread with valid lcore_id */
 	assert(lcore_id < RTE_MAX_LCORE);
 
-	__TIMER_STAT_ADD(manage, 1);
+	__TIMER_STAT_ADD(priv_timer, manage, 1);
+	wheel = priv_timer[list_lcore].wheel;
+	if (wheel != NULL) {
+		/* optimize for the cases where the wheel is empty, or
+		 * where the current tick was already processed */
+		if (wheel->count == 0)
+			return;
+		cur_tick = rte_get_timer_cycles() >> wheel->tick_shift;
+		if (likely(cur_tick < wheel->cur_tick))
+			return;
+
+		rte_spinlock_lock(&priv_timer[list_lcore].list_lock);
+		tim = timer_wheel_advance(wheel, cur_tick);
+		if (tim == NULL) {
+			rte_spinlock_unlock(&priv_timer[list_lcore].list_lock);
+			return;
+		}
+		goto run_list;
+	}
+
 	/* optimize for the case where per-cpu list is empty */
-	if (priv_timer[lcore_id].pending_head.sl_next[0] == NULL)
+	if (priv_timer[list_lcore].pending_head.sl_next[0] == NULL)
 		return;
 	cur_time = rte_get_timer_cycles();
 
@@ -529,35 +961,36 @@ void rte_timer_manage(void)
 	/* on 64-bit the value cached in the pending_head.expired will be
 	 * updated atomically, so we can consult that for a quick check here
 	 * outside the lock */
-	if (likely(priv_timer[lcore_id].pending_head.expire > cur_time))
+	if (likely(priv_timer[list_lcore].pending_head.expire > cur_time))
 		return;
 #endif
 
 	/* browse ordered list, add expired timers in 'expired' list */
-	rte_spinlock_lock(&priv_timer[lcore_id].list_lock);
+	rte_spinlock_lock(&priv_timer[list_lcore].list_lock);
 
 	/* if nothing to do just unlock and return */
-	if (priv_timer[lcore_id].pending_head.sl_next[0] == NULL ||
-	    priv_timer[lcore_id].pending_head.sl_next[0]->expire > cur_time) {
-		rte_spinlock_unlock(&priv_timer[lcore_id].list_lock);
+	if (priv_timer[list_lcore].pending_head.sl_next[0] == NULL ||
+	    priv_timer[list_lcore].pending_head.sl_next[0]->expire > cur_time) {
+		rte_spinlock_unlock(&priv_timer[list_lcore].list_lock);
 		return;
 	}
 
 	/* save start of list of expired timers */
-	tim = priv_timer[lcore_id].pending_head.sl_next[0];
+	tim = priv_timer[list_lcore].pending_head.sl_next[0];
 
 	/* break the existing list at current time point */
-	timer_get_prev_entries(cur_time, lcore_id, prev);
-	for (i = priv_timer[lcore_id].curr_skiplist_depth -1; i >= 0; i--) {
-		if (prev[i] == &priv_timer[lcore_id].pending_head)
+	timer_get_prev_entries(cur_time, list_lcore, prev, priv_timer);
+	for (i = priv_timer[list_lcore].curr_skiplist_depth -1; i >= 0; i--) {
+		if (prev[i] == &priv_timer[list_lcore].pending_head)
 			continue;
-		priv_timer[lcore_id].pending_head.sl_next[i] =
+		priv_timer[list_lcore].pending_head.sl_next[i] =
 		    prev[i]->sl_next[i];
 		if (prev[i]->sl_next[i] == NULL)
-			priv_timer[lcore_id].curr_skiplist_depth--;
+			priv_timer[list_lcore].curr_skiplist_depth--;
 		prev[i] ->sl_next[i] = NULL;
 	}
 
+run_list:
 	/* transition run-list from PENDING to RUNNING */
 	run_first_tim = tim;
 	pprev = &run_first_tim;
@@ -577,11 +1010,11 @@ void rte_timer_manage(void)
 	}
 
 	/* update the next to expire timer value */
-	priv_timer[lcore_id].pending_head.expire =
-	    (priv_timer[lcore_id].pending_head.sl_next[0] == NULL) ? 0 :
-		priv_timer[lcore_id].pending_head.sl_next[0]->expire;
+	priv_timer[list_lcore].pending_head.expire =
+	    (priv_timer[list_lcore].pending_head.sl_next[0] == NULL) ? 0 :
+		priv_timer[list_lcore].pending_head.sl_next[0]->expire;
 
-	rte_spinlock_unlock(&priv_timer[lcore_id].list_lock);
+	rte_spinlock_unlock(&priv_timer[list_lcore].list_lock);
 
 	/* now scan expired list and call callbacks */
 	for (tim = run_first_tim; tim != NULL; tim = next_tim) {
@@ -590,9 +1023,12 @@ void rte_timer_manage(void)
 		priv_timer[lcore_id].running_tim = tim;
 
 		/* execute callback function with list unlocked */
-		tim->f(tim, tim->arg);
+		if (f != NULL)
+			f(tim);
+		else
+			tim->f(tim, tim->arg);
 
-		__TIMER_STAT_ADD(pending, -1);
+		__TIMER_STAT_ADD(priv_timer, pending, -1);
 		/* the timer was stopped or reloaded by the callback
 		 * function, we have nothing to do here */
 		if (priv_timer[lcore_id].updated == 1)
@@ -607,22 +1043,56 @@ void rte_timer_manage(void)
 		}
 		else {
 			/* keep it in list and mark timer as pending */
-			rte_spinlock_lock(&priv_timer[lcore_id].list_lock);
+			rte_spinlock_lock(&priv_timer[list_lcore].list_lock);
 			status.state = RTE_TIMER_PENDING;
-			__TIMER_STAT_ADD(pending, 1);
-			status.owner = (int16_t)lcore_id;
+			__TIMER_STAT_ADD(priv_timer, pending, 1);
+			status.owner = (int16_t)list_lcore;
 			rte_wmb();
 			tim->status.u32 = status.u32;
 			__rte_timer_reset(tim, tim->expire + tim->period,
-				tim->period, lcore_id, tim->f, tim->arg, 1);
-			rte_spinlock_unlock(&priv_timer[lcore_id].list_lock);
+				tim->period, list_lcore, tim->f, tim->arg,
+				list_lcore, priv_timer);
+			rte_spinlock_unlock(&priv_timer[list_lcore].list_lock);
 		}
 	}
 	priv_timer[lcore_id].running_tim = NULL;
 }
 
-/* dump statistics about timers */
-void rte_timer_dump_stats(FILE *f)
+/* must be called periodically, run all timer that expired */
+void rte_timer_manage(void)
+{
+	timer_manage(default_timer_data.priv_timer, rte_lcore_id(), NULL);
+}
+
+/* run the expired timers of several lcores of a timer data instance */
+int
+rte_timer_alt_manage(uint32_t timer_data_id, unsigned int *poll_lcores,
+		     int n_poll_lcores, rte_timer_alt_manage_cb_t f)
+{
+	struct rte_timer_data *data = timer_data_get(timer_data_id);
+	unsigned int lcore_id = rte_lcore_id();
+	int i;
+
+	if (data == NULL || lcore_id >= RTE_MAX_LCORE)
+		return -EINVAL;
+
+	if (poll_lcores == NULL) {
+		timer_manage(data->priv_timer, lcore_id, f);
+		return 0;
+	}
+
+	for (i = 0; i < n_poll_lcores; i++) {
+		if (poll_lcores[i] >= RTE_MAX_LCORE)
+			return -EINVAL;
+		timer_manage(data->priv_timer, poll_lcores[i], f);
+	}
+
+	return 0;
+}
+
+/* dump statistics about the timers of a timer data instance */
+static void
+timer_dump_stats(struct priv_timer *priv_timer, FILE *f)
 {
 #ifdef RTE_LIBRTE_TIMER_DEBUG
 	struct rte_timer_debug_stats sum;
@@ -641,6 +1111,25 @@ void rte_timer_dump_stats(FILE *f)
 	fprintf(f, "  manage = %"PRIu64"\n", sum.manage);
 	fprintf(f, "  pending = %"PRIu64"\n", sum.pending);
 #else
+	RTE_SET_USED(priv_timer);
 	fprintf(f, "No timer statistics, RTE_LIBRTE_TIMER_DEBUG is disabled\n");
 #endif
 }
+
+/* dump statistics about timers */
+void rte_timer_dump_stats(FILE *f)
+{
+	timer_dump_stats(default_timer_data.priv_timer, f);
+}
+
+/* dump statistics about the timers of a given timer data instance */
+int
+rte_timer_alt_dump_stats(uint32_t timer_data_id, FILE *f)
+{
+	struct rte_timer_data *data = timer_data_get(timer_data_id);
+
+	if (data == NULL)
+		return -EINVAL;
+	timer_dump_stats(data->priv_timer, f);
+	return 0;
+}
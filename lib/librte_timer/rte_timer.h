@@ -79,6 +79,14 @@ extern "C" {
 
 #define RTE_TIMER_NO_OWNER -2 /**< Timer has no owner. */
 
+/**
+ * Data structure used to keep the pending timers of an lcore.
+ */
+enum rte_timer_backend {
+	RTE_TIMER_BACKEND_SKIPLIST, /**< Skiplist ordered by expiry time. */
+	RTE_TIMER_BACKEND_WHEEL,    /**< Hierarchical timing wheel. */
+};
+
 /**
  * Timer type: Periodic or single (one-shot).
  */
@@ -127,7 +135,18 @@ typedef void (*rte_timer_cb_t)(struct rte_timer *, void *);
 struct rte_timer
 {
 	uint64_t expire;       /**< Time when timer expire. */
-	struct rte_timer *sl_next[MAX_SKIPLIST_DEPTH];
+	RTE_STD_C11
+	union {
+		/** Next timers in the skiplist. */
+		struct rte_timer *sl_next[MAX_SKIPLIST_DEPTH];
+		RTE_STD_C11
+		struct {
+			/** Next timer in the timing wheel slot. */
+			struct rte_timer *wh_next;
+			/** Link pointing to this timer in the timing wheel. */
+			struct rte_timer **wh_pprev;
+		};
+	};
 	volatile union rte_timer_status status; /**< Status of timer. */
 	uint64_t period;       /**< Period of timer (0 if not periodic). */
 	rte_timer_cb_t f;      /**< Callback function. */
@@ -167,6 +186,81 @@ struct rte_timer
  */
 void rte_timer_subsystem_init(void);
 
+/**
+ * Initialize the timer library with a given backend.
+ *
+ * Like rte_timer_subsystem_init(), with a choice of the data structure
+ * keeping the pending timers of each lcore:
+ * - RTE_TIMER_BACKEND_SKIPLIST: a skiplist ordered by expiry time, where
+ *   adding a timer is O(log n). This is the default.
+ * - RTE_TIMER_BACKEND_WHEEL: a hierarchical timing wheel with a resolution
+ *   of about one microsecond, where adding and removing a timer is O(1).
+ *   A timer may expire up to one resolution step late, and the timers
+ *   run by one call to rte_timer_manage() are not ordered by expiry time.
+ *
+ * The backend may only be changed while no timer is pending.
+ *
+ * @param backend
+ *   The backend to use for all lcores.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): Unknown backend.
+ *   - (-EBUSY): Some timers are pending.
+ *   - (-ENOMEM): The timing wheels cannot be allocated.
+ */
+int rte_timer_subsystem_init_backend(enum rte_timer_backend backend);
+
+/**
+ * Allocate a timer data instance.
+ *
+ * A timer data instance is a set of per-lcore timer lists, independent of
+ * the default one used by rte_timer_reset(), rte_timer_stop() and
+ * rte_timer_manage(). Its timers are handled with rte_timer_alt_reset(),
+ * rte_timer_alt_stop() and rte_timer_alt_manage(). A timer must always be
+ * used with the same instance while it is pending. The new instance uses
+ * the skiplist backend.
+ *
+ * @param id_ptr
+ *   Pointer to store the id of the new timer data instance.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): id_ptr is NULL.
+ *   - (-ENOSPC): The maximum number of instances is reached.
+ *   - (-ENOMEM): The instance cannot be allocated.
+ */
+int rte_timer_data_alloc(uint32_t *id_ptr);
+
+/**
+ * Free a timer data instance.
+ *
+ * @param timer_data_id
+ *   The id of a timer data instance returned by rte_timer_data_alloc().
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): Invalid id, or the default instance.
+ *   - (-EBUSY): Some timers are pending in the instance.
+ */
+int rte_timer_data_dealloc(uint32_t timer_data_id);
+
+/**
+ * Select the backend of a timer data instance.
+ *
+ * See rte_timer_subsystem_init_backend() for the description of the
+ * backends.
+ *
+ * @param timer_data_id
+ *   The id of a timer data instance.
+ * @param backend
+ *   The backend to use for all lcores of the instance.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): Invalid id or unknown backend.
+ *   - (-EBUSY): Some timers are pending in the instance.
+ *   - (-ENOMEM): The timing wheels cannot be allocated.
+ */
+int rte_timer_data_set_backend(uint32_t timer_data_id,
+			       enum rte_timer_backend backend);
+
 /**
  * Initialize a timer handle.
  *
@@ -322,6 +416,85 @@ int rte_timer_pending(struct rte_timer *tim);
  */
 void rte_timer_manage(void);
 
+/**
+ * Reset and start a timer of a timer data instance.
+ *
+ * Same as rte_timer_reset(), with the lists of the timer data instance
+ * *timer_data_id*.
+ *
+ * @param timer_data_id
+ *   The id of a timer data instance.
+ * @param tim
+ *   The timer handle.
+ * @param ticks
+ *   The number of cycles (see rte_get_timer_hz()) before the callback
+ *   function is called.
+ * @param type
+ *   PERIODICAL or SINGLE, see rte_timer_reset().
+ * @param tim_lcore
+ *   The ID of the lcore list where the timer is pending, or LCORE_ID_ANY
+ *   for a round-robin among the lcores.
+ * @param fct
+ *   The callback function of the timer.
+ * @param arg
+ *   The user argument of the callback function.
+ * @return
+ *   - 0: Success; the timer is scheduled.
+ *   - (-1): Timer is in the RUNNING or CONFIG state.
+ *   - (-EINVAL): Invalid timer data id.
+ */
+int rte_timer_alt_reset(uint32_t timer_data_id, struct rte_timer *tim,
+			uint64_t ticks, enum rte_timer_type type,
+			unsigned tim_lcore, rte_timer_cb_t fct, void *arg);
+
+/**
+ * Stop a timer of a timer data instance.
+ *
+ * Same as rte_timer_stop(), with the lists of the timer data instance
+ * *timer_data_id*.
+ *
+ * @param timer_data_id
+ *   The id of a timer data instance.
+ * @param tim
+ *   The timer handle.
+ * @return
+ *   - 0: Success; the timer is stopped.
+ *   - (-1): The timer is in the RUNNING or CONFIG state.
+ *   - (-EINVAL): Invalid timer data id.
+ */
+int rte_timer_alt_stop(uint32_t timer_data_id, struct rte_timer *tim);
+
+/**
+ * Callback function type for rte_timer_alt_manage().
+ */
+typedef void (*rte_timer_alt_manage_cb_t)(struct rte_timer *tim);
+
+/**
+ * Run the expired timers of several lcores of a timer data instance.
+ *
+ * The expired timers pending on the lists of the lcores *poll_lcores* are
+ * run on the calling lcore, which must be an EAL thread, one list after
+ * the other. A periodic timer is reloaded on the list it came from.
+ * Several lcores may poll the same lists.
+ *
+ * @param timer_data_id
+ *   The id of a timer data instance.
+ * @param poll_lcores
+ *   Array of the lcore ids whose lists are polled. If NULL, only the list
+ *   of the calling lcore is polled.
+ * @param n_poll_lcores
+ *   Number of elements in poll_lcores.
+ * @param f
+ *   Function called with each expired timer. If NULL, the callback
+ *   function of the timer is called, as in rte_timer_manage().
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): Invalid timer data id or lcore id, or the calling thread
+ *     is not an EAL thread.
+ */
+int rte_timer_alt_manage(uint32_t timer_data_id, unsigned int *poll_lcores,
+			 int n_poll_lcores, rte_timer_alt_manage_cb_t f);
+
 /**
  * Dump statistics about timers.
  *
@@ -330,6 +503,19 @@ void rte_timer_manage(void);
  */
 void rte_timer_dump_stats(FILE *f);
 
+/**
+ * Dump statistics about the timers of a timer data instance.
+ *
+ * @param timer_data_id
+ *   The id of a timer data instance.
+ * @param f
+ *   A pointer to a file for output
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): Invalid timer data id.
+ */
+int rte_timer_alt_dump_stats(uint32_t timer_data_id, FILE *f);
+
 #ifdef __cplusplus
 }
 #endif
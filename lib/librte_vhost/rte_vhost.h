@@ -181,6 +181,21 @@ void rte_vhost_log_write(int vid, uint64_t addr, uint64_t len);
 void rte_vhost_log_used_vring(int vid, uint16_t vring_idx,
 			      uint64_t offset, uint64_t len);
 
+/**
+ * Enable or disable the notifications the guest sends when it makes new
+ * buffers available in a vring, i.e. the writes to the vring kickfd.
+ * Notifications are disabled when a device is set up, as the host is
+ * expected to poll the vrings.
+ *
+ * @param vid
+ *  vhost device ID
+ * @param queue_id
+ *  the vring index
+ * @param enable
+ *  1 to let the guest kick the host, 0 to suppress the kicks
+ * @return
+ *  0 on success, -1 on failure
+ */
 int rte_vhost_enable_guest_notification(int vid, uint16_t queue_id, int enable);
 
 /**
@@ -79,6 +79,9 @@ do_recursive_call(void)
 		int (*action_fn)(void);
 	} actions[] =  {
 			{ "run_secondary_instances", test_mp_secondary },
+			{ "test_malloc_hotplug", test_malloc_hotplug },
+			{ "test_malloc_hotplug_primary",
+					test_malloc_hotplug_primary },
 			{ "test_missing_c_flag", no_action },
 			{ "test_master_lcore_flag", no_action },
 			{ "test_invalid_n_flag", no_action },
@@ -95,6 +98,7 @@ do_recursive_call(void)
 			{ "test_memory_flags", no_action },
 			{ "test_file_prefix", no_action },
 			{ "test_no_huge_flag", no_action },
+			{ "test_in_memory_flag", no_action },
 	};
 
 	if (recursive_call == NULL)
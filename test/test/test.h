@@ -230,6 +230,9 @@ int commands_init(void);
 
 int test_mp_secondary(void);
 
+int test_malloc_hotplug(void);
+int test_malloc_hotplug_primary(void);
+
 int test_set_rxtx_conf(cmdline_fixed_string_t mode);
 int test_set_rxtx_anchor(cmdline_fixed_string_t type);
 int test_set_rxtx_sc(cmdline_fixed_string_t type);
@@ -40,6 +40,7 @@
 #include <libgen.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <inttypes.h>
 #include <errno.h>
 #include <unistd.h>
 #include <dirent.h>
@@ -47,7 +48,9 @@
 #include <sys/file.h>
 #include <limits.h>
 
+#include <rte_cycles.h>
 #include <rte_debug.h>
+#include <rte_eal.h>
 #include <rte_string_fns.h>
 
 #include "process.h"
@@ -810,6 +813,87 @@ test_no_huge_flag(void)
 	return 0;
 }
 
+/*
+ * Test that --in-memory runs a primary process without leaving any file
+ * behind (neither runtime config, hugepage info nor hugepage files) and
+ * that it is refused for a secondary process. Also report the startup
+ * time against a default primary process.
+ */
+static int
+test_in_memory_flag(void)
+{
+#ifdef RTE_EXEC_ENV_BSDAPP
+	/* BSD target doesn't support prefixes at this point */
+	return 0;
+#else
+	const char *in_memory = "--in-memory";
+	const char *huge = rte_eal_has_hugepages() ? "-v" : no_huge;
+	const char *home = getenv("HOME");
+	const char *dir = getuid() == 0 ? "/var/run" : home;
+	char path[PATH_MAX];
+	uint64_t start, default_cycles, in_memory_cycles;
+
+	/* default primary process, used as a reference for startup time */
+	const char *argv0[] = {prgname, "--file-prefix=inmemory_ref", huge,
+			"-c", "1", "-n", "2", "-m", DEFAULT_MEM_SIZE};
+	/* in-memory primary process */
+	const char *argv1[] = {prgname, "--file-prefix=inmemory", huge,
+			in_memory, "-c", "1", "-n", "2", "-m", DEFAULT_MEM_SIZE};
+	/* in-memory secondary process (should fail) */
+	const char *argv2[] = {prgname, "--file-prefix=inmemory", huge,
+			in_memory, mp_flag, "-c", "1", "-n", "2"};
+
+	if (dir == NULL) {
+		printf("Error - unable to get runtime directory\n");
+		return -1;
+	}
+
+	start = rte_get_timer_cycles();
+	if (launch_proc(argv0) != 0) {
+		printf("Error - process did not run ok with default flags\n");
+		return -1;
+	}
+	default_cycles = rte_get_timer_cycles() - start;
+	if (process_hugefiles("inmemory_ref", HUGEPAGE_DELETE) < 0) {
+		printf("Error - cannot delete hugepage files\n");
+		return -1;
+	}
+
+	start = rte_get_timer_cycles();
+	if (launch_proc(argv1) != 0) {
+		printf("Error - process did not run ok with --in-memory flag\n");
+		return -1;
+	}
+	in_memory_cycles = rte_get_timer_cycles() - start;
+
+	snprintf(path, sizeof(path), "%s/.%s_config", dir, "inmemory");
+	if (access(path, F_OK) == 0) {
+		printf("Error - --in-memory process created %s\n", path);
+		return -1;
+	}
+	snprintf(path, sizeof(path), "%s/.%s_hugepage_info", dir, "inmemory");
+	if (access(path, F_OK) == 0) {
+		printf("Error - --in-memory process created %s\n", path);
+		return -1;
+	}
+	if (process_hugefiles("inmemory", HUGEPAGE_CHECK_EXISTS) != 0) {
+		printf("Error - --in-memory process left hugepage files\n");
+		return -1;
+	}
+
+	if (launch_proc(argv2) == 0) {
+		printf("Error - secondary process ran ok with --in-memory flag\n");
+		return -1;
+	}
+
+	printf("Startup time: default %"PRIu64" ms, in-memory %"PRIu64" ms\n",
+		default_cycles * 1000 / rte_get_timer_hz(),
+		in_memory_cycles * 1000 / rte_get_timer_hz());
+
+	return 0;
+#endif
+}
+
 #ifdef RTE_LIBRTE_XEN_DOM0
 static int
 test_dom0_misc_flags(void)
@@ -1391,6 +1475,12 @@ test_eal_flags(void)
 		return ret;
 	}
 
+	ret = test_in_memory_flag();
+	if (ret < 0) {
+		printf("Error in test_in_memory_flag()\n");
+		return ret;
+	}
+
 	ret = test_whitelist_flag();
 	if (ret < 0) {
 		printf("Error in test_invalid_whitelist_flag()\n");
@@ -52,6 +52,7 @@
 #include "test.h"
 
 #include <rte_hash.h>
+#include <rte_rcu_qsbr.h>
 #include <rte_fbk_hash.h>
 #include <rte_jhash.h>
 #include <rte_hash_crc.h>
@@ -90,6 +91,17 @@ static uint32_t hashtest_key_lens[] = {0, 2, 4, 5, 6, 7, 8, 10, 11, 15, 16, 21,
 	}								\
 } while(0)
 
+/* Also puts the reader offline, so that freeing the table does not wait */
+#define RETURN_IF_ERROR_RCU(cond, str, ...) do {			\
+	if (cond) {							\
+		printf("ERROR line %d: " str "\n", __LINE__, ##__VA_ARGS__); \
+		rte_rcu_qsbr_thread_offline(v, 0);			\
+		if (handle) rte_hash_free(handle);			\
+		rte_free(v);						\
+		return -1;						\
+	}								\
+} while(0)
+
 /* 5-tuple key type */
 struct flow_key {
 	uint32_t ip_src;
@@ -1242,6 +1254,238 @@ static int test_hash_iteration(void)
 	return -1;
 }
 
+/*
+ * Fill a table whose keys all have the same hash. Its upper 16 bits,
+ * the short signature, are 0, so the alternative bucket of a key is its
+ * primary bucket and all but the first RTE_HASH_BUCKET_ENTRIES keys are
+ * stored in extendable buckets.
+ */
+#define EXT_TABLE_ENTRIES 64
+static int test_hash_ext_table(uint8_t extra_flag)
+{
+	struct rte_hash_parameters params = {
+		.name = "test_hash_ext_table",
+		.entries = EXT_TABLE_ENTRIES,
+		.key_len = sizeof(uint32_t),
+		.hash_func = pseudo_hash,
+		.hash_func_init_val = 0,
+		.socket_id = 0,
+		.extra_flag = RTE_HASH_EXTRA_FLAGS_EXT_TABLE | extra_flag,
+	};
+	struct rte_hash *handle;
+	uint32_t keys[EXT_TABLE_ENTRIES + 1];
+	const void *key_ptrs[EXT_TABLE_ENTRIES];
+	int32_t pos[EXT_TABLE_ENTRIES];
+	int32_t positions[EXT_TABLE_ENTRIES];
+	void *bulk_data[EXT_TABLE_ENTRIES];
+	const void *next_key;
+	void *next_data;
+	void *data;
+	uint64_t hit_mask;
+	uint32_t iter;
+	unsigned i, round, count;
+	int ret;
+
+	handle = rte_hash_create(&params);
+	RETURN_IF_ERROR(handle == NULL, "hash creation failed");
+
+	for (i = 0; i <= EXT_TABLE_ENTRIES; i++)
+		keys[i] = i;
+
+	/* Second round checks the extendable buckets are recycled */
+	for (round = 0; round < 2; round++) {
+		for (i = 0; i < EXT_TABLE_ENTRIES; i++) {
+			ret = rte_hash_add_key_data(handle, &keys[i],
+					(void *)((uintptr_t)i));
+			RETURN_IF_ERROR(ret < 0,
+				"failed to add key %u (round %u)", i, round);
+			pos[i] = rte_hash_lookup(handle, &keys[i]);
+		}
+		ret = rte_hash_add_key(handle, &keys[EXT_TABLE_ENTRIES]);
+		RETURN_IF_ERROR(ret != -ENOSPC,
+			"key added beyond table entries (ret=%d)", ret);
+
+		for (i = 0; i < EXT_TABLE_ENTRIES; i++) {
+			ret = rte_hash_lookup_data(handle, &keys[i], &data);
+			RETURN_IF_ERROR(ret != pos[i] ||
+				data != (void *)((uintptr_t)i),
+				"failed to find key %u (ret=%d)", i, ret);
+			key_ptrs[i] = &keys[i];
+		}
+
+		ret = rte_hash_lookup_bulk(handle, key_ptrs, EXT_TABLE_ENTRIES,
+				positions);
+		RETURN_IF_ERROR(ret != 0, "bulk lookup failed");
+		for (i = 0; i < EXT_TABLE_ENTRIES; i++)
+			RETURN_IF_ERROR(positions[i] != pos[i],
+				"bulk lookup of key %u returned %d", i,
+				positions[i]);
+
+		/* Delete a key in the middle of the chain, then re-add it */
+		ret = rte_hash_del_key(handle, &keys[EXT_TABLE_ENTRIES / 2]);
+		RETURN_IF_ERROR(ret != pos[EXT_TABLE_ENTRIES / 2],
+			"failed to delete key (ret=%d)", ret);
+		ret = rte_hash_lookup_bulk_data(handle, key_ptrs,
+				EXT_TABLE_ENTRIES, &hit_mask, bulk_data);
+		RETURN_IF_ERROR(ret != EXT_TABLE_ENTRIES - 1 ||
+			(hit_mask & (1ULL << (EXT_TABLE_ENTRIES / 2))),
+			"bulk lookup found %d keys after delete", ret);
+		if (extra_flag & RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF)
+			rte_hash_free_key_with_position(handle,
+					pos[EXT_TABLE_ENTRIES / 2]);
+		ret = rte_hash_add_key_data(handle,
+				&keys[EXT_TABLE_ENTRIES / 2],
+				(void *)((uintptr_t)(EXT_TABLE_ENTRIES / 2)));
+		RETURN_IF_ERROR(ret < 0, "failed to add back deleted key");
+		pos[EXT_TABLE_ENTRIES / 2] = rte_hash_lookup(handle,
+				&keys[EXT_TABLE_ENTRIES / 2]);
+
+		count = 0;
+		iter = 0;
+		while (rte_hash_iterate(handle, &next_key, &next_data,
+				&iter) >= 0) {
+			RETURN_IF_ERROR(*(const uint32_t *)next_key !=
+				(uintptr_t)next_data,
+				"wrong data iterated for key %u",
+				*(const uint32_t *)next_key);
+			count++;
+		}
+		RETURN_IF_ERROR(count != EXT_TABLE_ENTRIES,
+			"iterated %u keys instead of %u", count,
+			EXT_TABLE_ENTRIES);
+
+		for (i = 0; i < EXT_TABLE_ENTRIES; i++) {
+			ret = rte_hash_del_key(handle, &keys[i]);
+			RETURN_IF_ERROR(ret != pos[i],
+				"failed to delete key %u (ret=%d)", i, ret);
+			if (extra_flag & RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF)
+				rte_hash_free_key_with_position(handle, ret);
+		}
+		for (i = 0; i < EXT_TABLE_ENTRIES; i++) {
+			ret = rte_hash_lookup(handle, &keys[i]);
+			RETURN_IF_ERROR(ret != -ENOENT,
+				"found deleted key %u (ret=%d)", i, ret);
+		}
+	}
+
+	rte_hash_free(handle);
+	return 0;
+}
+
+static unsigned int rcu_freed_keys;
+static uintptr_t rcu_freed_data;
+
+static void
+test_hash_rcu_free_key_data(void *p, void *key_data)
+{
+	RTE_SET_USED(p);
+	rcu_freed_keys++;
+	rcu_freed_data = (uintptr_t)key_data;
+}
+
+/*
+ * Check that with a QS variable attached, the key slot of a deleted key is
+ * only reused once the reader reported a quiescent state.
+ */
+static int test_hash_rcu_qsbr(enum rte_hash_qsbr_mode mode)
+{
+	struct rte_hash_parameters params = {
+		.name = "test_hash_rcu_qsbr",
+		.entries = EXT_TABLE_ENTRIES,
+		.key_len = sizeof(uint32_t),
+		.hash_func = pseudo_hash,
+		.hash_func_init_val = 0,
+		.socket_id = 0,
+		.extra_flag = RTE_HASH_EXTRA_FLAGS_EXT_TABLE |
+			RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF,
+	};
+	struct rte_hash_rcu_config rcu_cfg = {
+		.v = NULL,
+		.mode = mode,
+		.free_key_data_func = test_hash_rcu_free_key_data,
+	};
+	struct rte_hash *handle;
+	struct rte_rcu_qsbr *v;
+	uint32_t keys[EXT_TABLE_ENTRIES + 1];
+	unsigned i;
+	int ret;
+
+	v = rte_zmalloc(NULL, rte_rcu_qsbr_get_memsize(1), RTE_CACHE_LINE_SIZE);
+	if (v == NULL) {
+		printf("ERROR line %d: QS variable allocation failed\n",
+			__LINE__);
+		return -1;
+	}
+	rte_rcu_qsbr_init(v, 1);
+	rte_rcu_qsbr_thread_register(v, 0);
+
+	handle = rte_hash_create(&params);
+	RETURN_IF_ERROR_RCU(handle == NULL, "hash creation failed");
+
+	ret = rte_hash_rcu_qsbr_add(handle, &rcu_cfg);
+	RETURN_IF_ERROR_RCU(ret != -EINVAL, "QS variable missing (ret=%d)",
+			ret);
+	rcu_cfg.v = v;
+	ret = rte_hash_rcu_qsbr_add(handle, &rcu_cfg);
+	RETURN_IF_ERROR_RCU(ret != 0, "failed to attach QS variable");
+	ret = rte_hash_rcu_qsbr_add(handle, &rcu_cfg);
+	RETURN_IF_ERROR_RCU(ret != -EEXIST, "QS variable attached twice");
+
+	rcu_freed_keys = 0;
+	for (i = 0; i <= EXT_TABLE_ENTRIES; i++)
+		keys[i] = i;
+	for (i = 0; i < EXT_TABLE_ENTRIES; i++) {
+		ret = rte_hash_add_key_data(handle, &keys[i],
+				(void *)((uintptr_t)i));
+		RETURN_IF_ERROR_RCU(ret < 0, "failed to add key %u", i);
+	}
+
+	if (mode == RTE_HASH_QSBR_MODE_DQ) {
+		/* The reader may still reference the deleted key */
+		rte_rcu_qsbr_thread_online(v, 0);
+		ret = rte_hash_del_key(handle, &keys[1]);
+		RETURN_IF_ERROR_RCU(ret < 0, "failed to delete key");
+		ret = rte_hash_free_key_with_position(handle, ret);
+		RETURN_IF_ERROR_RCU(ret != -EINVAL,
+			"key slot freed by the application (ret=%d)", ret);
+		ret = rte_hash_add_key(handle, &keys[EXT_TABLE_ENTRIES]);
+		RETURN_IF_ERROR_RCU(ret != -ENOSPC || rcu_freed_keys != 0,
+			"key slot reused during the grace period (ret=%d)",
+			ret);
+
+		rte_rcu_qsbr_quiescent(v, 0);
+	} else {
+		/* The delete waits for online readers only */
+		ret = rte_hash_del_key(handle, &keys[1]);
+		RETURN_IF_ERROR_RCU(ret < 0, "failed to delete key");
+	}
+
+	ret = rte_hash_add_key_data(handle, &keys[EXT_TABLE_ENTRIES],
+			(void *)((uintptr_t)EXT_TABLE_ENTRIES));
+	RETURN_IF_ERROR_RCU(ret < 0, "key slot not reclaimed (ret=%d)", ret);
+	RETURN_IF_ERROR_RCU(rcu_freed_keys != 1 || rcu_freed_data != 1,
+		"freed %u keys, last data %u", rcu_freed_keys,
+		(unsigned)rcu_freed_data);
+
+	/* Keys still in the defer queue are freed with the table */
+	rte_rcu_qsbr_thread_offline(v, 0);
+	for (i = 0; i <= EXT_TABLE_ENTRIES; i++) {
+		if (i == 1)
+			continue;
+		ret = rte_hash_del_key(handle, &keys[i]);
+		RETURN_IF_ERROR_RCU(ret < 0, "failed to delete key %u", i);
+	}
+	rte_hash_free(handle);
+	handle = NULL;
+	RETURN_IF_ERROR_RCU(rcu_freed_keys != EXT_TABLE_ENTRIES + 1,
+		"freed %u keys instead of %u", rcu_freed_keys,
+		EXT_TABLE_ENTRIES + 1);
+
+	rte_rcu_qsbr_thread_unregister(v, 0);
+	rte_free(v);
+	return 0;
+}
+
 static uint8_t key[16] = {0x00, 0x01, 0x02, 0x03,
 			0x04, 0x05, 0x06, 0x07,
 			0x08, 0x09, 0x0a, 0x0b,
@@ -1505,6 +1749,14 @@ test_hash(void)
 		return -1;
 	if (test_hash_iteration() < 0)
 		return -1;
+	if (test_hash_ext_table(0) < 0)
+		return -1;
+	if (test_hash_ext_table(RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF) < 0)
+		return -1;
+	if (test_hash_rcu_qsbr(RTE_HASH_QSBR_MODE_DQ) < 0)
+		return -1;
+	if (test_hash_rcu_qsbr(RTE_HASH_QSBR_MODE_SYNC) < 0)
+		return -1;
 
 	run_hash_func_tests();
 
@@ -244,6 +244,182 @@ test_hash_multiwriter(void)
 	return -1;
 }
 
+/*
+ * Lock-free readers: resident keys are looked up while writers add (and
+ * delete) other keys into a nearly full table, causing cuckoo moves of the
+ * resident keys. A lookup must never miss a resident key.
+ */
+#define RW_LF_ENTRIES (1 << 16)
+#define RW_LF_NB_RESIDENT (RW_LF_ENTRIES / 2)
+#define RW_LF_NB_CHURN (RW_LF_ENTRIES * 2 / 5)
+#define RW_LF_NB_ROUNDS 20
+#define RW_LF_BURST 64
+
+struct {
+	struct rte_hash *h;
+	uint32_t *keys;
+	int32_t *positions;
+	unsigned int nb_writers;
+	unsigned int with_del;
+	rte_atomic32_t next_role;
+	rte_atomic32_t writers_done;
+	rte_atomic64_t lookups;
+	rte_atomic64_t misses;
+} tbl_rw_lf_test_params;
+
+static void
+test_hash_rw_lf_writer(unsigned int id)
+{
+	unsigned int slice = RW_LF_NB_CHURN / tbl_rw_lf_test_params.nb_writers;
+	uint32_t *keys = tbl_rw_lf_test_params.keys + RW_LF_NB_RESIDENT +
+			id * slice;
+	struct rte_hash *h = tbl_rw_lf_test_params.h;
+	unsigned int i, r, nb_rounds;
+	int32_t pos;
+
+	nb_rounds = tbl_rw_lf_test_params.with_del ? RW_LF_NB_ROUNDS : 1;
+	for (r = 0; r < nb_rounds; r++) {
+		for (i = 0; i < slice; i++)
+			rte_hash_add_key(h, keys + i);
+		if (!tbl_rw_lf_test_params.with_del)
+			continue;
+		/*
+		 * Readers never look up the churn keys, so their slots can be
+		 * freed right away.
+		 */
+		for (i = 0; i < slice; i++) {
+			pos = rte_hash_del_key(h, keys + i);
+			if (pos >= 0)
+				rte_hash_free_key_with_position(h, pos);
+		}
+	}
+
+	rte_atomic32_inc(&tbl_rw_lf_test_params.writers_done);
+}
+
+static void
+test_hash_rw_lf_reader(void)
+{
+	const void *key_ptrs[RW_LF_BURST];
+	int32_t pos[RW_LF_BURST];
+	struct rte_hash *h = tbl_rw_lf_test_params.h;
+	uint32_t *keys = tbl_rw_lf_test_params.keys;
+	int32_t *positions = tbl_rw_lf_test_params.positions;
+	uint64_t lookups = 0, misses = 0;
+	unsigned int i, j;
+
+	do {
+		for (i = 0; i < RW_LF_NB_RESIDENT; i += RW_LF_BURST) {
+			for (j = 0; j < RW_LF_BURST; j++)
+				key_ptrs[j] = keys + i + j;
+			rte_hash_lookup_bulk(h, key_ptrs, RW_LF_BURST, pos);
+			for (j = 0; j < RW_LF_BURST; j++)
+				if (pos[j] != positions[i + j])
+					misses++;
+			/* Alternate with single key lookups */
+			if (rte_hash_lookup(h, keys + i) != positions[i])
+				misses++;
+			lookups += RW_LF_BURST + 1;
+		}
+	} while ((unsigned int)rte_atomic32_read(
+			&tbl_rw_lf_test_params.writers_done) <
+			tbl_rw_lf_test_params.nb_writers);
+
+	rte_atomic64_add(&tbl_rw_lf_test_params.lookups, lookups);
+	rte_atomic64_add(&tbl_rw_lf_test_params.misses, misses);
+}
+
+static int
+test_hash_rw_lf_worker(__attribute__((unused)) void *arg)
+{
+	unsigned int id;
+
+	id = rte_atomic32_add_return(&tbl_rw_lf_test_params.next_role, 1) - 1;
+	if (id < tbl_rw_lf_test_params.nb_writers)
+		test_hash_rw_lf_writer(id);
+	else
+		test_hash_rw_lf_reader();
+
+	return 0;
+}
+
+static int
+test_hash_rw_lf(unsigned int nb_writers, unsigned int with_del)
+{
+	struct rte_hash_parameters hash_params = {
+		.name = "test_rw_lf",
+		.entries = RW_LF_ENTRIES,
+		.key_len = sizeof(uint32_t),
+		.hash_func = rte_hash_crc,
+		.hash_func_init_val = 0,
+		.socket_id = rte_socket_id(),
+		.extra_flag = RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF,
+	};
+	struct rte_hash *handle;
+	uint32_t *keys = NULL;
+	int32_t *positions = NULL;
+	unsigned int i;
+	int ret = -1;
+
+	if (nb_writers > 1)
+		hash_params.extra_flag |= RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_ADD;
+
+	handle = rte_hash_create(&hash_params);
+	RETURN_IF_ERROR(handle == NULL, "hash creation failed");
+
+	keys = rte_malloc(NULL, sizeof(uint32_t) *
+			(RW_LF_NB_RESIDENT + RW_LF_NB_CHURN), 0);
+	positions = rte_malloc(NULL, sizeof(int32_t) * RW_LF_NB_RESIDENT, 0);
+	if (keys == NULL || positions == NULL) {
+		printf("RTE_MALLOC failed\n");
+		goto out;
+	}
+
+	for (i = 0; i < RW_LF_NB_RESIDENT + RW_LF_NB_CHURN; i++)
+		keys[i] = i;
+	for (i = 0; i < RW_LF_NB_RESIDENT; i++) {
+		positions[i] = rte_hash_add_key(handle, keys + i);
+		if (positions[i] < 0) {
+			printf("resident key %u cannot be added\n", i);
+			goto out;
+		}
+	}
+
+	tbl_rw_lf_test_params.h = handle;
+	tbl_rw_lf_test_params.keys = keys;
+	tbl_rw_lf_test_params.positions = positions;
+	tbl_rw_lf_test_params.nb_writers = nb_writers;
+	tbl_rw_lf_test_params.with_del = with_del;
+	rte_atomic32_init(&tbl_rw_lf_test_params.next_role);
+	rte_atomic32_init(&tbl_rw_lf_test_params.writers_done);
+	rte_atomic64_init(&tbl_rw_lf_test_params.lookups);
+	rte_atomic64_init(&tbl_rw_lf_test_params.misses);
+
+	rte_eal_mp_remote_launch(test_hash_rw_lf_worker, NULL, CALL_MASTER);
+	rte_eal_mp_wait_lcore();
+
+	printf("%"PRId64" lookups, %"PRId64" resident keys missed\n",
+		rte_atomic64_read(&tbl_rw_lf_test_params.lookups),
+		rte_atomic64_read(&tbl_rw_lf_test_params.misses));
+	if (rte_atomic64_read(&tbl_rw_lf_test_params.misses) != 0)
+		goto out;
+
+	/* Nothing lost once the writers are done either */
+	for (i = 0; i < RW_LF_NB_RESIDENT; i++) {
+		if (rte_hash_lookup(handle, keys + i) != positions[i]) {
+			printf("key %u is lost\n", i);
+			goto out;
+		}
+	}
+
+	ret = 0;
+out:
+	rte_free(positions);
+	rte_free(keys);
+	rte_hash_free(handle);
+	return ret;
+}
+
 static int
 test_hash_multiwriter_main(void)
 {
@@ -275,6 +451,16 @@ test_hash_multiwriter_main(void)
 	if (test_hash_multiwriter() < 0)
 		return -1;
 
+	printf("Test lock-free readers with a writer adding and deleting\n");
+	if (test_hash_rw_lf(1, 1) < 0)
+		return -1;
+
+	if (rte_lcore_count() > 2) {
+		printf("Test lock-free readers with multiple writers adding\n");
+		if (test_hash_rw_lf(rte_lcore_count() / 2, 0) < 0)
+			return -1;
+	}
+
 	return 0;
 }
 
@@ -42,6 +42,7 @@
 #include <rte_jhash.h>
 #include <rte_fbk_hash.h>
 #include <rte_random.h>
+#include <rte_rwlock.h>
 #include <rte_string_fns.h>
 
 #include "test.h"
@@ -554,6 +555,167 @@ run_all_tbl_perf_tests(unsigned with_pushes)
 	return 0;
 }
 
+/*
+ * Lookup performance of readers while a writer adds and deletes keys,
+ * on a lock-free table and on a table protected by a reader-writer lock.
+ */
+#define RW_ENTRIES (1 << 16)
+#define RW_NB_RESIDENT (RW_ENTRIES / 2)
+#define RW_NB_CHURN (RW_ENTRIES / 4)
+#define RW_NB_PASSES 50
+
+static struct {
+	struct rte_hash *h;
+	rte_rwlock_t lock;
+	unsigned int use_lock;
+	unsigned int with_writer;
+	unsigned int nb_readers;
+	uint32_t keys[RW_NB_RESIDENT + RW_NB_CHURN];
+	rte_atomic32_t next_role;
+	rte_atomic32_t readers_done;
+	rte_atomic64_t cycles;
+	rte_atomic64_t lookups;
+} rw_perf;
+
+static void
+rw_perf_writer(void)
+{
+	uint32_t *keys = rw_perf.keys + RW_NB_RESIDENT;
+	unsigned int i;
+	int32_t pos;
+
+	while ((unsigned int)rte_atomic32_read(&rw_perf.readers_done) <
+			rw_perf.nb_readers) {
+		for (i = 0; i < RW_NB_CHURN; i++) {
+			if (rw_perf.use_lock)
+				rte_rwlock_write_lock(&rw_perf.lock);
+			rte_hash_add_key(rw_perf.h, keys + i);
+			if (rw_perf.use_lock)
+				rte_rwlock_write_unlock(&rw_perf.lock);
+		}
+		for (i = 0; i < RW_NB_CHURN; i++) {
+			if (rw_perf.use_lock)
+				rte_rwlock_write_lock(&rw_perf.lock);
+			pos = rte_hash_del_key(rw_perf.h, keys + i);
+			if (rw_perf.use_lock)
+				rte_rwlock_write_unlock(&rw_perf.lock);
+			/* Churn keys are never looked up, free them at once */
+			if (pos >= 0 && !rw_perf.use_lock)
+				rte_hash_free_key_with_position(rw_perf.h, pos);
+		}
+	}
+}
+
+static void
+rw_perf_reader(void)
+{
+	const void *key_ptrs[BURST_SIZE];
+	int32_t pos[BURST_SIZE];
+	uint64_t begin, cycles;
+	unsigned int i, j, pass;
+
+	begin = rte_rdtsc();
+	for (pass = 0; pass < RW_NB_PASSES; pass++) {
+		for (i = 0; i < RW_NB_RESIDENT; i += BURST_SIZE) {
+			for (j = 0; j < BURST_SIZE; j++)
+				key_ptrs[j] = rw_perf.keys + i + j;
+			if (rw_perf.use_lock)
+				rte_rwlock_read_lock(&rw_perf.lock);
+			rte_hash_lookup_bulk(rw_perf.h, key_ptrs, BURST_SIZE,
+					pos);
+			if (rw_perf.use_lock)
+				rte_rwlock_read_unlock(&rw_perf.lock);
+		}
+	}
+	cycles = rte_rdtsc() - begin;
+
+	rte_atomic64_add(&rw_perf.cycles, cycles);
+	rte_atomic64_add(&rw_perf.lookups,
+			(uint64_t)RW_NB_PASSES * RW_NB_RESIDENT);
+	rte_atomic32_inc(&rw_perf.readers_done);
+}
+
+static int
+rw_perf_worker(__attribute__((unused)) void *arg)
+{
+	unsigned int id;
+
+	id = rte_atomic32_add_return(&rw_perf.next_role, 1) - 1;
+	if (rw_perf.with_writer && id == 0)
+		rw_perf_writer();
+	else
+		rw_perf_reader();
+
+	return 0;
+}
+
+static int
+timed_rw_lookups(unsigned int use_lock, unsigned int with_writer)
+{
+	struct rte_hash_parameters params = {
+		.name = "test_hash_rw",
+		.entries = RW_ENTRIES,
+		.key_len = sizeof(uint32_t),
+		.hash_func = rte_hash_crc,
+		.hash_func_init_val = 0,
+		.socket_id = rte_socket_id(),
+	};
+	unsigned int i;
+
+	if (!use_lock)
+		params.extra_flag = RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF;
+	rw_perf.h = rte_hash_create(&params);
+	if (rw_perf.h == NULL) {
+		printf("Error creating table\n");
+		return -1;
+	}
+
+	for (i = 0; i < RW_NB_RESIDENT + RW_NB_CHURN; i++)
+		rw_perf.keys[i] = rte_rand();
+	for (i = 0; i < RW_NB_RESIDENT; i++)
+		rte_hash_add_key(rw_perf.h, rw_perf.keys + i);
+
+	rte_rwlock_init(&rw_perf.lock);
+	rw_perf.use_lock = use_lock;
+	rw_perf.with_writer = with_writer;
+	rw_perf.nb_readers = rte_lcore_count() - with_writer;
+	rte_atomic32_init(&rw_perf.next_role);
+	rte_atomic32_init(&rw_perf.readers_done);
+	rte_atomic64_init(&rw_perf.cycles);
+	rte_atomic64_init(&rw_perf.lookups);
+
+	rte_eal_mp_remote_launch(rw_perf_worker, NULL, CALL_MASTER);
+	rte_eal_mp_wait_lcore();
+
+	printf("%-18s%-18s%-18"PRIu64"\n",
+		use_lock ? "rwlock" : "lock-free",
+		with_writer ? "yes" : "no",
+		rte_atomic64_read(&rw_perf.cycles) /
+		rte_atomic64_read(&rw_perf.lookups));
+
+	rte_hash_free(rw_perf.h);
+	return 0;
+}
+
+static int
+run_rw_perf_tests(void)
+{
+	printf("\n\n *** Lookups concurrent with a writer ***\n");
+	printf("Results (in CPU cycles/lookup in bursts of %u)\n", BURST_SIZE);
+	printf("\n%-18s%-18s%-18s\n", "Table", "Writer", "Lookup_bulk");
+
+	if (timed_rw_lookups(0, 0) < 0)
+		return -1;
+	if (rte_lcore_count() < 2) {
+		printf("More than one lcore is required for concurrent writes\n");
+		return 0;
+	}
+	if (timed_rw_lookups(0, 1) < 0 || timed_rw_lookups(1, 1) < 0)
+		return -1;
+
+	return 0;
+}
+
 /* Control operation of performance testing of fbk hash. */
 #define LOAD_FACTOR 0.667	/* How full to make the hash table. */
 #define TEST_SIZE 1000000	/* How many operations to time. */
@@ -650,6 +812,9 @@ test_hash_perf(void)
 		if (run_all_tbl_perf_tests(with_pushes) < 0)
 			return -1;
 	}
+	if (run_rw_perf_tests() < 0)
+		return -1;
+
 	if (fbk_hash_perf_test() < 0)
 		return -1;
 
@@ -32,9 +32,13 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
 #include <stdarg.h>
 #include <sys/queue.h>
+#include <pthread.h>
 
 #include <rte_log.h>
 #include <rte_memory.h>
@@ -43,6 +47,7 @@
 #include <rte_eal.h>
 #include <rte_per_lcore.h>
 #include <rte_lcore.h>
+#include <rte_cycles.h>
 
 #include "test.h"
 
@@ -58,6 +63,183 @@
  * - Send logs with different types and levels, some should not be displayed.
  */
 
+#define LOG_PERF_ITERATIONS 256
+
+/* content of a memory stream after a flush */
+static const char *
+memstream_get(FILE *f, char **buf)
+{
+	fflush(f);
+	return *buf != NULL ? *buf : "";
+}
+
+/* cycles spent in RTE_LOG() for each message */
+static uint64_t
+log_perf(uint32_t level)
+{
+	uint64_t start;
+	unsigned int i;
+
+	start = rte_rdtsc();
+	for (i = 0; i < LOG_PERF_ITERATIONS; i++)
+		rte_log(level, RTE_LOGTYPE_TESTAPP1,
+			"TESTAPP1: perf message %u %s\n", i, "arg");
+	return (rte_rdtsc() - start) / LOG_PERF_ITERATIONS;
+}
+
+/* log from a non-EAL thread */
+static void *
+log_thread(void *arg __rte_unused)
+{
+	RTE_LOG(INFO, TESTAPP1, "thread\n");
+	return NULL;
+}
+
+/*
+ * Deferred logs
+ * =============
+ *
+ * - Check that the messages are written by rte_log_deferred_flush() only,
+ *   with the same text as in synchronous mode.
+ * - Check that critical messages are written at once, after the pending
+ *   messages, and that unhandled formats, long strings and messages of
+ *   non-EAL threads are written in order by the flush.
+ * - Fill the ring of the lcore and check the extra messages are dropped.
+ * - Measure the cost of suppressed and emitted messages in both modes.
+ */
+static int
+test_logs_deferred(void)
+{
+	uint32_t global_level = rte_log_get_global_level();
+	char expected[256], str[300];
+	char *buf = NULL;
+	size_t size = 0, off;
+	uint64_t suppressed, sync, deferred;
+	pthread_t thread;
+	unsigned int i;
+	FILE *devnull;
+	FILE *f;
+	int len, ret = -1;
+
+	f = open_memstream(&buf, &size);
+	if (f == NULL) {
+		printf("Cannot open memory stream\n");
+		return -1;
+	}
+	rte_openlog_stream(f);
+	rte_log_set_global_level(RTE_LOG_DEBUG);
+	rte_log_set_level(RTE_LOGTYPE_TESTAPP1, RTE_LOG_INFO);
+
+	if (rte_log_deferred_enable() < 0) {
+		printf("Cannot enable deferred logs\n");
+		goto out;
+	}
+
+	snprintf(expected, sizeof(expected),
+		"TESTAPP1: %d %-5s| %5.2f %lx %zu %c %p %.*s %%\n",
+		-42, "str", 3.14159, 0xabcUL, (size_t)7, 'z',
+		(void *)0x1234, 3, "truncated");
+	len = RTE_LOG(INFO, TESTAPP1,
+		"%d %-5s| %5.2f %lx %zu %c %p %.*s %%\n",
+		-42, "str", 3.14159, 0xabcUL, (size_t)7, 'z',
+		(void *)0x1234, 3, "truncated");
+	RTE_LOG(DEBUG, TESTAPP1, "not displayed\n");
+	if (len != 0) {
+		printf("Wrong return of deferred message: %d\n", len);
+		goto out;
+	}
+	if (strcmp(memstream_get(f, &buf), "") != 0) {
+		printf("Deferred message written before flush\n");
+		goto out;
+	}
+	if (rte_log_deferred_flush() != 1) {
+		printf("Wrong number of deferred messages flushed\n");
+		goto out;
+	}
+	if (strcmp(memstream_get(f, &buf), expected) != 0) {
+		printf("Wrong deferred message: %s\n", buf);
+		goto out;
+	}
+
+	off = strlen(buf);
+
+	/*
+	 * positional arguments and messages of non-EAL threads are queued
+	 * in order, critical messages are written at once after them
+	 */
+	RTE_LOG(INFO, TESTAPP1, "pending\n");
+	RTE_LOG(INFO, TESTAPP1, "%1$d\n", 1);
+	if (pthread_create(&thread, NULL, log_thread, NULL) != 0) {
+		printf("Cannot create thread\n");
+		goto out;
+	}
+	pthread_join(thread, NULL);
+	if (strcmp(memstream_get(f, &buf) + off, "") != 0) {
+		printf("Message written before flush\n");
+		goto out;
+	}
+	RTE_LOG(CRIT, TESTAPP1, "critical\n");
+	if (strcmp(memstream_get(f, &buf) + off,
+			"TESTAPP1: pending\nTESTAPP1: 1\nTESTAPP1: thread\n"
+			"TESTAPP1: critical\n") != 0) {
+		printf("Critical message not written in order\n");
+		goto out;
+	}
+	off = strlen(buf);
+
+	/* a long string is formatted now, and written by the flush */
+	memset(str, 'a', sizeof(str) - 1);
+	str[sizeof(str) - 1] = '\0';
+	RTE_LOG(INFO, TESTAPP1, "%s\n", str);
+	if (strcmp(memstream_get(f, &buf) + off, "") != 0 ||
+	    rte_log_deferred_flush() != 1) {
+		printf("Long message not deferred\n");
+		goto out;
+	}
+	if (strncmp(memstream_get(f, &buf) + off, "TESTAPP1: ", 10) != 0 ||
+	    strncmp(buf + off + 10, str, strlen(str)) != 0) {
+		printf("Wrong long message\n");
+		goto out;
+	}
+
+	/* a full ring drops the messages */
+	for (i = 0; i < RTE_LOG_DEFERRED_RING_SIZE + 10; i++)
+		RTE_LOG(INFO, TESTAPP1, "message %u\n", i);
+	if (rte_log_deferred_flush() != RTE_LOG_DEFERRED_RING_SIZE) {
+		printf("Wrong number of messages kept in ring\n");
+		goto out;
+	}
+	rte_log_dump(stdout);
+
+	/* cost of RTE_LOG(), the messages are written in /dev/null */
+	devnull = fopen("/dev/null", "w");
+	if (devnull == NULL) {
+		printf("Cannot open /dev/null\n");
+		goto out;
+	}
+	rte_openlog_stream(devnull);
+	suppressed = log_perf(RTE_LOG_DEBUG);
+	deferred = log_perf(RTE_LOG_INFO);
+	rte_log_deferred_flush();
+	rte_log_deferred_disable();
+	sync = log_perf(RTE_LOG_INFO);
+	rte_openlog_stream(f);
+	fclose(devnull);
+
+	printf("Cycles per log message: suppressed %"PRIu64
+		", synchronous %"PRIu64", deferred %"PRIu64"\n",
+		suppressed, sync, deferred);
+	ret = 0;
+
+out:
+	rte_log_deferred_disable();
+	rte_openlog_stream(NULL);
+	rte_log_set_global_level(global_level);
+	fclose(f);
+	free(buf);
+	return ret;
+}
+
 static int
 test_logs(void)
 {
@@ -83,7 +265,7 @@ test_logs(void)
 	RTE_LOG(ERR, TESTAPP1, "error message\n");
 	RTE_LOG(ERR, TESTAPP2, "error message (not displayed)\n");
 
-	return 0;
+	return test_logs_deferred();
 }
 
 REGISTER_TEST_COMMAND(logs_autotest, test_logs);
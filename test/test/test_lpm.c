@@ -34,9 +34,12 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <rte_ip.h>
 #include <rte_lpm.h>
+#include <rte_malloc.h>
+#include <rte_rcu_qsbr.h>
 
 #include "test.h"
 #include "test_xmmt_ops.h"
@@ -69,6 +72,7 @@ static int32_t test15(void);
 static int32_t test16(void);
 static int32_t test17(void);
 static int32_t test18(void);
+static int32_t test19(void);
 
 rte_lpm_test tests[] = {
 /* Test Cases */
@@ -90,7 +94,8 @@ rte_lpm_test tests[] = {
 	test15,
 	test16,
 	test17,
-	test18
+	test18,
+	test19
 };
 
 #define NUM_LPM_TESTS (sizeof(tests)/sizeof(tests[0]))
@@ -1295,6 +1300,86 @@ test18(void)
 	return PASS;
 }
 
+/*
+ * Test for deferred recycle of tbl8 with RCU
+ *  - step 1: check invalid RCU configurations are rejected
+ *  - step 2: add and delete a rule with depth=28, using the only tbl8
+ *  - step 3: check the tbl8 is not reused while the reader is online
+ *  - step 4: check it is reused once the reader reported a quiescent state
+ *  - step 5: check the tbl8 is freed by the delete in sync mode
+ */
+int32_t
+test19(void)
+{
+	struct rte_lpm *lpm = NULL;
+	struct rte_lpm_config config;
+	struct rte_lpm_rcu_config rcu_cfg;
+	struct rte_rcu_qsbr *v;
+	uint32_t ip, next_hop;
+	uint8_t depth = 28;
+	int32_t status;
+
+	v = rte_zmalloc(NULL, rte_rcu_qsbr_get_memsize(1), RTE_CACHE_LINE_SIZE);
+	TEST_LPM_ASSERT(v != NULL);
+	rte_rcu_qsbr_init(v, 1);
+	rte_rcu_qsbr_thread_register(v, 0);
+	rte_rcu_qsbr_thread_online(v, 0);
+
+	config.max_rules = MAX_RULES;
+	config.number_tbl8s = 1;
+	config.flags = 0;
+	ip = IPv4(192, 168, 100, 100);
+	next_hop = 1;
+
+	lpm = rte_lpm_create(__func__, SOCKET_ID_ANY, &config);
+	TEST_LPM_ASSERT(lpm != NULL);
+
+	memset(&rcu_cfg, 0, sizeof(rcu_cfg));
+	TEST_LPM_ASSERT(rte_lpm_rcu_qsbr_add(NULL, &rcu_cfg) == -EINVAL);
+	TEST_LPM_ASSERT(rte_lpm_rcu_qsbr_add(lpm, &rcu_cfg) == -EINVAL);
+	rcu_cfg.v = v;
+	rcu_cfg.mode = RTE_LPM_QSBR_MODE_DQ;
+	TEST_LPM_ASSERT(rte_lpm_rcu_qsbr_add(lpm, &rcu_cfg) == 0);
+	TEST_LPM_ASSERT(rte_lpm_rcu_qsbr_add(lpm, &rcu_cfg) == -EEXIST);
+
+	status = rte_lpm_add(lpm, ip, depth, next_hop);
+	TEST_LPM_ASSERT(status == 0);
+	status = rte_lpm_delete(lpm, ip, depth);
+	TEST_LPM_ASSERT(status == 0);
+
+	/* The reader may still walk the tbl8 */
+	status = rte_lpm_add(lpm, ip, depth, next_hop);
+	TEST_LPM_ASSERT(status == -ENOSPC);
+
+	rte_rcu_qsbr_quiescent(v, 0);
+	status = rte_lpm_add(lpm, ip, depth, next_hop);
+	TEST_LPM_ASSERT(status == 0);
+	status = rte_lpm_lookup(lpm, ip, &next_hop);
+	TEST_LPM_ASSERT(status == 0 && next_hop == 1);
+
+	rte_lpm_free(lpm);
+
+	/* The delete waits for the reader, which goes offline first */
+	lpm = rte_lpm_create(__func__, SOCKET_ID_ANY, &config);
+	TEST_LPM_ASSERT(lpm != NULL);
+	rcu_cfg.mode = RTE_LPM_QSBR_MODE_SYNC;
+	TEST_LPM_ASSERT(rte_lpm_rcu_qsbr_add(lpm, &rcu_cfg) == 0);
+
+	status = rte_lpm_add(lpm, ip, depth, next_hop);
+	TEST_LPM_ASSERT(status == 0);
+	rte_rcu_qsbr_thread_offline(v, 0);
+	status = rte_lpm_delete(lpm, ip, depth);
+	TEST_LPM_ASSERT(status == 0);
+	status = rte_lpm_add(lpm, ip, depth, next_hop);
+	TEST_LPM_ASSERT(status == 0);
+
+	rte_lpm_free(lpm);
+	rte_rcu_qsbr_thread_unregister(v, 0);
+	rte_free(v);
+
+	return PASS;
+}
+
 /*
  * Do all unit tests.
  */
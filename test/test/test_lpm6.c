@@ -80,6 +80,7 @@ static int32_t test25(void);
 static int32_t test26(void);
 static int32_t test27(void);
 static int32_t test28(void);
+static int32_t test29(void);
 
 rte_lpm6_test tests6[] = {
 /* Test Cases */
@@ -112,6 +113,7 @@ rte_lpm6_test tests6[] = {
 	test26,
 	test27,
 	test28,
+	test29,
 };
 
 #define NUM_LPM6_TESTS                (sizeof(tests6)/sizeof(tests6[0]))
@@ -1800,6 +1802,114 @@ test28(void)
 	return PASS;
 }
 
+/*
+ * Add nested rules /16, /32, /48, /64 and /128 with as few tbl8s as the
+ * /128 rule needs.
+ * Delete the /48 rule and check its addresses fall back to the /32 rule
+ * while the more specific rules are untouched.
+ * Delete the /128 rule and check the tbl8s it used can be taken by another
+ * /128 rule below the /64 rule, but not by one needing more tbl8s.
+ * Delete every rule and check all the tbl8s can be used again.
+ */
+int32_t
+test29(void)
+{
+	struct rte_lpm6 *lpm = NULL;
+	struct rte_lpm6_config config;
+	uint8_t ip[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+	uint8_t depths[] = {16, 32, 48, 64, 128};
+	uint8_t probes[RTE_DIM(depths)][16];
+	uint8_t ip_64_128[16], ip_32_128[16];
+	uint32_t next_hop_return = 0;
+	int32_t status = 0;
+	unsigned i;
+
+	/* The /128 rule takes one tbl8 for each of the bytes 3 to 15 */
+	config.max_rules = MAX_RULES;
+	config.number_tbl8s = 13;
+	config.flags = 0;
+
+	lpm = rte_lpm6_create(__func__, SOCKET_ID_ANY, &config);
+	TEST_LPM_ASSERT(lpm != NULL);
+
+	/* probes[i] only matches the rules up to depths[i] */
+	for (i = 0; i < RTE_DIM(depths); i++) {
+		memcpy(probes[i], ip, sizeof(ip));
+		if (depths[i] < MAX_DEPTH)
+			probes[i][depths[i] / 8] ^= 0x80 >> (depths[i] % 8);
+
+		status = rte_lpm6_add(lpm, ip, depths[i], depths[i]);
+		TEST_LPM_ASSERT(status == 0);
+	}
+
+	for (i = 0; i < RTE_DIM(depths); i++) {
+		status = rte_lpm6_lookup(lpm, probes[i], &next_hop_return);
+		TEST_LPM_ASSERT(status == 0 && next_hop_return == depths[i]);
+	}
+
+	/* No tbl8 is left */
+	memcpy(ip_32_128, ip, sizeof(ip));
+	ip_32_128[4] ^= 0x80;
+	status = rte_lpm6_add(lpm, ip_32_128, 128, 1);
+	TEST_LPM_ASSERT(status == -ENOSPC);
+
+	status = rte_lpm6_delete(lpm, ip, 48);
+	TEST_LPM_ASSERT(status == 0);
+
+	status = rte_lpm6_lookup(lpm, probes[2], &next_hop_return);
+	TEST_LPM_ASSERT(status == 0 && next_hop_return == 32);
+	for (i = 0; i < RTE_DIM(depths); i++) {
+		if (depths[i] == 48)
+			continue;
+		status = rte_lpm6_lookup(lpm, probes[i], &next_hop_return);
+		TEST_LPM_ASSERT(status == 0 && next_hop_return == depths[i]);
+	}
+
+	status = rte_lpm6_delete(lpm, ip, 128);
+	TEST_LPM_ASSERT(status == 0);
+
+	status = rte_lpm6_lookup(lpm, ip, &next_hop_return);
+	TEST_LPM_ASSERT(status == 0 && next_hop_return == 64);
+
+	/* The 8 tbl8s below the /64 rule are free again, 12 are needed */
+	status = rte_lpm6_add(lpm, ip_32_128, 128, 1);
+	TEST_LPM_ASSERT(status == -ENOSPC);
+
+	memcpy(ip_64_128, ip, sizeof(ip));
+	ip_64_128[8] ^= 0x80;
+	status = rte_lpm6_add(lpm, ip_64_128, 128, 1);
+	TEST_LPM_ASSERT(status == 0);
+
+	status = rte_lpm6_lookup(lpm, ip_64_128, &next_hop_return);
+	TEST_LPM_ASSERT(status == 0 && next_hop_return == 1);
+	status = rte_lpm6_lookup(lpm, ip, &next_hop_return);
+	TEST_LPM_ASSERT(status == 0 && next_hop_return == 64);
+
+	/* Delete everything, every tbl8 goes back to the pool */
+	status = rte_lpm6_delete(lpm, ip_64_128, 128);
+	TEST_LPM_ASSERT(status == 0);
+	for (i = 0; i < RTE_DIM(depths); i++) {
+		if (depths[i] == 48 || depths[i] == 128)
+			continue;
+		status = rte_lpm6_delete(lpm, ip, depths[i]);
+		TEST_LPM_ASSERT(status == 0);
+	}
+
+	for (i = 0; i < RTE_DIM(depths); i++) {
+		status = rte_lpm6_lookup(lpm, probes[i], &next_hop_return);
+		TEST_LPM_ASSERT(status == -ENOENT);
+	}
+
+	status = rte_lpm6_add(lpm, ip_32_128, 128, 1);
+	TEST_LPM_ASSERT(status == 0);
+	status = rte_lpm6_add(lpm, ip, 128, 128);
+	TEST_LPM_ASSERT(status == -ENOSPC);
+
+	rte_lpm6_free(lpm);
+
+	return PASS;
+}
+
 /*
  * Do all unit tests.
  */
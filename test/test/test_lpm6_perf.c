@@ -35,6 +35,7 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
 
 #include <rte_cycles.h>
 #include <rte_random.h>
@@ -54,6 +55,10 @@
 #define ITERATIONS (1 << 10)
 #define BATCH_SIZE 100000
 #define NUMBER_TBL8S                                           (1 << 16)
+#define NUM_FILL_ROUTES                                        (1 << 16)
+
+static struct rules_tbl_entry fill_route_table[NUM_FILL_ROUTES];
+static uint8_t fill_route_added[NUM_FILL_ROUTES];
 
 static void
 print_route_distribution(const struct rules_tbl_entry *table, uint32_t n)
@@ -79,6 +84,60 @@ print_route_distribution(const struct rules_tbl_entry *table, uint32_t n)
 	printf("\n");
 }
 
+/*
+ * Generates random routes with the prefix width distribution of the large
+ * route table, enough of them to use up every tbl8 of the LPM.
+ */
+static void
+generate_fill_route_table(void)
+{
+	unsigned i, j;
+
+	for (i = 0; i < NUM_FILL_ROUTES; i++) {
+		for (j = 0; j < 16; j++)
+			fill_route_table[i].ip[j] = (uint8_t)rte_rand();
+		fill_route_table[i].depth =
+			large_route_table[i % NUM_ROUTE_ENTRIES].depth;
+		fill_route_table[i].next_hop = i;
+	}
+}
+
+/*
+ * Fills the LPM up to its capacity and empties it again, rule by rule.
+ * Only the adds that succeed are timed, the ones failing once the tbl8s
+ * are used up return early.
+ */
+static int
+fill_lpm6(struct rte_lpm6 *lpm, uint64_t *add_time, uint64_t *del_time)
+{
+	uint64_t begin, cycles;
+	unsigned i;
+	int added = 0;
+
+	*add_time = 0;
+	for (i = 0; i < NUM_FILL_ROUTES; i++) {
+		begin = rte_rdtsc();
+		fill_route_added[i] = rte_lpm6_add(lpm, fill_route_table[i].ip,
+				fill_route_table[i].depth,
+				fill_route_table[i].next_hop) == 0;
+		cycles = rte_rdtsc() - begin;
+
+		if (fill_route_added[i]) {
+			*add_time += cycles;
+			added++;
+		}
+	}
+
+	begin = rte_rdtsc();
+	for (i = 0; i < NUM_FILL_ROUTES; i++)
+		if (fill_route_added[i])
+			rte_lpm6_delete(lpm, fill_route_table[i].ip,
+					fill_route_table[i].depth);
+	*del_time = rte_rdtsc() - begin;
+
+	return added;
+}
+
 static int
 test_lpm6_perf(void)
 {
@@ -89,6 +148,8 @@ test_lpm6_perf(void)
 	uint32_t next_hop_add = 0xAA, next_hop_return = 0;
 	int status = 0;
 	int64_t count = 0;
+	uint64_t add_time, del_time;
+	int added;
 
 	config.max_rules = 1000000;
 	config.number_tbl8s = NUMBER_TBL8S;
@@ -178,11 +239,32 @@ test_lpm6_perf(void)
 				large_route_table[i].depth);
 	}
 
-	total_time += rte_rdtsc() - begin;
+	total_time = rte_rdtsc() - begin;
 
 	printf("Average LPM Delete: %g cycles\n",
 			(double)total_time / NUM_ROUTE_ENTRIES);
 
+	rte_lpm6_delete_all(lpm);
+
+	/*
+	 * Measure add and delete with the LPM filled up to its capacity,
+	 * twice to check the tbl8s freed by delete are all reused.
+	 */
+	generate_fill_route_table();
+
+	added = fill_lpm6(lpm, &add_time, &del_time);
+	printf("Full table: %d routes of %u added\n", added, NUM_FILL_ROUTES);
+	printf("Average LPM Add (full table): %g cycles\n",
+			(double)add_time / added);
+	printf("Average LPM Delete (full table): %g cycles\n",
+			(double)del_time / added);
+
+	for (i = 0; i < NUM_ROUTE_ENTRIES; i++)
+		TEST_LPM_ASSERT(rte_lpm6_lookup(lpm, large_route_table[i].ip,
+				&next_hop_return) == -ENOENT);
+
+	TEST_LPM_ASSERT(fill_lpm6(lpm, &add_time, &del_time) == added);
+
 	rte_lpm6_delete_all(lpm);
 	rte_lpm6_free(lpm);
 
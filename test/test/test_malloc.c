@@ -33,10 +33,15 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <string.h>
 #include <stdarg.h>
 #include <errno.h>
 #include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <libgen.h>
+#include <limits.h>
 #include <sys/queue.h>
 
 #include <rte_common.h>
@@ -53,6 +58,7 @@
 #include <rte_string_fns.h>
 
 #include "test.h"
+#include "process.h"
 
 #define N 10000
 
@@ -384,6 +390,119 @@ test_multi_alloc_statistics(void)
 	return 0;
 }
 
+/*
+ * Check that small objects freed by an lcore are served again from its
+ * cache, and that they are zeroed like the rest of the heap.
+ */
+static int
+test_lcore_cache(void)
+{
+	struct rte_malloc_socket_stats pre, post;
+	int socket = rte_socket_id();
+	size_t size = RTE_CACHE_LINE_SIZE;
+	char *p1, *p2;
+	size_t i;
+
+	if (rte_malloc_get_socket_stats(socket, &pre) < 0)
+		return -1;
+
+	p1 = rte_malloc_socket("cache", size, 0, socket);
+	if (p1 == NULL)
+		return -1;
+	memset(p1, 0xa5, size);
+	rte_free(p1);
+
+	p2 = rte_zmalloc_socket("cache", size, 0, socket);
+	if (p2 == NULL)
+		return -1;
+	for (i = 0; i < size; i++) {
+		if (p2[i] != 0) {
+			printf("Cached memory is not zeroed\n");
+			rte_free(p2);
+			return -1;
+		}
+	}
+	rte_free(p2);
+
+	if (rte_malloc_get_socket_stats(socket, &post) < 0)
+		return -1;
+#if RTE_MALLOC_LCORE_CACHE_SIZE > 0
+	if (p2 != p1 || post.cache_hits == pre.cache_hits) {
+		printf("Freed object was not served from the lcore cache\n");
+		return -1;
+	}
+	if (post.cache_count == 0 || post.cache_sz_bytes < size) {
+		printf("Incorrect cache statistics\n");
+		return -1;
+	}
+#else
+	if (post.cache_count != 0 || post.cache_hits != 0) {
+		printf("Cache statistics reported without a cache\n");
+		return -1;
+	}
+#endif
+	return 0;
+}
+
+/*
+ * Allocate and free bursts of small objects on all lcores at once, and
+ * report the average cost of an allocation and free pair.
+ */
+#define CACHE_PERF_BURST 32
+#define CACHE_PERF_ITER 10000
+
+static uint64_t cache_perf_cycles[RTE_MAX_LCORE];
+
+static int
+test_lcore_cache_perf_per_lcore(__attribute__((unused)) void *arg)
+{
+	void *objs[CACHE_PERF_BURST];
+	uint64_t start;
+	unsigned int i, j;
+	int ret = 0;
+
+	start = rte_rdtsc();
+	for (i = 0; i < CACHE_PERF_ITER; i++) {
+		for (j = 0; j < CACHE_PERF_BURST; j++) {
+			/* 64 to 512 bytes */
+			objs[j] = rte_malloc("perf",
+					RTE_CACHE_LINE_SIZE << (j % 4), 0);
+			if (objs[j] == NULL)
+				ret = -1;
+		}
+		for (j = 0; j < CACHE_PERF_BURST; j++)
+			rte_free(objs[j]);
+	}
+	cache_perf_cycles[rte_lcore_id()] = rte_rdtsc() - start;
+
+	return ret;
+}
+
+static int
+test_lcore_cache_perf(void)
+{
+	unsigned int lcore_id, n = 0;
+	uint64_t total = 0;
+	int ret = 0;
+
+	rte_eal_mp_remote_launch(test_lcore_cache_perf_per_lcore, NULL,
+			CALL_MASTER);
+	RTE_LCORE_FOREACH(lcore_id) {
+		if (rte_eal_wait_lcore(lcore_id) < 0)
+			ret = -1;
+		total += cache_perf_cycles[lcore_id];
+		n++;
+	}
+	if (ret < 0)
+		return ret;
+
+	printf("%u lcores, %"PRIu64" cycles per alloc/free of 64-512 bytes\n",
+		n, total / ((uint64_t)n * CACHE_PERF_ITER * CACHE_PERF_BURST));
+	rte_malloc_dump_stats(stdout, NULL);
+
+	return 0;
+}
+
 static int
 test_rte_malloc_type_limits(void)
 {
@@ -849,6 +968,180 @@ test_alloc_socket(void)
 	return 0;
 }
 
+/*
+ * Memory hotplug
+ * ==============
+ *
+ * With --mem-hotplug, an allocation bigger than the free space of a heap
+ * maps a new memseg, which is given back when freed. A memzone reserved
+ * in such a memseg must be usable from a secondary process.
+ * The checks run in a new primary process started with --mem-hotplug.
+ */
+#define HOTPLUG_MZ_NAME "malloc_hotplug_mz"
+#define HOTPLUG_PATTERN 0x5a
+
+#ifdef RTE_EXEC_ENV_LINUXAPP
+static char *
+get_current_prefix(char *prefix, int size)
+{
+	char path[PATH_MAX] = {0};
+	char buf[PATH_MAX] = {0};
+
+	/* get file for config (fd is always 3) */
+	snprintf(path, sizeof(path), "/proc/self/fd/%d", 3);
+
+	/* return NULL on error */
+	if (readlink(path, buf, sizeof(buf)) == -1)
+		return NULL;
+
+	/* get the basename */
+	snprintf(buf, sizeof(buf), "%s", basename(buf));
+
+	/* copy string all the way from second char up to start of _config */
+	snprintf(prefix, size, "%.*s",
+			(int)(strnlen(buf, sizeof(buf)) - sizeof("_config")),
+			&buf[1]);
+
+	return prefix;
+}
+#endif
+
+/* check the content of the memzone, in the secondary process */
+static int
+test_malloc_hotplug_secondary(void)
+{
+	const struct rte_memzone *mz;
+	const uint8_t *data;
+
+	mz = rte_memzone_lookup(HOTPLUG_MZ_NAME);
+	if (mz == NULL) {
+		printf("Cannot find memzone %s\n", HOTPLUG_MZ_NAME);
+		return -1;
+	}
+	data = mz->addr;
+	if (data[0] != HOTPLUG_PATTERN || data[mz->len - 1] != HOTPLUG_PATTERN) {
+		printf("Wrong content of memzone %s\n", HOTPLUG_MZ_NAME);
+		return -1;
+	}
+
+	return 0;
+}
+
+/* launch a secondary process checking the memzone, if supported */
+static int
+test_malloc_hotplug_mp(void)
+{
+#ifdef RTE_EXEC_ENV_LINUXAPP
+	char prefix[PATH_MAX], tmp[PATH_MAX];
+
+	/* anonymous memory cannot be shared */
+	if (!rte_eal_has_hugepages() ||
+			get_current_prefix(tmp, sizeof(tmp)) == NULL) {
+		printf("Memory hotplug: no shared hugepages, "
+			"secondary process check skipped\n");
+		return 0;
+	}
+	snprintf(prefix, sizeof(prefix), "--file-prefix=%s", tmp);
+
+	const char *argv[] = {prgname, "-c", "1", "-n", "2",
+			"--proc-type=secondary", prefix};
+
+	if (process_dup(argv, RTE_DIM(argv), "test_malloc_hotplug") != 0) {
+		printf("Secondary process cannot use the hotplugged memory\n");
+		return -1;
+	}
+#endif
+	return 0;
+}
+
+/* grow and shrink the heap, in the primary process with --mem-hotplug */
+int
+test_malloc_hotplug_primary(void)
+{
+	struct rte_malloc_socket_stats pre, post;
+	const struct rte_memzone *mz;
+	int socket = rte_socket_id();
+	size_t size;
+	char *mem;
+
+	rte_malloc_get_socket_stats(socket, &pre);
+	size = pre.greatest_free_size + RTE_PGSIZE_2M;
+
+	mem = rte_malloc_socket("hotplug", size, 0, socket);
+	if (mem == NULL) {
+		printf("Cannot allocate %zu bytes of hotplugged memory\n",
+			size);
+		return -1;
+	}
+	memset(mem, HOTPLUG_PATTERN, size);
+	rte_malloc_get_socket_stats(socket, &post);
+	if (post.heap_totalsz_bytes < pre.heap_totalsz_bytes + size) {
+		printf("Heap did not grow: %zu bytes, was %zu bytes\n",
+			post.heap_totalsz_bytes, pre.heap_totalsz_bytes);
+		rte_free(mem);
+		return -1;
+	}
+	rte_free(mem);
+	rte_malloc_get_socket_stats(socket, &post);
+	if (post.heap_totalsz_bytes != pre.heap_totalsz_bytes) {
+		printf("Heap did not shrink: %zu bytes, was %zu bytes\n",
+			post.heap_totalsz_bytes, pre.heap_totalsz_bytes);
+		return -1;
+	}
+
+	mz = rte_memzone_reserve(HOTPLUG_MZ_NAME, size, socket, 0);
+	if (mz == NULL) {
+		printf("Cannot reserve memzone in hotplugged memory\n");
+		return -1;
+	}
+	memset(mz->addr, HOTPLUG_PATTERN, mz->len);
+	if (test_malloc_hotplug_mp() < 0) {
+		rte_memzone_free(mz);
+		return -1;
+	}
+	rte_memzone_free(mz);
+
+	rte_malloc_get_socket_stats(socket, &post);
+	if (post.heap_totalsz_bytes != pre.heap_totalsz_bytes) {
+		printf("Heap did not shrink after memzone free\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+int
+test_malloc_hotplug(void)
+{
+	if (rte_eal_process_type() == RTE_PROC_SECONDARY)
+		return test_malloc_hotplug_secondary();
+
+#ifdef RTE_EXEC_ENV_LINUXAPP
+	/* the new primary process must not use the files of this one */
+	const char *argv[] = {prgname, "-c", "1", "-n", "2", "-m", "16",
+			"--mem-hotplug", "--file-prefix=malloc_hotplug"};
+	const char *argv_nohuge[] = {prgname, "-c", "1", "-n", "2", "-m", "16",
+			"--mem-hotplug", "--file-prefix=malloc_hotplug",
+			"--no-huge"};
+	int ret;
+
+	if (rte_eal_has_hugepages())
+		ret = process_dup(argv, RTE_DIM(argv),
+				"test_malloc_hotplug_primary");
+	else
+		ret = process_dup(argv_nohuge, RTE_DIM(argv_nohuge),
+				"test_malloc_hotplug_primary");
+	if (ret != 0) {
+		printf("Memory hotplug failed in a primary process with "
+			"--mem-hotplug\n");
+		return -1;
+	}
+#else
+	printf("Memory hotplug is not supported, test skipped\n");
+#endif
+	return 0;
+}
+
 static int
 test_malloc(void)
 {
@@ -956,6 +1249,30 @@ test_malloc(void)
 	else
 		printf("test_multi_alloc_statistics() passed\n");
 
+	ret = test_lcore_cache();
+	if (ret < 0) {
+		printf("test_lcore_cache() failed\n");
+		return ret;
+	}
+	else
+		printf("test_lcore_cache() passed\n");
+
+	ret = test_lcore_cache_perf();
+	if (ret < 0) {
+		printf("test_lcore_cache_perf() failed\n");
+		return ret;
+	}
+	else
+		printf("test_lcore_cache_perf() passed\n");
+
+	ret = test_malloc_hotplug();
+	if (ret < 0) {
+		printf("test_malloc_hotplug() failed\n");
+		return ret;
+	}
+	else
+		printf("test_malloc_hotplug() passed\n");
+
 	return 0;
 }
 
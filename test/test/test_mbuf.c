@@ -56,8 +56,10 @@
 #include <rte_ring.h>
 #include <rte_mempool.h>
 #include <rte_mbuf.h>
+#include <rte_malloc.h>
 #include <rte_random.h>
 #include <rte_cycles.h>
+#include <rte_errno.h>
 
 #include "test.h"
 
@@ -78,6 +80,12 @@
 #define REFCNT_MBUF_NUM         64
 #define REFCNT_RING_SIZE        (REFCNT_MBUF_NUM * REFCNT_MAX_REF)
 
+#define FREE_BULK_SIZE          32
+#define FREE_BULK_ITER          100000
+#define EXT_BUF_SIZE            2048
+#define EXT_BUF_CLONES          4
+#define COPY_PERF_ITER          10000
+
 #define MAGIC_DATA              0x42424242
 
 #define MAKE_STRING(x)          # x
@@ -538,6 +546,12 @@ test_attach_from_different_pool(void)
 }
 #undef GOTO_FAIL
 
+#define GOTO_FAIL(str, ...) do {					\
+		printf("mbuf test FAILED (l.%d): <" str ">\n",		\
+		       __LINE__,  ##__VA_ARGS__);			\
+		goto fail;						\
+} while(0)
+
 /*
  * test allocation and free of mbufs
  */
@@ -1049,6 +1063,559 @@ test_mbuf_linearize_check(void)
 	return 0;
 }
 
+/*
+ * free in bulk direct, chained and cloned mbufs from two pools, and
+ * check that all of them are back in their pool
+ */
+static int
+test_pktmbuf_free_bulk(void)
+{
+	struct rte_mbuf *m[16];
+	struct rte_mbuf *clone;
+	unsigned avail, avail2;
+	unsigned i;
+
+	memset(m, 0, sizeof(m));
+	avail = rte_mempool_avail_count(pktmbuf_pool);
+	avail2 = rte_mempool_avail_count(pktmbuf_pool2);
+
+	/* interleave mbufs from both pools */
+	for (i = 0; i < 12; i++) {
+		m[i] = rte_pktmbuf_alloc(i % 3 == 2 ?
+					 pktmbuf_pool2 : pktmbuf_pool);
+		if (m[i] == NULL)
+			GOTO_FAIL("cannot allocate mbuf");
+	}
+
+	/* a chain made of segments from both pools */
+	m[12] = rte_pktmbuf_alloc(pktmbuf_pool);
+	if (m[12] == NULL)
+		GOTO_FAIL("cannot allocate mbuf");
+	m[12]->next = rte_pktmbuf_alloc(pktmbuf_pool2);
+	if (m[12]->next == NULL)
+		GOTO_FAIL("cannot allocate mbuf");
+	m[12]->nb_segs = 2;
+
+	/* a clone and its direct mbuf, both freed in the same bulk */
+	clone = rte_pktmbuf_clone(m[0], pktmbuf_pool);
+	if (clone == NULL)
+		GOTO_FAIL("cannot clone mbuf");
+	m[13] = clone;
+
+	/* m[14] and m[15] are NULL and must be ignored */
+	rte_pktmbuf_free_bulk(m, RTE_DIM(m));
+
+	if (rte_mempool_avail_count(pktmbuf_pool) != avail)
+		GOTO_FAIL("mbufs not freed in pool, %u available",
+			rte_mempool_avail_count(pktmbuf_pool));
+	if (rte_mempool_avail_count(pktmbuf_pool2) != avail2)
+		GOTO_FAIL("mbufs not freed in pool2, %u available",
+			rte_mempool_avail_count(pktmbuf_pool2));
+
+	/* fast free of simple mbufs from one pool */
+	if (rte_pktmbuf_alloc_bulk(pktmbuf_pool, m, RTE_DIM(m)) != 0)
+		GOTO_FAIL("cannot allocate mbufs");
+	rte_mbuf_raw_free_bulk(pktmbuf_pool, m, RTE_DIM(m));
+	if (rte_mempool_avail_count(pktmbuf_pool) != avail)
+		GOTO_FAIL("mbufs not freed in pool, %u available",
+			rte_mempool_avail_count(pktmbuf_pool));
+
+	return 0;
+
+fail:
+	for (i = 0; i < RTE_DIM(m); i++)
+		rte_pktmbuf_free(m[i]);
+	return -1;
+}
+
+static unsigned int ext_buf_free_count;
+
+static void
+ext_buf_free_cb(void *addr, void *opaque)
+{
+	if (opaque != &ext_buf_free_count)
+		printf("bad opaque pointer in free callback\n");
+	rte_free(addr);
+	ext_buf_free_count++;
+}
+
+/*
+ * attach an external buffer to a mbuf, clone it a few times, and check
+ * that the buffer is released through the callback only once, after the
+ * last mbuf referencing it is freed
+ */
+static int
+test_pktmbuf_ext_buf(void)
+{
+	struct rte_mbuf *m = NULL;
+	struct rte_mbuf *clone[EXT_BUF_CLONES] = { NULL };
+	struct rte_mbuf_ext_shared_info *shinfo;
+	unsigned int avail, i;
+	uint16_t buf_len = EXT_BUF_SIZE;
+	char *buf = NULL, *data;
+	int attached = 0;
+
+	avail = rte_mempool_avail_count(pktmbuf_pool);
+	ext_buf_free_count = 0;
+
+	buf = rte_malloc("test_ext_buf", EXT_BUF_SIZE, RTE_CACHE_LINE_SIZE);
+	if (buf == NULL)
+		GOTO_FAIL("cannot allocate external buffer");
+
+	shinfo = rte_pktmbuf_ext_shinfo_init_helper(buf, &buf_len,
+		ext_buf_free_cb, &ext_buf_free_count);
+	if (shinfo == NULL)
+		GOTO_FAIL("cannot init shared info");
+	if (buf_len >= EXT_BUF_SIZE ||
+	    (char *)shinfo + sizeof(*shinfo) > buf + EXT_BUF_SIZE)
+		GOTO_FAIL("bad shared info placement");
+	if (rte_mbuf_ext_refcnt_read(shinfo) != 1)
+		GOTO_FAIL("bad initial refcnt of external buffer");
+
+	m = rte_pktmbuf_alloc(pktmbuf_pool);
+	if (m == NULL)
+		GOTO_FAIL("cannot allocate mbuf");
+
+	/* from now on, the buffer is released by the free callback */
+	rte_pktmbuf_attach_extbuf(m, buf, rte_malloc_virt2phy(buf), buf_len,
+		shinfo);
+	attached = 1;
+	if (!RTE_MBUF_HAS_EXTBUF(m) || RTE_MBUF_DIRECT(m) ||
+	    RTE_MBUF_INDIRECT(m))
+		GOTO_FAIL("mbuf not flagged as external");
+	if (m->buf_addr != buf || m->buf_len != buf_len ||
+	    rte_pktmbuf_headroom(m) != 0)
+		GOTO_FAIL("bad buffer fields after attach");
+
+	rte_pktmbuf_reset_headroom(m);
+	data = rte_pktmbuf_append(m, MBUF_TEST_DATA_LEN2);
+	if (data == NULL)
+		GOTO_FAIL("cannot append data");
+	memset(data, 0x5a, MBUF_TEST_DATA_LEN2);
+
+	for (i = 0; i < EXT_BUF_CLONES; i++) {
+		clone[i] = rte_pktmbuf_clone(m, pktmbuf_pool);
+		if (clone[i] == NULL)
+			GOTO_FAIL("cannot clone mbuf");
+		if (!RTE_MBUF_HAS_EXTBUF(clone[i]) ||
+		    RTE_MBUF_INDIRECT(clone[i]) ||
+		    clone[i]->shinfo != shinfo)
+			GOTO_FAIL("clone not attached to external buffer");
+		if (rte_pktmbuf_mtod(clone[i], char *) != data)
+			GOTO_FAIL("bad data pointer in clone");
+	}
+	if (rte_mbuf_ext_refcnt_read(shinfo) != EXT_BUF_CLONES + 1)
+		GOTO_FAIL("bad refcnt of external buffer after clone");
+	if (rte_mbuf_refcnt_read(m) != 1)
+		GOTO_FAIL("mbuf refcnt must not change on clone");
+
+	/* the original mbuf is released first: the buffer must survive */
+	rte_pktmbuf_free(m);
+	m = NULL;
+	if (ext_buf_free_count != 0)
+		GOTO_FAIL("external buffer freed too early");
+	if (rte_pktmbuf_mtod(clone[0], char *)[0] != 0x5a)
+		GOTO_FAIL("bad data in clone");
+
+	/* detach explicitly, the mbuf gets its own buffer back */
+	rte_pktmbuf_detach_extbuf(clone[0]);
+	if (!RTE_MBUF_DIRECT(clone[0]) ||
+	    clone[0]->buf_addr == buf)
+		GOTO_FAIL("clone not restored after detach");
+	if (rte_mbuf_ext_refcnt_read(shinfo) != EXT_BUF_CLONES - 1)
+		GOTO_FAIL("bad refcnt of external buffer after detach");
+
+	for (i = 0; i < EXT_BUF_CLONES; i++) {
+		if (ext_buf_free_count != 0)
+			GOTO_FAIL("external buffer freed too early");
+		rte_pktmbuf_free(clone[i]);
+		clone[i] = NULL;
+	}
+	if (ext_buf_free_count != 1)
+		GOTO_FAIL("free callback called %u times",
+			ext_buf_free_count);
+
+	if (rte_mempool_avail_count(pktmbuf_pool) != avail)
+		GOTO_FAIL("mbufs not freed in pool, %u available",
+			rte_mempool_avail_count(pktmbuf_pool));
+
+	return 0;
+
+fail:
+	for (i = 0; i < EXT_BUF_CLONES; i++)
+		rte_pktmbuf_free(clone[i]);
+	rte_pktmbuf_free(m);
+	if (!attached)
+		rte_free(buf);
+	return -1;
+}
+
+/* build a packet of pkt_len bytes in segments of at most seg_len bytes */
+static struct rte_mbuf *
+create_pattern_chain(struct rte_mempool *mp, uint32_t pkt_len,
+		     uint16_t seg_len)
+{
+	struct rte_mbuf *m, *seg;
+	uint32_t off = 0;
+	uint16_t n, i;
+	char *data;
+
+	m = rte_pktmbuf_alloc(mp);
+	if (m == NULL)
+		return NULL;
+
+	seg = m;
+	while (off < pkt_len) {
+		if (seg != m || rte_pktmbuf_data_len(m) != 0) {
+			seg = rte_pktmbuf_alloc(mp);
+			if (seg == NULL || rte_pktmbuf_chain(m, seg) != 0) {
+				rte_pktmbuf_free(seg);
+				rte_pktmbuf_free(m);
+				return NULL;
+			}
+		}
+		n = RTE_MIN(pkt_len - off, (uint32_t)seg_len);
+		data = rte_pktmbuf_append(seg, n);
+		if (data == NULL) {
+			rte_pktmbuf_free(m);
+			return NULL;
+		}
+		/* rte_pktmbuf_append() only accounts for the last segment */
+		if (seg != m)
+			m->pkt_len += n;
+		for (i = 0; i < n; i++)
+			data[i] = (char)(off + i);
+		off += n;
+	}
+
+	return m;
+}
+
+/* check that the copy holds len bytes of the pattern starting at off */
+static int
+check_pattern_copy(const struct rte_mbuf *mc, uint32_t off, uint32_t len)
+{
+	const struct rte_mbuf *seg;
+	const char *data;
+	uint32_t pos = 0;
+	uint16_t i;
+
+	if (rte_pktmbuf_pkt_len(mc) != len)
+		return -1;
+
+	for (seg = mc; seg != NULL; seg = seg->next) {
+		data = rte_pktmbuf_mtod(seg, const char *);
+		for (i = 0; i < rte_pktmbuf_data_len(seg); i++, pos++)
+			if (data[i] != (char)(off + pos))
+				return -1;
+	}
+
+	return pos == len ? 0 : -1;
+}
+
+/*
+ * copy ranges of a segmented packet, including ranges spanning several
+ * segments, and check the data, the segmentation and the metadata
+ */
+static int
+test_pktmbuf_copy(void)
+{
+	static const struct {
+		uint32_t off;
+		uint32_t len;
+		uint32_t expected;
+	} ranges[] = {
+		{ 0, UINT32_MAX, 3000 },	/* full packet */
+		{ 0, 100, 100 },		/* head of first segment */
+		{ 100, 700, 700 },		/* across first segments */
+		{ 1000, 1500, 1500 },		/* starts in a middle segment */
+		{ 2900, 500, 100 },		/* truncated at the end */
+		{ 3000, 10, 0 },		/* empty copy at the end */
+	};
+	struct rte_mbuf *m = NULL, *mc = NULL;
+	unsigned int avail, i;
+
+	avail = rte_mempool_avail_count(pktmbuf_pool);
+
+	/* segments smaller than the copy ones, to mix both boundaries */
+	m = create_pattern_chain(pktmbuf_pool, 3000, 512);
+	if (m == NULL)
+		GOTO_FAIL("cannot create chain");
+	m->port = 3;
+	m->vlan_tci = 42;
+	m->packet_type = RTE_PTYPE_L2_ETHER | RTE_PTYPE_L3_IPV4;
+	m->ol_flags = PKT_TX_VLAN_PKT | PKT_TX_IP_CKSUM | PKT_TX_IPV4;
+	m->l2_len = 14;
+	m->l3_len = 20;
+	m->hash.rss = 0x12345678;
+
+	for (i = 0; i < RTE_DIM(ranges); i++) {
+		mc = rte_pktmbuf_copy(m, pktmbuf_pool, ranges[i].off,
+				      ranges[i].len);
+		if (mc == NULL)
+			GOTO_FAIL("cannot copy range %u", i);
+		if (check_pattern_copy(mc, ranges[i].off,
+				       ranges[i].expected) < 0)
+			GOTO_FAIL("bad data in copy of range %u", i);
+		if (rte_mbuf_refcnt_read(mc) != 1 || !RTE_MBUF_DIRECT(mc))
+			GOTO_FAIL("copy of range %u is not a direct mbuf", i);
+		if (mc->port != m->port || mc->vlan_tci != m->vlan_tci ||
+		    mc->packet_type != m->packet_type ||
+		    mc->ol_flags != m->ol_flags ||
+		    mc->tx_offload != m->tx_offload ||
+		    mc->hash.rss != m->hash.rss)
+			GOTO_FAIL("metadata not preserved in range %u", i);
+		rte_mbuf_sanity_check(mc, 1);
+		rte_pktmbuf_free(mc);
+		mc = NULL;
+	}
+
+	/* the full copy of a 3000 bytes packet needs two 2KB segments */
+	mc = rte_pktmbuf_copy(m, pktmbuf_pool, 0, UINT32_MAX);
+	if (mc == NULL || mc->nb_segs != 2)
+		GOTO_FAIL("full copy is not made of 2 segments");
+	rte_pktmbuf_free(mc);
+
+	/* a copy of a clone is a regular direct mbuf */
+	mc = rte_pktmbuf_clone(m, pktmbuf_pool);
+	if (mc == NULL)
+		GOTO_FAIL("cannot clone mbuf");
+	rte_pktmbuf_free(m);
+	m = mc;
+	mc = rte_pktmbuf_copy(m, pktmbuf_pool, 10, 2000);
+	if (mc == NULL || check_pattern_copy(mc, 10, 2000) < 0)
+		GOTO_FAIL("bad copy of a clone");
+	if (!RTE_MBUF_DIRECT(mc))
+		GOTO_FAIL("copy of a clone is not direct");
+	rte_pktmbuf_free(mc);
+	mc = NULL;
+
+	if (rte_pktmbuf_copy(m, pktmbuf_pool, 3001, 1) != NULL)
+		GOTO_FAIL("copy beyond the packet end should fail");
+
+	rte_pktmbuf_free(m);
+	m = NULL;
+
+	if (rte_mempool_avail_count(pktmbuf_pool) != avail)
+		GOTO_FAIL("mbufs not freed in pool, %u available",
+			rte_mempool_avail_count(pktmbuf_pool));
+
+	return 0;
+
+fail:
+	rte_pktmbuf_free(mc);
+	rte_pktmbuf_free(m);
+	return -1;
+}
+
+/*
+ * register dynamic fields and flags, check that they do not overlap
+ * with the static mbuf fields and flags, and that they are copied to
+ * clones
+ */
+static int
+test_mbuf_dyn(void)
+{
+	const struct rte_mbuf_dynfield dynfield = {
+		.name = "test-dynfield",
+		.size = sizeof(uint8_t),
+		.align = __alignof__(uint8_t),
+	};
+	const struct rte_mbuf_dynfield dynfield2 = {
+		.name = "test-dynfield2",
+		.size = sizeof(uint16_t),
+		.align = __alignof__(uint16_t),
+	};
+	const struct rte_mbuf_dynfield dynfield_fail_big = {
+		.name = "test-dynfield-fail-big",
+		.size = 256,
+		.align = 1,
+	};
+	const struct rte_mbuf_dynfield dynfield_fail_align = {
+		.name = "test-dynfield-fail-align",
+		.size = 1,
+		.align = 3,
+	};
+	const struct rte_mbuf_dynflag dynflag = {
+		.name = "test-dynflag",
+	};
+	const struct rte_mbuf_dynflag dynflag2 = {
+		.name = "test-dynflag2",
+	};
+	struct rte_mbuf_dynfield dynfield_copy = dynfield;
+	struct rte_mbuf_dynfield params;
+	struct rte_mbuf *m = NULL, *clone = NULL;
+	int offset, offset2, bit, bit2;
+	uint64_t flag;
+
+	offset = rte_mbuf_dynfield_register(&dynfield);
+	if (offset < 0)
+		GOTO_FAIL("failed to register dynamic field, rte_errno=%d",
+			rte_errno);
+	if (rte_mbuf_dynfield_register(&dynfield) != offset)
+		GOTO_FAIL("registering the same field gave another offset");
+
+	offset2 = rte_mbuf_dynfield_register(&dynfield2);
+	if (offset2 < 0 || offset2 == offset ||
+	    (offset2 % __alignof__(uint16_t)) != 0)
+		GOTO_FAIL("bad offset for second dynamic field (%d, %d)",
+			offset, offset2);
+
+	/* the fields must be in the area reserved for them */
+	if ((size_t)offset < offsetof(struct rte_mbuf, dynfield1) ||
+	    offset2 + sizeof(uint16_t) >
+			offsetof(struct rte_mbuf, dynfield1) +
+			sizeof(((struct rte_mbuf *)0)->dynfield1))
+		GOTO_FAIL("dynamic fields outside of the reserved area");
+
+	if (rte_mbuf_dynfield_lookup("test-dynfield2", &params) != offset2 ||
+	    params.size != dynfield2.size || params.align != dynfield2.align)
+		GOTO_FAIL("failed to lookup dynamic field");
+	if (rte_mbuf_dynfield_lookup("test-dynfield-unknown", NULL) != -1 ||
+	    rte_errno != ENOENT)
+		GOTO_FAIL("lookup of an unknown field should fail");
+
+	dynfield_copy.size = sizeof(uint32_t);
+	if (rte_mbuf_dynfield_register(&dynfield_copy) != -1 ||
+	    rte_errno != EEXIST)
+		GOTO_FAIL("registering a field twice with another size "
+			"should fail");
+	if (rte_mbuf_dynfield_register(&dynfield_fail_big) != -1 ||
+	    rte_errno != ENOSPC)
+		GOTO_FAIL("registering a too big field should fail");
+	if (rte_mbuf_dynfield_register(&dynfield_fail_align) != -1 ||
+	    rte_errno != EINVAL)
+		GOTO_FAIL("registering a badly aligned field should fail");
+
+	bit = rte_mbuf_dynflag_register(&dynflag);
+	bit2 = rte_mbuf_dynflag_register(&dynflag2);
+	if (bit < 0 || bit2 < 0 || bit == bit2)
+		GOTO_FAIL("failed to register dynamic flags (%d, %d)",
+			bit, bit2);
+	if (rte_mbuf_dynflag_register(&dynflag) != bit ||
+	    rte_mbuf_dynflag_lookup("test-dynflag", NULL) != bit)
+		GOTO_FAIL("failed to lookup dynamic flag");
+
+	/* the flag must not be used by the mbuf library */
+	flag = 1ULL << bit;
+	if (rte_get_rx_ol_flag_name(flag) != NULL ||
+	    rte_get_tx_ol_flag_name(flag) != NULL ||
+	    (flag & (PKT_TX_OFFLOAD_MASK | IND_ATTACHED_MBUF |
+		     EXT_ATTACHED_MBUF | CTRL_MBUF_FLAG)) != 0)
+		GOTO_FAIL("dynamic flag %d overlaps a static one", bit);
+
+	m = rte_pktmbuf_alloc(pktmbuf_pool);
+	if (m == NULL)
+		GOTO_FAIL("cannot allocate mbuf");
+	*RTE_MBUF_DYNFIELD(m, offset, uint8_t *) = 0x42;
+	*RTE_MBUF_DYNFIELD(m, offset2, uint16_t *) = 0x1234;
+	m->ol_flags |= flag;
+
+	clone = rte_pktmbuf_clone(m, pktmbuf_pool);
+	if (clone == NULL)
+		GOTO_FAIL("cannot clone mbuf");
+	if (*RTE_MBUF_DYNFIELD(clone, offset, uint8_t *) != 0x42 ||
+	    *RTE_MBUF_DYNFIELD(clone, offset2, uint16_t *) != 0x1234 ||
+	    (clone->ol_flags & flag) == 0)
+		GOTO_FAIL("dynamic field or flag not copied in clone");
+
+	rte_pktmbuf_free(clone);
+	rte_pktmbuf_free(m);
+
+	rte_mbuf_dyn_dump(stdout);
+
+	return 0;
+
+fail:
+	rte_pktmbuf_free(clone);
+	rte_pktmbuf_free(m);
+	return -1;
+}
+
+/* measure the cost of a full copy of packets from 64B up to jumbo frames */
+static int
+test_pktmbuf_copy_perf(void)
+{
+	static const uint32_t sizes[] = { 64, 256, 1518, 4096, 9000 };
+	struct rte_mbuf *m, *mc;
+	uint64_t start, cycles;
+	unsigned int i, j;
+
+	for (i = 0; i < RTE_DIM(sizes); i++) {
+		/* received jumbo frames are made of 2KB segments */
+		m = create_pattern_chain(pktmbuf_pool, sizes[i],
+			MBUF_DATA_SIZE - RTE_PKTMBUF_HEADROOM);
+		if (m == NULL) {
+			printf("cannot create chain of %u bytes\n", sizes[i]);
+			return -1;
+		}
+
+		cycles = 0;
+		for (j = 0; j < COPY_PERF_ITER; j++) {
+			start = rte_rdtsc();
+			mc = rte_pktmbuf_copy(m, pktmbuf_pool, 0, UINT32_MAX);
+			cycles += rte_rdtsc() - start;
+			if (mc == NULL) {
+				printf("cannot copy chain of %u bytes\n",
+				       sizes[i]);
+				rte_pktmbuf_free(m);
+				return -1;
+			}
+			rte_pktmbuf_free(mc);
+		}
+
+		printf("copy of %u bytes (%u segs): %"PRIu64" cycles\n",
+		       sizes[i], m->nb_segs, cycles / COPY_PERF_ITER);
+		rte_pktmbuf_free(m);
+	}
+
+	return 0;
+}
+
+/*
+ * compare the cost of freeing single segment mbufs one by one, in bulk,
+ * and with the fast free path
+ */
+static int
+test_pktmbuf_free_bulk_perf(void)
+{
+	struct rte_mbuf *m[FREE_BULK_SIZE];
+	uint64_t cycles[3] = { 0, 0, 0 };
+	uint64_t start;
+	unsigned i, j, mode;
+
+	for (i = 0; i < FREE_BULK_ITER; i++) {
+		for (mode = 0; mode < RTE_DIM(cycles); mode++) {
+			if (rte_pktmbuf_alloc_bulk(pktmbuf_pool, m,
+						   FREE_BULK_SIZE) != 0) {
+				printf("cannot allocate mbufs\n");
+				return -1;
+			}
+
+			start = rte_rdtsc();
+			if (mode == 0) {
+				for (j = 0; j < FREE_BULK_SIZE; j++)
+					rte_pktmbuf_free(m[j]);
+			} else if (mode == 1) {
+				rte_pktmbuf_free_bulk(m, FREE_BULK_SIZE);
+			} else {
+				rte_mbuf_raw_free_bulk(pktmbuf_pool, m,
+						       FREE_BULK_SIZE);
+			}
+			cycles[mode] += rte_rdtsc() - start;
+		}
+	}
+
+	printf("free of %u mbufs, cycles/mbuf: rte_pktmbuf_free=%"PRIu64
+	       " rte_pktmbuf_free_bulk=%"PRIu64
+	       " rte_mbuf_raw_free_bulk=%"PRIu64"\n", FREE_BULK_SIZE,
+	       cycles[0] / (FREE_BULK_ITER * FREE_BULK_SIZE),
+	       cycles[1] / (FREE_BULK_ITER * FREE_BULK_SIZE),
+	       cycles[2] / (FREE_BULK_ITER * FREE_BULK_SIZE));
+
+	return 0;
+}
+
 static int
 test_mbuf(void)
 {
@@ -1146,6 +1713,36 @@ test_mbuf(void)
 		printf("test_mbuf_linearize_check() failed\n");
 		return -1;
 	}
+
+	if (test_pktmbuf_free_bulk() < 0) {
+		printf("test_pktmbuf_free_bulk() failed\n");
+		return -1;
+	}
+
+	if (test_pktmbuf_free_bulk_perf() < 0) {
+		printf("test_pktmbuf_free_bulk_perf() failed\n");
+		return -1;
+	}
+
+	if (test_pktmbuf_ext_buf() < 0) {
+		printf("test_pktmbuf_ext_buf() failed\n");
+		return -1;
+	}
+
+	if (test_pktmbuf_copy() < 0) {
+		printf("test_pktmbuf_copy() failed\n");
+		return -1;
+	}
+
+	if (test_pktmbuf_copy_perf() < 0) {
+		printf("test_pktmbuf_copy_perf() failed\n");
+		return -1;
+	}
+
+	if (test_mbuf_dyn() < 0) {
+		printf("test_mbuf_dyn() failed\n");
+		return -1;
+	}
 	return 0;
 }
 
@@ -38,6 +38,7 @@
 #include <inttypes.h>
 #include <stdarg.h>
 #include <errno.h>
+#include <pthread.h>
 #include <sys/queue.h>
 
 #include <rte_common.h>
@@ -55,6 +56,10 @@
 #include <rte_mempool.h>
 #include <rte_spinlock.h>
 #include <rte_malloc.h>
+#ifdef RTE_LIBRTE_MEMPOOL_STATS
+#include <rte_metrics.h>
+#include <rte_mempoolstats.h>
+#endif
 
 #include "test.h"
 
@@ -443,6 +448,165 @@ test_mempool_basic_ex(struct rte_mempool *mp)
 	return ret;
 }
 
+/*
+ * get and put objects from a non-EAL thread through an attached
+ * user-owned cache
+ */
+static void *
+test_mempool_thread_cache_main(void *arg)
+{
+	struct rte_mempool *mp = arg;
+	struct rte_mempool_cache *cache;
+	void *obj;
+	intptr_t ret = -1;
+
+	cache = rte_mempool_cache_create(RTE_MEMPOOL_CACHE_MAX_SIZE,
+					 SOCKET_ID_ANY);
+	if (cache == NULL)
+		return (void *)ret;
+
+	if (rte_mempool_default_cache(mp, rte_lcore_id()) != NULL)
+		GOTO_ERR(ret, out);
+	if (rte_mempool_cache_attach(mp, cache) < 0)
+		GOTO_ERR(ret, out);
+	if (rte_mempool_cache_attach(mp, cache) != -EINVAL)
+		GOTO_ERR(ret, detach);
+	if (rte_mempool_default_cache(mp, rte_lcore_id()) != cache)
+		GOTO_ERR(ret, detach);
+
+	/* the object comes from the attached cache, filled in bulk */
+	if (rte_mempool_get(mp, &obj) < 0)
+		GOTO_ERR(ret, detach);
+	if (cache->len == 0)
+		GOTO_ERR(ret, put);
+
+	/* the objects held by the cache are still available */
+	rte_mempool_dump(stdout, mp);
+	if (rte_mempool_avail_count(mp) != MEMPOOL_SIZE - 1)
+		GOTO_ERR(ret, put);
+
+	ret = 0;
+
+put:
+	rte_mempool_put(mp, obj);
+	rte_mempool_cache_flush(cache, mp);
+detach:
+	if (rte_mempool_cache_detach(mp, cache) < 0)
+		ret = -1;
+	if (rte_mempool_default_cache(mp, rte_lcore_id()) != NULL)
+		ret = -1;
+out:
+	rte_mempool_cache_free(cache);
+	return (void *)ret;
+}
+
+static int
+test_mempool_thread_cache(struct rte_mempool *mp)
+{
+	pthread_t thread;
+	void *ret;
+
+	if (pthread_create(&thread, NULL, test_mempool_thread_cache_main,
+			   mp) != 0)
+		RET_ERR();
+	if (pthread_join(thread, &ret) != 0)
+		RET_ERR();
+	if (ret != NULL)
+		RET_ERR();
+
+	if (rte_mempool_avail_count(mp) != MEMPOOL_SIZE)
+		RET_ERR();
+
+	return 0;
+}
+
+/*
+ * check the usage statistics of a mempool without cache, and their
+ * export through the metrics library
+ */
+static int
+test_mempool_stats(struct rte_mempool *mp)
+{
+	struct rte_mempool_stats stats;
+#ifdef RTE_LIBRTE_MEMPOOL_STATS
+	struct rte_metric_value *values = NULL;
+	int key, cnt;
+#endif
+	void **objtable = NULL;
+	int ret = -1;
+
+	if (mp->cache_size != 0)
+		RET_ERR();
+
+	rte_mempool_stats_reset(mp);
+	if (rte_mempool_stats_get(mp, &stats) < 0)
+		RET_ERR();
+	if (stats.in_use != 0 || stats.out != 0 || stats.out_max_read != 0 ||
+			stats.refill_bulk != 0 || stats.flush_bulk != 0)
+		RET_ERR();
+
+	objtable = malloc((MEMPOOL_SIZE + 1) * sizeof(void *));
+	if (objtable == NULL)
+		RET_ERR();
+
+	if (rte_mempool_get_bulk(mp, objtable, 4) < 0)
+		GOTO_ERR(ret, out);
+	/* out_max_read is updated when the statistics are read */
+	rte_mempool_stats_get(mp, &stats);
+	if (stats.out != 4 || stats.out_max_read != 4) {
+		rte_mempool_put_bulk(mp, objtable, 4);
+		GOTO_ERR(ret, out);
+	}
+	rte_mempool_put_bulk(mp, objtable, 2);
+
+	/* more objects than the mempool size cannot be allocated */
+	if (rte_mempool_get_bulk(mp, objtable + 2, MEMPOOL_SIZE) == 0)
+		GOTO_ERR(ret, out);
+
+	rte_mempool_stats_get(mp, &stats);
+	rte_mempool_dump(stdout, mp);
+	if (stats.in_use != 2 || stats.out != 2 || stats.out_max_read != 4)
+		GOTO_ERR(ret, put);
+	if (stats.refill_bulk != 1 || stats.refill_objs != 4 ||
+			stats.flush_bulk != 1 || stats.flush_objs != 2 ||
+			stats.get_fail_bulk != 1 ||
+			stats.get_fail_objs != MEMPOOL_SIZE)
+		GOTO_ERR(ret, put);
+
+#ifdef RTE_LIBRTE_MEMPOOL_STATS
+	rte_metrics_init(rte_socket_id());
+	key = rte_mempoolstats_reg(mp);
+	if (key < 0)
+		GOTO_ERR(ret, put);
+	if (rte_mempoolstats_update(mp, key) < 0)
+		GOTO_ERR(ret, put);
+
+	cnt = rte_metrics_get_values(RTE_METRICS_GLOBAL, NULL, 0);
+	if (cnt < key + 3)
+		GOTO_ERR(ret, put);
+	values = malloc(cnt * sizeof(*values));
+	if (values == NULL)
+		GOTO_ERR(ret, put);
+	if (rte_metrics_get_values(RTE_METRICS_GLOBAL, values, cnt) != cnt)
+		GOTO_ERR(ret, put);
+	/* in_use, out and out_max_read are the first metrics of the mempool */
+	if (values[key].value != 2 || values[key + 1].value != 2 ||
+			values[key + 2].value != 4)
+		GOTO_ERR(ret, put);
+#endif
+
+	ret = 0;
+
+put:
+	rte_mempool_put_bulk(mp, objtable, 2);
+out:
+#ifdef RTE_LIBRTE_MEMPOOL_STATS
+	free(values);
+#endif
+	free(objtable);
+	return ret;
+}
+
 static int
 test_mempool_same_name_twice_creation(void)
 {
@@ -513,6 +677,7 @@ test_mempool(void)
 	struct rte_mempool *mp_cache = NULL;
 	struct rte_mempool *mp_nocache = NULL;
 	struct rte_mempool *mp_stack = NULL;
+	struct rte_mempool *mp_lf_stack = NULL;
 	struct rte_mempool *default_pool = NULL;
 
 	rte_atomic32_init(&synchro);
@@ -563,6 +728,30 @@ test_mempool(void)
 	}
 	rte_mempool_obj_iter(mp_stack, my_obj_init, NULL);
 
+#if defined(RTE_ARCH_X86_64) || \
+	(defined(RTE_ARCH_ARM64) && defined(RTE_FORCE_INTRINSICS))
+	/* create a mempool with the lock-free stack handler */
+	mp_lf_stack = rte_mempool_create_empty("test_lf_stack",
+		MEMPOOL_SIZE,
+		MEMPOOL_ELT_SIZE,
+		RTE_MEMPOOL_CACHE_MAX_SIZE, 0,
+		SOCKET_ID_ANY, 0);
+
+	if (mp_lf_stack == NULL) {
+		printf("cannot allocate mp_lf_stack mempool\n");
+		goto err;
+	}
+	if (rte_mempool_set_ops_byname(mp_lf_stack, "lf_stack", NULL) < 0) {
+		printf("cannot set lf_stack handler\n");
+		goto err;
+	}
+	if (rte_mempool_populate_default(mp_lf_stack) < 0) {
+		printf("cannot populate mp_lf_stack mempool\n");
+		goto err;
+	}
+	rte_mempool_obj_iter(mp_lf_stack, my_obj_init, NULL);
+#endif
+
 	/* Create a mempool based on Default handler */
 	printf("Testing %s mempool handler\n",
 	       RTE_MBUF_DEFAULT_MEMPOOL_OPS);
@@ -612,10 +801,18 @@ test_mempool(void)
 	if (test_mempool_basic(mp_nocache, 1) < 0)
 		goto err;
 
+	/* user-owned cache attached to a non-EAL thread */
+	if (test_mempool_thread_cache(mp_nocache) < 0)
+		goto err;
+
 	/* more basic tests without cache */
 	if (test_mempool_basic_ex(mp_nocache) < 0)
 		goto err;
 
+	/* usage statistics */
+	if (test_mempool_stats(mp_nocache) < 0)
+		goto err;
+
 	/* mempool operation test based on single producer and single comsumer */
 	if (test_mempool_sp_sc() < 0)
 		goto err;
@@ -633,6 +830,10 @@ test_mempool(void)
 	if (test_mempool_basic(mp_stack, 1) < 0)
 		goto err;
 
+	/* test the lock-free stack handler */
+	if (mp_lf_stack != NULL && test_mempool_basic(mp_lf_stack, 1) < 0)
+		goto err;
+
 	if (test_mempool_basic(default_pool, 1) < 0)
 		goto err;
 
@@ -644,6 +845,7 @@ test_mempool(void)
 	rte_mempool_free(mp_nocache);
 	rte_mempool_free(mp_cache);
 	rte_mempool_free(mp_stack);
+	rte_mempool_free(mp_lf_stack);
 	rte_mempool_free(default_pool);
 
 	return ret;
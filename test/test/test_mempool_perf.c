@@ -80,6 +80,15 @@
  *      - One core with user-owned cache
  *      - Two cores with user-owned cache
  *      - Max. cores with user-owned cache
+ *      - 1, 2, 4, 8 and 16 cores (up to max.) without cache, for the
+ *        ring_mp_mc, stack and lf_stack handlers
+ *
+ *    The always-on usage statistics are then checked on one core, with
+ *    and without cache, along with the cost of reading them. The cost of
+ *    updating them is the difference between a get/put without cache and
+ *    the same accesses done by the mempool handler directly. With cache,
+ *    it must stay below *STATS_OVERHEAD_BUDGET* percent of the time spent
+ *    in the mempool.
  *
  *    - Bulk size (*n_get_bulk*, *n_put_bulk*)
  *
@@ -97,6 +106,8 @@
 #define MEMPOOL_ELT_SIZE 2048
 #define MAX_KEEP 128
 #define MEMPOOL_SIZE ((rte_lcore_count()*(MAX_KEEP+RTE_MEMPOOL_CACHE_MAX_SIZE))-1)
+#define STATS_ITER 100000
+#define STATS_OVERHEAD_BUDGET 5 /* percent */
 
 #define LOG_ERR() printf("test failed at %s():%d\n", __func__, __LINE__)
 #define RET_ERR() do {							\
@@ -308,12 +319,189 @@ do_one_mempool_test(struct rte_mempool *mp, unsigned int cores)
 	return 0;
 }
 
+/* create and populate a mempool without cache using the given handler */
+static struct rte_mempool *
+create_ops_mempool(const char *name, const char *ops)
+{
+	struct rte_mempool *mp;
+
+	mp = rte_mempool_create_empty(name, MEMPOOL_SIZE, MEMPOOL_ELT_SIZE,
+				      0, 0, SOCKET_ID_ANY, 0);
+	if (mp == NULL) {
+		printf("cannot allocate %s mempool\n", ops);
+		return NULL;
+	}
+
+	if (rte_mempool_set_ops_byname(mp, ops, NULL) < 0) {
+		printf("cannot set %s handler\n", ops);
+		rte_mempool_free(mp);
+		return NULL;
+	}
+
+	if (rte_mempool_populate_default(mp) < 0) {
+		printf("cannot populate %s mempool\n", ops);
+		rte_mempool_free(mp);
+		return NULL;
+	}
+
+	rte_mempool_obj_iter(mp, my_obj_init, NULL);
+	return mp;
+}
+
+/*
+ * compare the scalability of the pool handlers themselves, without the
+ * per-lcore caches hiding the contention on the common pool
+ */
+static int
+test_mempool_perf_handlers(void)
+{
+	static const char * const ops_tab[] = {
+		"ring_mp_mc", "stack", "lf_stack",
+	};
+	static const unsigned int cores_tab[] = { 1, 2, 4, 8, 16 };
+	struct rte_mempool *mp;
+	char name[RTE_MEMPOOL_NAMESIZE];
+	unsigned int i, j;
+
+	for (i = 0; i < RTE_DIM(ops_tab); i++) {
+		snprintf(name, sizeof(name), "perf_test_%s", ops_tab[i]);
+		mp = create_ops_mempool(name, ops_tab[i]);
+		if (mp == NULL) {
+			/* lf_stack is only available on some architectures */
+			if (strcmp(ops_tab[i], "lf_stack") == 0)
+				continue;
+			return -1;
+		}
+
+		printf("start performance test for %s (without cache)\n",
+		       ops_tab[i]);
+
+		for (j = 0; j < RTE_DIM(cores_tab); j++) {
+			if (cores_tab[j] > rte_lcore_count())
+				break;
+			if (do_one_mempool_test(mp, cores_tab[j]) < 0) {
+				rte_mempool_free(mp);
+				return -1;
+			}
+		}
+		rte_mempool_free(mp);
+	}
+
+	return 0;
+}
+
+/*
+ * cycles added by the usage statistics to an access to the common pool:
+ * get and put without cache, compared with the same accesses done by the
+ * mempool handler, which does not update the statistics
+ */
+static int
+test_mempool_perf_stats_update(struct rte_mempool *mp, double *update_cycles)
+{
+	void *obj_table[32];
+	uint64_t start, api_cycles, ops_cycles;
+	unsigned i;
+
+	start = rte_rdtsc();
+	for (i = 0; i < STATS_ITER; i++) {
+		if (rte_mempool_generic_get(mp, obj_table, 32, NULL, 0) < 0)
+			RET_ERR();
+		rte_mempool_generic_put(mp, obj_table, 32, NULL, 0);
+	}
+	api_cycles = rte_rdtsc() - start;
+
+	start = rte_rdtsc();
+	for (i = 0; i < STATS_ITER; i++) {
+		if (rte_mempool_ops_dequeue_bulk(mp, obj_table, 32) < 0)
+			RET_ERR();
+		rte_mempool_ops_enqueue_bulk(mp, obj_table, 32);
+	}
+	ops_cycles = rte_rdtsc() - start;
+
+	if (api_cycles < ops_cycles)
+		*update_cycles = 0;
+	else
+		*update_cycles = (double)(api_cycles - ops_cycles) /
+			(STATS_ITER * 2);
+	rte_mempool_stats_reset(mp);
+
+	printf("mempool_autotest stats: %.2f cycles/update\n",
+	       *update_cycles);
+	return 0;
+}
+
+/*
+ * get and put objects on one core, check that the usage statistics count
+ * the accesses to the common pool, check the share of the time spent
+ * updating them against the budget, and measure the cost of reading them
+ */
+static int
+test_mempool_perf_stats(struct rte_mempool *mp, double update_cycles)
+{
+	struct rte_mempool_cache *cache;
+	struct rte_mempool_stats stats;
+	void *obj_table[MAX_KEEP];
+	uint64_t start, mp_cycles, stats_cycles, accesses;
+	double overhead;
+	unsigned i, idx;
+
+	cache = rte_mempool_default_cache(mp, rte_lcore_id());
+	if (cache != NULL)
+		rte_mempool_cache_flush(cache, mp);
+	rte_mempool_stats_reset(mp);
+
+	start = rte_rdtsc();
+	for (i = 0; i < STATS_ITER; i++) {
+		for (idx = 0; idx < MAX_KEEP; idx += 32) {
+			if (rte_mempool_generic_get(mp, &obj_table[idx], 32,
+						    cache, 0) < 0)
+				RET_ERR();
+		}
+		for (idx = 0; idx < MAX_KEEP; idx += 32)
+			rte_mempool_generic_put(mp, &obj_table[idx], 32,
+						cache, 0);
+	}
+	mp_cycles = rte_rdtsc() - start;
+	if (cache != NULL)
+		rte_mempool_cache_flush(cache, mp);
+
+	start = rte_rdtsc();
+	for (i = 0; i < STATS_ITER; i++)
+		rte_mempool_stats_get(mp, &stats);
+	stats_cycles = rte_rdtsc() - start;
+
+	/* all the objects went back to the common pool */
+	if (stats.refill_objs != stats.flush_objs || stats.out != 0 ||
+			stats.get_fail_bulk != 0) {
+		rte_mempool_dump(stdout, mp);
+		RET_ERR();
+	}
+	accesses = stats.refill_bulk + stats.flush_bulk;
+	rte_mempool_stats_reset(mp);
+
+	overhead = update_cycles * accesses * 100 / mp_cycles;
+	printf("mempool_autotest cache=%u stats: %"PRIu64" common pool "
+	       "accesses for %u objects in %"PRIu64" cycles, "
+	       "overhead=%.2f%%, %"PRIu64" cycles/read\n",
+	       (unsigned)mp->cache_size, accesses, STATS_ITER * MAX_KEEP * 2,
+	       mp_cycles, overhead, stats_cycles / STATS_ITER);
+
+	if (mp->cache_size != 0 && overhead > STATS_OVERHEAD_BUDGET) {
+		printf("statistics overhead is above %d%%\n",
+		       STATS_OVERHEAD_BUDGET);
+		return -1;
+	}
+
+	return 0;
+}
+
 static int
 test_mempool_perf(void)
 {
 	struct rte_mempool *mp_cache = NULL;
 	struct rte_mempool *mp_nocache = NULL;
 	struct rte_mempool *default_pool = NULL;
+	double update_cycles;
 	int ret = -1;
 
 	rte_atomic32_init(&synchro);
@@ -415,6 +603,19 @@ test_mempool_perf(void)
 	if (do_one_mempool_test(mp_nocache, rte_lcore_count()) < 0)
 		goto err;
 
+	/* pool handlers scalability, from 1 to 16 cores */
+	use_external_cache = 0;
+	if (test_mempool_perf_handlers() < 0)
+		goto err;
+
+	/* usage statistics, and overhead of their updates */
+	if (test_mempool_perf_stats_update(mp_nocache, &update_cycles) < 0)
+		goto err;
+	if (test_mempool_perf_stats(mp_nocache, update_cycles) < 0)
+		goto err;
+	if (test_mempool_perf_stats(mp_cache, update_cycles) < 0)
+		goto err;
+
 	rte_mempool_list_dump(stdout);
 
 	ret = 0;
@@ -51,8 +51,10 @@
 #include <libgen.h>
 #include <dirent.h>
 #include <limits.h>
+#include <fcntl.h>
 
 #include <rte_common.h>
+#include <rte_cycles.h>
 #include <rte_memory.h>
 #include <rte_memzone.h>
 #include <rte_eal.h>
@@ -83,6 +85,9 @@
 #define launch_proc(ARGV) process_dup(ARGV, \
 		sizeof(ARGV)/(sizeof(ARGV[0])), __func__)
 
+#define MP_TEST_ACTION "mp_test_echo"
+#define MP_TEST_VALUE 0x5eed
+
 #ifdef RTE_EXEC_ENV_LINUXAPP
 static char*
 get_current_prefix(char * prefix, int size)
@@ -109,6 +114,30 @@ get_current_prefix(char * prefix, int size)
 }
 #endif
 
+/*
+ * Action of the primary process, replying to a secondary process with the
+ * parameters of its request and a file descriptor
+ */
+static int
+mp_test_echo(const struct rte_mp_msg *msg, const void *peer)
+{
+	struct rte_mp_msg reply;
+	int ret;
+
+	memset(&reply, 0, sizeof(reply));
+	snprintf(reply.name, sizeof(reply.name), "%s", msg->name);
+	reply.len_param = msg->len_param;
+	memcpy(reply.param, msg->param, msg->len_param);
+	reply.num_fds = 1;
+	reply.fds[0] = open("/dev/null", O_RDONLY);
+	if (reply.fds[0] < 0)
+		return -1;
+
+	ret = rte_mp_reply(&reply, peer);
+	close(reply.fds[0]);
+	return ret;
+}
+
 /*
  * This function is called in the primary i.e. main test, to spawn off secondary
  * processes to run actual mp tests. Uses fork() and exec pair
@@ -156,9 +185,16 @@ run_secondary_instances(void)
 	snprintf(coremask, sizeof(coremask), "%x", \
 			(1 << rte_get_master_lcore()));
 
+	if (rte_mp_action_register(MP_TEST_ACTION, mp_test_echo) < 0) {
+		printf("Error: cannot register action %s\n", MP_TEST_ACTION);
+		return -1;
+	}
+
 	ret |= launch_proc(argv1);
 	ret |= launch_proc(argv2);
 
+	rte_mp_action_unregister(MP_TEST_ACTION);
+
 	ret |= !(launch_proc(argv3));
 #ifdef RTE_EXEC_ENV_LINUXAPP
 	ret |= !(launch_proc(argv4));
@@ -248,6 +284,89 @@ run_object_creation_tests(void)
 	return 0;
 }
 
+static volatile int mp_async_replies = -1;
+
+static int
+mp_test_async_reply(const struct rte_mp_msg *request __rte_unused,
+		const struct rte_mp_reply *reply)
+{
+	int i;
+
+	for (i = 0; i < reply->nb_received; i++)
+		close(reply->msgs[i].fds[0]);
+	mp_async_replies = reply->nb_received;
+	return 0;
+}
+
+/*
+ * This function is run in the secondary instance to test the requests to
+ * the primary process through the multi-process channel
+ */
+static int
+run_ipc_tests(void)
+{
+	struct timespec ts = {.tv_sec = 5, .tv_nsec = 0};
+	const int value = MP_TEST_VALUE;
+	struct rte_mp_reply reply;
+	struct rte_mp_msg req, *rep;
+	int i, ret = -1;
+
+	printf("### Testing multi-process channel\n");
+
+	memset(&reply, 0, sizeof(reply));
+	memset(&req, 0, sizeof(req));
+	snprintf(req.name, sizeof(req.name), MP_TEST_ACTION);
+	req.len_param = sizeof(value);
+	memcpy(req.param, &value, sizeof(value));
+
+	if (rte_mp_request_sync(&req, &reply, &ts) < 0 ||
+			reply.nb_sent != 1 || reply.nb_received != 1) {
+		printf("Error: no reply from rte_mp_request_sync()\n");
+		goto out;
+	}
+	rep = &reply.msgs[0];
+	if (rep->num_fds != 1 || fcntl(rep->fds[0], F_GETFD) < 0) {
+		printf("Error: no fd in the reply\n");
+		goto out;
+	}
+	close(rep->fds[0]);
+	if (rep->len_param != sizeof(value) ||
+			memcmp(rep->param, &value, sizeof(value)) != 0) {
+		printf("Error: unexpected reply parameters\n");
+		goto out;
+	}
+	free(reply.msgs);
+	reply.msgs = NULL;
+	printf("# Checked rte_mp_request_sync() OK\n");
+
+	/* a request with no action is ignored without waiting the timeout */
+	snprintf(req.name, sizeof(req.name), "mp_test_none");
+	if (rte_mp_request_sync(&req, &reply, &ts) < 0 ||
+			reply.nb_sent != 0 || reply.nb_received != 0) {
+		printf("Error: request with no action was not ignored\n");
+		goto out;
+	}
+	printf("# Checked ignored request OK\n");
+
+	snprintf(req.name, sizeof(req.name), MP_TEST_ACTION);
+	if (rte_mp_request_async(&req, &ts, mp_test_async_reply) < 0) {
+		printf("Error: rte_mp_request_async() failed\n");
+		goto out;
+	}
+	for (i = 0; i < 5000 && mp_async_replies < 0; i++)
+		rte_delay_ms(1);
+	if (mp_async_replies != 1) {
+		printf("Error: no reply from rte_mp_request_async()\n");
+		goto out;
+	}
+	printf("# Checked rte_mp_request_async() OK\n");
+	ret = 0;
+
+out:
+	free(reply.msgs);
+	return ret;
+}
+
 /* if called in a primary process, just spawns off a secondary process to
  * run validation tests - which brings us right back here again...
  * if called in a secondary process, this runs a series of API tests to check
@@ -262,7 +381,10 @@ test_mp_secondary(void)
 
 	printf("IN SECONDARY PROCESS\n");
 
-	return run_object_creation_tests();
+	if (run_object_creation_tests() < 0)
+		return -1;
+
+	return run_ipc_tests();
 }
 
 REGISTER_TEST_COMMAND(multiprocess_autotest, test_mp_secondary);
@@ -36,6 +36,7 @@
 
 #include <rte_eth_ring.h>
 #include <rte_ethdev.h>
+#include <rte_interrupts.h>
 
 static struct rte_mempool *mp;
 static int tx_porta, rx_portb, rxtx_portc, rxtx_portd, rxtx_porte;
@@ -240,6 +241,106 @@ test_stats_reset(int port)
 	return 0;
 }
 
+#ifdef RTE_EXEC_ENV_LINUXAPP
+static int
+test_rx_intr_wait(int expected)
+{
+	struct rte_epoll_event event;
+	int n;
+
+	n = rte_epoll_wait(RTE_EPOLL_PER_THREAD, &event, 1,
+			expected ? 100 : 0);
+	if (n != expected) {
+		printf("Error: got %d Rx interrupts, expected %d\n",
+			n, expected);
+		return -1;
+	}
+	return 0;
+}
+
+static int
+test_rx_intr_port_start(int port)
+{
+	struct rte_eth_conf intr_conf;
+
+	memset(&intr_conf, 0, sizeof(struct rte_eth_conf));
+	intr_conf.intr_conf.rxq = 1;
+
+	if ((rte_eth_dev_configure(port, 1, 1, &intr_conf) < 0) ||
+	    (rte_eth_tx_queue_setup(port, 0, RING_SIZE, SOCKET0, NULL) < 0) ||
+	    (rte_eth_rx_queue_setup(port, 0, RING_SIZE, SOCKET0,
+			NULL, mp) < 0) ||
+	    (rte_eth_dev_start(port) < 0)) {
+		printf("Error setting up port %d\n", port);
+		return -1;
+	}
+	return 0;
+}
+
+static int
+test_rx_intr(int txport, int rxport)
+{
+	struct rte_mbuf buf, *pbuf = &buf;
+	int ret = -1;
+
+	printf("Testing Rx interrupt (port %d -> port %d)\n", txport, rxport);
+
+	if (test_rx_intr_port_start(txport) < 0 ||
+	    test_rx_intr_port_start(rxport) < 0)
+		return -1;
+
+	if (rte_eth_dev_rx_intr_ctl_q(rxport, 0, RTE_EPOLL_PER_THREAD,
+			RTE_INTR_EVENT_ADD, NULL) < 0) {
+		printf("Error adding Rx interrupt of port %d\n", rxport);
+		goto out;
+	}
+
+	/* nothing queued, the armed queue must not fire */
+	if (rte_eth_dev_rx_intr_enable(rxport, 0) < 0 ||
+	    test_rx_intr_wait(0) < 0)
+		goto out_del;
+
+	/* a packet sent while armed fires the interrupt */
+	if (rte_eth_tx_burst(txport, 0, &pbuf, 1) != 1 ||
+	    test_rx_intr_wait(1) < 0)
+		goto out_del;
+	rte_eth_dev_rx_intr_disable(rxport, 0);
+	if (rte_eth_rx_burst(rxport, 0, &pbuf, 1) != 1 || pbuf != &buf) {
+		printf("Error receiving packet on port %d\n", rxport);
+		goto out_del;
+	}
+
+	/* a packet sent before arming fires as soon as it is armed */
+	if (rte_eth_tx_burst(txport, 0, &pbuf, 1) != 1 ||
+	    rte_eth_dev_rx_intr_enable(rxport, 0) < 0 ||
+	    test_rx_intr_wait(1) < 0)
+		goto out_del;
+	rte_eth_dev_rx_intr_disable(rxport, 0);
+	if (rte_eth_rx_burst(rxport, 0, &pbuf, 1) != 1) {
+		printf("Error receiving packet on port %d\n", rxport);
+		goto out_del;
+	}
+
+	/* disabled, no interrupt */
+	if (rte_eth_tx_burst(txport, 0, &pbuf, 1) != 1 ||
+	    test_rx_intr_wait(0) < 0)
+		goto out_del;
+	if (rte_eth_rx_burst(rxport, 0, &pbuf, 1) != 1) {
+		printf("Error receiving packet on port %d\n", rxport);
+		goto out_del;
+	}
+
+	ret = 0;
+out_del:
+	rte_eth_dev_rx_intr_ctl_q(rxport, 0, RTE_EPOLL_PER_THREAD,
+			RTE_INTR_EVENT_DEL, NULL);
+out:
+	rte_eth_dev_stop(txport);
+	rte_eth_dev_stop(rxport);
+	return ret;
+}
+#endif
+
 static int
 test_pmd_ring_pair_create_attach(int portd, int porte)
 {
@@ -498,6 +599,11 @@ test_pmd_ring(void)
 	rte_eth_dev_stop(rx_portb);
 	rte_eth_dev_stop(rxtx_portc);
 
+#ifdef RTE_EXEC_ENV_LINUXAPP
+	if (test_rx_intr(tx_porta, rx_portb) < 0)
+		return -1;
+#endif
+
 	if (test_pmd_ring_pair_create_attach(rxtx_portd, rxtx_porte) < 0)
 		return -1;
 
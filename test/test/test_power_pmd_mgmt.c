@@ -0,0 +1,261 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include "test.h"
+
+#include <rte_cycles.h>
+#include <rte_eth_ring.h>
+#include <rte_ethdev.h>
+#include <rte_launch.h>
+#include <rte_lcore.h>
+#include <rte_mbuf.h>
+#include <rte_ring.h>
+#include <rte_power_pmd_mgmt.h>
+
+#define PMD_MGMT_RING_SIZE 64
+#define PMD_MGMT_NB_MBUF 64
+#define PMD_MGMT_SOCKET 0
+
+static struct rte_mempool *mp;
+static struct rte_ring *ring;
+static uint8_t port;
+
+static const struct rte_power_pmd_mgmt_conf test_conf = {
+	.pause_threshold = 1,
+	.pause_us = 1,
+	.sleep_threshold = 4,
+	.sleep_us = 10,
+	.intr_threshold = 8,
+	.intr_timeout_ms = 1,
+};
+
+static int
+test_pmd_mgmt_port_setup(void)
+{
+	struct rte_eth_conf conf;
+	int ret;
+
+	if (mp == NULL)
+		mp = rte_pktmbuf_pool_create("pmd_mgmt_pool", PMD_MGMT_NB_MBUF,
+				0, 0, RTE_MBUF_DEFAULT_BUF_SIZE,
+				PMD_MGMT_SOCKET);
+	if (mp == NULL) {
+		printf("Cannot create mbuf pool\n");
+		return -1;
+	}
+
+	if (ring == NULL) {
+		ring = rte_ring_create("pmd_mgmt_ring", PMD_MGMT_RING_SIZE,
+				PMD_MGMT_SOCKET, RING_F_SP_ENQ | RING_F_SC_DEQ);
+		if (ring == NULL) {
+			printf("Cannot create ring\n");
+			return -1;
+		}
+		/* the port transmits into its own Rx queue */
+		ret = rte_eth_from_rings("net_pmd_mgmt", &ring, 1, &ring, 1,
+				PMD_MGMT_SOCKET);
+		if (ret < 0) {
+			printf("Cannot create ring port\n");
+			return -1;
+		}
+		port = ret;
+	}
+
+	memset(&conf, 0, sizeof(conf));
+	conf.intr_conf.rxq = 1;
+	if (rte_eth_dev_configure(port, 1, 1, &conf) < 0 ||
+	    rte_eth_tx_queue_setup(port, 0, PMD_MGMT_RING_SIZE,
+			PMD_MGMT_SOCKET, NULL) < 0 ||
+	    rte_eth_rx_queue_setup(port, 0, PMD_MGMT_RING_SIZE,
+			PMD_MGMT_SOCKET, NULL, mp) < 0 ||
+	    rte_eth_dev_start(port) < 0) {
+		printf("Cannot start port %u\n", port);
+		return -1;
+	}
+	return 0;
+}
+
+static void
+test_pmd_mgmt_poll(unsigned int n)
+{
+	struct rte_mbuf *pkt;
+
+	while (n-- > 0)
+		rte_eth_rx_burst(port, 0, &pkt, 1);
+}
+
+static int
+test_pmd_mgmt_args(unsigned int lcore)
+{
+	struct rte_power_pmd_mgmt_conf conf = test_conf;
+	struct rte_power_pmd_mgmt_stats stats;
+
+	TEST_ASSERT(rte_power_pmd_mgmt_queue_enable(RTE_MAX_LCORE, port, 0,
+			NULL) == -EINVAL, "Invalid lcore accepted");
+	TEST_ASSERT(rte_power_pmd_mgmt_queue_enable(lcore, RTE_MAX_ETHPORTS,
+			0, NULL) == -EINVAL, "Invalid port accepted");
+	TEST_ASSERT(rte_power_pmd_mgmt_queue_enable(lcore, port, 1,
+			NULL) < 0, "Invalid queue accepted");
+
+	conf.sleep_us = 0;
+	TEST_ASSERT(rte_power_pmd_mgmt_queue_enable(lcore, port, 0,
+			&conf) == -EINVAL, "Sleep without duration accepted");
+
+	TEST_ASSERT(rte_power_pmd_mgmt_queue_disable(lcore, port, 0) ==
+			-ENOENT, "Unmanaged queue disabled");
+	TEST_ASSERT(rte_power_pmd_mgmt_stats_get(RTE_MAX_LCORE, &stats) ==
+			-EINVAL, "Invalid lcore stats returned");
+	TEST_ASSERT(rte_power_pmd_mgmt_stats_get(lcore, NULL) == -EINVAL,
+			"NULL stats accepted");
+	return 0;
+}
+
+static int
+test_pmd_mgmt_stages(unsigned int lcore)
+{
+	struct rte_power_pmd_mgmt_stats stats;
+	struct rte_mbuf buf, *pbuf = &buf;
+
+	TEST_ASSERT_SUCCESS(rte_power_pmd_mgmt_queue_enable(lcore, port, 0,
+			&test_conf), "Cannot manage queue");
+	TEST_ASSERT(rte_power_pmd_mgmt_queue_enable(lcore, port, 0,
+			&test_conf) == -EEXIST, "Queue managed twice");
+	rte_power_pmd_mgmt_stats_reset(lcore);
+
+	/* 3 rounds paused, 4 slept, then interrupt waits that time out */
+	test_pmd_mgmt_poll(16);
+	rte_power_pmd_mgmt_stats_get(lcore, &stats);
+	TEST_ASSERT(stats.polls == 16 && stats.empty_polls == 16,
+			"Wrong poll count %"PRIu64"/%"PRIu64,
+			stats.polls, stats.empty_polls);
+	TEST_ASSERT(stats.pauses == 3 && stats.sleeps == 4 &&
+			stats.intr_waits == 9 && stats.intr_wakeups == 0,
+			"Wrong idle stages %"PRIu64"/%"PRIu64"/%"PRIu64
+			"/%"PRIu64, stats.pauses, stats.sleeps,
+			stats.intr_waits, stats.intr_wakeups);
+	TEST_ASSERT(stats.idle_cycles != 0, "No idle cycles accounted");
+
+	/* traffic resets the streak back to the first stage */
+	TEST_ASSERT(rte_eth_tx_burst(port, 0, &pbuf, 1) == 1,
+			"Cannot send packet");
+	TEST_ASSERT(rte_eth_rx_burst(port, 0, &pbuf, 1) == 1 &&
+			pbuf == &buf, "Cannot receive packet");
+	test_pmd_mgmt_poll(1);
+	rte_power_pmd_mgmt_stats_get(lcore, &stats);
+	TEST_ASSERT(stats.polls == 18 && stats.empty_polls == 17 &&
+			stats.pauses == 4 && stats.intr_waits == 9,
+			"Streak not reset by traffic");
+
+	TEST_ASSERT_SUCCESS(rte_power_pmd_mgmt_queue_disable(lcore, port, 0),
+			"Cannot release queue");
+	test_pmd_mgmt_poll(16);
+	rte_power_pmd_mgmt_stats_get(lcore, &stats);
+	TEST_ASSERT(stats.polls == 18, "Released queue still managed");
+	return 0;
+}
+
+static int
+test_pmd_mgmt_sender(void *arg)
+{
+	struct rte_mbuf *pbuf = arg;
+
+	rte_delay_ms(50);
+	return rte_eth_tx_burst(port, 0, &pbuf, 1) == 1 ? 0 : -1;
+}
+
+static int
+test_pmd_mgmt_wakeup(unsigned int lcore)
+{
+	struct rte_power_pmd_mgmt_conf conf = test_conf;
+	struct rte_power_pmd_mgmt_stats stats;
+	struct rte_mbuf buf, *pbuf = &buf;
+	unsigned int sender;
+	uint64_t start;
+	unsigned int n;
+
+	sender = rte_get_next_lcore(lcore, 1, 0);
+	if (sender >= RTE_MAX_LCORE) {
+		printf("No spare lcore, skipping interrupt wakeup test\n");
+		return 0;
+	}
+
+	conf.intr_threshold = 1;
+	conf.intr_timeout_ms = 5000;
+	TEST_ASSERT_SUCCESS(rte_power_pmd_mgmt_queue_enable(lcore, port, 0,
+			&conf), "Cannot manage queue");
+	rte_power_pmd_mgmt_stats_reset(lcore);
+
+	/* the first empty poll blocks until the sender transmits */
+	rte_eal_remote_launch(test_pmd_mgmt_sender, &buf, sender);
+	start = rte_get_timer_cycles();
+	n = rte_eth_rx_burst(port, 0, &pbuf, 1);
+	if (n == 0)
+		n = rte_eth_rx_burst(port, 0, &pbuf, 1);
+	rte_eal_wait_lcore(sender);
+	rte_power_pmd_mgmt_queue_disable(lcore, port, 0);
+
+	rte_power_pmd_mgmt_stats_get(lcore, &stats);
+	TEST_ASSERT(n == 1 && pbuf == &buf, "Packet not received");
+	TEST_ASSERT(stats.intr_waits == 1 && stats.intr_wakeups == 1,
+			"Not woken up by Rx interrupt");
+	TEST_ASSERT(rte_get_timer_cycles() - start < rte_get_timer_hz(),
+			"Interrupt wait timed out");
+	return 0;
+}
+
+static int
+test_power_pmd_mgmt(void)
+{
+	unsigned int lcore = rte_lcore_id();
+	int ret = -1;
+
+	if (test_pmd_mgmt_port_setup() < 0)
+		return -1;
+
+	if (test_pmd_mgmt_args(lcore) < 0 ||
+	    test_pmd_mgmt_stages(lcore) < 0 ||
+	    test_pmd_mgmt_wakeup(lcore) < 0)
+		goto out;
+
+	ret = 0;
+out:
+	rte_power_pmd_mgmt_queue_disable(lcore, port, 0);
+	rte_eth_dev_stop(port);
+	return ret;
+}
+
+REGISTER_TEST_COMMAND(power_pmd_mgmt_autotest, test_power_pmd_mgmt);
@@ -0,0 +1,332 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <errno.h>
+
+#include "test.h"
+
+#include <rte_atomic.h>
+#include <rte_launch.h>
+#include <rte_lcore.h>
+#include <rte_malloc.h>
+#include <rte_rcu_qsbr.h>
+
+#define RCU_TEST_MAX_THREADS 4
+#define RCU_TEST_UPDATES 64
+#define RCU_TEST_DQ_SIZE 4
+#define RCU_TEST_POISON 0xdeadbeef
+
+static struct rte_rcu_qsbr *v;
+
+/* Element read by the readers and replaced by the writer */
+struct rcu_test_elem {
+	uint32_t val;
+};
+
+static struct rcu_test_elem *volatile shared_elem;
+static rte_atomic32_t writer_done;
+static rte_atomic32_t reader_errors;
+
+static int
+test_rcu_qsbr_args(void)
+{
+	struct rte_rcu_qsbr_dq_parameters params;
+
+	TEST_ASSERT(rte_rcu_qsbr_get_memsize(0) == 0,
+			"Memory size returned for 0 threads");
+	TEST_ASSERT(rte_rcu_qsbr_init(NULL, 1) == -EINVAL,
+			"NULL QS variable initialized");
+	TEST_ASSERT(rte_rcu_qsbr_init(v, 0) == -EINVAL,
+			"QS variable initialized for 0 threads");
+	TEST_ASSERT_SUCCESS(rte_rcu_qsbr_init(v, RCU_TEST_MAX_THREADS),
+			"Cannot initialize QS variable");
+	TEST_ASSERT(rte_rcu_qsbr_thread_register(NULL, 0) == -EINVAL,
+			"Thread registered with NULL QS variable");
+	TEST_ASSERT(rte_rcu_qsbr_thread_register(v, RCU_TEST_MAX_THREADS) ==
+			-EINVAL, "Invalid thread ID registered");
+	TEST_ASSERT(rte_rcu_qsbr_thread_unregister(v, RCU_TEST_MAX_THREADS) ==
+			-EINVAL, "Invalid thread ID unregistered");
+	TEST_ASSERT(rte_rcu_qsbr_dump(NULL, v) == -EINVAL,
+			"Dumped to NULL file");
+
+	memset(&params, 0, sizeof(params));
+	TEST_ASSERT(rte_rcu_qsbr_dq_create(NULL) == NULL,
+			"Defer queue created without parameters");
+	TEST_ASSERT(rte_rcu_qsbr_dq_create(&params) == NULL,
+			"Defer queue created with invalid parameters");
+	TEST_ASSERT(rte_rcu_qsbr_dq_enqueue(NULL, &params) == -EINVAL,
+			"Enqueued to NULL defer queue");
+	TEST_ASSERT(rte_rcu_qsbr_dq_reclaim(NULL, 1, NULL, NULL, NULL) ==
+			-EINVAL, "Reclaimed from NULL defer queue");
+	TEST_ASSERT_SUCCESS(rte_rcu_qsbr_dq_delete(NULL),
+			"Cannot delete NULL defer queue");
+	return 0;
+}
+
+static int
+test_rcu_qsbr_register(void)
+{
+	unsigned int i;
+
+	rte_rcu_qsbr_init(v, RCU_TEST_MAX_THREADS);
+
+	for (i = 0; i < RCU_TEST_MAX_THREADS; i++)
+		TEST_ASSERT_SUCCESS(rte_rcu_qsbr_thread_register(v, i),
+				"Cannot register thread %u", i);
+	TEST_ASSERT_SUCCESS(rte_rcu_qsbr_thread_register(v, 0),
+			"Cannot register thread twice");
+	TEST_ASSERT(rte_atomic32_read(&v->num_threads) ==
+			RCU_TEST_MAX_THREADS, "Wrong registered thread count");
+
+	for (i = 0; i < RCU_TEST_MAX_THREADS; i++)
+		TEST_ASSERT_SUCCESS(rte_rcu_qsbr_thread_unregister(v, i),
+				"Cannot unregister thread %u", i);
+	TEST_ASSERT(rte_atomic32_read(&v->num_threads) == 0,
+			"Threads still registered");
+	return 0;
+}
+
+static int
+test_rcu_qsbr_check(void)
+{
+	uint64_t t;
+
+	rte_rcu_qsbr_init(v, RCU_TEST_MAX_THREADS);
+	rte_rcu_qsbr_thread_register(v, 0);
+	rte_rcu_qsbr_thread_register(v, RCU_TEST_MAX_THREADS - 1);
+
+	/* Offline readers do not hold the grace period */
+	t = rte_rcu_qsbr_start(v);
+	TEST_ASSERT(rte_rcu_qsbr_check(v, t, false) == 1,
+			"Grace period held by offline threads");
+
+	rte_rcu_qsbr_thread_online(v, 0);
+	rte_rcu_qsbr_thread_online(v, RCU_TEST_MAX_THREADS - 1);
+	t = rte_rcu_qsbr_start(v);
+	TEST_ASSERT(rte_rcu_qsbr_check(v, t, false) == 0,
+			"Grace period over without quiescent state");
+
+	rte_rcu_qsbr_quiescent(v, 0);
+	TEST_ASSERT(rte_rcu_qsbr_check(v, t, false) == 0,
+			"Grace period over with a reader left");
+	rte_rcu_qsbr_quiescent(v, RCU_TEST_MAX_THREADS - 1);
+	TEST_ASSERT(rte_rcu_qsbr_check(v, t, false) == 1,
+			"Grace period not over after quiescent states");
+	/* Tokens returned earlier are acknowledged too */
+	TEST_ASSERT(rte_rcu_qsbr_check(v, t - 1, false) == 1,
+			"Older grace period not over");
+
+	t = rte_rcu_qsbr_start(v);
+	rte_rcu_qsbr_thread_offline(v, RCU_TEST_MAX_THREADS - 1);
+	rte_rcu_qsbr_quiescent(v, 0);
+	TEST_ASSERT(rte_rcu_qsbr_check(v, t, true) == 1,
+			"Grace period not over after going offline");
+
+	/* A reader synchronizing reports its own quiescent state */
+	rte_rcu_qsbr_synchronize(v, 0);
+	rte_rcu_qsbr_dump(stdout, v);
+
+	rte_rcu_qsbr_thread_offline(v, 0);
+	rte_rcu_qsbr_synchronize(v, RTE_QSBR_THRID_INVALID);
+	rte_rcu_qsbr_thread_unregister(v, 0);
+	rte_rcu_qsbr_thread_unregister(v, RCU_TEST_MAX_THREADS - 1);
+	return 0;
+}
+
+static int
+test_rcu_qsbr_reader(void *arg)
+{
+	unsigned int id = (uintptr_t)arg;
+	struct rcu_test_elem *e;
+
+	rte_rcu_qsbr_thread_register(v, id);
+	rte_rcu_qsbr_thread_online(v, id);
+
+	while (rte_atomic32_read(&writer_done) == 0) {
+		e = shared_elem;
+		if (e->val == RCU_TEST_POISON)
+			rte_atomic32_inc(&reader_errors);
+		rte_rcu_qsbr_quiescent(v, id);
+	}
+
+	rte_rcu_qsbr_thread_offline(v, id);
+	rte_rcu_qsbr_thread_unregister(v, id);
+	return 0;
+}
+
+/* Readers never see an element freed by the writer */
+static int
+test_rcu_qsbr_functional(void)
+{
+	struct rcu_test_elem *old, *e;
+	unsigned int lcore, id = 0, i;
+
+	rte_rcu_qsbr_init(v, RCU_TEST_MAX_THREADS);
+	rte_atomic32_init(&writer_done);
+	rte_atomic32_init(&reader_errors);
+
+	shared_elem = rte_zmalloc(NULL, sizeof(*shared_elem), 0);
+	TEST_ASSERT(shared_elem != NULL, "Cannot allocate element");
+
+	RTE_LCORE_FOREACH_SLAVE(lcore) {
+		if (id == RCU_TEST_MAX_THREADS)
+			break;
+		rte_eal_remote_launch(test_rcu_qsbr_reader,
+				(void *)(uintptr_t)id++, lcore);
+	}
+	if (id == 0)
+		printf("No spare lcore, running without readers\n");
+
+	for (i = 0; i < RCU_TEST_UPDATES; i++) {
+		e = rte_zmalloc(NULL, sizeof(*e), 0);
+		if (e == NULL)
+			break;
+		e->val = i;
+		old = shared_elem;
+		rte_smp_wmb();
+		shared_elem = e;
+
+		rte_rcu_qsbr_synchronize(v, RTE_QSBR_THRID_INVALID);
+		old->val = RCU_TEST_POISON;
+		rte_free(old);
+	}
+
+	rte_atomic32_set(&writer_done, 1);
+	rte_eal_mp_wait_lcore();
+	rte_free(shared_elem);
+
+	TEST_ASSERT(i == RCU_TEST_UPDATES, "Cannot allocate element");
+	TEST_ASSERT(rte_atomic32_read(&reader_errors) == 0,
+			"Readers accessed freed elements");
+	return 0;
+}
+
+static unsigned int dq_freed;
+static uint64_t dq_last;
+
+static void
+test_rcu_qsbr_dq_free(void *p, void *e, unsigned int n)
+{
+	RTE_SET_USED(p);
+	dq_freed += n;
+	dq_last = *(uint64_t *)e;
+}
+
+static int
+test_rcu_qsbr_dq(void)
+{
+	struct rte_rcu_qsbr_dq_parameters params;
+	struct rte_rcu_qsbr_dq *dq;
+	unsigned int freed, pending, available;
+	uint64_t e;
+
+	rte_rcu_qsbr_init(v, RCU_TEST_MAX_THREADS);
+	rte_rcu_qsbr_thread_register(v, 0);
+	rte_rcu_qsbr_thread_online(v, 0);
+
+	memset(&params, 0, sizeof(params));
+	params.name = "test_rcu_dq";
+	params.size = RCU_TEST_DQ_SIZE;
+	params.esize = sizeof(e);
+	params.trigger_reclaim_limit = RCU_TEST_DQ_SIZE;
+	params.max_reclaim_size = RCU_TEST_DQ_SIZE;
+	params.free_fn = test_rcu_qsbr_dq_free;
+	params.v = v;
+	dq = rte_rcu_qsbr_dq_create(&params);
+	TEST_ASSERT(dq != NULL, "Cannot create defer queue");
+
+	dq_freed = 0;
+	for (e = 0; e < RCU_TEST_DQ_SIZE; e++)
+		TEST_ASSERT_SUCCESS(rte_rcu_qsbr_dq_enqueue(dq, &e),
+				"Cannot enqueue element %"PRIu64, e);
+	TEST_ASSERT(rte_rcu_qsbr_dq_enqueue(dq, &e) == -ENOSPC,
+			"Element enqueued during its grace period");
+	rte_rcu_qsbr_dq_reclaim(dq, RCU_TEST_DQ_SIZE, &freed, &pending,
+			&available);
+	TEST_ASSERT(freed == 0 && pending == RCU_TEST_DQ_SIZE &&
+			available == 0 && dq_freed == 0,
+			"Element freed during its grace period");
+
+	/* Elements are freed in order, the full queue is reclaimed */
+	rte_rcu_qsbr_quiescent(v, 0);
+	TEST_ASSERT_SUCCESS(rte_rcu_qsbr_dq_enqueue(dq, &e),
+			"Cannot enqueue to a reclaimable queue");
+	TEST_ASSERT(dq_freed == RCU_TEST_DQ_SIZE &&
+			dq_last == RCU_TEST_DQ_SIZE - 1,
+			"Wrong elements reclaimed");
+	rte_rcu_qsbr_dq_reclaim(dq, RCU_TEST_DQ_SIZE, &freed, &pending,
+			&available);
+	TEST_ASSERT(freed == 0 && pending == 1 &&
+			available == RCU_TEST_DQ_SIZE - 1,
+			"Element freed during its grace period");
+
+	rte_rcu_qsbr_thread_offline(v, 0);
+	TEST_ASSERT_SUCCESS(rte_rcu_qsbr_dq_delete(dq),
+			"Cannot delete defer queue");
+	TEST_ASSERT(dq_freed == RCU_TEST_DQ_SIZE + 1 &&
+			dq_last == RCU_TEST_DQ_SIZE,
+			"Elements not freed with the queue");
+
+	rte_rcu_qsbr_thread_unregister(v, 0);
+	return 0;
+}
+
+static int
+test_rcu_qsbr(void)
+{
+	int ret = -1;
+
+	v = rte_zmalloc(NULL, rte_rcu_qsbr_get_memsize(RCU_TEST_MAX_THREADS),
+			RTE_CACHE_LINE_SIZE);
+	if (v == NULL) {
+		printf("Cannot allocate QS variable\n");
+		return -1;
+	}
+
+	if (test_rcu_qsbr_args() < 0 ||
+	    test_rcu_qsbr_register() < 0 ||
+	    test_rcu_qsbr_check() < 0 ||
+	    test_rcu_qsbr_functional() < 0 ||
+	    test_rcu_qsbr_dq() < 0)
+		goto out;
+
+	ret = 0;
+out:
+	rte_free(v);
+	return ret;
+}
+
+REGISTER_TEST_COMMAND(rcu_qsbr_autotest, test_rcu_qsbr);
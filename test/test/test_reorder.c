@@ -181,7 +181,7 @@ test_reorder_insert(void)
 	TEST_ASSERT_SUCCESS(ret, "Error getting mbuf from pool");
 
 	for (i = 0; i < num_bufs; i++)
-		bufs[i]->seqn = i;
+		*rte_reorder_seqn(bufs[i]) = i;
 
 	/* This should fill up order buffer:
 	 * reorder_seq = 0
@@ -212,7 +212,7 @@ test_reorder_insert(void)
 	}
 
 	/* early packet from current sequence window - full ready buffer */
-	bufs[5]->seqn = 2 * size;
+	*rte_reorder_seqn(bufs[5]) = 2 * size;
 	ret = rte_reorder_insert(b, bufs[5]);
 	if (!((ret == -1) && (rte_errno == ENOSPC))) {
 		printf("%s:%d: No error inserting early packet with full ready buffer\n",
@@ -222,7 +222,7 @@ test_reorder_insert(void)
 	}
 
 	/* late packet */
-	bufs[6]->seqn = 3 * size;
+	*rte_reorder_seqn(bufs[6]) = 3 * size;
 	ret = rte_reorder_insert(b, bufs[6]);
 	if (!((ret == -1) && (rte_errno == ERANGE))) {
 		printf("%s:%d: No error inserting late packet with seqn:"
@@ -271,7 +271,7 @@ test_reorder_drain(void)
 	}
 
 	for (i = 0; i < num_bufs; i++)
-		bufs[i]->seqn = i;
+		*rte_reorder_seqn(bufs[i]) = i;
 
 	/* Insert packet with seqn 1:
 	 * reorder_seq = 0
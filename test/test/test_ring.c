@@ -36,6 +36,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 #include <inttypes.h>
 #include <errno.h>
 #include <sys/queue.h>
@@ -53,6 +54,7 @@
 #include <rte_branch_prediction.h>
 #include <rte_malloc.h>
 #include <rte_ring.h>
+#include <rte_ring_elem.h>
 #include <rte_random.h>
 #include <rte_common.h>
 #include <rte_errno.h>
@@ -78,6 +80,16 @@
  *      - Dequeue one object, two objects, MAX_BULK objects
  *      - Check that dequeued pointers are correct
  *
+ * #. Relaxed tail sync tests: done on one core:
+ *
+ *    - Enqueue/dequeue through the default functions of a RTS ring
+ *    - Check conflicting sync flags and head/tail distance settings
+ *
+ * #. Element ring tests: done on one core, for several element sizes:
+ *
+ *    - Enqueue/dequeue bulk and burst of elements across the ring wrap
+ *    - Check that dequeued elements are copied back unchanged
+ *
  * #. Performance tests.
  *
  * Tests done in test_ring_perf.c
@@ -769,6 +781,192 @@ test_ring_basic_ex(void)
 	return ret;
 }
 
+/*
+ * test a ring in relaxed tail sync mode through the default functions
+ */
+static int
+test_ring_rts(void)
+{
+	struct rte_ring *rp;
+	void **src = NULL, **dst = NULL;
+	unsigned int i, n;
+	int ret = -1;
+
+	/* only one sync mode may be requested for each side */
+	if (rte_ring_create("test_ring_rts_bad", RING_SIZE, SOCKET_ID_ANY,
+			RING_F_SP_ENQ | RING_F_MP_RTS_ENQ) != NULL ||
+			rte_errno != EINVAL)
+		return -1;
+	if (rte_ring_create("test_ring_rts_bad", RING_SIZE, SOCKET_ID_ANY,
+			RING_F_SC_DEQ | RING_F_MC_RTS_DEQ) != NULL ||
+			rte_errno != EINVAL)
+		return -1;
+
+	src = rte_calloc(NULL, RING_SIZE, sizeof(void *), 0);
+	dst = rte_calloc(NULL, RING_SIZE, sizeof(void *), 0);
+	if (src == NULL || dst == NULL)
+		goto fail_test;
+	for (i = 0; i < RING_SIZE; i++)
+		src[i] = (void *)(uintptr_t)(i + 1);
+
+	rp = rte_ring_create("test_ring_rts", RING_SIZE, SOCKET_ID_ANY,
+			RING_F_MP_RTS_ENQ | RING_F_MC_RTS_DEQ);
+	if (rp == NULL) {
+		printf("%s: cannot create ring\n", __func__);
+		goto fail_test;
+	}
+
+	if (rte_ring_get_prod_htd_max(rp) != RING_SIZE / 8 ||
+			rte_ring_get_cons_htd_max(rp) != RING_SIZE / 8)
+		goto fail_ring;
+	if (rte_ring_set_prod_htd_max(rp, MAX_BULK) != 0 ||
+			rte_ring_get_prod_htd_max(rp) != MAX_BULK)
+		goto fail_ring;
+	if (rte_ring_set_prod_htd_max(r, MAX_BULK) != -ENOTSUP)
+		goto fail_ring;
+
+	/* several laps so that positions wrap around the table */
+	for (i = 0; i < 4 * RING_SIZE / MAX_BULK; i++) {
+		if (rte_ring_enqueue_bulk(rp, src, MAX_BULK, NULL) != MAX_BULK)
+			goto fail_ring;
+		if (rte_ring_count(rp) != MAX_BULK)
+			goto fail_ring;
+		if (rte_ring_dequeue_bulk(rp, dst, MAX_BULK, NULL) != MAX_BULK)
+			goto fail_ring;
+		if (memcmp(src, dst, MAX_BULK * sizeof(void *)) != 0)
+			goto fail_ring;
+	}
+
+	/* fill and drain with bursts */
+	n = rte_ring_enqueue_burst(rp, src, RING_SIZE, NULL);
+	if (n != RING_SIZE - 1 || rte_ring_full(rp) != 1)
+		goto fail_ring;
+	if (rte_ring_enqueue(rp, src[0]) != -ENOBUFS)
+		goto fail_ring;
+	n = rte_ring_dequeue_burst(rp, dst, RING_SIZE, NULL);
+	if (n != RING_SIZE - 1 || rte_ring_empty(rp) != 1)
+		goto fail_ring;
+	if (memcmp(src, dst, n * sizeof(void *)) != 0)
+		goto fail_ring;
+	if (rte_ring_dequeue(rp, &dst[0]) != -ENOENT)
+		goto fail_ring;
+
+	ret = 0;
+fail_ring:
+	if (ret != 0)
+		rte_ring_dump(stdout, rp);
+	rte_ring_free(rp);
+fail_test:
+	rte_free(src);
+	rte_free(dst);
+	return ret;
+}
+
+/*
+ * test enqueue/dequeue of in-place elements of a given size, with the
+ * copies straddling the end of the ring table
+ */
+#define ELEM_RING_SIZE 64
+
+static int
+test_ring_elem(unsigned int esize)
+{
+	struct rte_ring *rp;
+	uint32_t *src = NULL, *dst = NULL;
+	const unsigned int words = esize / sizeof(uint32_t);
+	unsigned int i, n, num_elems;
+	int ret = -1;
+
+	src = rte_zmalloc(NULL, ELEM_RING_SIZE * esize, 0);
+	dst = rte_zmalloc(NULL, ELEM_RING_SIZE * esize, 0);
+	if (src == NULL || dst == NULL) {
+		printf("%s: cannot allocate buffers\n", __func__);
+		goto fail_test;
+	}
+	for (i = 0; i < ELEM_RING_SIZE * words; i++)
+		src[i] = i;
+
+	rp = rte_ring_create_elem("test_ring_elem", esize, ELEM_RING_SIZE,
+			SOCKET_ID_ANY, 0);
+	if (rp == NULL) {
+		printf("%s: cannot create ring with esize %u\n", __func__,
+			esize);
+		goto fail_test;
+	}
+
+	/* move the head/tail close to the end of the ring */
+	num_elems = ELEM_RING_SIZE / 2 + 5;
+	if (rte_ring_sp_enqueue_bulk_elem(rp, src, esize, num_elems,
+			NULL) != num_elems ||
+			rte_ring_sc_dequeue_bulk_elem(rp, dst, esize,
+			num_elems, NULL) != num_elems)
+		goto fail_ring;
+
+	/* this bulk wraps around the end of the table */
+	memset(dst, 0, ELEM_RING_SIZE * esize);
+	if (rte_ring_mp_enqueue_bulk_elem(rp, src, esize, num_elems,
+			NULL) != num_elems)
+		goto fail_ring;
+	if (rte_ring_mc_dequeue_bulk_elem(rp, dst, esize, num_elems,
+			NULL) != num_elems)
+		goto fail_ring;
+	if (memcmp(src, dst, num_elems * esize) != 0) {
+		printf("%s: wrapped elements differ for esize %u\n", __func__,
+			esize);
+		goto fail_ring;
+	}
+
+	/* burst fills the ring up to its usable size */
+	n = rte_ring_enqueue_burst_elem(rp, src, esize, ELEM_RING_SIZE, NULL);
+	if (n != ELEM_RING_SIZE - 1 || rte_ring_full(rp) != 1)
+		goto fail_ring;
+	if (rte_ring_enqueue_elem(rp, src, esize) != -ENOBUFS)
+		goto fail_ring;
+
+	memset(dst, 0, ELEM_RING_SIZE * esize);
+	if (rte_ring_dequeue_elem(rp, dst, esize) != 0)
+		goto fail_ring;
+	n = rte_ring_dequeue_burst_elem(rp, (char *)dst + esize, esize,
+			ELEM_RING_SIZE, NULL);
+	if (n != ELEM_RING_SIZE - 2 || rte_ring_empty(rp) != 1)
+		goto fail_ring;
+	if (memcmp(src, dst, (ELEM_RING_SIZE - 1) * esize) != 0) {
+		printf("%s: burst elements differ for esize %u\n", __func__,
+			esize);
+		goto fail_ring;
+	}
+	if (rte_ring_dequeue_elem(rp, dst, esize) != -ENOENT)
+		goto fail_ring;
+
+	ret = 0;
+fail_ring:
+	if (ret != 0)
+		rte_ring_dump(stdout, rp);
+	rte_ring_free(rp);
+fail_test:
+	rte_free(src);
+	rte_free(dst);
+	return ret;
+}
+
+static int
+test_ring_elem_sizes(void)
+{
+	static const unsigned int esizes[] = { 4, 8, 12, 16, 20, 32 };
+	unsigned int i;
+
+	for (i = 0; i < RTE_DIM(esizes); i++)
+		if (test_ring_elem(esizes[i]) < 0)
+			return -1;
+
+	/* element size must be a multiple of 4 */
+	if (rte_ring_create_elem("test_bad_esize", 6, RING_SIZE,
+			SOCKET_ID_ANY, 0) != NULL)
+		return -1;
+
+	return 0;
+}
+
 static int
 test_ring(void)
 {
@@ -820,6 +1018,14 @@ test_ring(void)
 	if (test_ring_creation_with_an_used_name() < 0)
 		return -1;
 
+	/* relaxed tail sync mode */
+	if (test_ring_rts() < 0)
+		return -1;
+
+	/* rings storing elements in place */
+	if (test_ring_elem_sizes() < 0)
+		return -1;
+
 	/* dump the ring status */
 	rte_ring_list_dump(stdout);
 
@@ -34,7 +34,10 @@
 
 #include <stdio.h>
 #include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
 #include <rte_ring.h>
+#include <rte_ring_elem.h>
 #include <rte_cycles.h>
 #include <rte_launch.h>
 
@@ -48,11 +51,14 @@
  *  * Empty ring dequeue
  *  * Enqueue/dequeue of bursts in 1 threads
  *  * Enqueue/dequeue of bursts in 2 threads
+ *  * The same bulk tests for rings storing 8, 16 and 32-byte elements
+ *  * MP/MC and relaxed tail sync enq/dequeue with more threads than cpus
  */
 
 #define RING_NAME "RING_PERF"
 #define RING_SIZE 4096
 #define MAX_BURST 32
+#define MAX_ELEM_SIZE 32
 
 /*
  * the sizes to enqueue and dequeue in testing
@@ -60,9 +66,15 @@
  */
 static const volatile unsigned bulk_sizes[] = { 8, 32 };
 
+/* element sizes, in bytes, for the tests of rings storing elements in place */
+static const unsigned int elem_sizes[] = { 8, 16, 32 };
+
 /* The ring structure used for tests */
 static struct rte_ring *r;
 
+/* The element size of the ring used by the *_elem tests */
+static unsigned int esize;
+
 struct lcore_pair {
 	unsigned c1, c2;
 };
@@ -389,6 +401,293 @@ test_bulk_enqueue_dequeue(void)
 	}
 }
 
+/*
+ * Same as enqueue_bulk() but copying elements of esize bytes in place.
+ */
+static int
+enqueue_bulk_elem(void *p)
+{
+	const unsigned iter_shift = 23;
+	const unsigned iterations = 1<<iter_shift;
+	struct thread_params *params = p;
+	const unsigned size = params->size;
+	unsigned i;
+	uint64_t burst[MAX_BURST * MAX_ELEM_SIZE / sizeof(uint64_t)] = {0};
+
+	if ( __sync_add_and_fetch(&lcore_count, 1) != 2 )
+		while(lcore_count != 2)
+			rte_pause();
+
+	const uint64_t sp_start = rte_rdtsc();
+	for (i = 0; i < iterations; i++)
+		while (rte_ring_sp_enqueue_bulk_elem(r, burst, esize, size,
+				NULL) == 0)
+			rte_pause();
+	const uint64_t sp_end = rte_rdtsc();
+
+	const uint64_t mp_start = rte_rdtsc();
+	for (i = 0; i < iterations; i++)
+		while (rte_ring_mp_enqueue_bulk_elem(r, burst, esize, size,
+				NULL) == 0)
+			rte_pause();
+	const uint64_t mp_end = rte_rdtsc();
+
+	params->spsc = ((double)(sp_end - sp_start))/(iterations*size);
+	params->mpmc = ((double)(mp_end - mp_start))/(iterations*size);
+	return 0;
+}
+
+/*
+ * Same as dequeue_bulk() but copying elements of esize bytes in place.
+ */
+static int
+dequeue_bulk_elem(void *p)
+{
+	const unsigned iter_shift = 23;
+	const unsigned iterations = 1<<iter_shift;
+	struct thread_params *params = p;
+	const unsigned size = params->size;
+	unsigned i;
+	uint64_t burst[MAX_BURST * MAX_ELEM_SIZE / sizeof(uint64_t)] = {0};
+
+	if ( __sync_add_and_fetch(&lcore_count, 1) != 2 )
+		while(lcore_count != 2)
+			rte_pause();
+
+	const uint64_t sc_start = rte_rdtsc();
+	for (i = 0; i < iterations; i++)
+		while (rte_ring_sc_dequeue_bulk_elem(r, burst, esize, size,
+				NULL) == 0)
+			rte_pause();
+	const uint64_t sc_end = rte_rdtsc();
+
+	const uint64_t mc_start = rte_rdtsc();
+	for (i = 0; i < iterations; i++)
+		while (rte_ring_mc_dequeue_bulk_elem(r, burst, esize, size,
+				NULL) == 0)
+			rte_pause();
+	const uint64_t mc_end = rte_rdtsc();
+
+	params->spsc = ((double)(sc_end - sc_start))/(iterations*size);
+	params->mpmc = ((double)(mc_end - mc_start))/(iterations*size);
+	return 0;
+}
+
+/* Times enqueue and dequeue of in-place elements on a single lcore */
+static void
+test_bulk_enqueue_dequeue_elem(void)
+{
+	const unsigned iter_shift = 23;
+	const unsigned iterations = 1<<iter_shift;
+	unsigned sz, i = 0;
+	uint64_t burst[MAX_BURST * MAX_ELEM_SIZE / sizeof(uint64_t)] = {0};
+
+	for (sz = 0; sz < sizeof(bulk_sizes)/sizeof(bulk_sizes[0]); sz++) {
+		const uint64_t sc_start = rte_rdtsc();
+		for (i = 0; i < iterations; i++) {
+			rte_ring_sp_enqueue_bulk_elem(r, burst, esize,
+					bulk_sizes[sz], NULL);
+			rte_ring_sc_dequeue_bulk_elem(r, burst, esize,
+					bulk_sizes[sz], NULL);
+		}
+		const uint64_t sc_end = rte_rdtsc();
+
+		const uint64_t mc_start = rte_rdtsc();
+		for (i = 0; i < iterations; i++) {
+			rte_ring_mp_enqueue_bulk_elem(r, burst, esize,
+					bulk_sizes[sz], NULL);
+			rte_ring_mc_dequeue_bulk_elem(r, burst, esize,
+					bulk_sizes[sz], NULL);
+		}
+		const uint64_t mc_end = rte_rdtsc();
+
+		double sc_avg = ((double)(sc_end-sc_start) /
+				(iterations * bulk_sizes[sz]));
+		double mc_avg = ((double)(mc_end-mc_start) /
+				(iterations * bulk_sizes[sz]));
+
+		printf("SP/SC bulk enq/dequeue (size: %u): %.2F\n", bulk_sizes[sz],
+				sc_avg);
+		printf("MP/MC bulk enq/dequeue (size: %u): %.2F\n", bulk_sizes[sz],
+				mc_avg);
+	}
+}
+
+/*
+ * Oversubscription test: runs several threads per cpu available to the
+ * master lcore, each one doing enqueue/dequeue of bursts through the
+ * default functions for a fixed time. The threads are plain pthreads
+ * sharing the cpus, so the OS scheduler preempts them at any point,
+ * including between a head and a tail update. This compares the default
+ * MP/MC sync, where all threads then wait for the preempted one, with the
+ * relaxed tail sync.
+ */
+#define OVERSUB_FACTOR 4
+#define OVERSUB_MAX_THREADS 64
+#define OVERSUB_DURATION_MS 500
+
+struct oversub_params {
+	struct rte_ring *r;
+	unsigned int size;
+	uint64_t iterations; /* output value, number of enq+deq done */
+	uint64_t max;        /* output value, worst enq+deq cycles */
+};
+
+static volatile unsigned int oversub_start;
+static uint64_t oversub_end;
+
+static void *
+oversub_enqueue_dequeue(void *p)
+{
+	struct oversub_params *params = p;
+	struct rte_ring *rp = params->r;
+	const unsigned size = params->size;
+	void *burst[MAX_BURST] = {0};
+	uint64_t start, t, max = 0, i = 0;
+
+	while (oversub_start == 0)
+		rte_pause();
+
+	do {
+		start = rte_rdtsc();
+		while (rte_ring_enqueue_bulk(rp, burst, size, NULL) == 0)
+			rte_pause();
+		while (rte_ring_dequeue_bulk(rp, burst, size, NULL) == 0)
+			rte_pause();
+		t = rte_rdtsc() - start;
+		if (t > max)
+			max = t;
+		i++;
+	} while (start + t < oversub_end);
+
+	params->iterations = i;
+	params->max = max;
+	return NULL;
+}
+
+static int
+run_oversubscribed(struct rte_ring *rp, unsigned int nb_threads,
+		unsigned int size)
+{
+	struct oversub_params params[OVERSUB_MAX_THREADS];
+	pthread_t tid[OVERSUB_MAX_THREADS];
+	uint64_t begin, end, max = 0, iterations = 0;
+	unsigned int i, n;
+
+	oversub_start = 0;
+	for (n = 0; n < nb_threads; n++) {
+		params[n].r = rp;
+		params[n].size = size;
+		if (pthread_create(&tid[n], NULL, oversub_enqueue_dequeue,
+				&params[n]) != 0)
+			break;
+	}
+	begin = rte_rdtsc();
+	oversub_end = begin + rte_get_tsc_hz() * OVERSUB_DURATION_MS / 1000;
+	rte_smp_wmb();
+	oversub_start = 1;
+	for (i = 0; i < n; i++) {
+		pthread_join(tid[i], NULL);
+		iterations += params[i].iterations;
+		if (params[i].max > max)
+			max = params[i].max;
+	}
+	end = rte_rdtsc();
+	if (n != nb_threads) {
+		printf("Cannot create oversubscription threads\n");
+		return -1;
+	}
+
+	printf("%s enq/dequeue (size: %u): %.2F per object, worst %"PRIu64"\n",
+		rp->prod.sync_type == RTE_RING_SYNC_MT_RTS ? "RTS  " : "MP/MC",
+		size, (double)(end - begin) / (iterations * size), max);
+	return 0;
+}
+
+static int
+test_ring_perf_oversubscribed(void)
+{
+	static const unsigned int sync_flags[] = {
+		0, RING_F_MP_RTS_ENQ | RING_F_MC_RTS_DEQ,
+	};
+	struct rte_ring *rp;
+	char name[RTE_RING_NAMESIZE];
+	cpu_set_t cpuset;
+	unsigned int i, sz, nb_cpus, nb_threads;
+
+	/* new threads inherit the affinity of the master lcore */
+	if (pthread_getaffinity_np(pthread_self(), sizeof(cpuset),
+			&cpuset) != 0)
+		return -1;
+	nb_cpus = CPU_COUNT(&cpuset);
+	nb_threads = RTE_MIN(nb_cpus * OVERSUB_FACTOR,
+			(unsigned int)OVERSUB_MAX_THREADS);
+
+	printf("\n### Testing %u threads on %u cpus ###\n", nb_threads,
+			nb_cpus);
+	for (i = 0; i < RTE_DIM(sync_flags); i++) {
+		snprintf(name, sizeof(name), "%s_OVS_%u", RING_NAME, i);
+		rp = rte_ring_create(name, RING_SIZE, rte_socket_id(),
+				sync_flags[i]);
+		if (rp == NULL && (rp = rte_ring_lookup(name)) == NULL)
+			return -1;
+
+		for (sz = 0; sz < sizeof(bulk_sizes)/sizeof(bulk_sizes[0]);
+				sz++) {
+			if (run_oversubscribed(rp, nb_threads,
+					bulk_sizes[sz]) != 0) {
+				rte_ring_free(rp);
+				return -1;
+			}
+		}
+		rte_ring_free(rp);
+	}
+	return 0;
+}
+
+/* Runs the bulk tests against a ring storing elements of each size */
+static int
+test_ring_perf_elem(void)
+{
+	struct lcore_pair cores;
+	char name[RTE_RING_NAMESIZE];
+	unsigned int i;
+
+	for (i = 0; i < RTE_DIM(elem_sizes); i++) {
+		esize = elem_sizes[i];
+		snprintf(name, sizeof(name), "%s_%u", RING_NAME, esize);
+		r = rte_ring_create_elem(name, esize, RING_SIZE,
+				rte_socket_id(), 0);
+		if (r == NULL && (r = rte_ring_lookup(name)) == NULL)
+			return -1;
+
+		printf("\n### Testing %u-byte elements using a single lcore ###\n",
+				esize);
+		test_bulk_enqueue_dequeue_elem();
+
+		if (get_two_hyperthreads(&cores) == 0) {
+			printf("\n### Testing %u-byte elements using two hyperthreads ###\n",
+					esize);
+			run_on_core_pair(&cores, enqueue_bulk_elem,
+					dequeue_bulk_elem);
+		}
+		if (get_two_cores(&cores) == 0) {
+			printf("\n### Testing %u-byte elements using two physical cores ###\n",
+					esize);
+			run_on_core_pair(&cores, enqueue_bulk_elem,
+					dequeue_bulk_elem);
+		}
+		if (get_two_sockets(&cores) == 0) {
+			printf("\n### Testing %u-byte elements using two NUMA nodes ###\n",
+					esize);
+			run_on_core_pair(&cores, enqueue_bulk_elem,
+					dequeue_bulk_elem);
+		}
+		rte_ring_free(r);
+	}
+	return 0;
+}
+
 static int
 test_ring_perf(void)
 {
@@ -419,7 +718,11 @@ test_ring_perf(void)
 		printf("\n### Testing using two NUMA nodes ###\n");
 		run_on_core_pair(&cores, enqueue_bulk, dequeue_bulk);
 	}
-	return 0;
+
+	if (test_ring_perf_oversubscribed() < 0)
+		return -1;
+
+	return test_ring_perf_elem();
 }
 
 REGISTER_TEST_COMMAND(ring_perf_autotest, test_ring_perf);
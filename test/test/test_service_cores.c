@@ -0,0 +1,351 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_lcore.h>
+#include <rte_atomic.h>
+#include <rte_service.h>
+#include <rte_service_component.h>
+
+#include "test.h"
+
+#define DUMMY_SERVICE_NAME "dummy_service"
+/* maximum time to wait for a service lcore to run a service, in ms */
+#define SERVICE_DELAY_MS 1000
+
+static uint32_t dummy_id;
+static uint32_t slave_lcore;
+static rte_atomic32_t dummy_calls;
+
+static int32_t
+dummy_cb(void *args)
+{
+	RTE_SET_USED(args);
+	rte_atomic32_inc(&dummy_calls);
+	return 0;
+}
+
+/* wait until the dummy service was called, returns 0 on success */
+static int
+wait_dummy_calls(void)
+{
+	int ms;
+
+	for (ms = 0; ms < SERVICE_DELAY_MS; ms++) {
+		if (rte_atomic32_read(&dummy_calls) > 0)
+			return 0;
+		rte_delay_ms(1);
+	}
+	return -1;
+}
+
+static int
+testsuite_setup(void)
+{
+	slave_lcore = rte_get_next_lcore(-1, 1, 0);
+	if (slave_lcore >= RTE_MAX_LCORE) {
+		printf("Not enough lcores for service cores test\n");
+		return -1;
+	}
+	return 0;
+}
+
+static int
+dummy_register(void)
+{
+	struct rte_service_spec spec;
+
+	memset(&spec, 0, sizeof(spec));
+	snprintf(spec.name, sizeof(spec.name), DUMMY_SERVICE_NAME);
+	spec.callback = dummy_cb;
+	spec.socket_id = rte_socket_id();
+
+	rte_atomic32_clear(&dummy_calls);
+	return rte_service_component_register(&spec, &dummy_id);
+}
+
+static void
+dummy_unregister(void)
+{
+	rte_service_lcore_reset_all();
+	rte_service_component_unregister(dummy_id);
+}
+
+static int
+service_register(void)
+{
+	struct rte_service_spec spec;
+	uint32_t count = rte_service_get_count();
+	uint32_t id;
+
+	memset(&spec, 0, sizeof(spec));
+	TEST_ASSERT_EQUAL(-EINVAL, rte_service_component_register(NULL, &id),
+			"Registered a NULL service");
+	snprintf(spec.name, sizeof(spec.name), "no_callback");
+	TEST_ASSERT_EQUAL(-EINVAL, rte_service_component_register(&spec, &id),
+			"Registered a service without callback");
+
+	TEST_ASSERT_SUCCESS(dummy_register(), "Failed to register service");
+	TEST_ASSERT_EQUAL(count + 1, rte_service_get_count(),
+			"Wrong service count");
+	TEST_ASSERT_EQUAL(-EINVAL, dummy_register(),
+			"Registered two services with the same name");
+
+	TEST_ASSERT_SUCCESS(rte_service_get_by_name(DUMMY_SERVICE_NAME, &id),
+			"Failed to find service by name");
+	TEST_ASSERT_EQUAL(dummy_id, id, "Wrong service id");
+	TEST_ASSERT_EQUAL(-ENODEV, rte_service_get_by_name("invalid", &id),
+			"Found an unregistered service");
+	TEST_ASSERT_EQUAL(0, strcmp(DUMMY_SERVICE_NAME,
+			rte_service_get_name(dummy_id)), "Wrong service name");
+	TEST_ASSERT_EQUAL(0, rte_service_probe_capability(dummy_id,
+			RTE_SERVICE_CAP_MT_SAFE), "Service is not MT safe");
+
+	TEST_ASSERT_SUCCESS(rte_service_component_unregister(dummy_id),
+			"Failed to unregister service");
+	TEST_ASSERT_EQUAL(count, rte_service_get_count(),
+			"Wrong service count");
+	TEST_ASSERT_EQUAL(-EINVAL, rte_service_component_unregister(dummy_id),
+			"Unregistered a service twice");
+	TEST_ASSERT_NULL(rte_service_get_name(dummy_id),
+			"Unregistered service has a name");
+
+	return TEST_SUCCESS;
+}
+
+static int
+service_lcore_add_del(void)
+{
+	unsigned int lcore_count = rte_lcore_count();
+	uint32_t ids[RTE_MAX_LCORE];
+
+	TEST_ASSERT_EQUAL(0, rte_service_lcore_count(),
+			"Service lcores before the test");
+	TEST_ASSERT_EQUAL(-EINVAL,
+			rte_service_lcore_add(rte_get_master_lcore()),
+			"Master lcore added as service lcore");
+
+	TEST_ASSERT_SUCCESS(rte_service_lcore_add(slave_lcore),
+			"Failed to add service lcore");
+	TEST_ASSERT_EQUAL(-EALREADY, rte_service_lcore_add(slave_lcore),
+			"Service lcore added twice");
+	TEST_ASSERT_EQUAL(1, rte_service_lcore_count(),
+			"Wrong service lcore count");
+	TEST_ASSERT_EQUAL(lcore_count - 1, rte_lcore_count(),
+			"Service lcore still counted as application lcore");
+	TEST_ASSERT_EQUAL(0, rte_lcore_is_enabled(slave_lcore),
+			"Service lcore still enabled");
+
+	TEST_ASSERT_EQUAL(-ENOMEM, rte_service_lcore_list(ids, 0),
+			"Listed service lcores in a too small array");
+	TEST_ASSERT_EQUAL(1, rte_service_lcore_list(ids, RTE_MAX_LCORE),
+			"Wrong number of service lcores listed");
+	TEST_ASSERT_EQUAL(slave_lcore, ids[0], "Wrong service lcore listed");
+
+	TEST_ASSERT_SUCCESS(rte_service_lcore_del(slave_lcore),
+			"Failed to delete service lcore");
+	TEST_ASSERT_EQUAL(-EINVAL, rte_service_lcore_del(slave_lcore),
+			"Service lcore deleted twice");
+	TEST_ASSERT_EQUAL(lcore_count, rte_lcore_count(),
+			"Wrong lcore count after deleting service lcore");
+	TEST_ASSERT_EQUAL(1, rte_lcore_is_enabled(slave_lcore),
+			"Deleted service lcore not enabled");
+
+	return TEST_SUCCESS;
+}
+
+static int
+service_runstate(void)
+{
+	TEST_ASSERT_EQUAL(-ENOEXEC, rte_service_run_iter_on_app_lcore(dummy_id),
+			"Ran a stopped service");
+
+	TEST_ASSERT_SUCCESS(rte_service_runstate_set(dummy_id, 1),
+			"Failed to start service");
+	TEST_ASSERT_EQUAL(0, rte_service_runstate_get(dummy_id),
+			"Service running without component runstate");
+	TEST_ASSERT_EQUAL(-ENOEXEC, rte_service_run_iter_on_app_lcore(dummy_id),
+			"Ran a service stopped by its component");
+
+	TEST_ASSERT_SUCCESS(rte_service_component_runstate_set(dummy_id, 1),
+			"Failed to set component runstate");
+	TEST_ASSERT_EQUAL(1, rte_service_runstate_get(dummy_id),
+			"Service not running");
+
+	TEST_ASSERT_SUCCESS(rte_service_set_stats_enable(dummy_id, 1),
+			"Failed to enable stats");
+	TEST_ASSERT_SUCCESS(rte_service_run_iter_on_app_lcore(dummy_id),
+			"Failed to run service on app lcore");
+	TEST_ASSERT_EQUAL(1, rte_atomic32_read(&dummy_calls),
+			"Service callback not called");
+
+	uint64_t calls = 0;
+	TEST_ASSERT_SUCCESS(rte_service_attr_get(dummy_id,
+			RTE_SERVICE_ATTR_CALL_COUNT, &calls),
+			"Failed to get call count");
+	TEST_ASSERT_EQUAL(1, calls, "Wrong call count");
+	TEST_ASSERT_EQUAL(-EINVAL, rte_service_attr_get(dummy_id, UINT32_MAX,
+			&calls), "Got an invalid attribute");
+
+	TEST_ASSERT_SUCCESS(rte_service_attr_reset_all(dummy_id),
+			"Failed to reset stats");
+	TEST_ASSERT_SUCCESS(rte_service_attr_get(dummy_id,
+			RTE_SERVICE_ATTR_CALL_COUNT, &calls),
+			"Failed to get call count");
+	TEST_ASSERT_EQUAL(0, calls, "Call count not reset");
+
+	return TEST_SUCCESS;
+}
+
+static int
+service_lcore_start_stop(void)
+{
+	uint64_t calls = 0, cycles = 0;
+
+	TEST_ASSERT_SUCCESS(rte_service_lcore_add(slave_lcore),
+			"Failed to add service lcore");
+	TEST_ASSERT_SUCCESS(rte_service_map_lcore_set(dummy_id, slave_lcore, 1),
+			"Failed to map service");
+	TEST_ASSERT_EQUAL(1, rte_service_map_lcore_get(dummy_id, slave_lcore),
+			"Service not mapped");
+	TEST_ASSERT_EQUAL(1, rte_service_lcore_count_services(slave_lcore),
+			"Wrong number of services on service lcore");
+	TEST_ASSERT_EQUAL(-EINVAL, rte_service_map_lcore_set(dummy_id,
+			rte_get_master_lcore(), 1),
+			"Mapped service to a non service lcore");
+
+	TEST_ASSERT_SUCCESS(rte_service_runstate_set(dummy_id, 1),
+			"Failed to start service");
+	TEST_ASSERT_SUCCESS(rte_service_component_runstate_set(dummy_id, 1),
+			"Failed to set component runstate");
+	TEST_ASSERT_SUCCESS(rte_service_set_stats_enable(dummy_id, 1),
+			"Failed to enable stats");
+
+	TEST_ASSERT_SUCCESS(rte_service_lcore_start(slave_lcore),
+			"Failed to start service lcore");
+	TEST_ASSERT_EQUAL(-EALREADY, rte_service_lcore_start(slave_lcore),
+			"Service lcore started twice");
+	TEST_ASSERT_EQUAL(-EBUSY, rte_service_lcore_del(slave_lcore),
+			"Deleted a running service lcore");
+	TEST_ASSERT_SUCCESS(wait_dummy_calls(),
+			"Service not run by service lcore");
+
+	TEST_ASSERT_SUCCESS(rte_service_lcore_stop(slave_lcore),
+			"Failed to stop service lcore");
+	TEST_ASSERT_EQUAL(-EALREADY, rte_service_lcore_stop(slave_lcore),
+			"Service lcore stopped twice");
+
+	rte_service_attr_get(dummy_id, RTE_SERVICE_ATTR_CALL_COUNT, &calls);
+	rte_service_attr_get(dummy_id, RTE_SERVICE_ATTR_CYCLES, &cycles);
+	TEST_ASSERT_EQUAL((uint64_t)rte_atomic32_read(&dummy_calls), calls,
+			"Wrong call count");
+	TEST_ASSERT(cycles > 0, "No cycles accounted to the service");
+	rte_service_dump(stdout, UINT32_MAX);
+
+	/* a stopped service lcore can be restarted */
+	rte_atomic32_clear(&dummy_calls);
+	TEST_ASSERT_SUCCESS(rte_service_lcore_start(slave_lcore),
+			"Failed to restart service lcore");
+	TEST_ASSERT_SUCCESS(wait_dummy_calls(),
+			"Service not run by restarted service lcore");
+	TEST_ASSERT_SUCCESS(rte_service_lcore_stop(slave_lcore),
+			"Failed to stop service lcore");
+
+	TEST_ASSERT_SUCCESS(rte_service_map_lcore_set(dummy_id, slave_lcore, 0),
+			"Failed to unmap service");
+	TEST_ASSERT_EQUAL(0, rte_service_map_lcore_get(dummy_id, slave_lcore),
+			"Service still mapped");
+	TEST_ASSERT_SUCCESS(rte_service_lcore_del(slave_lcore),
+			"Failed to delete service lcore");
+
+	/* the lcore runs application functions again */
+	TEST_ASSERT_SUCCESS(rte_eal_remote_launch(dummy_cb, NULL, slave_lcore),
+			"Failed to launch function on former service lcore");
+	rte_eal_wait_lcore(slave_lcore);
+
+	return TEST_SUCCESS;
+}
+
+static int
+service_start_with_defaults(void)
+{
+	TEST_ASSERT_EQUAL(-ENOTSUP, rte_service_start_with_defaults(),
+			"Started services without service lcores");
+
+	TEST_ASSERT_SUCCESS(rte_service_lcore_add(slave_lcore),
+			"Failed to add service lcore");
+	TEST_ASSERT_SUCCESS(rte_service_component_runstate_set(dummy_id, 1),
+			"Failed to set component runstate");
+	TEST_ASSERT_SUCCESS(rte_service_start_with_defaults(),
+			"Failed to start services with defaults");
+	TEST_ASSERT_EQUAL(1, rte_service_map_lcore_get(dummy_id, slave_lcore),
+			"Service not mapped by default");
+	TEST_ASSERT_SUCCESS(wait_dummy_calls(),
+			"Service not run by service lcore");
+
+	TEST_ASSERT_SUCCESS(rte_service_lcore_reset_all(),
+			"Failed to reset service lcores");
+	TEST_ASSERT_EQUAL(0, rte_service_lcore_count(),
+			"Service lcores left after reset");
+
+	return TEST_SUCCESS;
+}
+
+static struct unit_test_suite service_tests = {
+	.suite_name = "service core test suite",
+	.setup = testsuite_setup,
+	.unit_test_cases = {
+		TEST_CASE(service_register),
+		TEST_CASE(service_lcore_add_del),
+		TEST_CASE_ST(dummy_register, dummy_unregister,
+				service_runstate),
+		TEST_CASE_ST(dummy_register, dummy_unregister,
+				service_lcore_start_stop),
+		TEST_CASE_ST(dummy_register, dummy_unregister,
+				service_start_with_defaults),
+		TEST_CASES_END()
+	}
+};
+
+static int
+test_service_common(void)
+{
+	return unit_test_suite_runner(&service_tests);
+}
+
+REGISTER_TEST_COMMAND(service_autotest, test_service_common);
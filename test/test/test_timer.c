@@ -112,6 +112,19 @@
  *      - At initialization, timer3 is loaded by the master core, on
  *        another core in "periodical" mode (time = 1 second).
  *      - It is stopped at t=25s by timer2.
+ *
+ * #. Timer data test.
+ *
+ *    This test checks the timers of a separate timer data instance.
+ *
+ *    - A timer is loaded on the list of each lcore of the instance, and a
+ *      periodic timer on the list of a slave lcore.
+ *    - rte_timer_manage() does not run them.
+ *    - rte_timer_alt_manage() called by the master lcore on the lists of
+ *      all lcores runs all of them on the master lcore, and reloads the
+ *      periodic timer on the list of the slave lcore.
+ *    - The instance cannot be freed while the periodic timer is pending.
+ *    - This is done with both backends.
  */
 
 #include <stdio.h>
@@ -120,6 +133,7 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <inttypes.h>
+#include <errno.h>
 #include <sys/queue.h>
 #include <math.h>
 
@@ -561,23 +575,12 @@ timer_sanity_check(void)
 }
 
 static int
-test_timer(void)
+timer_run_tests(void)
 {
 	unsigned i;
 	uint64_t cur_time;
 	uint64_t hz;
 
-	/* sanity check our timer sources and timer config values */
-	if (timer_sanity_check() < 0) {
-		printf("Timer sanity checks failed\n");
-		return TEST_FAILED;
-	}
-
-	if (rte_lcore_count() < 2) {
-		printf("not enough lcores for this test\n");
-		return TEST_FAILED;
-	}
-
 	/* init timer */
 	for (i=0; i<NB_TIMER; i++) {
 		memset(&mytiminfo[i], 0, sizeof(struct mytimerinfo));
@@ -626,4 +629,184 @@ test_timer(void)
 	return TEST_SUCCESS;
 }
 
+static unsigned timer_data_count;
+
+static void
+timer_data_cb(struct rte_timer *tim __rte_unused, void *arg __rte_unused)
+{
+	if (rte_lcore_id() == rte_get_master_lcore())
+		timer_data_count++;
+}
+
+static void
+timer_data_manage_cb(struct rte_timer *tim)
+{
+	tim->f(tim, tim->arg);
+}
+
+static int
+timer_data_test(enum rte_timer_backend backend)
+{
+	struct rte_timer tims[RTE_MAX_LCORE], periodic;
+	unsigned int lcores[RTE_MAX_LCORE];
+	uint64_t hz = rte_get_timer_hz();
+	unsigned lcore_id, slave_id, n = 0;
+	uint32_t id;
+	int ret = TEST_FAILED;
+
+	rte_timer_init(&periodic);
+	if (rte_timer_data_alloc(&id) < 0) {
+		printf("Cannot allocate timer data\n");
+		return TEST_FAILED;
+	}
+	if (rte_timer_data_set_backend(id, backend) < 0) {
+		printf("Cannot set timer data backend\n");
+		goto out;
+	}
+
+	timer_data_count = 0;
+	RTE_LCORE_FOREACH(lcore_id) {
+		rte_timer_init(&tims[n]);
+		if (rte_timer_alt_reset(id, &tims[n], hz / 1000, SINGLE,
+				lcore_id, timer_data_cb, NULL) < 0) {
+			printf("Cannot reset timer on lcore %u\n", lcore_id);
+			goto out;
+		}
+		lcores[n++] = lcore_id;
+	}
+	slave_id = rte_get_next_lcore(rte_get_master_lcore(), 1, 0);
+	rte_timer_alt_reset(id, &periodic, hz / 1000, PERIODICAL, slave_id,
+			timer_data_cb, NULL);
+
+	rte_delay_ms(10);
+	rte_timer_manage();
+	if (timer_data_count != 0) {
+		printf("Default timer lists ran instance timers\n");
+		goto out;
+	}
+
+	if (rte_timer_alt_manage(id, lcores, n, timer_data_manage_cb) < 0) {
+		printf("Cannot manage timer data lists\n");
+		goto out;
+	}
+	if (timer_data_count != n + 1) {
+		printf("Expected %u callbacks on master lcore, got %u\n",
+			n + 1, timer_data_count);
+		goto out;
+	}
+	if (!rte_timer_pending(&periodic) ||
+			periodic.status.owner != (int16_t)slave_id) {
+		printf("Periodic timer not reloaded on its lcore\n");
+		goto out;
+	}
+	if (rte_timer_data_dealloc(id) != -EBUSY) {
+		printf("Timer data freed with a pending timer\n");
+		goto out;
+	}
+	if (rte_timer_alt_stop(id, &periodic) < 0) {
+		printf("Cannot stop periodic timer\n");
+		goto out;
+	}
+	ret = TEST_SUCCESS;
+
+out:
+	rte_timer_alt_stop(id, &periodic);
+	if (rte_timer_data_dealloc(id) < 0) {
+		printf("Cannot free timer data\n");
+		ret = TEST_FAILED;
+	}
+	return ret;
+}
+
+/* cycles allowed for the first manage after arming a timer on idle */
+#define WHEEL_IDLE_MANAGE_BUDGET 20000
+
+static void
+wheel_idle_cb(__attribute__((unused)) struct rte_timer *tim, void *arg)
+{
+	(*(unsigned *)arg)++;
+}
+
+/*
+ * Arm a timer on a timing wheel which stayed empty for a second: the wheel
+ * must not be advanced over the idle period by the next manage.
+ */
+static int
+timer_wheel_idle_test(void)
+{
+	static struct rte_timer tim;
+	unsigned lcore_id = rte_lcore_id();
+	unsigned count = 0;
+	uint64_t hz = rte_get_timer_hz();
+	uint64_t start, cycles;
+
+	rte_timer_manage();
+	rte_delay_ms(1000);
+
+	rte_timer_init(&tim);
+	if (rte_timer_reset(&tim, hz / 1000, SINGLE, lcore_id,
+			wheel_idle_cb, &count) < 0) {
+		printf("Cannot arm timer after idle\n");
+		return TEST_FAILED;
+	}
+	start = rte_rdtsc();
+	rte_timer_manage();
+	cycles = rte_rdtsc() - start;
+	printf("First manage after idle: %"PRIu64" cycles\n", cycles);
+	if (cycles > WHEEL_IDLE_MANAGE_BUDGET) {
+		printf("Wheel advanced over the idle period\n");
+		rte_timer_stop_sync(&tim);
+		return TEST_FAILED;
+	}
+
+	rte_delay_ms(2);
+	rte_timer_manage();
+	if (count != 1) {
+		printf("Timer armed after idle did not expire\n");
+		rte_timer_stop_sync(&tim);
+		return TEST_FAILED;
+	}
+	return TEST_SUCCESS;
+}
+
+static int
+test_timer(void)
+{
+	int ret;
+
+	/* sanity check our timer sources and timer config values */
+	if (timer_sanity_check() < 0) {
+		printf("Timer sanity checks failed\n");
+		return TEST_FAILED;
+	}
+
+	if (rte_lcore_count() < 2) {
+		printf("not enough lcores for this test\n");
+		return TEST_FAILED;
+	}
+
+	ret = timer_run_tests();
+	if (ret != TEST_SUCCESS)
+		return ret;
+
+	/* same tests with the timing wheel */
+	printf("\nStart timing wheel tests\n");
+	if (rte_timer_subsystem_init_backend(RTE_TIMER_BACKEND_WHEEL) < 0) {
+		printf("Cannot use the timing wheel\n");
+		return TEST_FAILED;
+	}
+	ret = timer_run_tests();
+	if (ret == TEST_SUCCESS)
+		ret = timer_wheel_idle_test();
+	rte_timer_subsystem_init_backend(RTE_TIMER_BACKEND_SKIPLIST);
+	if (ret != TEST_SUCCESS)
+		return ret;
+
+	printf("\nStart timer data tests\n");
+	ret = timer_data_test(RTE_TIMER_BACKEND_SKIPLIST);
+	if (ret != TEST_SUCCESS)
+		return ret;
+	return timer_data_test(RTE_TIMER_BACKEND_WHEEL);
+}
+
 REGISTER_TEST_COMMAND(timer_autotest, test_timer);
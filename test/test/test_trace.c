@@ -0,0 +1,230 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_lcore.h>
+#include <rte_trace.h>
+
+#include "test.h"
+
+#define TRACE_NB_EVENTS 100
+#define TRACE_PERF_ITERATIONS 100000
+
+/* layout of the events in the stream files */
+struct test_trace_event {
+	uint64_t tsc;
+	uint16_t id;
+	uint16_t nb_args;
+	uint32_t reserved;
+	uint64_t args[RTE_TRACE_MAX_ARGS];
+};
+
+RTE_TRACE_POINT_DEFINE(test_trace_event);
+RTE_TRACE_POINT_DEFINE(test_trace_perf);
+
+/* cycles spent in RTE_TRACE() for each event */
+static uint64_t
+trace_perf(void)
+{
+	uint64_t start;
+	unsigned int i;
+
+	start = rte_rdtsc();
+	for (i = 0; i < TRACE_PERF_ITERATIONS; i++)
+		RTE_TRACE(test_trace_perf, i, i + 1);
+	return (rte_rdtsc() - start) / TRACE_PERF_ITERATIONS;
+}
+
+/* check the last events of the stream file of the lcore */
+static int
+trace_check_stream(const char *dir, struct rte_trace_point *tp)
+{
+	struct test_trace_event ev;
+	char path[PATH_MAX];
+	struct stat st;
+	FILE *f;
+	long off;
+	unsigned int i;
+	int ret = -1;
+
+	snprintf(path, sizeof(path), "%s/channel0_%u", dir, rte_lcore_id());
+	if (stat(path, &st) < 0 || st.st_size < 16 ||
+			(st.st_size - 16) % sizeof(ev) != 0) {
+		printf("Wrong stream file %s\n", path);
+		return -1;
+	}
+	if ((st.st_size - 16) / sizeof(ev) < TRACE_NB_EVENTS) {
+		printf("Missing events in %s\n", path);
+		return -1;
+	}
+
+	f = fopen(path, "r");
+	if (f == NULL)
+		return -1;
+	off = st.st_size - TRACE_NB_EVENTS * sizeof(ev);
+	if (fseek(f, off, SEEK_SET) < 0)
+		goto out;
+	for (i = 0; i < TRACE_NB_EVENTS; i++) {
+		if (fread(&ev, sizeof(ev), 1, f) != 1)
+			goto out;
+		if (ev.id != tp->id || ev.nb_args != 3 ||
+				ev.args[0] != i || ev.args[1] != 42 ||
+				ev.args[2] != UINT64_MAX || ev.args[3] != 0) {
+			printf("Wrong event %u: id %u, %u args\n",
+				i, ev.id, ev.nb_args);
+			goto out;
+		}
+	}
+	ret = 0;
+out:
+	fclose(f);
+	return ret;
+}
+
+static void
+trace_remove_dir(const char *dir)
+{
+	char path[PATH_MAX];
+	struct dirent *e;
+	DIR *d;
+
+	d = opendir(dir);
+	if (d == NULL)
+		return;
+	while ((e = readdir(d)) != NULL) {
+		if (e->d_name[0] == '.')
+			continue;
+		snprintf(path, sizeof(path), "%s/%s", dir, e->d_name);
+		unlink(path);
+	}
+	closedir(d);
+	rmdir(dir);
+}
+
+static int
+test_trace(void)
+{
+	struct rte_trace_point *tp;
+	char dir[] = "/tmp/dpdk_trace_XXXXXX";
+	uint64_t disabled, enabled;
+	char line[256];
+	FILE *f;
+	unsigned int i;
+	int found = 0;
+	int ret;
+
+	tp = rte_trace_point_lookup("test_trace_event");
+	if (tp != &__rte_trace_test_trace_event) {
+		printf("Cannot find the tracepoint\n");
+		return -1;
+	}
+	if (rte_trace_point_lookup("test_trace_none") != NULL) {
+		printf("Unknown tracepoint found\n");
+		return -1;
+	}
+	if (rte_trace_point_enable(NULL, 1) != -EINVAL ||
+			rte_trace_regexp("[", 1) != -EINVAL) {
+		printf("Invalid parameters accepted\n");
+		return -1;
+	}
+
+	ret = rte_trace_regexp("^test_trace_", 1);
+	if (ret != 2 || !tp->enabled) {
+		printf("Wrong number of tracepoints enabled: %d\n", ret);
+		return -1;
+	}
+	ret = rte_trace_regexp("^test_trace_perf$", 0);
+	if (ret != 1 || __rte_trace_test_trace_perf.enabled) {
+		printf("Wrong number of tracepoints disabled: %d\n", ret);
+		return -1;
+	}
+
+	for (i = 0; i < TRACE_NB_EVENTS; i++)
+		RTE_TRACE(test_trace_event, i, 42, UINT64_MAX);
+	rte_trace_point_enable(tp, 0);
+	/* not recorded */
+	RTE_TRACE(test_trace_event, 0, 0, 0);
+	rte_trace_dump(stdout);
+
+	if (mkdtemp(dir) == NULL) {
+		printf("Cannot create a temporary directory\n");
+		return -1;
+	}
+	ret = rte_trace_save(dir);
+	if (ret < 0) {
+		printf("Cannot save the trace: %s\n", strerror(-ret));
+		goto out;
+	}
+	ret = -1;
+	if (trace_check_stream(dir, tp) < 0)
+		goto out;
+
+	snprintf(line, sizeof(line), "%s/metadata", dir);
+	f = fopen(line, "r");
+	if (f == NULL) {
+		printf("Cannot open the metadata\n");
+		goto out;
+	}
+	while (fgets(line, sizeof(line), f) != NULL)
+		if (strstr(line, "name = \"test_trace_event\";") != NULL)
+			found = 1;
+	fclose(f);
+	if (!found) {
+		printf("Tracepoint missing in the metadata\n");
+		goto out;
+	}
+
+	disabled = trace_perf();
+	rte_trace_point_enable(&__rte_trace_test_trace_perf, 1);
+	enabled = trace_perf();
+	rte_trace_point_enable(&__rte_trace_test_trace_perf, 0);
+	printf("Cycles per tracepoint: disabled %"PRIu64
+		", enabled %"PRIu64"\n", disabled, enabled);
+	ret = 0;
+
+out:
+	trace_remove_dir(dir);
+	return ret;
+}
+
+REGISTER_TEST_COMMAND(trace_autotest, test_trace);